@@ -0,0 +1,45 @@
+#include "alloc_counter.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+
+std::atomic<uint64_t> numAllocations = 0;
+
+} // namespace
+
+// Not inlined, so the compiler does not pair the malloc and free with the
+// new and delete expressions they implement
+[[gnu::noinline]] void* operator new(size_t size)
+{
+    numAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+namespace bios_bmc_smm_error_logger
+{
+
+uint64_t getNumAllocations()
+{
+    return numAllocations.load(std::memory_order_relaxed);
+}
+
+} // namespace bios_bmc_smm_error_logger
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+namespace bios_bmc_smm_error_logger
+{
+
+/**
+ * Get the number of allocations made through the global operator new so far,
+ * counted by the replacement in alloc_counter.cpp
+ *
+ * @return allocations since the process started
+ */
+uint64_t getNumAllocations();
+
+} // namespace bios_bmc_smm_error_logger
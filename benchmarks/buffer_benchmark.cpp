@@ -0,0 +1,346 @@
+#include "config.h"
+
+#include "alloc_counter.hpp"
+#include "bios_producer.hpp"
+#include "buffer.hpp"
+#include "fake_data_interface.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace
+{
+
+constexpr size_t entryHeaderSize = sizeof(struct QueueEntryHeader);
+// Bytes available to entries in the queue configured for the build
+constexpr size_t maxOffset =
+    QUEUE_REGION_SIZE - UE_REGION_SIZE - sizeof(struct CircularBufferHeader);
+constexpr std::array<uint32_t, 4> magicNumber = {
+    MAGIC_NUMBER_BYTE1, MAGIC_NUMBER_BYTE2, MAGIC_NUMBER_BYTE3,
+    MAGIC_NUMBER_BYTE4};
+
+/**
+ * Where the first entry of a tick starts, relative to the end of the queue
+ */
+enum WrapPosition : int64_t
+{
+    // At the start of the queue, nothing wraps around
+    noWrap,
+    // The queue ends in the middle of the first entry header
+    inEntryHeader,
+    // The queue ends in the middle of the first entry
+    inEntry,
+};
+
+/**
+ * A BufferImpl over a FakeDataInterface, with one tick worth of entries
+ * written by BiosProducer at the given wrap position. The queue size is the
+ * one configured for the build (queue-region-size and ue-region-size).
+ */
+class BufferFixture
+{
+  public:
+    BufferFixture(size_t entrySize, size_t entriesPerTick,
+                  WrapPosition wrapPosition)
+    {
+        auto memory = std::make_unique<FakeDataInterface>(MEMORY_REGION_SIZE);
+        dataInterface = memory.get();
+        buffer = std::make_unique<BufferImpl>(std::move(memory));
+        buffer->initialize(BMC_INTERFACE_VERSION, QUEUE_REGION_SIZE,
+                           UE_REGION_SIZE, magicNumber);
+
+        const size_t entryAndHeaderSize = entryHeaderSize + entrySize;
+        bytesPerTick = entryAndHeaderSize * entriesPerTick;
+        // One byte always stays free in the queue
+        if (bytesPerTick >= maxOffset)
+        {
+            return;
+        }
+        switch (wrapPosition)
+        {
+            case noWrap:
+                startPtr = 0;
+                break;
+            case inEntryHeader:
+                startPtr = maxOffset - entryHeaderSize / 2;
+                break;
+            case inEntry:
+                startPtr = maxOffset - entryHeaderSize - entrySize / 2;
+                break;
+        }
+
+        // Start both pointers at the wrap position, as if the queue had been
+        // filled and drained up to there
+        setPointer(offsetof(struct CircularBufferHeader, biosWritePtr),
+                   startPtr);
+        rewind();
+        BiosProducer producer(*dataInterface);
+        producer.attach();
+        const std::vector<uint8_t> payload(entrySize, 0xa5);
+        for (size_t i = 0; i < entriesPerTick; ++i)
+        {
+            producer.writeEntry(/*rdeCommandType=*/2, payload);
+        }
+        valid = true;
+    }
+
+    /** @brief Whether a tick of entries fits in the configured queue */
+    bool isValid() const
+    {
+        return valid;
+    }
+
+    /** @brief Move bmcReadPtr back to the first entry of the tick, so the
+     *  same entries are read again. The BMC never writes to the queue, this
+     *  is the only way to refill it without timing BIOS as well.
+     */
+    void rewind()
+    {
+        setPointer(offsetof(struct CircularBufferHeader, bmcReadPtr), startPtr);
+    }
+
+    BufferImpl& getBuffer()
+    {
+        return *buffer;
+    }
+
+    size_t getStartPtr() const
+    {
+        return startPtr;
+    }
+
+    size_t getBytesPerTick() const
+    {
+        return bytesPerTick;
+    }
+
+  private:
+    void setPointer(size_t offset, uint32_t ptr)
+    {
+        const boost::endian::little_uint24_t littlePtr = ptr;
+        dataInterface->write(
+            offset, std::span(reinterpret_cast<const uint8_t*>(&littlePtr),
+                              sizeof(littlePtr)));
+    }
+
+    std::unique_ptr<BufferImpl> buffer;
+    FakeDataInterface* dataInterface;
+    size_t bytesPerTick = 0;
+    uint32_t startPtr = 0;
+    bool valid = false;
+};
+
+const char* wrapLabel(int64_t wrapPosition)
+{
+    switch (wrapPosition)
+    {
+        case noWrap:
+            return "no wrap";
+        case inEntryHeader:
+            return "wrap in entry header";
+        default:
+            return "wrap in entry";
+    }
+}
+
+/** @brief Report entries/s, bytes/s and allocations per entry */
+void setCounters(benchmark::State& state, uint64_t entries, uint64_t bytes,
+                 uint64_t allocations)
+{
+    state.SetItemsProcessed(entries);
+    state.SetBytesProcessed(bytes);
+    state.counters["allocs/entry"] =
+        entries == 0 ? 0.0 : static_cast<double>(allocations) / entries;
+    state.counters["queue_size"] = QUEUE_REGION_SIZE;
+}
+
+// Args: {entry size, entries per tick, wrap position}, for every tick that fits
+// in the queue
+void tickArgs(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({"entry_size", "entries", "wrap"});
+    for (int64_t entrySize : {0, 32, 128, 1024})
+    {
+        for (int64_t entriesPerTick : {1, 4, 16, 64})
+        {
+            if ((entryHeaderSize + entrySize) * entriesPerTick >= maxOffset)
+            {
+                continue;
+            }
+            for (int64_t wrap : {noWrap, inEntryHeader, inEntry})
+            {
+                b->Args({entrySize, entriesPerTick, wrap});
+            }
+        }
+    }
+}
+
+// What the read loop used to do every tick: read the header, then copy out
+// and consume every entry
+void BM_ReadErrorLogs(benchmark::State& state)
+{
+    const size_t entriesPerTick = state.range(1);
+    BufferFixture fixture(state.range(0), entriesPerTick,
+                          static_cast<WrapPosition>(state.range(2)));
+    if (!fixture.isValid())
+    {
+        state.SkipWithError("A tick of entries does not fit in the queue");
+        return;
+    }
+    state.SetLabel(wrapLabel(state.range(2)));
+
+    const uint64_t allocationsBefore = getNumAllocations();
+    for (auto _ : state)
+    {
+        fixture.rewind();
+        benchmark::DoNotOptimize(fixture.getBuffer().readErrorLogs());
+    }
+    setCounters(state, state.iterations() * entriesPerTick,
+                state.iterations() * fixture.getBytesPerTick(),
+                getNumAllocations() - allocationsBefore);
+}
+
+// The same tick through poll and drain, for comparison
+void BM_PollAndDrain(benchmark::State& state)
+{
+    const size_t entriesPerTick = state.range(1);
+    BufferFixture fixture(state.range(0), entriesPerTick,
+                          static_cast<WrapPosition>(state.range(2)));
+    if (!fixture.isValid())
+    {
+        state.SkipWithError("A tick of entries does not fit in the queue");
+        return;
+    }
+    state.SetLabel(wrapLabel(state.range(2)));
+
+    const uint64_t allocationsBefore = getNumAllocations();
+    for (auto _ : state)
+    {
+        fixture.rewind();
+        BufferImpl& buffer = fixture.getBuffer();
+        benchmark::DoNotOptimize(buffer.poll());
+        benchmark::DoNotOptimize(
+            buffer.drain([](const struct QueueEntryHeader& header,
+                            std::span<const uint8_t> entry) {
+                benchmark::DoNotOptimize(header);
+                benchmark::DoNotOptimize(entry.data());
+            }));
+    }
+    setCounters(state, state.iterations() * entriesPerTick,
+                state.iterations() * fixture.getBytesPerTick(),
+                getNumAllocations() - allocationsBefore);
+}
+
+// Args: {entry size, wrap position}, for every entry that fits in the queue
+void entryArgs(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({"entry_size", "wrap"});
+    for (int64_t entrySize : {0, 32, 128, 1024, 4096})
+    {
+        if (entryHeaderSize + entrySize >= maxOffset)
+        {
+            continue;
+        }
+        for (int64_t wrap : {noWrap, inEntryHeader, inEntry})
+        {
+            b->Args({entrySize, wrap});
+        }
+    }
+}
+
+void BM_ReadEntry(benchmark::State& state)
+{
+    const size_t entrySize = state.range(0);
+    BufferFixture fixture(entrySize, 1,
+                          static_cast<WrapPosition>(state.range(1)));
+    if (!fixture.isValid())
+    {
+        state.SkipWithError("The entry does not fit in the queue");
+        return;
+    }
+    state.SetLabel(wrapLabel(state.range(1)));
+    BufferImpl& buffer = fixture.getBuffer();
+    buffer.readBufferHeader();
+
+    const uint64_t allocationsBefore = getNumAllocations();
+    for (auto _ : state)
+    {
+        // readEntry moves the read pointer past the entry, move it back
+        buffer.updateReadPtr(fixture.getStartPtr());
+        benchmark::DoNotOptimize(buffer.readEntry());
+    }
+    setCounters(state, state.iterations(),
+                state.iterations() * (entryHeaderSize + entrySize),
+                getNumAllocations() - allocationsBefore);
+}
+
+template <bool Into>
+void BM_WraparoundRead(benchmark::State& state)
+{
+    const size_t length = state.range(0);
+    BufferFixture fixture(length, 1, static_cast<WrapPosition>(state.range(1)));
+    if (!fixture.isValid())
+    {
+        state.SkipWithError("The read does not fit in the queue");
+        return;
+    }
+    state.SetLabel(wrapLabel(state.range(1)));
+    BufferImpl& buffer = fixture.getBuffer();
+    std::vector<uint8_t> bytes(length);
+
+    const uint64_t allocationsBefore = getNumAllocations();
+    for (auto _ : state)
+    {
+        if constexpr (Into)
+        {
+            buffer.wraparoundReadInto(fixture.getStartPtr(), bytes);
+            benchmark::DoNotOptimize(bytes.data());
+        }
+        else
+        {
+            benchmark::DoNotOptimize(
+                buffer.wraparoundRead(fixture.getStartPtr(), length));
+        }
+    }
+    setCounters(state, state.iterations(), state.iterations() * length,
+                getNumAllocations() - allocationsBefore);
+}
+
+// Done on every BMC start and every time the buffer is found corrupted
+void BM_Initialize(benchmark::State& state)
+{
+    auto memory = std::make_unique<FakeDataInterface>(MEMORY_REGION_SIZE);
+    BufferImpl buffer(std::move(memory));
+
+    const uint64_t allocationsBefore = getNumAllocations();
+    for (auto _ : state)
+    {
+        buffer.initialize(BMC_INTERFACE_VERSION, QUEUE_REGION_SIZE,
+                          UE_REGION_SIZE, magicNumber);
+    }
+    state.SetBytesProcessed(state.iterations() * QUEUE_REGION_SIZE);
+    state.counters["allocs/init"] =
+        benchmark::Counter(getNumAllocations() - allocationsBefore,
+                           benchmark::Counter::kAvgIterations);
+    state.counters["queue_size"] = QUEUE_REGION_SIZE;
+}
+
+BENCHMARK(BM_ReadErrorLogs)->Apply(tickArgs);
+BENCHMARK(BM_PollAndDrain)->Apply(tickArgs);
+BENCHMARK(BM_ReadEntry)->Apply(entryArgs);
+BENCHMARK(BM_WraparoundRead<false>)->Apply(entryArgs);
+BENCHMARK(BM_WraparoundRead<true>)->Apply(entryArgs);
+BENCHMARK(BM_Initialize);
+
+} // namespace
+} // namespace bios_bmc_smm_error_logger
+
+BENCHMARK_MAIN();
@@ -0,0 +1,95 @@
+#include "checksum/checksum.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <span>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace
+{
+
+// Queue entry header, small entry, queue size, dictionary chunk, big dictionary
+void sizeArgs(benchmark::internal::Benchmark* b)
+{
+    for (int64_t length : {6, 38, 384, 4096, 65536})
+    {
+        b->Arg(length);
+    }
+}
+
+std::vector<uint8_t> makeBytes(size_t length)
+{
+    std::vector<uint8_t> bytes(length);
+    std::iota(bytes.begin(), bytes.end(), 0);
+    return bytes;
+}
+
+// The checksum BufferImpl used before the kernels
+uint8_t accumulateXor(std::span<const uint8_t> bytes)
+{
+    return std::accumulate(bytes.begin(), bytes.end(), 0,
+                           std::bit_xor<void>());
+}
+
+bool skipUnsupported(benchmark::State& state, ChecksumKernel kernel)
+{
+    if (!isChecksumKernelSupported(kernel))
+    {
+        state.SkipWithError("Kernel not supported on this CPU");
+        return true;
+    }
+    return false;
+}
+
+void BM_AccumulateXor(benchmark::State& state)
+{
+    std::vector<uint8_t> src = makeBytes(state.range(0));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(accumulateXor(src));
+    }
+    state.SetBytesProcessed(state.iterations() * src.size());
+}
+
+// Through the kernel picked at runtime
+void BM_XorChecksumBest(benchmark::State& state)
+{
+    std::vector<uint8_t> src = makeBytes(state.range(0));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(xorChecksum(src));
+    }
+    state.SetBytesProcessed(state.iterations() * src.size());
+}
+
+void BM_XorChecksum(benchmark::State& state, ChecksumKernel kernel)
+{
+    if (skipUnsupported(state, kernel))
+    {
+        return;
+    }
+    std::vector<uint8_t> src = makeBytes(state.range(0));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(xorChecksum(kernel, src));
+    }
+    state.SetBytesProcessed(state.iterations() * src.size());
+}
+
+BENCHMARK(BM_AccumulateXor)->Apply(sizeArgs);
+BENCHMARK(BM_XorChecksumBest)->Apply(sizeArgs);
+BENCHMARK_CAPTURE(BM_XorChecksum, portable, ChecksumKernel::portable)
+    ->Apply(sizeArgs);
+BENCHMARK_CAPTURE(BM_XorChecksum, sse2, ChecksumKernel::sse2)->Apply(sizeArgs);
+BENCHMARK_CAPTURE(BM_XorChecksum, avx2, ChecksumKernel::avx2)->Apply(sizeArgs);
+BENCHMARK_CAPTURE(BM_XorChecksum, neon, ChecksumKernel::neon)->Apply(sizeArgs);
+
+} // namespace
+} // namespace bios_bmc_smm_error_logger
+
+BENCHMARK_MAIN();
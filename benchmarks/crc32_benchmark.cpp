@@ -0,0 +1,136 @@
+#include "checksum/crc32.hpp"
+
+#include <array>
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace
+{
+
+// Dictionary chunks come in whatever size fits in a queue entry, from a few
+// bytes up to whole dictionaries for START_AND_END transfers
+void chunkSizeArgs(benchmark::internal::Benchmark* b)
+{
+    for (int64_t length : {16, 64, 256, 1024, 4096, 65536})
+    {
+        b->Arg(length);
+    }
+}
+
+std::vector<uint8_t> makeBytes(size_t length)
+{
+    std::vector<uint8_t> bytes(length);
+    std::iota(bytes.begin(), bytes.end(), 0);
+    return bytes;
+}
+
+// The byte at a time CRC RdeCommandHandler::updateCrc used before
+uint32_t byteLoopCrc(uint32_t crc, std::span<const uint8_t> bytes)
+{
+    static const std::array<uint32_t, UINT8_MAX + 1> crcTable = [] {
+        std::array<uint32_t, UINT8_MAX + 1> table{};
+        for (uint32_t i = 0; i < table.size(); ++i)
+        {
+            uint32_t rem = i;
+            for (uint8_t k = 0; k < 8; ++k)
+            {
+                rem = (rem & 1) ? (rem >> 1) ^ 0xedb88320 : rem >> 1;
+            }
+            table[i] = rem;
+        }
+        return table;
+    }();
+    for (uint8_t byte : bytes)
+    {
+        crc = crcTable[(crc ^ byte) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+void BM_ByteLoopCrc(benchmark::State& state)
+{
+    std::vector<uint8_t> bytes = makeBytes(state.range(0));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(byteLoopCrc(crc32Init, bytes));
+    }
+    state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+
+void BM_Crc32Update(benchmark::State& state, Crc32Kernel kernel)
+{
+    if (!isCrc32KernelSupported(kernel))
+    {
+        state.SkipWithError("Kernel not supported on this CPU");
+        return;
+    }
+    std::vector<uint8_t> bytes = makeBytes(state.range(0));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(crc32Update(kernel, crc32Init, bytes));
+    }
+    state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+
+// Through the kernel picked at runtime, as RdeCommandHandler uses it
+void BM_Crc32UpdateBest(benchmark::State& state)
+{
+    std::vector<uint8_t> bytes = makeBytes(state.range(0));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(crc32Update(crc32Init, bytes));
+    }
+    state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+
+// A dictionary chunk appended to the dictionary, then the CRC over it as
+// RdeCommandHandler::updateCrc did
+void BM_InsertThenByteLoopCrc(benchmark::State& state)
+{
+    std::vector<uint8_t> bytes = makeBytes(state.range(0));
+    std::vector<uint8_t> dictionary;
+    for (auto _ : state)
+    {
+        dictionary.clear();
+        dictionary.insert(dictionary.end(), bytes.begin(), bytes.end());
+        benchmark::DoNotOptimize(byteLoopCrc(crc32Init, dictionary));
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+
+// The same through crc32Append, as DictionaryManager does it now
+void BM_Crc32Append(benchmark::State& state)
+{
+    std::vector<uint8_t> bytes = makeBytes(state.range(0));
+    std::vector<uint8_t> dictionary;
+    for (auto _ : state)
+    {
+        dictionary.clear();
+        benchmark::DoNotOptimize(crc32Append(crc32Init, bytes, dictionary));
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+
+BENCHMARK(BM_ByteLoopCrc)->Apply(chunkSizeArgs);
+BENCHMARK_CAPTURE(BM_Crc32Update, slicingBy8, Crc32Kernel::slicingBy8)
+    ->Apply(chunkSizeArgs);
+BENCHMARK_CAPTURE(BM_Crc32Update, armv8, Crc32Kernel::armv8)
+    ->Apply(chunkSizeArgs);
+BENCHMARK_CAPTURE(BM_Crc32Update, pclmul, Crc32Kernel::pclmul)
+    ->Apply(chunkSizeArgs);
+BENCHMARK(BM_Crc32UpdateBest)->Apply(chunkSizeArgs);
+BENCHMARK(BM_InsertThenByteLoopCrc)->Apply(chunkSizeArgs);
+BENCHMARK(BM_Crc32Append)->Apply(chunkSizeArgs);
+
+} // namespace
+} // namespace bios_bmc_smm_error_logger
+
+BENCHMARK_MAIN();
@@ -0,0 +1,65 @@
+#include "doorbell.hpp"
+
+#include <poll.h>
+#include <unistd.h>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+
+#include <functional>
+#include <thread>
+
+#include <benchmark/benchmark.h>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace
+{
+
+// Re-arm the wait after every ring, same as the read loop does
+void answerRings(boost::asio::posix::stream_descriptor* descriptor,
+                 EventFdDoorbell* doorbell, EventFdDoorbell* answer,
+                 const boost::system::error_code& error)
+{
+    if (error)
+    {
+        return;
+    }
+    doorbell->acknowledge();
+    answer->ring();
+    descriptor->async_wait(
+        boost::asio::posix::stream_descriptor::wait_read,
+        std::bind_front(answerRings, descriptor, doorbell, answer));
+}
+
+// Time from the BIOS side ringing the doorbell until a handler on an
+// io_context thread has run and answered
+void BM_DoorbellWakeupRoundTrip(benchmark::State& state)
+{
+    EventFdDoorbell doorbell;
+    EventFdDoorbell answer;
+    boost::asio::io_context io;
+    boost::asio::posix::stream_descriptor descriptor(io,
+                                                     ::dup(doorbell.getFd()));
+    descriptor.async_wait(
+        boost::asio::posix::stream_descriptor::wait_read,
+        std::bind_front(answerRings, &descriptor, &doorbell, &answer));
+    std::thread ioThread([&io]() { io.run(); });
+
+    struct pollfd pfd = {.fd = answer.getFd(), .events = POLLIN, .revents = 0};
+    for (auto _ : state)
+    {
+        doorbell.ring();
+        ::poll(&pfd, 1, -1);
+        answer.acknowledge();
+    }
+
+    io.stop();
+    ioThread.join();
+}
+BENCHMARK(BM_DoorbellWakeupRoundTrip)->UseRealTime();
+
+} // namespace
+} // namespace bios_bmc_smm_error_logger
+
+BENCHMARK_MAIN();
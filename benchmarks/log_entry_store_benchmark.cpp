@@ -0,0 +1,187 @@
+/**
+ * Cost of keeping LogEntries on tmpfs (/dev/shm) the way the storer does,
+ * for a directory and an index.json per entry (ExternalStorerFileWriter) and
+ * for segment files (ExternalStorerSegmentWriter):
+ *  - BM_WriteEvict: writing an entry and evicting the oldest, once the
+ *    storer's 980 rolling entries are there
+ *  - BM_StoredBytes: tmpfs blocks and inodes a full set of entries takes up,
+ *    as counters per entry
+ */
+
+#include "alloc_counter.hpp"
+#include "rde/external_storer_file.hpp"
+#include "rde/external_storer_segment.hpp"
+#include "rde/log_entry_segment_store.hpp"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include <benchmark/benchmark.h>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace rde
+{
+namespace
+{
+
+enum StoreKind : int64_t
+{
+    directoryStore,
+    segmentStore,
+};
+
+constexpr int numEntries = 980;
+constexpr size_t segmentSize = 262144;
+
+// A CPER LogEntry as the storer writes it
+constexpr std::string_view logEntryJson =
+    R"({"Id":"6b5a8c2e-2b9f-4f3e-9b1a-0c6d1e2f3a4b",)"
+    R"("@odata.type":"#LogEntry.v1_13_0.LogEntry","EntryType":"Oem",)"
+    R"("OemRecordFormat":"CPER","Severity":"Critical",)"
+    R"("DiagnosticDataType":"CPER","Message":"Uncorrectable memory error",)"
+    R"("Oem":{"SectionCount":1,"ErrorType":"DRAM","Dimm":"dimm0"}})";
+
+std::string entryPath(int64_t i)
+{
+    return std::format(
+        "/redfish/v1/Systems/system/LogServices/6F7-C1A7C/Entries/{}", i);
+}
+
+/** @brief A file handler of the given kind in its own directory */
+class StoreFixture
+{
+  public:
+    explicit StoreFixture(StoreKind kind) :
+        rootDir(std::filesystem::path("/dev/shm") /
+                std::format("log_entry_store_benchmark.{}", getpid()))
+    {
+        std::filesystem::remove_all(rootDir);
+        auto fileWriter =
+            std::make_unique<ExternalStorerFileWriter>(
+                (rootDir / "bmcweb").string());
+        if (kind == directoryStore)
+        {
+            fileHandler = std::move(fileWriter);
+            return;
+        }
+        fileHandler = std::make_unique<ExternalStorerSegmentWriter>(
+            std::make_unique<LogEntrySegmentStore>(
+                (rootDir / "segments").string(), segmentSize),
+            std::move(fileWriter));
+    }
+
+    ~StoreFixture()
+    {
+        fileHandler.reset();
+        std::error_code ec;
+        std::filesystem::remove_all(rootDir, ec);
+    }
+
+    StoreFixture(const StoreFixture&) = delete;
+    StoreFixture& operator=(const StoreFixture&) = delete;
+
+    bool write(int64_t i)
+    {
+        return fileHandler->createFile(entryPath(i),
+                                       std::span(&logEntryJson, 1));
+    }
+
+    bool evict(int64_t i)
+    {
+        return fileHandler->removeAll(entryPath(i));
+    }
+
+    /** @brief Sum up the tmpfs blocks and inodes under the directory */
+    void countStored(uint64_t& bytes, uint64_t& inodes) const
+    {
+        bytes = 0;
+        inodes = 0;
+        for (const auto& file :
+             std::filesystem::recursive_directory_iterator(rootDir))
+        {
+            struct stat fileStat;
+            if (::lstat(file.path().c_str(), &fileStat) == 0)
+            {
+                bytes += static_cast<uint64_t>(fileStat.st_blocks) * 512;
+                ++inodes;
+            }
+        }
+    }
+
+  private:
+    std::filesystem::path rootDir;
+    std::unique_ptr<FileHandlerInterface> fileHandler;
+};
+
+const char* storeLabel(int64_t kind)
+{
+    return kind == directoryStore ? "directories" : "segments";
+}
+
+void BM_WriteEvict(benchmark::State& state)
+{
+    StoreFixture store(static_cast<StoreKind>(state.range(0)));
+    state.SetLabel(storeLabel(state.range(0)));
+    int64_t next = 0;
+    for (; next < numEntries; ++next)
+    {
+        store.write(next);
+    }
+
+    const uint64_t allocationsBefore = getNumAllocations();
+    for (auto _ : state)
+    {
+        if (!store.write(next) || !store.evict(next - numEntries))
+        {
+            state.SkipWithError("Writing or evicting the LogEntry failed");
+            return;
+        }
+        ++next;
+    }
+    state.counters["allocs/log"] =
+        benchmark::Counter(getNumAllocations() - allocationsBefore,
+                           benchmark::Counter::kAvgIterations);
+    state.SetBytesProcessed(state.iterations() * logEntryJson.size());
+}
+
+void BM_StoredBytes(benchmark::State& state)
+{
+    state.SetLabel(storeLabel(state.range(0)));
+    uint64_t bytes = 0;
+    uint64_t inodes = 0;
+    for (auto _ : state)
+    {
+        StoreFixture store(static_cast<StoreKind>(state.range(0)));
+        for (int64_t i = 0; i < numEntries; ++i)
+        {
+            store.write(i);
+        }
+        store.countStored(bytes, inodes);
+    }
+    state.counters["tmpfs bytes/log"] =
+        static_cast<double>(bytes) / numEntries;
+    state.counters["inodes/log"] = static_cast<double>(inodes) / numEntries;
+}
+
+BENCHMARK(BM_WriteEvict)->Arg(directoryStore)->Arg(segmentStore);
+BENCHMARK(BM_StoredBytes)
+    ->Arg(directoryStore)
+    ->Arg(segmentStore)
+    ->Iterations(3)
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+} // namespace rde
+} // namespace bios_bmc_smm_error_logger
+
+BENCHMARK_MAIN();
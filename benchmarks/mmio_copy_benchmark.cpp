@@ -0,0 +1,132 @@
+#include "mmio_copy.hpp"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace
+{
+
+/**
+ * A memfd backed shared mapping, standing in for the /dev/mem MMIO window.
+ */
+class MemfdMapping
+{
+  public:
+    explicit MemfdMapping(size_t size) : size(size)
+    {
+        fd = memfd_create("mmio_copy_benchmark", MFD_CLOEXEC);
+        if (fd < 0 || ftruncate(fd, static_cast<off_t>(size)) != 0)
+        {
+            throw std::runtime_error("Failed to create the memfd");
+        }
+        void* mapped =
+            mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED)
+        {
+            throw std::runtime_error("Failed to mmap the memfd");
+        }
+        data = static_cast<uint8_t*>(mapped);
+        std::memset(data, 0x5a, size);
+    }
+    ~MemfdMapping()
+    {
+        munmap(data, size);
+        close(fd);
+    }
+    MemfdMapping(const MemfdMapping&) = delete;
+    MemfdMapping& operator=(const MemfdMapping&) = delete;
+
+    volatile uint8_t* get(size_t offset)
+    {
+        return data + offset;
+    }
+
+  private:
+    size_t size;
+    int fd;
+    uint8_t* data;
+};
+
+constexpr size_t mappingSize = 16384;
+
+// The copy loops PciDataHandler used before copyFromMmio / copyToMmio
+void byteLoopRead(const volatile uint8_t* src, std::span<uint8_t> dest)
+{
+    for (size_t i = 0; i < dest.size(); ++i)
+    {
+        dest[i] = src[i];
+    }
+}
+
+void byteLoopWrite(volatile uint8_t* dest, std::span<const uint8_t> src)
+{
+    for (size_t i = 0; i < src.size(); ++i)
+    {
+        dest[i] = src[i];
+    }
+}
+
+// Args: {length, offset into the mapping}
+void copyArgs(benchmark::internal::Benchmark* b)
+{
+    for (int64_t length : {6, 48, 80, 384, 4096})
+    {
+        for (int64_t offset : {0, 1, 0x21})
+        {
+            b->Args({length, offset});
+        }
+    }
+}
+
+template <void (*ReadFn)(const volatile uint8_t*, std::span<uint8_t>)>
+void BM_MmioRead(benchmark::State& state)
+{
+    MemfdMapping mapping(mappingSize);
+    const size_t length = state.range(0);
+    const volatile uint8_t* src = mapping.get(state.range(1));
+    std::vector<uint8_t> dest(length);
+
+    for (auto _ : state)
+    {
+        ReadFn(src, dest);
+        benchmark::DoNotOptimize(dest.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * length);
+}
+
+template <void (*WriteFn)(volatile uint8_t*, std::span<const uint8_t>)>
+void BM_MmioWrite(benchmark::State& state)
+{
+    MemfdMapping mapping(mappingSize);
+    const size_t length = state.range(0);
+    volatile uint8_t* dest = mapping.get(state.range(1));
+    std::vector<uint8_t> src(length, 0xa5);
+
+    for (auto _ : state)
+    {
+        WriteFn(dest, src);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * length);
+}
+
+BENCHMARK(BM_MmioRead<byteLoopRead>)->Apply(copyArgs);
+BENCHMARK(BM_MmioRead<copyFromMmio>)->Apply(copyArgs);
+BENCHMARK(BM_MmioWrite<byteLoopWrite>)->Apply(copyArgs);
+BENCHMARK(BM_MmioWrite<copyToMmio>)->Apply(copyArgs);
+
+} // namespace
+} // namespace bios_bmc_smm_error_logger
+
+BENCHMARK_MAIN();
@@ -0,0 +1,364 @@
+/**
+ * Cost of turning one RDE command from the queue into a published log, stage
+ * by stage, over the commands recorded in rde_test_vectors.hpp:
+ *  - BM_DictionaryTransfer: receiving a dictionary (copy and CRC)
+ *  - BM_DictionaryLookup: finding the schema and annotation dictionaries
+ *  - BM_BejDecode: libbej decoding the payload to JSON
+ *  - BM_PublishJson: the storer writing a log out
+ *  - BM_DecodeRdeCommand: all of the above through RdeCommandHandler
+ *
+ * Storers are a null storer, ExternalStorerFileInterface on tmpfs (/dev/shm),
+ * and ExternalStorerFileInterface on the disk backed TMPDIR. The file storers
+ * log every entry they create, run with 2>/dev/null to keep the report clean.
+ */
+
+#include "alloc_counter.hpp"
+#include "rde/external_storer_file.hpp"
+#include "rde/external_storer_interface.hpp"
+#include "rde/rde_dictionary_manager.hpp"
+#include "rde/rde_handler.hpp"
+#include "rde_test_vectors.hpp"
+
+#include <unistd.h>
+
+#include <boost/asio/io_context.hpp>
+#include <sdbusplus/asio/connection.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include <benchmark/benchmark.h>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace rde
+{
+namespace
+{
+
+/**
+ * Drops every log, so only the handler itself is measured
+ */
+class NullStorer : public ExternalStorerInterface
+{
+  public:
+    bool publishJson(std::string_view jsonStr) override
+    {
+        benchmark::DoNotOptimize(jsonStr.data());
+        return true;
+    }
+};
+
+// The LogService BIOS sends once, before any LogEntry
+constexpr std::string_view logServiceJson =
+    R"({"@odata.id":"/redfish/v1/Systems/system/LogServices/6F7-C1A7C",)"
+    R"("@odata.type":"#LogService.v1_1_0.LogService","Id":"6F7-C1A7C"})";
+
+// A CPER LogEntry about the size of what the recorded payload decodes to
+constexpr std::string_view logEntryJson =
+    R"({"@odata.id":"/redfish/v1/Systems/system/LogServices/6F7-C1A7C/)"
+    R"(Entries/0","@odata.type":"#LogEntry.v1_13_0.LogEntry","Id":"0",)"
+    R"("EntryType":"Oem","OemRecordFormat":"CPER","Severity":"Critical",)"
+    R"("DiagnosticDataType":"CPER","Message":"Uncorrectable memory error",)"
+    R"("Oem":{"SectionCount":1,"ErrorType":"DRAM","Dimm":"dimm0"}})";
+
+/**
+ * The recorded payload decodes to a DummySimple resource, which has no
+ * @odata.type and is rejected by ExternalStorerFileInterface. Stands in a
+ * LogEntry for every decoded log, so the file storers do the work of a real
+ * one.
+ */
+class LogEntryStorer : public ExternalStorerInterface
+{
+  public:
+    explicit LogEntryStorer(std::unique_ptr<ExternalStorerInterface> storer) :
+        storer(std::move(storer))
+    {}
+
+    bool publishJson(std::string_view) override
+    {
+        return storer->publishJson(logEntryJson);
+    }
+
+  private:
+    std::unique_ptr<ExternalStorerInterface> storer;
+};
+
+enum StorerKind : int64_t
+{
+    nullStorer,
+    tmpfsStorer,
+    diskStorer,
+};
+
+const char* storerLabel(int64_t kind)
+{
+    switch (kind)
+    {
+        case nullStorer:
+            return "null storer";
+        case tmpfsStorer:
+            return "tmpfs storer";
+        default:
+            return "disk storer";
+    }
+}
+
+/**
+ * A storer of the given kind. File storers get their own directory, removed
+ * again at the end, and the LogService every LogEntry needs.
+ */
+class StorerFixture
+{
+  public:
+    explicit StorerFixture(StorerKind kind)
+    {
+        if (kind == nullStorer)
+        {
+            storer = std::make_unique<NullStorer>();
+            return;
+        }
+
+        const std::filesystem::path baseDir =
+            kind == tmpfsStorer ? std::filesystem::path("/dev/shm")
+                                : std::filesystem::temp_directory_path();
+        rootDir = baseDir / std::format("rde_decode_benchmark.{}", getpid());
+        std::filesystem::create_directories(rootDir);
+        conn = std::make_shared<sdbusplus::asio::connection>(io);
+        storer = std::make_unique<ExternalStorerFileInterface>(
+            conn, rootDir.string(),
+            std::make_unique<ExternalStorerFileWriter>(rootDir.string()));
+        storer->publishJson(logServiceJson);
+    }
+
+    ~StorerFixture()
+    {
+        storer.reset();
+        if (!rootDir.empty())
+        {
+            std::error_code ec;
+            std::filesystem::remove_all(rootDir, ec);
+        }
+    }
+
+    StorerFixture(const StorerFixture&) = delete;
+    StorerFixture& operator=(const StorerFixture&) = delete;
+
+    /** @brief Hand the storer over, e.g. to a RdeCommandHandler. It still
+     *  has to be used within the lifetime of the fixture.
+     */
+    std::unique_ptr<ExternalStorerInterface> release()
+    {
+        return std::move(storer);
+    }
+
+    ExternalStorerInterface& get()
+    {
+        return *storer;
+    }
+
+    /** @brief Create the D-Bus objects for the entries published so far, as
+     *  the daemon's io_context would
+     */
+    void runPosted()
+    {
+        io.poll();
+    }
+
+  private:
+    std::filesystem::path rootDir;
+    boost::asio::io_context io;
+    std::shared_ptr<sdbusplus::asio::connection> conn;
+    std::unique_ptr<ExternalStorerInterface> storer;
+};
+
+/** @brief The dictionary data in a MultipartReceive response */
+std::span<const uint8_t> dictionaryData(std::span<const uint8_t> command)
+{
+    const auto* header =
+        reinterpret_cast<const MultipartReceiveResHeader*>(command.data());
+    return command.subspan(sizeof(MultipartReceiveResHeader),
+                           header->dataLengthBytes);
+}
+
+/** @brief The BEJ encoded payload of mInitOp */
+std::span<const uint8_t> initOpPayload()
+{
+    const auto* header =
+        reinterpret_cast<const RdeOperationInitReqHeader*>(mInitOp.data());
+    return std::span(mInitOp).subspan(sizeof(RdeOperationInitReqHeader) +
+                                          header->operationLocatorLength,
+                                      header->requestPayloadLength);
+}
+
+uint32_t initOpResourceId()
+{
+    return reinterpret_cast<const RdeOperationInitReqHeader*>(mInitOp.data())
+        ->resourceID;
+}
+
+/** @brief Both dictionaries mInitOp needs, as the handler keeps them */
+void loadDictionaries(DictionaryManager& dictionaryManager)
+{
+    dictionaryManager.startDictionaryEntry(
+        initOpResourceId(), dictionaryData(mRcvInput0StartAndEnd));
+    dictionaryManager.markDataComplete(initOpResourceId());
+    dictionaryManager.startDictionaryEntry(
+        annotationResourceId, dictionaryData(mRcvDummyAnnotation));
+    dictionaryManager.markDataComplete(annotationResourceId);
+}
+
+void setAllocationCounter(benchmark::State& state, uint64_t allocations)
+{
+    state.counters["allocs/log"] = benchmark::Counter(
+        allocations, benchmark::Counter::kAvgIterations);
+}
+
+void BM_DictionaryTransfer(benchmark::State& state)
+{
+    RdeCommandHandler handler(std::make_unique<NullStorer>());
+
+    const uint64_t allocationsBefore = getNumAllocations();
+    for (auto _ : state)
+    {
+        if (handler.decodeRdeCommand(
+                mRcvInput0StartAndEnd,
+                RdeCommandType::RdeMultiPartReceiveResponse) !=
+            RdeDecodeStatus::RdeStopFlagReceived)
+        {
+            state.SkipWithError("Dictionary transfer failed");
+            return;
+        }
+    }
+    setAllocationCounter(state, getNumAllocations() - allocationsBefore);
+    state.SetBytesProcessed(state.iterations() * mRcvInput0StartAndEnd.size());
+}
+
+void BM_DictionaryLookup(benchmark::State& state)
+{
+    DictionaryManager dictionaryManager;
+    loadDictionaries(dictionaryManager);
+    const uint32_t resourceId = initOpResourceId();
+
+    const uint64_t allocationsBefore = getNumAllocations();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(dictionaryManager.getDictionary(resourceId));
+        benchmark::DoNotOptimize(dictionaryManager.getAnnotationDictionary());
+    }
+    setAllocationCounter(state, getNumAllocations() - allocationsBefore);
+}
+
+void BM_BejDecode(benchmark::State& state)
+{
+    DictionaryManager dictionaryManager;
+    loadDictionaries(dictionaryManager);
+    const std::span<const uint8_t> schemaDictionary =
+        *dictionaryManager.getDictionary(initOpResourceId());
+    const std::span<const uint8_t> annotationDictionary =
+        *dictionaryManager.getAnnotationDictionary();
+    const BejDictionaries dictionaries = {
+        .schemaDictionary = schemaDictionary.data(),
+        .schemaDictionarySize =
+            static_cast<uint32_t>(schemaDictionary.size_bytes()),
+        .annotationDictionary = annotationDictionary.data(),
+        .annotationDictionarySize =
+            static_cast<uint32_t>(annotationDictionary.size_bytes()),
+        .errorDictionary = nullptr,
+        .errorDictionarySize = 0,
+    };
+    const std::span<const uint8_t> payload = initOpPayload();
+    libbej::BejDecoderJson decoder;
+
+    const uint64_t allocationsBefore = getNumAllocations();
+    for (auto _ : state)
+    {
+        if (decoder.decode(dictionaries, payload) != 0)
+        {
+            state.SkipWithError("BEJ decoding failed");
+            return;
+        }
+        benchmark::DoNotOptimize(decoder.getOutput());
+    }
+    setAllocationCounter(state, getNumAllocations() - allocationsBefore);
+    state.SetBytesProcessed(state.iterations() * payload.size());
+}
+
+void BM_PublishJson(benchmark::State& state)
+{
+    StorerFixture storer(static_cast<StorerKind>(state.range(0)));
+    state.SetLabel(storerLabel(state.range(0)));
+
+    const uint64_t allocationsBefore = getNumAllocations();
+    for (auto _ : state)
+    {
+        if (!storer.get().publishJson(logEntryJson))
+        {
+            state.SkipWithError("Publishing the LogEntry failed");
+            return;
+        }
+        storer.runPosted();
+    }
+    setAllocationCounter(state, getNumAllocations() - allocationsBefore);
+    state.SetBytesProcessed(state.iterations() * logEntryJson.size());
+}
+
+void BM_DecodeRdeCommand(benchmark::State& state)
+{
+    const StorerKind kind = static_cast<StorerKind>(state.range(0));
+    StorerFixture storer(kind);
+    state.SetLabel(storerLabel(kind));
+    std::unique_ptr<ExternalStorerInterface> handlerStorer = storer.release();
+    if (kind != nullStorer)
+    {
+        handlerStorer =
+            std::make_unique<LogEntryStorer>(std::move(handlerStorer));
+    }
+    RdeCommandHandler handler(std::move(handlerStorer));
+    handler.decodeRdeCommand(mRcvInput0StartAndEnd,
+                             RdeCommandType::RdeMultiPartReceiveResponse);
+    handler.decodeRdeCommand(mRcvDummyAnnotation,
+                             RdeCommandType::RdeMultiPartReceiveResponse);
+
+    const uint64_t allocationsBefore = getNumAllocations();
+    for (auto _ : state)
+    {
+        if (handler.decodeRdeCommand(mInitOp,
+                                     RdeCommandType::RdeOperationInitRequest) !=
+            RdeDecodeStatus::RdeOk)
+        {
+            state.SkipWithError("Decoding the RDE command failed");
+            return;
+        }
+        storer.runPosted();
+    }
+    setAllocationCounter(state, getNumAllocations() - allocationsBefore);
+    state.SetItemsProcessed(state.iterations());
+}
+
+void storerArgs(benchmark::internal::Benchmark* b)
+{
+    b->ArgName("storer");
+    for (int64_t kind : {nullStorer, tmpfsStorer, diskStorer})
+    {
+        b->Arg(kind);
+    }
+}
+
+BENCHMARK(BM_DictionaryTransfer);
+BENCHMARK(BM_DictionaryLookup);
+BENCHMARK(BM_BejDecode);
+BENCHMARK(BM_PublishJson)->Apply(storerArgs);
+BENCHMARK(BM_DecodeRdeCommand)->Apply(storerArgs);
+
+} // namespace
+} // namespace rde
+} // namespace bios_bmc_smm_error_logger
+
+BENCHMARK_MAIN();
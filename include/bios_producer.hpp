@@ -0,0 +1,111 @@
+#pragma once
+
+#include "buffer.hpp"
+#include "data_interface.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace bios_bmc_smm_error_logger
+{
+
+/**
+ * Counters for BiosProducer
+ */
+struct BiosProducerStats
+{
+    // Entries that made it into the queue, and their size with headers
+    uint64_t entriesWritten;
+    uint64_t bytesWritten;
+    // Entries that did not fit into the queue. They still use up a sequence
+    // ID, the BMC sees them as a gap.
+    uint64_t entriesDropped;
+    // Times the overflow flag was toggled for the BMC to acknowledge
+    uint64_t overflowsSignaled;
+    // UE logs written to the reserved region, and dropped because the BMC had
+    // not read the previous one yet
+    uint64_t ueLogsWritten;
+    uint64_t ueLogsDropped;
+    // Times the BMC reinitialized the buffer under the producer
+    uint64_t reattaches;
+};
+
+/**
+ * The BIOS side of the circular buffer, as described in the design doc.
+ *
+ * Writes checksummed entries into the queue, wrapping around at the end,
+ * publishes them by moving biosWritePtr, and toggles the overflow flag when
+ * an entry does not fit. Only ever writes the BIOS owned fields of the
+ * header. Used to simulate BIOS against a real BufferImpl.
+ */
+class BiosProducer
+{
+  public:
+    /**
+     * @param[in] dataInterface - the shared buffer, the BMC side needs to
+     * have initialized it before attach is called
+     */
+    explicit BiosProducer(DataInterface& dataInterface);
+
+    /** @brief Check whether the BMC has initialized the buffer yet
+     *  @return true if the header has a queue
+     */
+    bool isBufferInitialized();
+
+    /** @brief Pick up the queue layout from the header the BMC initialized.
+     *  Called by writeEntry when the BMC reinitialized the buffer.
+     */
+    void attach();
+
+    /** @brief Append an entry to the queue, or drop it and signal an overflow
+     *  if it does not fit
+     *
+     *  @param[in] rdeCommandType - command type for the entry header
+     *  @param[in] payload - the entry
+     *  @return true if the entry was written
+     */
+    bool writeEntry(uint8_t rdeCommandType, std::span<const uint8_t> payload);
+
+    /** @brief Write a log to the UE region and toggle the ueSwitch flag
+     *
+     *  @param[in] ueLog - the log, at most the size of the UE region
+     *  @return false if the BMC had not read the previous UE log yet
+     */
+    bool writeUeLog(std::span<const uint8_t> ueLog);
+
+    /** @brief Bytes that can be written before the queue is full */
+    size_t getQueueFreeBytes();
+
+    /** @brief Get the counters since construction
+     *  @return BiosProducerStats
+     */
+    BiosProducerStats getStats() const
+    {
+        return stats;
+    }
+
+  private:
+    /** @brief Read the header the BMC writes to, and re-attach if the BMC
+     *  reinitialized the buffer
+     *  @return the header
+     */
+    struct CircularBufferHeader readHeader();
+
+    /** @brief Write biosFlags and biosWritePtr. They share an aligned word,
+     *  which the BMC reads in one access.
+     */
+    void publish();
+
+    DataInterface& dataInterface;
+    uint32_t queueOffset = 0;
+    uint32_t maxOffset = 0;
+    uint16_t ueRegionSize = 0;
+
+    uint32_t biosFlags = 0;
+    uint32_t writePtr = 0;
+    uint16_t nextSequenceId = 0;
+    BiosProducerStats stats = {};
+};
+
+} // namespace bios_bmc_smm_error_logger
@@ -3,10 +3,14 @@
 #include "pci_handler.hpp"
 
 #include <boost/endian/arithmetic.hpp>
+#include <stdplus/function_view.hpp>
 
 #include <array>
 #include <cstdint>
 #include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
 #include <tuple>
 
 namespace bios_bmc_smm_error_logger
@@ -22,6 +26,12 @@ using boost::endian::little_uint64_t;
 // EntryPair.second = Error entry in vector of bytes
 using EntryPair = std::pair<struct QueueEntryHeader, std::vector<uint8_t>>;
 
+// Called with each valid entry by BufferInterface::drain. The entry span
+// points into the buffer's own copy of the queue and is only valid for the
+// duration of the call.
+using EntryVisitor = stdplus::function_view<void(
+    const struct QueueEntryHeader&, std::span<const uint8_t>)>;
+
 enum class BufferFlags : uint32_t
 {
     ueSwitch = 1 << 0,
@@ -83,6 +93,86 @@ struct QueueEntryHeader
 static_assert(sizeof(QueueEntryHeader) == 0x6,
               "Size of QueueEntryHeader struct is incorrect.");
 
+/**
+ * When BufferImpl writes the position of consumed entries back to bmcReadPtr
+ */
+enum class ReadPtrCommitMode
+{
+    // After every consumed entry
+    perEntry,
+    // After every `threshold` consumed entries
+    everyNEntries,
+    // Once `threshold` or more bytes were consumed since the last commit
+    everyNBytes,
+    // Only when commitReadPtr is called, i.e. once per drained batch
+    perBatch,
+};
+
+struct ReadPtrCommitPolicy
+{
+    ReadPtrCommitMode mode = ReadPtrCommitMode::perBatch;
+    uint32_t threshold = 0;
+};
+
+/**
+ * Counters for the corruption BufferImpl recovered from without reinitializing
+ * the buffer, since BufferImpl was created
+ */
+struct RecoveryStats
+{
+    // Number of times the queue had to be resynchronized
+    uint64_t resyncs = 0;
+    // Number of queue bytes skipped over while resynchronizing
+    uint64_t bytesSkipped = 0;
+    // Number of resyncs that found no valid entry and skipped to biosWritePtr
+    uint64_t writePtrFallbacks = 0;
+};
+
+/**
+ * Counters for the sequence IDs of the consumed entries, since BufferImpl was
+ * created. BIOS numbers entries consecutively, so any jump in the sequence ID
+ * is a log that never made it to the BMC.
+ */
+struct SequenceStats
+{
+    // Number of entries consumed
+    uint64_t entries = 0;
+    // Number of times the sequence ID jumped ahead
+    uint64_t gaps = 0;
+    // Number of sequence IDs skipped over by those jumps
+    uint64_t entriesLost = 0;
+    // Part of entriesLost found at the first gap after an overflow
+    uint64_t entriesLostToOverflow = 0;
+    // Part of entriesLost found right after corrupt bytes were skipped
+    uint64_t entriesLostToResync = 0;
+    // Entries with the same sequence ID as the previous entry
+    uint64_t duplicates = 0;
+    // Entries with an older sequence ID than the previous entry
+    uint64_t reordered = 0;
+    // Jumps too far back to be reordering, e.g. after BIOS restarted
+    uint64_t restarts = 0;
+    // Number of overflows acknowledged
+    uint64_t overflows = 0;
+};
+
+/**
+ * Work pending in the buffer, found from a single read of the buffer header
+ */
+struct PollResult
+{
+    // An unread Uncorrectable Error (UE) log is present in the reserved region
+    bool ueLogPending = false;
+    // BIOS reported an overflow, which has now been acknowledged
+    bool overflowAcknowledged = false;
+    // Number of unread bytes in the error log queue
+    uint32_t queueBytesPending = 0;
+
+    bool idle() const
+    {
+        return !ueLogPending && !overflowAcknowledged && queueBytesPending == 0;
+    }
+};
+
 /**
  * An interface class for the buffer helper APIs
  */
@@ -146,6 +236,16 @@ class BufferInterface
      */
     virtual std::vector<uint8_t> wraparoundRead(const uint32_t relativeOffset,
                                                 const uint32_t length) = 0;
+
+    /**
+     * Same as wraparoundRead, but reads into caller-owned storage
+     *
+     * @param[in] relativeOffset - offset relative the "Error Log
+     *  Queue region" = (sizeof(CircularBufferHeader) + UE reserved region)
+     * @param[out] bytes - destination of the read, bytes.size() bytes are read
+     */
+    virtual void wraparoundReadInto(const uint32_t relativeOffset,
+                                    std::span<uint8_t> bytes) = 0;
     /**
      * Read the entry header from shared buffer from the read pointer
      *
@@ -168,6 +268,77 @@ class BufferInterface
      */
     virtual std::vector<EntryPair> readErrorLogs() = 0;
 
+    /**
+     * Read the buffer header once, acknowledge any overflow and report what
+     * work is pending. This is meant to be called once per read loop tick,
+     * followed by readPendingUeLog / readPendingErrorLogs only when the result
+     * says there is something to read.
+     *
+     * @return the work pending in the buffer
+     */
+    virtual PollResult poll() = 0;
+
+    /**
+     * Same as readUeLogFromReservedRegion, but uses the cached buffer header
+     * instead of reading it again
+     *
+     * @return the UE log, empty if there is no unread UE log
+     */
+    virtual std::vector<uint8_t> readPendingUeLog() = 0;
+
+    /**
+     * Same as readErrorLogs, but uses the cached buffer header instead of
+     * reading it again. The read pointer is not moved: each returned entry
+     * must be passed to markEntryConsumed once it has been handed downstream,
+     * followed by commitReadPtr at the end of the batch.
+     *
+     * A corrupt entry does not fail the whole batch. It is skipped by scanning
+     * forward for the next valid entry, or up to biosWritePtr if there is
+     * none, see getRecoveryStats.
+     *
+     * @return vector of EntryPair which consists of entry header and entry
+     */
+    virtual std::vector<EntryPair> readPendingErrorLogs() = 0;
+
+    /**
+     * Same as readPendingErrorLogs, but hands each valid entry to the visitor
+     * as it is parsed instead of copying it into an EntryPair. Each entry is
+     * marked as consumed once the visitor returns, and the read pointer is
+     * committed at the end. If the visitor throws, the entries consumed so far
+     * are committed and the exception is rethrown, the entry it threw on will
+     * be read again.
+     *
+     * @param[in] visitor - called with every valid entry, in queue order
+     * @return the number of entries drained
+     */
+    virtual size_t drain(EntryVisitor visitor) = 0;
+
+    /**
+     * Mark the oldest entry returned by readPendingErrorLogs that was not
+     * marked yet as consumed. Depending on the ReadPtrCommitPolicy, this may
+     * write the new read pointer to the buffer.
+     */
+    virtual void markEntryConsumed() = 0;
+
+    /**
+     * Write the position after the last consumed entry to the read pointer,
+     * if it has not been written yet
+     */
+    virtual void commitReadPtr() = 0;
+
+    /**
+     * Getter API for the corruption recovered from so far
+     * @return recovery counters
+     */
+    virtual RecoveryStats getRecoveryStats() const = 0;
+
+    /**
+     * Getter API for the sequence ID gaps, duplicates and reordering seen in
+     * the consumed entries so far
+     * @return sequence ID counters
+     */
+    virtual SequenceStats getSequenceStats() const = 0;
+
     /**
      * Get max offset for the queue
      *
@@ -190,8 +361,13 @@ class BufferImpl : public BufferInterface
   public:
     /** @brief Constructor for BufferImpl
      *  @param[in] dataInterface     - DataInterface for this object
+     *  @param[in] commitPolicy      - when consumed entries are committed to
+     *                                 the read pointer
+     *  @throws std::invalid_argument if the policy counts entries or bytes
+     *          with a threshold of 0
      */
-    explicit BufferImpl(std::unique_ptr<DataInterface> dataInterface);
+    explicit BufferImpl(std::unique_ptr<DataInterface> dataInterface,
+                        ReadPtrCommitPolicy commitPolicy = {});
     void initialize(uint32_t bmcInterfaceVersion, uint16_t queueSize,
                     uint16_t ueRegionSize,
                     const std::array<uint32_t, 4>& magicNumber) override;
@@ -203,9 +379,19 @@ class BufferImpl : public BufferInterface
     void updateBmcFlags(const uint32_t newBmcFlag) override;
     std::vector<uint8_t> wraparoundRead(const uint32_t relativeOffset,
                                         const uint32_t length) override;
+    void wraparoundReadInto(const uint32_t relativeOffset,
+                            std::span<uint8_t> bytes) override;
     struct QueueEntryHeader readEntryHeader() override;
     EntryPair readEntry() override;
     std::vector<EntryPair> readErrorLogs() override;
+    PollResult poll() override;
+    std::vector<uint8_t> readPendingUeLog() override;
+    std::vector<EntryPair> readPendingErrorLogs() override;
+    size_t drain(EntryVisitor visitor) override;
+    void markEntryConsumed() override;
+    void commitReadPtr() override;
+    RecoveryStats getRecoveryStats() const override;
+    SequenceStats getSequenceStats() const override;
     size_t getMaxOffset() override;
     size_t getQueueOffset() override;
 
@@ -214,10 +400,127 @@ class BufferImpl : public BufferInterface
      *  @param[in] entry     - Span to calculate the checksum on
      *  @return calculated checksum
      */
-    uint8_t calculateChecksum(std::span<uint8_t> entry);
+    uint8_t calculateChecksum(std::span<const uint8_t> entry);
+
+    /** @brief Read a range of the error log queue, splitting it at the end of
+     *  the queue. Does not touch the read pointer.
+     *  @param[in] relativeOffset - offset relative to the error log queue
+     *  @param[out] bytes - destination of the read, bytes.size() bytes are read
+     */
+    void readQueueRange(const uint32_t relativeOffset,
+                        std::span<uint8_t> bytes);
+
+    /** @brief Validate the queue entry at the start of a span of queue bytes
+     *  @param[in] bytes - queue bytes starting with a QueueEntryHeader
+     *  @return the entry header, the entry itself follows the header in bytes
+     */
+    struct QueueEntryHeader parseEntry(std::span<const uint8_t> bytes);
+
+    /** @brief Read the pending part of the queue using the cached buffer
+     *  header and call visitor with each valid entry, skipping over corrupt
+     *  ones. Every entry is added to pendingEntries before the visitor is
+     *  called.
+     *  @param[in] visitor - called with every valid entry, in queue order
+     */
+    void forEachPendingEntry(EntryVisitor visitor);
+
+    /** @brief Same checks as parseEntry, without the error reporting. Used
+     *  when scanning for the next entry, where most offsets are invalid.
+     *  @param[in] bytes - queue bytes starting with a QueueEntryHeader
+     *  @return the entry header if a valid entry starts at bytes
+     */
+    std::optional<struct QueueEntryHeader>
+        checkEntry(std::span<const uint8_t> bytes);
+
+    /** @brief Find the first offset after a corrupt entry where a valid entry
+     *  starts. A candidate must have a sequence ID that fits the number of
+     *  bytes skipped, and must be followed by either biosWritePtr or another
+     *  valid entry with the next sequence ID.
+     *  @param[in] pendingBytes - all the pending bytes of the queue
+     *  @param[in] corruptOffset - offset of the corrupt entry in pendingBytes
+     *  @param[in] prevSequenceId - sequence ID of the valid entry before the
+     *                              corrupt one, if known
+     *  @return offset of the next valid entry in pendingBytes, if any
+     */
+    std::optional<size_t> findNextEntry(std::span<const uint8_t> pendingBytes,
+                                        size_t corruptOffset,
+                                        std::optional<uint16_t> prevSequenceId);
+
+    /** @brief Skip over a corrupt entry, either to the next valid entry or to
+     *  the end of the pending bytes (biosWritePtr)
+     *  @param[in] pendingBytes - all the pending bytes of the queue
+     *  @param[in] corruptOffset - offset of the corrupt entry in pendingBytes
+     *  @param[in] prevSequenceId - sequence ID of the valid entry before the
+     *                              corrupt one, if known
+     *  @param[in] reason - why the entry at corruptOffset is corrupt
+     *  @return number of bytes skipped
+     */
+    size_t resync(std::span<const uint8_t> pendingBytes, size_t corruptOffset,
+                  std::optional<uint16_t> prevSequenceId,
+                  std::string_view reason);
+
+    /** @brief Check the sequence ID of a consumed entry against the previous
+     *  one and update sequenceStats
+     *  @param[in] sequenceId - sequence ID of the consumed entry
+     *  @param[in] afterResync - corrupt bytes were skipped before the entry
+     */
+    void trackSequenceId(uint16_t sequenceId, bool afterResync);
+
+    /** @brief Forget about the entries of the previous batch
+     *  @param[in] readPtr - read pointer the next batch starts from
+     */
+    void resetPendingEntries(uint32_t readPtr);
+
+    /** @brief Check the cached header for an unread UE log
+     *  @return true if the UE region holds a log the BMC has not read yet
+     */
+    bool isUeLogPending() const;
+
+    /** @brief Acknowledge an overflow reported in the cached header, if any
+     *  @return true if an overflow was acknowledged
+     */
+    bool acknowledgeOverflow();
+
+    /** @brief Validate the cached read and write pointers
+     *  @return the number of unread bytes in the error log queue
+     */
+    size_t getQueueBytesPending();
 
     std::unique_ptr<DataInterface> dataInterface;
     struct CircularBufferHeader cachedBufferHeader = {};
+    // Local copy of the pending part of the error log queue. Sized once to the
+    // queue size and reused so that draining the queue does not allocate.
+    std::vector<uint8_t> queueShadow;
+
+    ReadPtrCommitPolicy commitPolicy;
+    struct PendingEntry
+    {
+        // Read pointer value after the entry
+        uint32_t end;
+        uint16_t sequenceId;
+        // Corrupt bytes were skipped right before the entry
+        bool afterResync;
+    };
+    // Entries returned by readPendingErrorLogs, in queue order
+    std::vector<PendingEntry> pendingEntries;
+    size_t numEntriesConsumed = 0;
+    // Read pointer value after the last consumed entry
+    uint32_t consumedReadPtr = 0;
+    // Read pointer value after the whole batch, including any corrupt bytes
+    // skipped after the last entry
+    uint32_t batchEndReadPtr = 0;
+    uint32_t entriesSinceCommit = 0;
+    uint32_t bytesSinceCommit = 0;
+
+    // Sequence ID of the last consumed entry, used to validate resync
+    // candidates and detect gaps
+    std::optional<uint16_t> lastSequenceId;
+    // An overflow was acknowledged and the gap it caused was not seen yet
+    bool overflowGapPending = false;
+    // Corrupt bytes were skipped and no entry was found after them yet
+    bool resyncGapPending = false;
+    RecoveryStats recoveryStats;
+    SequenceStats sequenceStats;
 };
 
 } // namespace bios_bmc_smm_error_logger
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+namespace bios_bmc_smm_error_logger
+{
+
+/**
+ * Implementations of the XOR checksum kernels, from the slowest to the fastest
+ */
+enum class ChecksumKernel
+{
+    // 64-bit words, any CPU
+    portable,
+    // 128-bit vectors, x86 with SSE2
+    sse2,
+    // 256-bit vectors, x86 with AVX2, detected at runtime
+    avx2,
+    // 128-bit vectors, ARM with NEON
+    neon,
+};
+
+/**
+ * Check if a kernel was built in and can run on this CPU
+ *
+ * @param[in] kernel - kernel to check
+ * @return true if the kernel can be used
+ */
+bool isChecksumKernelSupported(ChecksumKernel kernel);
+
+/**
+ * The fastest kernel supported on this CPU, picked once at runtime. Used by
+ * all the functions below that do not take a kernel.
+ *
+ * @return the kernel in use
+ */
+ChecksumKernel bestChecksumKernel();
+
+/**
+ * XOR all the bytes together, as done for the queue entry checksum
+ *
+ * @param[in] bytes - bytes to checksum
+ * @return XOR of all the bytes
+ */
+uint8_t xorChecksum(std::span<const uint8_t> bytes);
+uint8_t xorChecksum(ChecksumKernel kernel, std::span<const uint8_t> bytes);
+
+} // namespace bios_bmc_smm_error_logger
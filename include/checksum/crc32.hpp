@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace bios_bmc_smm_error_logger
+{
+
+/**
+ * Initial value of a running CRC-32 (IEEE 802.3)
+ */
+constexpr uint32_t crc32Init = 0xFFFFFFFF;
+
+/**
+ * Implementations of the CRC-32, from the slowest to the fastest
+ */
+enum class Crc32Kernel
+{
+    // Slicing-by-8 tables, any CPU
+    slicingBy8,
+    // CRC32 instructions, AArch64 with the CRC extension, detected at runtime
+    armv8,
+    // Carry-less multiplication folding, x86 with PCLMULQDQ and SSE4.1,
+    // detected at runtime
+    pclmul,
+};
+
+/**
+ * Check if a kernel was built in and can run on this CPU
+ *
+ * @param[in] kernel - kernel to check
+ * @return true if the kernel can be used
+ */
+bool isCrc32KernelSupported(Crc32Kernel kernel);
+
+/**
+ * The fastest kernel supported on this CPU, picked once at runtime. Used by
+ * crc32Update when no kernel is given.
+ *
+ * @return the kernel in use
+ */
+Crc32Kernel bestCrc32Kernel();
+
+/**
+ * Advance a running CRC-32 (IEEE 802.3) over more bytes. The running value
+ * starts at crc32Init and the final CRC is the running value XOR 0xFFFFFFFF,
+ * see crc32Final.
+ *
+ * @param[in] crc - running CRC-32
+ * @param[in] bytes - bytes to add to the CRC
+ * @return the updated running CRC-32
+ */
+uint32_t crc32Update(uint32_t crc, std::span<const uint8_t> bytes);
+uint32_t crc32Update(Crc32Kernel kernel, uint32_t crc,
+                     std::span<const uint8_t> bytes);
+
+/**
+ * Append bytes to a vector and advance a running CRC-32 over them in the same
+ * pass. The bytes are processed in chunks small enough to stay in L1 between
+ * the copy and the CRC, and dest is grown without zero filling it first.
+ *
+ * @param[in] crc - running CRC-32
+ * @param[in] bytes - bytes to append and add to the CRC
+ * @param[in,out] dest - vector the bytes are appended to
+ * @return the updated running CRC-32
+ */
+uint32_t crc32Append(uint32_t crc, std::span<const uint8_t> bytes,
+                     std::vector<uint8_t>& dest);
+
+/**
+ * @param[in] crc - running CRC-32
+ * @return the final CRC-32 value
+ */
+constexpr uint32_t crc32Final(uint32_t crc)
+{
+    return crc ^ 0xFFFFFFFF;
+}
+
+} // namespace bios_bmc_smm_error_logger
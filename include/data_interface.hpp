@@ -1,5 +1,7 @@
 #pragma once
 
+#include "doorbell.hpp"
+
 #include <cstdint>
 #include <span>
 #include <vector>
@@ -25,6 +27,17 @@ class DataInterface
     virtual std::vector<uint8_t> read(const uint32_t offset,
                                       const uint32_t length) = 0;
 
+    /**
+     * Read bytes from shared buffer into caller-owned storage (blocking call).
+     *
+     * @param[in] offset - offset to read from relative to MMIO space
+     * @param[out] bytes - destination of the read, bytes.size() bytes are
+     *  requested
+     * @return the number of bytes read
+     */
+    virtual uint32_t readInto(const uint32_t offset,
+                              std::span<uint8_t> bytes) = 0;
+
     /**
      * Write bytes to shared buffer.
      *
@@ -41,6 +54,17 @@ class DataInterface
      * @return return Memory Region size allocated
      */
     virtual uint32_t getMemoryRegionSize() = 0;
+
+    /**
+     * Getter for the doorbell BIOS rings after writing to the shared buffer.
+     * Transports without one are polled.
+     *
+     * @return the doorbell, owned by the DataInterface, or nullptr
+     */
+    virtual Doorbell* getDoorbell()
+    {
+        return nullptr;
+    }
 };
 
 } // namespace bios_bmc_smm_error_logger
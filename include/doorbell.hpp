@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdplus/fd/managed.hpp>
+
+#include <cstdint>
+#include <string>
+
+namespace bios_bmc_smm_error_logger
+{
+
+/**
+ * A file descriptor that becomes readable when BIOS has written to the
+ * buffer, so the daemon can sleep on it instead of polling.
+ */
+class Doorbell
+{
+  public:
+    virtual ~Doorbell() = default;
+
+    /**
+     * Get the file descriptor to wait on for readability. It stays owned by
+     * the Doorbell.
+     *
+     * @return the file descriptor
+     */
+    virtual int getFd() const = 0;
+
+    /**
+     * Consume the pending rings and re-arm the doorbell, must be called after
+     * every wakeup. Rings that happened since the last call are coalesced.
+     *
+     * @return the number of rings since the last call, 0 on a spurious wakeup
+     */
+    virtual uint64_t acknowledge() = 0;
+};
+
+/**
+ * Doorbell backed by an eventfd. Stands in for a hardware doorbell where
+ * there is none, e.g. in tests, benchmarks and simulators that play the BIOS
+ * side and call ring.
+ */
+class EventFdDoorbell : public Doorbell
+{
+  public:
+    EventFdDoorbell();
+
+    int getFd() const override;
+    uint64_t acknowledge() override;
+
+    /** @brief Ring the doorbell, safe to call from any thread */
+    void ring();
+
+  private:
+    stdplus::ManagedFd fd;
+};
+
+/**
+ * Doorbell backed by a UIO device whose interrupt is raised by BIOS, e.g. a
+ * doorbell register or an eSPI virtual wire routed to a GPIO interrupt.
+ */
+class UioDoorbell : public Doorbell
+{
+  public:
+    /**
+     * @param[in] devicePath - UIO device, e.g. /dev/uio0
+     */
+    explicit UioDoorbell(const std::string& devicePath);
+
+    int getFd() const override;
+    uint64_t acknowledge() override;
+
+  private:
+    /** @brief Unmask the interrupt, UIO masks it every time it fires */
+    void enableInterrupt();
+
+    stdplus::ManagedFd fd;
+    // Interrupt count UIO reported on the last read
+    uint32_t lastEventCount = 0;
+};
+
+} // namespace bios_bmc_smm_error_logger
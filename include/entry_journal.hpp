@@ -0,0 +1,184 @@
+#pragma once
+
+#include "buffer.hpp"
+
+#include <stdplus/fd/managed.hpp>
+#include <stdplus/function_view.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace bios_bmc_smm_error_logger
+{
+
+/*
+ * Capture journal layout, all fields little endian:
+ *
+ *   JournalFileHeader
+ *   JournalRecordHeader, payload
+ *   JournalRecordHeader, payload
+ *   ...
+ *
+ * Records are only ever appended. A record cut short by a crash can only be
+ * the last one, readers stop there. EntryJournalWriter drops it when it opens
+ * the journal again, before appending anything.
+ */
+
+struct JournalFileHeader
+{
+    std::array<uint8_t, 8> magic; // Offset 0x0
+    little_uint32_t version;      // Offset 0x8
+    little_uint32_t reserved;     // Offset 0xc
+};
+static_assert(sizeof(JournalFileHeader) == 0x10,
+              "Size of JournalFileHeader struct is incorrect.");
+
+constexpr std::array<uint8_t, 8> journalMagic = {'B', 'B', 'S', 'M',
+                                                 'J', 'R', 'N', 'L'};
+constexpr uint32_t journalVersion = 1;
+
+/**
+ * What a journal record holds
+ */
+enum class JournalRecordKind : uint8_t
+{
+    // An entry from the error log queue, dictionary transfers included
+    queueEntry = 0,
+    // A log from the UE reserved region, entryHeader is all 0s
+    ueLog = 1,
+};
+
+struct JournalRecordHeader
+{
+    // When the BMC read the record, nanoseconds since the epoch
+    little_uint64_t timestampNs;         // Offset 0x0
+    little_uint32_t payloadSize;         // Offset 0x8
+    uint8_t kind;                        // Offset 0xc
+    uint8_t reserved;                    // Offset 0xd
+    struct QueueEntryHeader entryHeader; // Offset 0xe
+};
+static_assert(sizeof(JournalRecordHeader) == 0x14,
+              "Size of JournalRecordHeader struct is incorrect.");
+
+/**
+ * A record read back from a journal, pointing into the journal's mapping
+ */
+struct JournalRecord
+{
+    std::chrono::system_clock::time_point timestamp;
+    JournalRecordKind kind;
+    struct QueueEntryHeader entryHeader;
+    std::span<const uint8_t> payload;
+};
+
+/**
+ * Appends validated entries to a capture journal, to reproduce the exact
+ * byte stream BIOS produced offline.
+ *
+ * Records are collected in memory and written with a single write on one
+ * O_APPEND fd once the buffer fills up or flush is called. Safe to use from
+ * several threads, e.g. the decode worker appending and the read loop
+ * flushing.
+ */
+class EntryJournalWriter
+{
+  public:
+    /**
+     * Open the journal, creating it if needed. Records are appended to an
+     * existing journal, after cutting off a record left torn by a crash.
+     *
+     * @param[in] path - path of the journal
+     * @param[in] bufferSize - bytes collected before they are written out
+     */
+    explicit EntryJournalWriter(const std::string& path,
+                                size_t bufferSize = 64 * 1024);
+
+    /** @brief Writes out what is still buffered */
+    ~EntryJournalWriter();
+
+    EntryJournalWriter(const EntryJournalWriter&) = delete;
+    EntryJournalWriter& operator=(const EntryJournalWriter&) = delete;
+
+    /** @brief Add an entry from the error log queue
+     *
+     *  @param[in] entryHeader - header of the entry, as read from the queue
+     *  @param[in] entry - the entry, without its header
+     */
+    void appendEntry(const struct QueueEntryHeader& entryHeader,
+                     std::span<const uint8_t> entry);
+
+    /** @brief Add a log from the UE reserved region
+     *
+     *  @param[in] ueLog - the log
+     */
+    void appendUeLog(std::span<const uint8_t> ueLog);
+
+    /** @brief Write out the buffered records */
+    void flush();
+
+    /** @brief Get the number of records appended since construction */
+    uint64_t getNumRecords() const;
+
+  private:
+    void append(JournalRecordKind kind,
+                const struct QueueEntryHeader& entryHeader,
+                std::span<const uint8_t> payload);
+
+    /** @brief Write out the buffer, the mutex must be held */
+    void writeBuffered();
+
+    stdplus::ManagedFd fd;
+    const size_t bufferSize;
+    mutable std::mutex mutex;
+    std::vector<uint8_t> buffer;
+    uint64_t numRecords = 0;
+};
+
+/**
+ * Reads the records of a capture journal back, in the order they were
+ * appended.
+ */
+class EntryJournalReader
+{
+  public:
+    using RecordVisitor = stdplus::function_view<void(const JournalRecord&)>;
+
+    /**
+     * Map the journal and check its header.
+     *
+     * @param[in] path - path of the journal
+     */
+    explicit EntryJournalReader(const std::string& path);
+    ~EntryJournalReader();
+
+    EntryJournalReader(const EntryJournalReader&) = delete;
+    EntryJournalReader& operator=(const EntryJournalReader&) = delete;
+
+    /** @brief Hand every complete record to the visitor. The payload spans
+     *  stay valid for the lifetime of the reader.
+     *
+     *  @param[in] visitor - called with each record, in journal order
+     *  @return the number of records visited
+     */
+    size_t forEach(RecordVisitor visitor) const;
+
+    /** @brief Whether the journal ends in a record cut short, e.g. by a
+     *  crash while it was written
+     */
+    bool isTruncated() const;
+
+    /** @brief Get the size of the journal in bytes */
+    size_t size() const;
+
+  private:
+    const uint8_t* data = nullptr;
+    size_t mappedSize = 0;
+};
+
+} // namespace bios_bmc_smm_error_logger
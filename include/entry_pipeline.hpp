@@ -0,0 +1,124 @@
+#pragma once
+
+#include "buffer.hpp"
+#include "spsc_ring.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace bios_bmc_smm_error_logger
+{
+
+/**
+ * Counters for the decode queue between the drain and the decode stage
+ */
+struct PipelineStats
+{
+    // Entries drained from the buffer into the decode queue
+    uint64_t entriesQueued;
+    // Entries the decode stage is done with
+    uint64_t entriesDecoded;
+    // Times the decode stage threw instead of returning
+    uint64_t decodeErrors;
+    // Times draining had to stop because the decode queue was full. Entries
+    // that did not fit stay in the buffer until the next drain.
+    uint64_t queueFullStalls;
+    // Most entries ever waiting in the decode queue at once
+    uint64_t maxQueueDepth;
+};
+
+/**
+ * Two stage pipeline for the entries in the BIOS queue.
+ *
+ * The drain stage runs on the caller's thread. It copies entries out of the
+ * buffer into a bounded single-producer/single-consumer ring, and lets the
+ * buffer commit bmcReadPtr right away so BIOS gets the space back. The decode
+ * stage runs on a worker thread owned by the pipeline and hands every entry
+ * to the decode function, so a slow decode or a slow storage backend does not
+ * hold up freeing space in the BIOS queue.
+ *
+ * The decode function runs on the worker thread. Anything it touches that is
+ * also used from the drain side (D-Bus objects, the buffer) must be posted
+ * back to the thread that owns it.
+ */
+class EntryPipeline
+{
+  public:
+    using DecodeFunction = std::function<void(const struct QueueEntryHeader&,
+                                              std::span<const uint8_t>)>;
+    using BatchDoneFunction = std::function<void()>;
+
+    /**
+     * @param[in] decode - called on the worker thread with each entry
+     * @param[in] queueDepth - number of entries the decode queue can hold.
+     * Each slot keeps the memory of the largest entry that passed through it,
+     * so queueing stops allocating once the queue has been around once.
+     * @param[in] batchDone - called on the worker thread after decoding the
+     * last entry queued so far, e.g. to commit what the entries of a drain
+     * produced together. waitIdle returns only after it.
+     */
+    EntryPipeline(DecodeFunction decode, size_t queueDepth,
+                  BatchDoneFunction batchDone = nullptr);
+
+    /** @brief Stops the worker once it is done with the entries it has */
+    ~EntryPipeline();
+
+    EntryPipeline(const EntryPipeline&) = delete;
+    EntryPipeline& operator=(const EntryPipeline&) = delete;
+
+    /** @brief Drain stage. Move the pending entries of the buffer into the
+     *  decode queue, and commit them as consumed. Must always be called from
+     *  the same thread.
+     *
+     *  The buffer header needs to have been read with poll first, same as for
+     *  BufferInterface::drain.
+     *
+     *  @param[in] buffer - buffer to drain
+     *  @return the number of entries queued
+     */
+    size_t drain(BufferInterface& buffer);
+
+    /** @brief Block until the decode stage is done with every entry queued so
+     *  far. Useful before touching state shared with the decode function from
+     *  the drain side.
+     */
+    void waitIdle() const;
+
+    /** @brief Get the pipeline counters since construction
+     *  @return PipelineStats
+     */
+    PipelineStats getStats() const;
+
+  private:
+    struct Slot
+    {
+        struct QueueEntryHeader entryHeader;
+        std::vector<uint8_t> entry;
+    };
+
+    void decodeLoop(std::stop_token stopToken);
+
+    DecodeFunction decode;
+    BatchDoneFunction batchDone;
+    SpscRing<Slot> ring;
+
+    // Bumped by the drain stage after queueing entries and on shutdown, the
+    // worker sleeps on it while the ring is empty
+    std::atomic<uint32_t> doorbell = 0;
+
+    std::atomic<uint64_t> decodeErrors = 0;
+    // Only touched by the drain stage
+    std::atomic<uint64_t> queueFullStalls = 0;
+    std::atomic<uint64_t> maxQueueDepth = 0;
+    bool stalled = false;
+
+    // Last member, so the worker stops before the rest is destroyed
+    std::jthread worker;
+};
+
+} // namespace bios_bmc_smm_error_logger
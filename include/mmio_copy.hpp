@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+namespace bios_bmc_smm_error_logger
+{
+
+/**
+ * Copy bytes out of a memory-mapped device region.
+ *
+ * Every byte is read through a volatile access so that the device is always
+ * accessed directly. The bulk of the copy is done with the widest naturally
+ * aligned access the platform supports (32-bit or 64-bit), and only the
+ * unaligned head and the tail are copied one byte at a time.
+ *
+ * @param[in] src - start of the memory-mapped source
+ * @param[out] dest - destination buffer, its size is the number of bytes copied
+ */
+void copyFromMmio(const volatile uint8_t* src, std::span<uint8_t> dest);
+
+/**
+ * Copy bytes into a memory-mapped device region.
+ *
+ * Uses the same access pattern as copyFromMmio.
+ *
+ * @param[in] dest - start of the memory-mapped destination
+ * @param[in] src - bytes to write
+ */
+void copyToMmio(volatile uint8_t* dest, std::span<const uint8_t> src);
+
+} // namespace bios_bmc_smm_error_logger
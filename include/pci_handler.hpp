@@ -20,19 +20,31 @@ namespace bios_bmc_smm_error_logger
 class PciDataHandler : public DataInterface
 {
   public:
+    /**
+     * @param[in] regionAddress - physical address of the shared buffer
+     * @param[in] regionSize - size of the shared buffer
+     * @param[in] fd - fd to map the shared buffer from, e.g. /dev/mem
+     * @param[in] doorbell - doorbell BIOS rings after writing to the buffer,
+     * nullptr if there is none
+     */
     explicit PciDataHandler(uint32_t regionAddress, size_t regionSize,
-                            std::unique_ptr<stdplus::fd::Fd> fd);
+                            std::unique_ptr<stdplus::fd::Fd> fd,
+                            std::unique_ptr<Doorbell> doorbell = nullptr);
 
     std::vector<uint8_t> read(uint32_t offset, uint32_t length) override;
+    uint32_t readInto(const uint32_t offset,
+                      std::span<uint8_t> bytes) override;
     uint32_t write(const uint32_t offset,
                    const std::span<const uint8_t> bytes) override;
     uint32_t getMemoryRegionSize() override;
+    Doorbell* getDoorbell() override;
 
   private:
     uint32_t regionSize;
 
     std::unique_ptr<stdplus::fd::Fd> fd;
     stdplus::fd::MMap mmap;
+    std::unique_ptr<Doorbell> doorbell;
 };
 
 } // namespace bios_bmc_smm_error_logger
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace bios_bmc_smm_error_logger
+{
+
+/**
+ * Limits for PollScheduler
+ */
+struct PollSchedulerConfig
+{
+    // Interval used right after the queue was found idle
+    std::chrono::milliseconds minInterval;
+    // The interval doubles on every idle poll, up to this
+    std::chrono::milliseconds maxInterval;
+};
+
+/**
+ * What the read loop saw on one poll
+ */
+struct PollActivity
+{
+    // Bytes that were pending in the queue when it was polled
+    size_t queueBytesPending;
+    // Size of the queue, used to report the fill level
+    size_t queueCapacity;
+    // Entries had to be left in the queue, e.g. because the decode stage was
+    // full. Polling again right away would only spin.
+    bool drainStalled;
+};
+
+/**
+ * Counters reported by PollScheduler
+ */
+struct PollSchedulerStats
+{
+    // Polls since construction
+    uint64_t wakeups;
+    // Poll rate over the last window of at least a second
+    double wakeupsPerSecond;
+    // Most bytes ever found pending in the queue, and the queue size at the
+    // time
+    size_t maxQueueFill;
+    size_t queueCapacity;
+};
+
+/**
+ * Decides when the read loop polls the buffer next.
+ *
+ * While BIOS is logging, the queue is polled again right away, until a poll
+ * finds it empty. After that the interval starts at minInterval and doubles
+ * on every idle poll up to maxInterval. Deadlines are absolute and advance
+ * from the previous deadline, not from when the previous poll finished, so
+ * processing time does not add up into drift. A poll that happens before its
+ * deadline, e.g. on a doorbell, schedules the next one from when it happened.
+ */
+class PollScheduler
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @param[in] config - interval limits
+     * @param[in] start - time of the first poll
+     */
+    PollScheduler(PollSchedulerConfig config, Clock::time_point start);
+
+    /** @brief Record a poll and compute when the next one should happen
+     *
+     *  @param[in] now - time the poll finished
+     *  @param[in] activity - what the poll found
+     *  @return deadline for the next poll, may be now or in the past if the
+     *  next poll should happen right away
+     */
+    Clock::time_point next(Clock::time_point now,
+                           const PollActivity& activity);
+
+    /** @brief Interval that will be used for the next idle poll */
+    std::chrono::milliseconds getInterval() const
+    {
+        return interval;
+    }
+
+    /** @brief Whether the last call to next backed off to maxInterval. Used
+     *  to report once at the end of a burst of activity.
+     */
+    bool burstEnded() const
+    {
+        return backedOff;
+    }
+
+    /** @brief Get the counters since construction
+     *  @return PollSchedulerStats
+     */
+    PollSchedulerStats getStats() const;
+
+  private:
+    PollSchedulerConfig config;
+    std::chrono::milliseconds interval;
+    Clock::time_point deadline;
+    bool backedOff = false;
+
+    uint64_t wakeups = 0;
+    Clock::time_point windowStart;
+    uint64_t windowWakeups = 0;
+    double wakeupsPerSecond = 0;
+    size_t maxQueueFill = 0;
+    size_t queueCapacity = 0;
+};
+
+} // namespace bios_bmc_smm_error_logger
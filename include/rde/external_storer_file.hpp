@@ -1,14 +1,27 @@
 #pragma once
 
 #include "external_storer_interface.hpp"
-#include "nlohmann/json.hpp"
+#include "json_scanner.hpp"
+#include "log_entry_index.hpp"
 #include "notifier_dbus_handler.hpp"
 
 #include <boost/uuid/uuid_generators.hpp>
+#include <stdplus/fd/managed.hpp>
 
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
-#include <queue>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace bios_bmc_smm_error_logger
 {
@@ -40,11 +53,13 @@ class FileHandlerInterface
      * If the file already exists, this will overwrite it.
      *
      * @param[in] folderPath - path of the file without including the file name.
-     * @param[in] jsonPdr - PDR in nlohmann::json format.
+     * @param[in] jsonParts - JSON text of the PDR, split in parts. The file
+     * holds the parts one after the other, they are not joined beforehand.
      * @return true if successful.
      */
-    virtual bool createFile(const std::string& folderPath,
-                            const nlohmann::json& jsonPdr) const = 0;
+    virtual bool
+        createFile(const std::string& folderPath,
+                   std::span<const std::string_view> jsonParts) const = 0;
 
     /**
      * @brief Call remove_all on the filePath
@@ -53,10 +68,54 @@ class FileHandlerInterface
      * @return true if successful.
      */
     virtual bool removeAll(const std::string& filePath) const = 0;
+
+    /**
+     * @brief Get the bytes a file written with createFile takes up, which
+     * the LogEntries are kept within.
+     *
+     * @param[in] folderPath - path of the file without including the file name.
+     * @param[in] size - size of the JSON content.
+     * @return the bytes, pages of tmpfs by default.
+     */
+    virtual uint32_t getStoredSize(const std::string& folderPath,
+                                   size_t size) const;
+
+    /**
+     * @brief Check if createFile leaves an index.json at the path, for
+     * consumers to be pointed at.
+     *
+     * @param[in] folderPath - path of the file without including the file name.
+     * @return true by default.
+     */
+    virtual bool hasIndexFile(
+        [[maybe_unused]] const std::string& folderPath) const
+    {
+        return true;
+    }
+
+    /**
+     * @brief Start writing what was handed over so far, for handlers that
+     * create and remove files asynchronously. The others have already done
+     * it by the time their calls return.
+     *
+     * @param[in] done - called once the files created and removed so far are
+     * done with, right away or from the thread running the io_context.
+     */
+    virtual void flush(std::function<void()> done = nullptr) const
+    {
+        if (done)
+        {
+            done();
+        }
+    }
 };
 
 /**
  * @brief Class for handling folder and file creation for ExternalStorer.
+ *
+ * Directories are opened once and files are created relative to them with
+ * mkdirat / openat, so creating the index.json of a new LogEntry does not
+ * walk the whole path again. Safe to use from several threads.
  */
 class ExternalStorerFileWriter : public FileHandlerInterface
 {
@@ -64,10 +123,10 @@ class ExternalStorerFileWriter : public FileHandlerInterface
     explicit ExternalStorerFileWriter(std::string_view baseDir);
     bool createFolder(const std::string& folderPath) const override;
     bool createFile(const std::string& folderPath,
-                    const nlohmann::json& jsonPdr) const override;
+                    std::span<const std::string_view> jsonParts) const override;
     bool removeAll(const std::string& filePath) const override;
 
-  private:
+  protected:
     /**
      * @brief Check if the provided path is valid.
      *
@@ -76,6 +135,40 @@ class ExternalStorerFileWriter : public FileHandlerInterface
      */
     bool isValidPath(const std::string& folderPath) const;
 
+    /**
+     * @brief Get a path relative to baseDir without "." or ".." parts.
+     *
+     * @param[in] path_str - path string, isValidPath has to hold for it.
+     * @return the path, empty for baseDir itself.
+     */
+    std::filesystem::path getNormalizedPath(const std::string& path_str) const;
+
+    /** @brief Drop the cached dirfds, after a directory was removed behind
+     *  our back */
+    void forgetDirs() const;
+
+    std::filesystem::path baseDir;
+
+  private:
+    /**
+     * @brief Get a dirfd for a directory, creating it and its parents if
+     * needed. The mutex must be held.
+     *
+     * @param[in] relativePath - normalized path relative to baseDir, empty for
+     * baseDir itself.
+     * @return the dirfd, owned by the cache. -1 with errno set on failure.
+     */
+    int getDirFd(const std::filesystem::path& relativePath) const;
+
+    /**
+     * @brief Create folderPath and open its index.json for writing. The mutex
+     * must be held.
+     *
+     * @param[in] relativePath - normalized path relative to baseDir.
+     * @return the fd of index.json, -1 with errno set on failure.
+     */
+    int openIndexFile(const std::filesystem::path& relativePath) const;
+
     /**
      * @briefGet a relative path from the input string.
      *
@@ -84,7 +177,13 @@ class ExternalStorerFileWriter : public FileHandlerInterface
      */
     std::filesystem::path getRelativePath(const std::string& path_str) const;
 
-    std::filesystem::path baseDir;
+    mutable std::mutex mutex;
+    // O_PATH dirfd of baseDir, opened on first use
+    mutable std::optional<stdplus::ManagedFd> baseDirFd;
+    // O_PATH dirfds of the directories in use, keyed by their path relative
+    // to baseDir. E.g. LogServices/<id>/Entries, which every LogEntry is
+    // created in.
+    mutable std::unordered_map<std::string, stdplus::ManagedFd> dirFds;
 };
 
 /**
@@ -106,7 +205,8 @@ class ExternalStorerFileInterface : public ExternalStorerInterface
     /**
      * @brief Constructor for the ExternalStorerFileInterface.
      *
-     * @param[in] conn - sdbusplus asio connection.
+     * @param[in] conn - sdbusplus asio connection, nullptr to write the files
+     * without creating D-Bus objects for the LogEntries.
      * @param[in] rootPath - root path for creating redfish folders.
      * Eg: "/run/bmcweb"
      * @param[in] fileHandler - an ExternalStorerFileWriter object. This class
@@ -115,69 +215,245 @@ class ExternalStorerFileInterface : public ExternalStorerInterface
      * in the queue (default shall be 20)
      * @param[in] numLogEntries - number of non-saved log entries in the queue
      * (default shall be 1000 - 20 = 980)
+     * @param[in] counterFlushInterval - how long updates to a PDR without a
+     * specific category (e.g. an error counter) are held in memory before
+     * they are written out. 0 writes every update right away.
+     * @param[in] maxLogEntryBytes - bytes of tmpfs the log entries can take
+     * up, the oldest non-saved entries are deleted to stay within it. 0 for
+     * no limit.
+     * @param[in] retentionIndexPath - file the log entries are tracked in
+     * across restarts, empty to only track them in memory.
+     * @param[in] reapBacklog - number of old log entries that can wait to be
+     * deleted in the background. Past that, or if 0, they are deleted before
+     * the new log entry is written.
      */
     ExternalStorerFileInterface(
         const std::shared_ptr<sdbusplus::asio::connection>& conn,
         std::string_view rootPath,
         std::unique_ptr<FileHandlerInterface> fileHandler,
-        uint32_t numSavedLogEntries = 20, uint32_t numLogEntries = 980);
+        uint32_t numSavedLogEntries = 20, uint32_t numLogEntries = 980,
+        std::chrono::milliseconds counterFlushInterval =
+            std::chrono::milliseconds(0),
+        uint64_t maxLogEntryBytes = 0,
+        const std::string& retentionIndexPath = "", size_t reapBacklog = 0);
+
+    /** @brief Deletes the old log entries still waiting and writes out the
+     *  counters still held in memory */
+    ~ExternalStorerFileInterface() override;
+
+    ExternalStorerFileInterface(const ExternalStorerFileInterface&) = delete;
+    ExternalStorerFileInterface& operator=(const ExternalStorerFileInterface&) =
+        delete;
 
     bool publishJson(std::string_view jsonStr) override;
 
+    /**
+     * @brief Stage the LogEntries published from now on, until commitBatch.
+     * Call from the thread publishJson is called from.
+     */
+    void beginBatch();
+
+    /**
+     * @brief Write out the LogEntries staged since beginBatch together: the
+     * old entries they replace are evicted in one pass, the files are written
+     * one after the other and the D-Bus objects are created in one go. Call
+     * from the thread publishJson is called from.
+     *
+     * @return true if every staged LogEntry was written.
+     */
+    bool commitBatch();
+
+    /**
+     * @brief Write out the counters updated since they were last written,
+     * without waiting for the flush interval.
+     */
+    void flushCounters();
+
   private:
+    /**
+     * @brief A counter PDR, keyed by its path in counterFiles.
+     */
+    struct CounterFile
+    {
+        // Content of the file as last written, empty if never written. Kept
+        // whole, so only byte-identical updates are skipped.
+        std::string written;
+        // Latest content, only kept while dirty
+        std::string pending;
+        bool dirty = false;
+    };
+
     std::string rootPath;
     std::unique_ptr<FileHandlerInterface> fileHandler;
     std::string logServiceId;
     std::unique_ptr<CperFileNotifierHandler> cperNotifier;
     boost::uuids::random_generator randomGen;
-    std::queue<std::string> logEntrySavedQueue;
-    std::queue<std::string> logEntryQueue;
-    // Default should be 20
-    const uint32_t maxNumSavedLogEntries;
-    // Default should be 1000 - maxNumSavedLogEntries(20) = 980
-    const uint32_t maxNumLogEntries;
+    // LogEntries written, to delete the oldest once over the limits
+    std::unique_ptr<LogEntryRetentionIndex> retentionIndex;
+    // Members of the PDR being published
+    JsonObjectScanner scanner;
+
+    /**
+     * @brief A LogEntry waiting to be written, under logServiceId.
+     */
+    struct StagedLogEntry
+    {
+        boost::uuids::uuid id;
+        std::string subPath;
+        // Where its JSON is in stagedJson
+        size_t begin;
+        size_t end;
+        // Evicted by a newer entry of the same batch, not written at all
+        bool dropped;
+    };
+
+    // LogEntries are staged between beginBatch and commitBatch. Outside of a
+    // batch each one is committed on its own. The vectors are kept to reuse
+    // their memory.
+    bool batching = false;
+    std::string stagedJson;
+    std::vector<StagedLogEntry> stagedLogEntries;
+
+    // Write-back cache of the counter PDRs, BIOS updates the same few of
+    // them over and over during an error storm. Flushed from counterFlusher,
+    // publishJson is called from the decode thread.
+    const std::chrono::milliseconds counterFlushInterval;
+    std::mutex counterMutex;
+    std::condition_variable_any counterDirty;
+    std::unordered_map<std::string, CounterFile> counterFiles;
+    bool anyCounterDirty = false;
+    std::jthread counterFlusher;
+
+    /**
+     * @brief An old LogEntry to delete.
+     */
+    struct EvictedLogEntry
+    {
+        boost::uuids::uuid id;
+        // Path within the root folder
+        std::string subPath;
+    };
+
+    // Old LogEntries waiting to be deleted by reaper, so writing a new one
+    // doesn't wait on deleting the oldest. The retention index keeps track
+    // of them until they are deleted, in case the daemon goes down first.
+    const size_t maxReapBacklog;
+    std::mutex reapMutex;
+    std::condition_variable_any reapReady;
+    std::vector<EvictedLogEntry> reapBacklog;
+    // Deleted, for the decode thread to mark removed in the index
+    std::vector<boost::uuids::uuid> removedIds;
+    // Swapped with removedIds, to reuse its memory
+    std::vector<boost::uuids::uuid> appliedIds;
+    std::jthread reaper;
+
+    /**
+     * @brief Delete the LogEntries handed to the reaper, in batches of
+     * whatever piled up since the last one.
+     *
+     * @param[in] stopToken - stops the loop once the backlog is empty.
+     */
+    void reapLoop(std::stop_token stopToken);
+
+    /**
+     * @brief Delete an evicted LogEntry, in the background if the backlog
+     * has room. It is marked removed in the index once deleted.
+     *
+     * @param[in] id - ID of the LogEntry.
+     * @param[in] subPath - path of the LogEntry within the root folder.
+     * @return false if it was deleted right away and that failed.
+     */
+    bool removeLogEntry(const boost::uuids::uuid& id, std::string subPath);
+
+    /**
+     * @brief Hand over deleted LogEntries to be marked removed in the index.
+     * Safe to call from any thread.
+     *
+     * @param[in] ids - IDs of the LogEntries.
+     */
+    void confirmRemovals(std::span<const boost::uuids::uuid> ids);
+
+    /**
+     * @brief Mark the LogEntries handed over by confirmRemovals removed in
+     * the index. Call from the thread publishJson is called from.
+     */
+    void applyRemovals();
+
+    /**
+     * @brief Write out the staged LogEntries, see commitBatch.
+     *
+     * @return true if every staged LogEntry was written.
+     */
+    bool writeStagedLogEntries();
+
+    /**
+     * @brief Flush the counters every counterFlushInterval while any of them
+     * is dirty.
+     *
+     * @param[in] stopToken - stops the loop.
+     */
+    void counterFlushLoop(std::stop_token stopToken);
 
     /**
      * @brief Get the type of the received PDR.
      *
-     * @param[in] jsonSchema - PDR in nlohmann::json format.
+     * @param[in] odataType - @odata.type of the PDR.
      * @return JsonPdrType of the PDR.
      */
-    JsonPdrType getSchemaType(const nlohmann::json& jsonSchema) const;
+    JsonPdrType getSchemaType(std::string_view odataType) const;
 
     /**
-     * @brief Process a LogEntry type PDR.
+     * @brief Process a LogEntry type PDR, from the members scanned. It is
+     * staged, and written right away unless in a batch.
      *
-     * @param[in] logEntry - PDR in nlohmann::json format.
      * @return true if successful.
      */
-    bool processLogEntry(nlohmann::json& logEntry);
+    bool processLogEntry();
 
     /**
      * @brief Process a LogService type PDR.
      *
-     * @param[in] logService - PDR in nlohmann::json format.
+     * @param[in] jsonStr - PDR as JSON text, already scanned.
      * @return true if successful.
      */
-    bool processLogService(const nlohmann::json& logService);
+    bool processLogService(std::string_view jsonStr);
 
     /**
-     * @brief Process PDRs that doesn't have a specific category.
+     * @brief Process PDRs that doesn't have a specific category. They are
+     * cached and written out later if counterFlushInterval is set.
      *
-     * @param[in] jsonPdr - PDR in nlohmann::json format.
+     * @param[in] jsonStr - PDR as JSON text, already scanned.
      * @return true if successful.
      */
-    bool processOtherTypes(const nlohmann::json& jsonPdr) const;
+    bool processOtherTypes(std::string_view jsonStr);
+
+    /**
+     * @brief Write out a counter PDR.
+     *
+     * @param[in] path - @odata.id of the PDR.
+     * @param[in] jsonStr - PDR as JSON text.
+     * @return true if successful.
+     */
+    bool writeCounter(const std::string& path, std::string_view jsonStr);
 
     /**
      * @brief Create the needed folders and the index.json.
      *
      * @param subPath - path within the root folder.
-     * @param jsonPdr - PDR in nlohmann::json format.
+     * @param jsonStr - PDR as JSON text.
      * @return true if successful.
      */
-    bool createFile(const std::string& subPath,
-                    const nlohmann::json& jsonPdr) const;
+    bool createFile(const std::string& subPath, std::string_view jsonStr) const;
+
+    /**
+     * @brief Get the path of a LogEntry within the root folder.
+     *
+     * @param[in] serviceId - Id of the LogService the entry is under.
+     * @param[in] entryId - Id of the entry.
+     * @return the path.
+     */
+    static std::string getLogEntryPath(std::string_view serviceId,
+                                       std::string_view entryId);
 };
 
 } // namespace rde
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "external_storer_file.hpp"
+#include "log_entry_segment_store.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace rde
+{
+
+/**
+ * @brief FileHandlerInterface that keeps the LogEntries in a
+ * LogEntrySegmentStore instead of a directory each.
+ *
+ * Paths right under an Entries directory are LogEntries. The few other paths,
+ * the LogServices, their Entries/index.json and the counters, are handed on
+ * to another handler. LogEntries have no index.json, consumers read them
+ * through getStore(), see LogEntryStoreDbusHandler.
+ */
+class ExternalStorerSegmentWriter : public FileHandlerInterface
+{
+  public:
+    /**
+     * @param[in] store - store for the LogEntries.
+     * @param[in] fileHandler - handler for everything else.
+     */
+    ExternalStorerSegmentWriter(
+        std::unique_ptr<LogEntrySegmentStore> store,
+        std::unique_ptr<FileHandlerInterface> fileHandler);
+
+    bool createFolder(const std::string& folderPath) const override;
+    bool createFile(const std::string& folderPath,
+                    std::span<const std::string_view> jsonParts) const override;
+    bool removeAll(const std::string& filePath) const override;
+    void flush(std::function<void()> done = nullptr) const override;
+    uint32_t getStoredSize(const std::string& folderPath,
+                           size_t size) const override;
+    bool hasIndexFile(const std::string& folderPath) const override;
+
+    /** @brief Get the store the LogEntries are read from */
+    const LogEntrySegmentStore& getStore() const;
+
+  private:
+    /** @brief Check if a path is the one of a LogEntry */
+    static bool isLogEntryPath(const std::string& path);
+
+    std::unique_ptr<LogEntrySegmentStore> store;
+    std::unique_ptr<FileHandlerInterface> fileHandler;
+};
+
+} // namespace rde
+} // namespace bios_bmc_smm_error_logger
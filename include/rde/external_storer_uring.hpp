@@ -0,0 +1,167 @@
+#pragma once
+
+#include "external_storer_file.hpp"
+
+#include <liburing.h>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace rde
+{
+
+/**
+ * @brief ExternalStorerFileWriter that creates and removes files through
+ * io_uring.
+ *
+ * createFile queues a mkdirat -> openat -> write -> close chain and removeAll
+ * an unlinkat -> unlinkat chain, flush submits everything queued with a single
+ * io_uring_enter. The completions are reaped on the io_context, so neither
+ * the caller nor the io_context ever waits on the disk. createFile and
+ * removeAll only fail for invalid paths, errors of the chains are printed once
+ * they complete.
+ *
+ * The parents of the files and whatever a chain can't handle (removing a
+ * directory holding more than an index.json) go through the synchronous
+ * ExternalStorerFileWriter, on a worker thread rather than the io_context.
+ * Calls for the same path are done in order. Safe to use from several
+ * threads.
+ */
+class ExternalStorerUringWriter : public ExternalStorerFileWriter
+{
+  public:
+    /**
+     * @brief Set up the ring.
+     *
+     * @param[in] io - io_context the completions are reaped on.
+     * @param[in] baseDir - directory the files are created under.
+     * @throws std::runtime_error if io_uring or one of the operations the
+     * chains are made of is unavailable.
+     */
+    ExternalStorerUringWriter(boost::asio::io_context& io,
+                              std::string_view baseDir);
+
+    /** @brief Waits for what is still queued or in flight */
+    ~ExternalStorerUringWriter() override;
+
+    ExternalStorerUringWriter(const ExternalStorerUringWriter&) = delete;
+    ExternalStorerUringWriter& operator=(const ExternalStorerUringWriter&) =
+        delete;
+
+    bool createFolder(const std::string& folderPath) const override;
+    bool createFile(const std::string& folderPath,
+                    std::span<const std::string_view> jsonParts) const override;
+    bool removeAll(const std::string& filePath) const override;
+    void flush(std::function<void()> done = nullptr) const override;
+
+  private:
+    /** @brief A createFile or removeAll, keyed by the order of the calls */
+    struct Op
+    {
+        // Path relative to baseDir
+        std::string path;
+        // Absolute paths the chain works on, kept until it completes
+        std::string dir;
+        std::string file;
+        // Content of the index.json, empty for removeAll
+        std::string data;
+        bool remove = false;
+        // Fixed file slot, also counts the chain as in flight
+        unsigned slot = 0;
+        unsigned pendingCqes = 0;
+        // First error of the chain, as a negative errno
+        int error = 0;
+        bool retried = false;
+    };
+
+    /** @brief A synchronous operation of an op, done by the worker */
+    struct SlowOp
+    {
+        uint64_t seq;
+        // Relative path to create or remove
+        std::string path;
+        bool remove;
+    };
+
+    /** @brief Queue an op behind the earlier ones for its path */
+    void enqueue(std::string path, std::string data, bool remove) const;
+
+    /** @brief Queue the SQEs of an op, or wait for a slot */
+    void start(uint64_t seq) const;
+
+    /** @brief Queue the SQEs of an op that has a slot */
+    void prepare(uint64_t seq, Op& op) const;
+
+    /** @brief Handle the CQEs there are, then submit what they started */
+    void reap() const;
+
+    /** @brief Handle the CQE of one SQE of a chain */
+    void complete(uint64_t userData, int res) const;
+
+    /** @brief Wrap up an op after the last CQE of its chain */
+    void finish(uint64_t seq) const;
+
+    /** @brief Let the next ops have the slot and path of a finished one */
+    void release(uint64_t seq) const;
+
+    /** @brief Hand a synchronous createFolder or removeAll of an op to the
+     *  worker, the op keeps its slot until it is done
+     */
+    void queueSlowOp(uint64_t seq, std::string path, bool remove) const;
+
+    /** @brief Carry on with an op once the worker is done with it */
+    void resumeAfterSlowOp(const SlowOp& slowOp, bool success) const;
+
+    /** @brief Run the synchronous operations handed to the worker */
+    void slowOpLoop(std::stop_token stopToken);
+
+    /** @brief Take out the flush callbacks that are due */
+    std::vector<std::function<void()>> takeDone() const;
+
+    /** @brief Wait for the next completion on the io_context */
+    void waitCompletions();
+
+    mutable std::mutex uringMutex;
+    mutable io_uring ring;
+    boost::asio::posix::stream_descriptor eventFd;
+    mutable uint64_t nextSeq = 0;
+    // Ops queued or in flight
+    mutable std::map<uint64_t, Op> ops;
+    // Ops of each path, the first one is in flight
+    mutable std::unordered_map<std::string, std::deque<uint64_t>> pathOps;
+    // Ops waiting for a slot
+    mutable std::deque<uint64_t> waitingOps;
+    mutable std::vector<unsigned> freeSlots;
+    // Callbacks, run once the ops before the sequence number are done
+    mutable std::vector<std::pair<uint64_t, std::function<void()>>> doneFns;
+    // Relative paths of the directories known to exist
+    mutable std::unordered_set<std::string> knownDirs;
+
+    // Queued for the worker, and how many are queued or running
+    mutable std::deque<SlowOp> slowOps;
+    mutable size_t numSlowOps = 0;
+    mutable std::condition_variable_any slowOpQueued;
+    mutable std::condition_variable_any slowOpFinished;
+    std::jthread slowOpWorker;
+};
+
+} // namespace rde
+} // namespace bios_bmc_smm_error_logger
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace rde
+{
+
+/**
+ * @brief A top level member of a JSON object, pointing into the scanned text.
+ */
+struct JsonMember
+{
+    // The key as written, without the quotes
+    std::string_view key;
+    // The value as written, including the quotes of a string
+    std::string_view value;
+    // The whole member as written, from the opening quote of the key to the
+    // end of the value
+    std::string_view text;
+};
+
+/**
+ * @brief Single pass scanner for the JSON objects libbej decodes to.
+ *
+ * Checks that the text is one well formed JSON object and collects where its
+ * top level members are, without building a DOM. Nested values are skipped
+ * over. The scanner keeps its member list between scans, so scanning does not
+ * allocate once it has seen an object with as many members.
+ */
+class JsonObjectScanner
+{
+  public:
+    /**
+     * @brief Scan a JSON object.
+     *
+     * @param[in] json - JSON text, must outlive the members found.
+     * @return true if json is a well formed JSON object.
+     */
+    bool scan(std::string_view json);
+
+    /**
+     * @brief Get the top level members of the last scanned object, in the
+     * order they are written.
+     *
+     * @return the members.
+     */
+    const std::vector<JsonMember>& getMembers() const;
+
+    /**
+     * @brief Find a top level member of the last scanned object. Like most
+     * JSON parsers, the last one wins if the key is repeated.
+     *
+     * @param[in] key - key as written, without the quotes.
+     * @return the member, nullptr if there is none.
+     */
+    const JsonMember* find(std::string_view key) const;
+
+    /**
+     * @brief Get the string a member holds, with escapes resolved.
+     *
+     * @param[in] member - member to read, can be nullptr.
+     * @return the string, std::nullopt if there is no member or its value is
+     * not a string.
+     */
+    static std::optional<std::string> getString(const JsonMember* member);
+
+  private:
+    bool scanValue(size_t depth);
+    bool scanObject(size_t depth);
+    bool scanArray(size_t depth);
+    bool scanString();
+    bool scanLiteral();
+    void skipWhitespace();
+
+    std::string_view json;
+    size_t pos = 0;
+    std::vector<JsonMember> members;
+};
+
+} // namespace rde
+} // namespace bios_bmc_smm_error_logger
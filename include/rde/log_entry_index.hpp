@@ -0,0 +1,189 @@
+#pragma once
+
+#include <boost/uuid/uuid.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace rde
+{
+
+/**
+ * @brief A LogEntry the retention index keeps track of.
+ */
+struct RetainedLogEntry
+{
+    boost::uuids::uuid id;
+    // Id of the LogService the entry is under
+    std::string logServiceId;
+    // Bytes the entry takes up
+    uint32_t size;
+    // One of the first entries, which are never evicted for newer ones
+    bool saved;
+};
+
+/**
+ * @brief Retention index of the LogEntries written under /run/bmcweb.
+ *
+ * The first maxSavedEntries entries are kept, past those only the newest
+ * maxEntries are. The oldest of those are also evicted to keep the entries
+ * within maxBytes. Saved entries are never evicted.
+ *
+ * Entries refer to one of maxLogServices LogService slots. Once all of them
+ * are in use, a new LogService takes over the slot of the LogService with the
+ * fewest entries and no saved ones, evicting those entries. A new LogService
+ * is rejected if every slot holds saved entries, see hasRoomForLogService.
+ *
+ * The index is a file mapped into memory, holding a fixed size ring of the
+ * 16 byte entry IDs and their sizes, so it survives a restart of the daemon
+ * and is loaded back without walking the directory tree. Like the entries
+ * themselves it is meant to live on tmpfs, it is in host byte order and not
+ * synced. Without a path the index is in memory only.
+ *
+ * Evicted entries are kept track of until markRemoved is called for them,
+ * so entries whose files were still waiting to be removed when the daemon
+ * went down can be removed after it starts again.
+ *
+ * Not thread safe.
+ */
+class LogEntryRetentionIndex
+{
+  public:
+    // The index can refer to entries of this many LogServices at once
+    static constexpr size_t maxLogServices = 16;
+    static constexpr size_t maxLogServiceIdSize = 127;
+
+    /**
+     * @brief Load the index, or create it if there is none or it doesn't
+     * match the limits.
+     *
+     * @param[in] path - path of the index file, empty to keep it in memory.
+     * @param[in] maxSavedEntries - number of first entries that are kept.
+     * @param[in] maxEntries - number of newest entries kept after those, at
+     * least 1.
+     * @param[in] maxBytes - bytes all of the entries can take up, 0 for no
+     * limit.
+     * @param[in] maxPendingRemovals - number of evicted entries kept track of
+     * until they are removed, past it the oldest are forgotten. 0 to not keep
+     * track of them.
+     */
+    LogEntryRetentionIndex(const std::string& path, uint32_t maxSavedEntries,
+                           uint32_t maxEntries, uint64_t maxBytes,
+                           uint32_t maxPendingRemovals = 0);
+    ~LogEntryRetentionIndex();
+
+    LogEntryRetentionIndex(const LogEntryRetentionIndex&) = delete;
+    LogEntryRetentionIndex& operator=(const LogEntryRetentionIndex&) = delete;
+
+    /**
+     * @brief Get the entry that has to be evicted before adding one. Call
+     * again after evicting it, until there is none.
+     *
+     * @param[in] logServiceId - LogService of the entry to add.
+     * @param[in] size - bytes the entry to add takes up.
+     * @return the oldest entry that has to go, std::nullopt if the entry fits.
+     */
+    std::optional<RetainedLogEntry>
+        getNextEviction(std::string_view logServiceId, uint32_t size) const;
+
+    /**
+     * @brief Check if entries of a LogService can be added, it takes up a
+     * slot unless it has entries already.
+     *
+     * @param[in] logServiceId - the LogService.
+     * @return false if every slot is held by saved entries.
+     */
+    bool hasRoomForLogService(std::string_view logServiceId) const;
+
+    /**
+     * @brief Drop an entry returned by getNextEviction from the index. It is
+     * kept track of until markRemoved.
+     *
+     * @param[in] entry - the entry, never a saved one.
+     */
+    void evict(const RetainedLogEntry& entry);
+
+    /**
+     * @brief Stop keeping track of an evicted entry, once it was removed.
+     *
+     * @param[in] id - ID of the entry.
+     */
+    void markRemoved(const boost::uuids::uuid& id);
+
+    /**
+     * @brief Get the evicted entries that weren't marked removed yet.
+     *
+     * @return the entries, from the oldest eviction.
+     */
+    std::vector<RetainedLogEntry> getPendingRemovals() const;
+
+    /**
+     * @brief Add an entry. getNextEviction has to have made room for it, and
+     * hasRoomForLogService has to hold for its LogService.
+     *
+     * @param[in] id - ID of the entry.
+     * @param[in] logServiceId - LogService of the entry, at most
+     * maxLogServiceIdSize bytes.
+     * @param[in] size - bytes the entry takes up.
+     */
+    void add(const boost::uuids::uuid& id, std::string_view logServiceId,
+             uint32_t size);
+
+    /**
+     * @brief Get the entries in the index, saved ones first, then the rest
+     * from the oldest.
+     *
+     * @return the entries.
+     */
+    std::vector<RetainedLogEntry> getEntries() const;
+
+    /** @brief Get the number of entries in the index */
+    size_t getNumEntries() const;
+
+    /** @brief Get the bytes all of the entries in the index take up */
+    uint64_t getTotalSize() const;
+
+  private:
+    struct Header;
+    struct Record;
+    struct PendingRecord;
+
+    Header& header() const;
+    Record& savedRecord(uint32_t index) const;
+    Record& record(uint32_t index) const;
+    PendingRecord& pendingRecord(uint32_t index) const;
+    RetainedLogEntry toEntry(const Record& record, bool saved) const;
+
+    /** @brief Check the loaded index against the limits */
+    bool isValid(size_t fileSize) const;
+
+    /** @brief Start over with an empty index */
+    void reset();
+
+    /** @brief Get the slot without saved entries that has the fewest
+     *  entries, std::nullopt if every slot holds saved ones */
+    std::optional<uint8_t> findReclaimableLogService() const;
+
+    /** @brief Get the LogService slot of an ID, std::nullopt if it has none */
+    std::optional<uint8_t> findLogService(std::string_view logServiceId) const;
+
+    const uint32_t maxSavedEntries;
+    const uint32_t maxEntries;
+    const uint64_t maxBytes;
+    const uint32_t maxPendingRemovals;
+    uint8_t* mapped = nullptr;
+    size_t mappedSize = 0;
+    // Not kept in the file, counted when the index is loaded
+    uint64_t totalSize = 0;
+    std::array<uint32_t, maxLogServices> logServiceRefs = {};
+};
+
+} // namespace rde
+} // namespace bios_bmc_smm_error_logger
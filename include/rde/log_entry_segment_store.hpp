@@ -0,0 +1,167 @@
+#pragma once
+
+#include "external_storer_file.hpp"
+
+#include <stdplus/fd/managed.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace rde
+{
+
+/**
+ * @brief LogEntries appended to rotating segment files, with an offset index
+ * of them in memory.
+ *
+ * Instead of a directory and an index.json per entry, each entry is a record
+ * in the current segment file: a header, its path and its JSON. Writing one is
+ * a single pwritev. Removing one clears the live flag in its header, and a
+ * segment is deleted once none of its records are live. A segment that is
+ * mostly dead has its live records moved to the current one first.
+ *
+ * The segments are meant to live on tmpfs, they are in host byte order and
+ * not synced. The index is built back from them when the store is opened,
+ * the newest record of a path is the live one. Thread safe.
+ */
+class LogEntrySegmentStore
+{
+  public:
+    // Bytes a record takes up on top of its path and JSON
+    static constexpr size_t recordOverhead = 16;
+
+    /**
+     * @brief Open the segments in a directory, creating it if needed.
+     *
+     * @param[in] dir - directory of the segment files.
+     * @param[in] segmentSize - size a segment is rotated at.
+     * @throws std::runtime_error if the directory can't be opened.
+     */
+    LogEntrySegmentStore(const std::string& dir, size_t segmentSize);
+
+    LogEntrySegmentStore(const LogEntrySegmentStore&) = delete;
+    LogEntrySegmentStore& operator=(const LogEntrySegmentStore&) = delete;
+
+    /**
+     * @brief Append the JSON of a path, replacing what the path held.
+     *
+     * @param[in] path - path of the entry, e.g. the one of its directory in
+     * the directory layout.
+     * @param[in] jsonParts - JSON of the entry, split in parts.
+     * @return true if successful.
+     */
+    bool append(const std::string& path,
+                std::span<const std::string_view> jsonParts);
+
+    /**
+     * @brief Remove the entry of a path and the ones under it.
+     *
+     * @param[in] path - path of the entry or of a directory of them.
+     * @return true if successful, also if there was nothing to remove.
+     */
+    bool remove(const std::string& path);
+
+    /**
+     * @brief Read the JSON of an entry.
+     *
+     * @param[in] path - path of the entry.
+     * @return the JSON, std::nullopt if there is no such entry.
+     */
+    std::optional<std::string> read(const std::string& path) const;
+
+    /**
+     * @brief List the entries right under a path, e.g. the LogEntries of a
+     * LogService's Entries.
+     *
+     * @param[in] path - path of the directory.
+     * @return the last path component of each entry, in order of the paths.
+     */
+    std::vector<std::string> list(const std::string& path) const;
+
+    /**
+     * @brief Write every entry out through another handler, e.g. in the
+     * directory layout for consumers that read files.
+     *
+     * @param[in] fileHandler - handler the entries are created with.
+     * @return true if all of them were written.
+     */
+    bool exportTo(const FileHandlerInterface& fileHandler) const;
+
+    /** @brief Get the number of entries in the store */
+    size_t getNumEntries() const;
+
+    /** @brief Get the number of segment files */
+    size_t getNumSegments() const;
+
+  private:
+    struct RecordHeader;
+
+    /** @brief Where the record of an entry is */
+    struct Location
+    {
+        uint64_t segment;
+        uint64_t offset;
+        uint32_t dataSize;
+    };
+
+    struct Segment
+    {
+        stdplus::ManagedFd fd;
+        uint64_t size = 0;
+        // Bytes of the records that are still live
+        uint64_t liveBytes = 0;
+        // Keys of the entries whose record is in this segment, they point
+        // into the keys of entries
+        std::set<std::string_view> keys = {};
+    };
+
+    /** @brief Read a segment into the index */
+    void loadSegment(uint64_t id);
+
+    /** @brief Start a new segment after the current one */
+    bool rotate();
+
+    /** @brief Append a record to the current segment. The mutex must be
+     *  held. */
+    std::optional<Location>
+        appendRecord(std::string_view key,
+                     std::span<const std::string_view> jsonParts);
+
+    /** @brief Clear the live flag of a record. The mutex must be held. */
+    bool markDead(std::string_view key, const Location& location);
+
+    /** @brief Delete or compact a segment that lost a record. The mutex must
+     *  be held. */
+    void release(uint64_t id);
+
+    /** @brief Move the live records of a segment to the current one and
+     *  delete it. The mutex must be held. */
+    void compact(uint64_t id);
+
+    /** @brief Read the JSON of a record. The mutex must be held. */
+    std::optional<std::string> readRecord(std::string_view key,
+                                          const Location& location) const;
+
+    const size_t segmentSize;
+    mutable std::mutex mutex;
+    std::optional<stdplus::ManagedFd> dirFd;
+    std::map<uint64_t, Segment> segments;
+    // Segment records are appended to, the newest one
+    uint64_t current = 0;
+    // Keyed by the path without leading or trailing '/'
+    std::map<std::string, Location, std::less<>> entries;
+};
+
+} // namespace rde
+} // namespace bios_bmc_smm_error_logger
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "log_entry_segment_store.hpp"
+
+#include <sdbusplus/asio/object_server.hpp>
+
+#include <memory>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace rde
+{
+
+/**
+ * @brief A class to let consumers read the LogEntries kept in a
+ * LogEntrySegmentStore over DBus, as they have no index.json to be read.
+ *
+ * The object at logEntriesPath has the methods
+ *  - List(s path) -> as: Ids of the LogEntries in a LogService's Entries,
+ *    e.g. /redfish/v1/Systems/system/LogServices/<id>/Entries
+ *  - Read(s path) -> s: JSON of the LogEntry at a path, which is the
+ *    @odata.id of the LogEntry. ResourceNotFound if there is none.
+ */
+class LogEntryStoreDbusHandler
+{
+  public:
+    /**
+     * @brief Constructor for the LogEntryStoreDbusHandler class.
+     *
+     * @param conn - sdbusplus asio connection.
+     * @param store - store the LogEntries are read from, it has to outlive
+     * the handler.
+     */
+    LogEntryStoreDbusHandler(
+        const std::shared_ptr<sdbusplus::asio::connection>& conn,
+        const LogEntrySegmentStore& store);
+
+    ~LogEntryStoreDbusHandler();
+
+    LogEntryStoreDbusHandler(const LogEntryStoreDbusHandler&) = delete;
+    LogEntryStoreDbusHandler& operator=(const LogEntryStoreDbusHandler&) =
+        delete;
+
+    static constexpr const char* logEntriesPath =
+        "/xyz/openbmc_project/external_storer/bios_bmc_smm_error_logger/"
+        "LogEntries";
+    static constexpr const char* logEntriesInterface =
+        "xyz.openbmc_project.BiosBmcSmmErrorLogger.LogEntries";
+
+  private:
+    sdbusplus::asio::object_server objServer;
+    std::shared_ptr<sdbusplus::asio::dbus_interface> iface;
+};
+
+} // namespace rde
+} // namespace bios_bmc_smm_error_logger
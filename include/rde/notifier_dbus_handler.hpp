@@ -2,9 +2,11 @@
 
 #include "dbus/file_notifier.hpp"
 
+#include <boost/asio/io_context.hpp>
 #include <sdbusplus/asio/object_server.hpp>
 
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace bios_bmc_smm_error_logger
@@ -27,15 +29,19 @@ class CperFileNotifierHandler
         const std::shared_ptr<sdbusplus::asio::connection>& conn);
 
     /**
-     * @brief Create a DBus object with the provided filePath value.
+     * @brief Create a DBus object for each of the provided filePaths.
      *
-     * @param filePath - file path of the CPER log JSON file.
+     * Safe to call from any thread, the objects are created on the
+     * connection's io_context, all in one go.
+     *
+     * @param filePaths - file paths of the CPER log JSON files.
      */
-    void createEntry(const std::string& filePath);
+    void createEntries(std::vector<std::string> filePaths);
 
   private:
     sdbusplus::server::manager_t objManager;
     sdbusplus::asio::object_server objServer;
+    boost::asio::io_context& io;
 
     /**
      * @brief DBus index of the next entry.
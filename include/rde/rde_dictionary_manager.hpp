@@ -45,9 +45,12 @@ class DictionaryManager
      *
      * @param[in] resourceId - PDR resource id corresponding to the dictionary.
      * @param[in] data - dictionary data.
+     * @param[in,out] crc - if set, a running CRC-32 advanced over the data in
+     * the same pass it is copied in, see crc32Update.
      */
     void startDictionaryEntry(uint32_t resourceId,
-                              const std::span<const uint8_t> data);
+                              const std::span<const uint8_t> data,
+                              uint32_t* crc = nullptr);
 
     /**
      * @brief Set the dictionary valid status. Until this is called, dictionary
@@ -64,10 +67,13 @@ class DictionaryManager
      *
      * @param[in] resourceId - PDR resource id corresponding to the dictionary.
      * @param[in] data - dictionary data.
+     * @param[in,out] crc - if set, a running CRC-32 advanced over the data in
+     * the same pass it is copied in. Left as is on failure.
      * @return true if successful.
      */
     bool addDictionaryData(uint32_t resourceId,
-                           const std::span<const uint8_t> data);
+                           const std::span<const uint8_t> data,
+                           uint32_t* crc = nullptr);
 
     /**
      * @brief Get a dictionary.
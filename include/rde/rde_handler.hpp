@@ -169,8 +169,12 @@ class RdeCommandHandler
     DictionaryManager dictionaryManager;
     libbej::BejDecoderJson decoder;
 
+    // Running CRC of the dictionary being received. According to the RDE BEJ
+    // specification: "32-bit CRC for the entire block of data (all parts
+    // concatenated together, excluding this checksum)". It is advanced by
+    // DictionaryManager in the same pass the data is copied in, with the
+    // fastest crc32Update implementation for the CPU.
     uint32_t crc;
-    std::array<uint32_t, UINT8_MAX + 1> crcTable;
 
     /**
      * @brief Handles OperationInit request messages.
@@ -188,24 +192,6 @@ class RdeCommandHandler
      */
     RdeDecodeStatus multiPartReceiveResp(std::span<const uint8_t> rdeCommand);
 
-    /**
-     * @brief Initializes the CRC table.
-     */
-    void calcCrcTable();
-
-    /**
-     * @brief Update the existing CRC using the provided byte stream.
-     *
-     * According to the RDE BEJ specification: "32-bit CRC for the entire block
-     * of data (all parts concatenated together, excluding this checksum)".
-     * Therefore when calculating the CRC whole RDEMultipartReceive Response
-     * data packet is considered, not just the dictionary data contained within
-     * it.
-     *
-     * @param[in] stream - a byte stream.
-     */
-    void updateCrc(std::span<const uint8_t> stream);
-
     /**
      * @brief Get the final checksum value.
      *
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "pci_handler.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+
+namespace bios_bmc_smm_error_logger
+{
+
+/**
+ * Data handler for a buffer in shared memory (a memfd or a file, e.g. under
+ * /dev/shm) instead of the PCI bridge. Lets the daemon run against a BIOS
+ * simulator in another thread or process.
+ *
+ * Accesses are the same as for PciDataHandler, plus fences so that writes
+ * from one CPU are seen in order on another: the entry bytes before the
+ * pointer that publishes them.
+ */
+class SharedMemoryDataHandler : public PciDataHandler
+{
+  public:
+    /**
+     * Create a buffer in a new anonymous memfd, filled with 0s.
+     *
+     * @param[in] regionSize - size of the buffer
+     * @param[in] doorbell - doorbell for the buffer, nullptr if there is none
+     * @return the handler
+     */
+    static std::unique_ptr<SharedMemoryDataHandler> createMemfd(
+        size_t regionSize, std::unique_ptr<Doorbell> doorbell = nullptr);
+
+    /**
+     * Map a file shared with another process, creating it and growing it to
+     * regionSize if needed. The contents of an existing file are kept.
+     *
+     * @param[in] path - path of the file, e.g. under /dev/shm
+     * @param[in] regionSize - size of the buffer
+     * @param[in] doorbell - doorbell for the buffer, nullptr if there is none
+     * @return the handler
+     */
+    static std::unique_ptr<SharedMemoryDataHandler> openFile(
+        const std::string& path, size_t regionSize,
+        std::unique_ptr<Doorbell> doorbell = nullptr);
+
+    /**
+     * Map the same memory again, e.g. to hand the BIOS side of the buffer to
+     * a simulator.
+     *
+     * @return a new handler for the same memory, without a doorbell
+     */
+    std::unique_ptr<SharedMemoryDataHandler> share() const;
+
+    uint32_t readInto(const uint32_t offset,
+                      std::span<uint8_t> bytes) override;
+    uint32_t write(const uint32_t offset,
+                   const std::span<const uint8_t> bytes) override;
+
+  private:
+    SharedMemoryDataHandler(int fd, size_t regionSize,
+                            std::unique_ptr<Doorbell> doorbell);
+
+    // Owned by the base class, kept to be able to share the mapping
+    int mappedFd;
+    size_t regionSize;
+};
+
+} // namespace bios_bmc_smm_error_logger
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <stdexcept>
+#include <vector>
+
+namespace bios_bmc_smm_error_logger
+{
+
+/**
+ * Bounded lock-free ring for exactly one producer thread and one consumer
+ * thread.
+ *
+ * Slots are constructed once and reused, the producer fills a slot in place
+ * and publishes it, the consumer reads it in place and releases it. Objects
+ * that own memory (e.g. a std::vector) therefore keep their capacity and
+ * passing items through the ring does not allocate once it is warmed up.
+ */
+template <typename T>
+class SpscRing
+{
+  public:
+    /**
+     * @param[in] capacity - maximum number of published, unreleased slots
+     */
+    explicit SpscRing(size_t capacity) : slots(capacity)
+    {
+        if (capacity == 0)
+        {
+            throw std::invalid_argument(
+                std::format("[SpscRing] Capacity can't be 0"));
+        }
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    /** @brief Producer only. Get the next free slot to fill in.
+     *  @return the slot, or nullptr if the ring is full
+     */
+    T* producerSlot()
+    {
+        const uint64_t tail = writeIndex.load(std::memory_order_relaxed);
+        if (tail - cachedReadIndex == slots.size())
+        {
+            cachedReadIndex = readIndex.load(std::memory_order_acquire);
+            if (tail - cachedReadIndex == slots.size())
+            {
+                return nullptr;
+            }
+        }
+        return &slots[tail % slots.size()];
+    }
+
+    /** @brief Producer only. Hand the slot from producerSlot to the consumer.
+     */
+    void publish()
+    {
+        writeIndex.fetch_add(1, std::memory_order_release);
+    }
+
+    /** @brief Consumer only. Get the oldest published slot.
+     *  @return the slot, or nullptr if the ring is empty
+     */
+    T* consumerSlot()
+    {
+        const uint64_t head = readIndex.load(std::memory_order_relaxed);
+        if (head == cachedWriteIndex)
+        {
+            cachedWriteIndex = writeIndex.load(std::memory_order_acquire);
+            if (head == cachedWriteIndex)
+            {
+                return nullptr;
+            }
+        }
+        return &slots[head % slots.size()];
+    }
+
+    /** @brief Consumer only. Give the slot from consumerSlot back to the
+     *  producer.
+     */
+    void release()
+    {
+        readIndex.fetch_add(1, std::memory_order_release);
+        readIndex.notify_all();
+    }
+
+    /** @brief Block until the consumer released the given number of slots.
+     *  Parking the consumer while the ring is empty is left to the caller.
+     *  @param[in] released - value of released() to wait for
+     */
+    void waitForRelease(uint64_t released) const
+    {
+        uint64_t current = readIndex.load(std::memory_order_acquire);
+        while (current < released)
+        {
+            readIndex.wait(current, std::memory_order_acquire);
+            current = readIndex.load(std::memory_order_acquire);
+        }
+    }
+
+    /** @brief Total number of slots published so far */
+    uint64_t published() const
+    {
+        return writeIndex.load(std::memory_order_acquire);
+    }
+
+    /** @brief Total number of slots released so far */
+    uint64_t released() const
+    {
+        return readIndex.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const
+    {
+        return slots.size();
+    }
+
+  private:
+    std::vector<T> slots;
+
+    // Each index is only written by one side, keep them on separate cache
+    // lines so the two threads don't bounce a line between them
+    alignas(64) std::atomic<uint64_t> writeIndex = 0;
+    // Producer's last view of readIndex
+    uint64_t cachedReadIndex = 0;
+    alignas(64) std::atomic<uint64_t> readIndex = 0;
+    // Consumer's last view of writeIndex
+    uint64_t cachedWriteIndex = 0;
+};
+
+} // namespace bios_bmc_smm_error_logger
@@ -0,0 +1,241 @@
+/**
+ * Feeds a capture journal (see -Dcapture-journal) through RdeCommandHandler
+ * as fast as it can, to reproduce a decode failure seen in the field or to
+ * measure the decode and store path without BIOS in the loop.
+ *
+ * Usage:
+ *   bios-bmc-smm-journal-replay --journal FILE [--output DIR] [--loop N]
+ *                               [--verbose]
+ *
+ * Without --output the decoded logs are dropped, so only decoding is timed.
+ * With --output they are written under DIR as the daemon writes them under
+ * /run/bmcweb. No D-Bus objects are created for them, so the tool runs
+ * without a bus and next to the daemon.
+ */
+
+#include "entry_journal.hpp"
+#include "rde/external_storer_file.hpp"
+#include "rde/external_storer_interface.hpp"
+#include "rde/rde_handler.hpp"
+
+#include <getopt.h>
+
+#include <boost/endian/conversion.hpp>
+#include <stdplus/print.hpp>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace
+{
+
+using namespace bios_bmc_smm_error_logger;
+using Clock = std::chrono::steady_clock;
+
+/**
+ * Drops every log
+ */
+class NullStorer : public rde::ExternalStorerInterface
+{
+  public:
+    bool publishJson(std::string_view) override
+    {
+        return true;
+    }
+};
+
+// One past the last RdeDecodeStatus
+constexpr size_t numDecodeStatuses =
+    static_cast<size_t>(rde::RdeDecodeStatus::RdeStopFlagReceived) + 1;
+
+const char* statusName(rde::RdeDecodeStatus status)
+{
+    switch (status)
+    {
+        case rde::RdeDecodeStatus::RdeOk:
+            return "RdeOk";
+        case rde::RdeDecodeStatus::RdeInvalidCommand:
+            return "RdeInvalidCommand";
+        case rde::RdeDecodeStatus::RdeUnsupportedOperation:
+            return "RdeUnsupportedOperation";
+        case rde::RdeDecodeStatus::RdeNoDictionary:
+            return "RdeNoDictionary";
+        case rde::RdeDecodeStatus::RdePayloadOverflow:
+            return "RdePayloadOverflow";
+        case rde::RdeDecodeStatus::RdeBejDecodingError:
+            return "RdeBejDecodingError";
+        case rde::RdeDecodeStatus::RdeInvalidPktOrder:
+            return "RdeInvalidPktOrder";
+        case rde::RdeDecodeStatus::RdeDictionaryError:
+            return "RdeDictionaryError";
+        case rde::RdeDecodeStatus::RdeFileCreationFailed:
+            return "RdeFileCreationFailed";
+        case rde::RdeDecodeStatus::RdeExternalStorerError:
+            return "RdeExternalStorerError";
+        case rde::RdeDecodeStatus::RdeInvalidChecksum:
+            return "RdeInvalidChecksum";
+        case rde::RdeDecodeStatus::RdeStopFlagReceived:
+            return "RdeStopFlagReceived";
+    }
+    return "Unknown";
+}
+
+struct Options
+{
+    std::string journal;
+    std::string output;
+    uint64_t loop = 1;
+    bool verbose = false;
+};
+
+uint64_t parseNumber(std::string_view str)
+{
+    uint64_t value = 0;
+    auto [ptr, ec] =
+        std::from_chars(str.data(), str.data() + str.size(), value);
+    if (ec != std::errc() || ptr != str.data() + str.size())
+    {
+        throw std::invalid_argument(std::format("Invalid number '{}'", str));
+    }
+    return value;
+}
+
+Options parseOptions(int argc, char** argv)
+{
+    static const struct option longOptions[] = {
+        {"journal", required_argument, nullptr, 'j'},
+        {"output", required_argument, nullptr, 'o'},
+        {"loop", required_argument, nullptr, 'l'},
+        {"verbose", no_argument, nullptr, 'v'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    Options options;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "j:o:l:v", longOptions, nullptr)) !=
+           -1)
+    {
+        const std::string_view arg = optarg != nullptr ? optarg : "";
+        switch (opt)
+        {
+            case 'j':
+                options.journal = arg;
+                break;
+            case 'o':
+                options.output = arg;
+                break;
+            case 'l':
+                options.loop = std::max<uint64_t>(parseNumber(arg), 1);
+                break;
+            case 'v':
+                options.verbose = true;
+                break;
+            default:
+                throw std::invalid_argument("Unknown option");
+        }
+    }
+    if (options.journal.empty())
+    {
+        throw std::invalid_argument("--journal is required");
+    }
+    return options;
+}
+
+int run(const Options& options)
+{
+    EntryJournalReader reader(options.journal);
+    if (reader.isTruncated())
+    {
+        stdplus::print(stderr,
+                       "{} ends in a partial record, replaying up to it\n",
+                       options.journal);
+    }
+
+    std::unique_ptr<rde::ExternalStorerInterface> storer;
+    if (options.output.empty())
+    {
+        storer = std::make_unique<NullStorer>();
+    }
+    else
+    {
+        storer = std::make_unique<rde::ExternalStorerFileInterface>(
+            nullptr, options.output,
+            std::make_unique<rde::ExternalStorerFileWriter>(options.output));
+    }
+    rde::RdeCommandHandler handler(std::move(storer));
+
+    std::array<uint64_t, numDecodeStatuses> statusCounts = {};
+    uint64_t numRecords = 0;
+    uint64_t numBytes = 0;
+    const Clock::time_point start = Clock::now();
+    for (uint64_t pass = 0; pass < options.loop; ++pass)
+    {
+        reader.forEach([&](const JournalRecord& record) {
+            // UE logs are BEJ encoded data, same as in the daemon
+            const rde::RdeCommandType type =
+                record.kind == JournalRecordKind::ueLog
+                    ? rde::RdeCommandType::RdeOperationInitRequest
+                    : static_cast<rde::RdeCommandType>(
+                          record.entryHeader.rdeCommandType);
+            const rde::RdeDecodeStatus status =
+                handler.decodeRdeCommand(record.payload, type);
+
+            ++statusCounts[static_cast<size_t>(status)];
+            ++numRecords;
+            numBytes += record.payload.size();
+            if (options.verbose && status != rde::RdeDecodeStatus::RdeOk)
+            {
+                stdplus::print(
+                    stdout, "record {}: {} {} bytes, sequence ID {}: {}\n",
+                    numRecords - 1,
+                    record.kind == JournalRecordKind::ueLog ? "UE log"
+                                                            : "entry",
+                    record.payload.size(),
+                    boost::endian::little_to_native(
+                        record.entryHeader.sequenceId),
+                    statusName(status));
+            }
+        });
+    }
+    const double seconds =
+        std::chrono::duration<double>(Clock::now() - start).count();
+
+    stdplus::print(stdout,
+                   "{} records, {} bytes in {:.3f}s ({:.0f} records/s, "
+                   "{:.0f} B/s)\n",
+                   numRecords, numBytes, seconds, numRecords / seconds,
+                   numBytes / seconds);
+    for (size_t i = 0; i < numDecodeStatuses; ++i)
+    {
+        if (statusCounts[i] != 0)
+        {
+            stdplus::print(stdout, "  {}: {}\n",
+                           statusName(static_cast<rde::RdeDecodeStatus>(i)),
+                           statusCounts[i]);
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        return run(parseOptions(argc, argv));
+    }
+    catch (const std::exception& e)
+    {
+        stdplus::print(stderr, "bios-bmc-smm-journal-replay: {}\n", e.what());
+        return 1;
+    }
+}
@@ -0,0 +1,304 @@
+/**
+ * Plays the BIOS side of the circular buffer against a buffer in shared
+ * memory, so the daemon (built with -Dtransport=shared-memory) can be run
+ * end to end without hardware.
+ *
+ * Usage:
+ *   bios-simulator --file /dev/shm/bios-bmc-smm-error-logger
+ *                  [--region-size BYTES] [--rate ENTRIES_PER_S]
+ *                  [--burst ENTRIES] [--count ENTRIES] [--duration S]
+ *                  [--size fixed:N|uniform:MIN:MAX|exponential:MEAN]
+ *                  [--command-type TYPE] [--ue-every ENTRIES] [--seed N]
+ */
+
+#include "bios_producer.hpp"
+#include "shared_memory_handler.hpp"
+
+#include <getopt.h>
+
+#include <stdplus/print.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+using namespace bios_bmc_smm_error_logger;
+using Clock = std::chrono::steady_clock;
+
+std::atomic<bool> stopRequested = false;
+
+/**
+ * Entry sizes to draw from
+ */
+class SizeDistribution
+{
+  public:
+    /** @param[in] spec - fixed:N, uniform:MIN:MAX or exponential:MEAN */
+    explicit SizeDistribution(std::string_view spec)
+    {
+        std::vector<size_t> values;
+        const size_t colon = spec.find(':');
+        kind = spec.substr(0, colon);
+        std::string_view rest =
+            colon == std::string_view::npos ? "" : spec.substr(colon + 1);
+        while (!rest.empty())
+        {
+            const size_t next = rest.find(':');
+            values.push_back(parseNumber(rest.substr(0, next)));
+            rest = next == std::string_view::npos ? std::string_view()
+                                                  : rest.substr(next + 1);
+        }
+
+        if (kind == "fixed" && values.size() == 1)
+        {
+            min = max = values[0];
+        }
+        else if (kind == "uniform" && values.size() == 2 &&
+                 values[0] <= values[1])
+        {
+            min = values[0];
+            max = values[1];
+        }
+        else if (kind == "exponential" && values.size() == 1 && values[0] > 0)
+        {
+            min = 1;
+            max = UINT16_MAX;
+            mean = values[0];
+        }
+        else
+        {
+            throw std::invalid_argument(
+                std::format("Invalid size distribution '{}'", spec));
+        }
+    }
+
+    size_t operator()(std::mt19937& random)
+    {
+        if (kind == "exponential")
+        {
+            std::exponential_distribution<double> exponential(1.0 / mean);
+            return std::clamp<size_t>(
+                static_cast<size_t>(exponential(random)), min, max);
+        }
+        return std::uniform_int_distribution<size_t>(min, max)(random);
+    }
+
+    static size_t parseNumber(std::string_view str)
+    {
+        size_t value = 0;
+        auto [ptr, ec] =
+            std::from_chars(str.data(), str.data() + str.size(), value);
+        if (ec != std::errc() || ptr != str.data() + str.size())
+        {
+            throw std::invalid_argument(
+                std::format("Invalid number '{}'", str));
+        }
+        return value;
+    }
+
+  private:
+    std::string kind;
+    size_t min = 0;
+    size_t max = 0;
+    size_t mean = 0;
+};
+
+struct Options
+{
+    std::string file;
+    size_t regionSize = 0x4000;
+    double rate = 1000;
+    size_t burst = 1;
+    uint64_t count = 0;
+    double duration = 0;
+    std::string size = "uniform:16:256";
+    uint8_t commandType = 2;
+    uint64_t ueEvery = 0;
+    uint32_t seed = 1;
+};
+
+Options parseOptions(int argc, char** argv)
+{
+    static const struct option longOptions[] = {
+        {"file", required_argument, nullptr, 'f'},
+        {"region-size", required_argument, nullptr, 'r'},
+        {"rate", required_argument, nullptr, 'R'},
+        {"burst", required_argument, nullptr, 'b'},
+        {"count", required_argument, nullptr, 'c'},
+        {"duration", required_argument, nullptr, 'd'},
+        {"size", required_argument, nullptr, 's'},
+        {"command-type", required_argument, nullptr, 't'},
+        {"ue-every", required_argument, nullptr, 'u'},
+        {"seed", required_argument, nullptr, 'S'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    Options options;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "f:r:R:b:c:d:s:t:u:S:", longOptions,
+                              nullptr)) != -1)
+    {
+        const std::string_view arg = optarg != nullptr ? optarg : "";
+        switch (opt)
+        {
+            case 'f':
+                options.file = arg;
+                break;
+            case 'r':
+                options.regionSize = SizeDistribution::parseNumber(arg);
+                break;
+            case 'R':
+                // 0 means as fast as the queue allows
+                options.rate = std::stod(std::string(arg));
+                break;
+            case 'b':
+                options.burst =
+                    std::max<size_t>(SizeDistribution::parseNumber(arg), 1);
+                break;
+            case 'c':
+                options.count = SizeDistribution::parseNumber(arg);
+                break;
+            case 'd':
+                options.duration = std::stod(std::string(arg));
+                break;
+            case 's':
+                options.size = arg;
+                break;
+            case 't':
+                options.commandType = SizeDistribution::parseNumber(arg);
+                break;
+            case 'u':
+                options.ueEvery = SizeDistribution::parseNumber(arg);
+                break;
+            case 'S':
+                options.seed = SizeDistribution::parseNumber(arg);
+                break;
+            default:
+                throw std::invalid_argument("Unknown option");
+        }
+    }
+    if (options.file.empty())
+    {
+        throw std::invalid_argument("--file is required");
+    }
+    return options;
+}
+
+void printStats(const BiosProducerStats& stats, Clock::duration elapsed)
+{
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    stdplus::print(
+        stdout,
+        "{:.1f}s: {} entries ({:.0f}/s, {:.0f} B/s), {} dropped, {} "
+        "overflows, {} UE logs ({} dropped), {} reattaches\n",
+        seconds, stats.entriesWritten, stats.entriesWritten / seconds,
+        stats.bytesWritten / seconds, stats.entriesDropped,
+        stats.overflowsSignaled, stats.ueLogsWritten, stats.ueLogsDropped,
+        stats.reattaches);
+}
+
+int run(const Options& options)
+{
+    auto dataHandler =
+        SharedMemoryDataHandler::openFile(options.file, options.regionSize);
+    BiosProducer producer(*dataHandler);
+
+    stdplus::print(stdout, "Waiting for the BMC to initialize {}\n",
+                   options.file);
+    while (!producer.isBufferInitialized())
+    {
+        if (stopRequested)
+        {
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    producer.attach();
+
+    std::mt19937 random(options.seed);
+    SizeDistribution entrySize(options.size);
+    std::uniform_int_distribution<int> byte(0, UINT8_MAX);
+    std::vector<uint8_t> payload;
+
+    const Clock::time_point start = Clock::now();
+    // Absolute schedule, so time spent writing doesn't lower the rate
+    Clock::time_point nextBurst = start;
+    Clock::time_point nextReport = start + std::chrono::seconds(1);
+    const auto burstInterval =
+        options.rate > 0
+            ? std::chrono::duration_cast<Clock::duration>(
+                  std::chrono::duration<double>(options.burst / options.rate))
+            : Clock::duration::zero();
+    uint64_t numEntries = 0;
+    while (!stopRequested &&
+           (options.count == 0 || numEntries < options.count) &&
+           (options.duration == 0 ||
+            Clock::now() - start <
+                std::chrono::duration<double>(options.duration)))
+    {
+        for (size_t i = 0; i < options.burst; ++i, ++numEntries)
+        {
+            payload.resize(entrySize(random));
+            std::generate(payload.begin(), payload.end(),
+                          [&]() { return byte(random); });
+            producer.writeEntry(options.commandType, payload);
+            if (options.ueEvery != 0 && numEntries % options.ueEvery == 0)
+            {
+                // Small enough for any UE region worth simulating
+                payload.resize(std::min<size_t>(payload.size(), 0x10));
+                producer.writeUeLog(payload);
+            }
+        }
+
+        const Clock::time_point now = Clock::now();
+        if (now >= nextReport)
+        {
+            printStats(producer.getStats(), now - start);
+            nextReport += std::chrono::seconds(1);
+        }
+        nextBurst += burstInterval;
+        if (nextBurst > now)
+        {
+            std::this_thread::sleep_until(nextBurst);
+        }
+        else if (options.rate > 0 && now - nextBurst > std::chrono::seconds(1))
+        {
+            // Can't keep up, don't try to catch up on everything missed
+            nextBurst = now;
+        }
+    }
+
+    printStats(producer.getStats(), Clock::now() - start);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::signal(SIGINT, [](int) { stopRequested = true; });
+    std::signal(SIGTERM, [](int) { stopRequested = true; });
+    try
+    {
+        return run(parseOptions(argc, argv));
+    }
+    catch (const std::exception& e)
+    {
+        stdplus::print(stderr, "bios-simulator: {}\n", e.what());
+        return 1;
+    }
+}
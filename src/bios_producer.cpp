@@ -0,0 +1,205 @@
+#include "bios_producer.hpp"
+
+#include "checksum/checksum.hpp"
+
+#include <boost/endian/arithmetic.hpp>
+#include <boost/endian/conversion.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <format>
+#include <stdexcept>
+#include <vector>
+
+namespace bios_bmc_smm_error_logger
+{
+
+namespace
+{
+
+constexpr size_t headerSize = sizeof(struct CircularBufferHeader);
+constexpr size_t entryHeaderSize = sizeof(struct QueueEntryHeader);
+constexpr uint32_t biosFieldsOffset =
+    offsetof(struct CircularBufferHeader, biosFlags);
+
+// biosFlags, biosWritePtr and reserved2, in the layout of the header
+struct BiosFields
+{
+    boost::endian::little_uint32_t biosFlags;
+    boost::endian::little_uint24_t biosWritePtr;
+    uint8_t reserved2;
+};
+static_assert(sizeof(BiosFields) == headerSize - biosFieldsOffset);
+
+} // namespace
+
+BiosProducer::BiosProducer(DataInterface& dataInterface) :
+    dataInterface(dataInterface)
+{}
+
+bool BiosProducer::isBufferInitialized()
+{
+    struct CircularBufferHeader header;
+    dataInterface.readInto(
+        0, std::span(reinterpret_cast<uint8_t*>(&header), headerSize));
+    return boost::endian::little_to_native(header.queueSize) >
+           headerSize + boost::endian::little_to_native(header.ueRegionSize);
+}
+
+void BiosProducer::attach()
+{
+    struct CircularBufferHeader header;
+    if (dataInterface.readInto(0, std::span(reinterpret_cast<uint8_t*>(&header),
+                                            headerSize)) != headerSize)
+    {
+        throw std::runtime_error("[attach] Failed to read the buffer header");
+    }
+    const uint32_t queueSize =
+        boost::endian::little_to_native(header.queueSize);
+    ueRegionSize = boost::endian::little_to_native(header.ueRegionSize);
+    if (queueSize <= headerSize + ueRegionSize ||
+        queueSize > dataInterface.getMemoryRegionSize())
+    {
+        throw std::runtime_error(std::format(
+            "[attach] Buffer is not initialized, queue size '{}' with a UE "
+            "region of '{}'",
+            queueSize, ueRegionSize));
+    }
+    queueOffset = headerSize + ueRegionSize;
+    maxOffset = queueSize - queueOffset;
+    biosFlags = boost::endian::little_to_native(header.biosFlags);
+    writePtr = boost::endian::little_to_native(header.biosWritePtr);
+}
+
+struct CircularBufferHeader BiosProducer::readHeader()
+{
+    // bmcReadPtr is written one byte at a time, read until two reads agree so
+    // a half written pointer is not mistaken for free space
+    struct CircularBufferHeader header;
+    struct CircularBufferHeader prevHeader;
+    auto read = [this](struct CircularBufferHeader& into) {
+        dataInterface.readInto(
+            0, std::span(reinterpret_cast<uint8_t*>(&into), headerSize));
+    };
+    read(header);
+    do
+    {
+        prevHeader = header;
+        read(header);
+    } while (header.bmcReadPtr != prevHeader.bmcReadPtr);
+
+    if (boost::endian::little_to_native(header.biosWritePtr) != writePtr ||
+        boost::endian::little_to_native(header.biosFlags) != biosFlags)
+    {
+        // Only the BMC initializing the buffer changes what BIOS wrote
+        attach();
+        ++stats.reattaches;
+    }
+    return header;
+}
+
+size_t BiosProducer::getQueueFreeBytes()
+{
+    const struct CircularBufferHeader header = readHeader();
+    const uint32_t readPtr = boost::endian::little_to_native(header.bmcReadPtr);
+    const uint32_t used = (writePtr + maxOffset - readPtr) % maxOffset;
+    // One byte always stays free, a full queue would look empty
+    return maxOffset - used - 1;
+}
+
+bool BiosProducer::writeEntry(uint8_t rdeCommandType,
+                              std::span<const uint8_t> payload)
+{
+    if (payload.size() > UINT16_MAX)
+    {
+        throw std::invalid_argument(std::format(
+            "[writeEntry] Entry of '{}' bytes is too big", payload.size()));
+    }
+    const uint16_t sequenceId = nextSequenceId++;
+    const size_t entryAndHeaderSize = entryHeaderSize + payload.size();
+    const size_t freeBytes = getQueueFreeBytes();
+    if (entryAndHeaderSize > freeBytes)
+    {
+        ++stats.entriesDropped;
+        struct CircularBufferHeader header = readHeader();
+        const uint32_t overflowPending =
+            (biosFlags ^ boost::endian::little_to_native(header.bmcFlags)) &
+            static_cast<uint32_t>(BufferFlags::overflow);
+        if (!overflowPending)
+        {
+            biosFlags ^= static_cast<uint32_t>(BufferFlags::overflow);
+            publish();
+            ++stats.overflowsSignaled;
+        }
+        return false;
+    }
+
+    struct QueueEntryHeader entryHeader = {};
+    entryHeader.sequenceId = boost::endian::native_to_little(sequenceId);
+    entryHeader.entrySize =
+        boost::endian::native_to_little(static_cast<uint16_t>(payload.size()));
+    entryHeader.rdeCommandType = rdeCommandType;
+    const uint8_t* entryHeaderPtr =
+        reinterpret_cast<const uint8_t*>(&entryHeader);
+    entryHeader.checksum =
+        xorChecksum(std::span(entryHeaderPtr, entryHeaderSize)) ^
+        xorChecksum(payload);
+
+    std::vector<uint8_t> entry(entryHeaderPtr,
+                               entryHeaderPtr + entryHeaderSize);
+    entry.insert(entry.end(), payload.begin(), payload.end());
+
+    // Wrap around to the start of the queue if needed
+    const size_t firstPart =
+        std::min<size_t>(entry.size(), maxOffset - writePtr);
+    dataInterface.write(queueOffset + writePtr,
+                        std::span(entry).first(firstPart));
+    if (firstPart < entry.size())
+    {
+        dataInterface.write(queueOffset, std::span(entry).subspan(firstPart));
+    }
+
+    writePtr = (writePtr + entry.size()) % maxOffset;
+    publish();
+    ++stats.entriesWritten;
+    stats.bytesWritten += entry.size();
+    return true;
+}
+
+bool BiosProducer::writeUeLog(std::span<const uint8_t> ueLog)
+{
+    if (ueLog.size() > ueRegionSize)
+    {
+        throw std::invalid_argument(std::format(
+            "[writeUeLog] UE log of '{}' bytes is bigger than the '{}' byte UE "
+            "region",
+            ueLog.size(), ueRegionSize));
+    }
+    struct CircularBufferHeader header = readHeader();
+    if ((biosFlags ^ boost::endian::little_to_native(header.bmcFlags)) &
+        static_cast<uint32_t>(BufferFlags::ueSwitch))
+    {
+        ++stats.ueLogsDropped;
+        return false;
+    }
+
+    std::vector<uint8_t> ueRegion(ueRegionSize, 0);
+    std::copy(ueLog.begin(), ueLog.end(), ueRegion.begin());
+    dataInterface.write(headerSize, ueRegion);
+    biosFlags ^= static_cast<uint32_t>(BufferFlags::ueSwitch);
+    publish();
+    ++stats.ueLogsWritten;
+    return true;
+}
+
+void BiosProducer::publish()
+{
+    BiosFields fields = {};
+    fields.biosFlags = boost::endian::native_to_little(biosFlags);
+    fields.biosWritePtr = boost::endian::native_to_little(writePtr);
+    dataInterface.write(
+        biosFieldsOffset,
+        std::span(reinterpret_cast<const uint8_t*>(&fields), sizeof(fields)));
+}
+
+} // namespace bios_bmc_smm_error_logger
@@ -2,6 +2,7 @@
 
 #include "buffer.hpp"
 
+#include "checksum/checksum.hpp"
 #include "pci_handler.hpp"
 
 #include <boost/endian/arithmetic.hpp>
@@ -14,15 +15,27 @@
 #include <cstdint>
 #include <format>
 #include <memory>
-#include <numeric>
+#include <optional>
 #include <span>
+#include <stdexcept>
+#include <string_view>
 #include <vector>
 
 namespace bios_bmc_smm_error_logger
 {
 
-BufferImpl::BufferImpl(std::unique_ptr<DataInterface> dataInterface) :
-    dataInterface(std::move(dataInterface)) {};
+BufferImpl::BufferImpl(std::unique_ptr<DataInterface> dataInterface,
+                       ReadPtrCommitPolicy commitPolicy) :
+    dataInterface(std::move(dataInterface)), commitPolicy(commitPolicy)
+{
+    if ((commitPolicy.mode == ReadPtrCommitMode::everyNEntries ||
+         commitPolicy.mode == ReadPtrCommitMode::everyNBytes) &&
+        commitPolicy.threshold == 0)
+    {
+        throw std::invalid_argument(
+            "[BufferImpl] Read pointer commit threshold must be > 0");
+    }
+}
 
 void BufferImpl::initialize(uint32_t bmcInterfaceVersion, uint16_t queueSize,
                             uint16_t ueRegionSize,
@@ -72,23 +85,31 @@ void BufferImpl::initialize(uint32_t bmcInterfaceVersion, uint16_t queueSize,
             "[initialize] Only wrote '{}' bytes of the header", byteWritten));
     }
     cachedBufferHeader = initializationHeader;
+    resetPendingEntries(0);
+    // Whatever was in the queue is gone, there is nothing to compare the next
+    // sequence ID with
+    lastSequenceId.reset();
+    overflowGapPending = false;
+    resyncGapPending = false;
 }
 
 void BufferImpl::readBufferHeader()
 {
     size_t headerSize = sizeof(struct CircularBufferHeader);
-    std::vector<uint8_t> bytesRead =
-        dataInterface->read(/*offset=*/0, headerSize);
+    struct CircularBufferHeader bufferHeader;
+    uint32_t bytesRead = dataInterface->readInto(
+        /*offset=*/0,
+        std::span<uint8_t>(reinterpret_cast<uint8_t*>(&bufferHeader),
+                           headerSize));
 
-    if (bytesRead.size() != headerSize)
+    if (bytesRead != headerSize)
     {
         throw std::runtime_error(
             std::format("Buffer header read only read '{}', expected '{}'",
-                        bytesRead.size(), headerSize));
+                        bytesRead, headerSize));
     }
 
-    cachedBufferHeader =
-        *reinterpret_cast<struct CircularBufferHeader*>(bytesRead.data());
+    cachedBufferHeader = bufferHeader;
 };
 
 struct CircularBufferHeader BufferImpl::getCachedBufferHeader() const
@@ -146,6 +167,41 @@ std::vector<uint8_t> BufferImpl::wraparoundRead(const uint32_t relativeOffset,
                                                 const uint32_t length)
 {
     const size_t maxOffset = getMaxOffset();
+    if (length > maxOffset)
+    {
+        throw std::runtime_error(std::format(
+            "[wraparoundRead] length '{}' was bigger than maxOffset '{}'",
+            length, maxOffset));
+    }
+
+    std::vector<uint8_t> bytesRead(length);
+    wraparoundReadInto(relativeOffset, bytesRead);
+    return bytesRead;
+}
+
+void BufferImpl::wraparoundReadInto(const uint32_t relativeOffset,
+                                    std::span<uint8_t> bytes)
+{
+    // readQueueRange will throw if the parameters are invalid or if it did not
+    // read all the bytes
+    readQueueRange(relativeOffset, bytes);
+
+    const size_t maxOffset = getMaxOffset();
+    size_t updatedReadPtr = relativeOffset + bytes.size();
+    if (updatedReadPtr >= maxOffset)
+    {
+        // If we read up to or past the end of the queue, wrap the read pointer
+        // around to the start of the queue
+        updatedReadPtr -= maxOffset;
+    }
+    updateReadPtr(updatedReadPtr);
+}
+
+void BufferImpl::readQueueRange(const uint32_t relativeOffset,
+                                std::span<uint8_t> bytes)
+{
+    const size_t maxOffset = getMaxOffset();
+    const size_t length = bytes.size();
 
     if (relativeOffset > maxOffset)
     {
@@ -172,62 +228,58 @@ std::vector<uint8_t> BufferImpl::wraparoundRead(const uint32_t relativeOffset,
     }
     const size_t numBytesToReadTillQueueEnd = length - numWraparoundBytesToRead;
 
-    std::vector<uint8_t> bytesRead = dataInterface->read(
-        queueOffset + relativeOffset, numBytesToReadTillQueueEnd);
-    if (bytesRead.size() != numBytesToReadTillQueueEnd)
+    if (numBytesToReadTillQueueEnd > 0)
     {
-        throw std::runtime_error(
-            std::format("[wraparoundRead] Read '{}' which was not "
-                        "the requested length of '{}'",
-                        bytesRead.size(), numBytesToReadTillQueueEnd));
-    }
-    size_t updatedReadPtr = relativeOffset + numBytesToReadTillQueueEnd;
-    if (updatedReadPtr == maxOffset)
-    {
-        // If we read all the way up to the end of the queue, we need to
-        // manually wrap the updateReadPtr around to 0
-        updatedReadPtr = 0;
+        uint32_t bytesRead = dataInterface->readInto(
+            queueOffset + relativeOffset,
+            bytes.first(numBytesToReadTillQueueEnd));
+        if (bytesRead != numBytesToReadTillQueueEnd)
+        {
+            throw std::runtime_error(
+                std::format("[wraparoundRead] Read '{}' which was not "
+                            "the requested length of '{}'",
+                            bytesRead, numBytesToReadTillQueueEnd));
+        }
     }
 
     // If there are any more bytes to be read beyond the buffer, wrap around and
     // read from the beginning of the buffer (offset by the queueOffset)
     if (numWraparoundBytesToRead > 0)
     {
-        std::vector<uint8_t> wrappedBytesRead =
-            dataInterface->read(queueOffset, numWraparoundBytesToRead);
-        if (numWraparoundBytesToRead != wrappedBytesRead.size())
+        uint32_t wrappedBytesRead = dataInterface->readInto(
+            queueOffset, bytes.subspan(numBytesToReadTillQueueEnd));
+        if (numWraparoundBytesToRead != wrappedBytesRead)
         {
             throw std::runtime_error(std::format(
                 "[wraparoundRead] Buffer wrapped around but read '{}' which "
                 "was not the requested lenght of '{}'",
-                wrappedBytesRead.size(), numWraparoundBytesToRead));
+                wrappedBytesRead, numWraparoundBytesToRead));
         }
-        bytesRead.insert(bytesRead.end(), wrappedBytesRead.begin(),
-                         wrappedBytesRead.end());
-        updatedReadPtr = numWraparoundBytesToRead;
     }
-    updateReadPtr(updatedReadPtr);
-
-    return bytesRead;
 }
 
 struct QueueEntryHeader BufferImpl::readEntryHeader()
 {
-    size_t headerSize = sizeof(struct QueueEntryHeader);
+    struct QueueEntryHeader entryHeader;
     // wraparonudRead will throw if it did not read all the bytes, let it
     // propagate up the stack
-    std::vector<uint8_t> bytesRead = wraparoundRead(
+    wraparoundReadInto(
         boost::endian::little_to_native(cachedBufferHeader.bmcReadPtr),
-        headerSize);
+        std::span<uint8_t>(reinterpret_cast<uint8_t*>(&entryHeader),
+                           sizeof(struct QueueEntryHeader)));
 
-    return *reinterpret_cast<struct QueueEntryHeader*>(bytesRead.data());
+    return entryHeader;
 }
 
 std::vector<uint8_t> BufferImpl::readUeLogFromReservedRegion()
 {
     // Ensure cachedBufferHeader is up-to-date
     readBufferHeader();
+    return readPendingUeLog();
+}
 
+std::vector<uint8_t> BufferImpl::readPendingUeLog()
+{
     uint16_t currentUeRegionSize =
         boost::endian::little_to_native(cachedBufferHeader.ueRegionSize);
     if (currentUeRegionSize == 0)
@@ -237,43 +289,57 @@ std::vector<uint8_t> BufferImpl::readUeLogFromReservedRegion()
         return {};
     }
 
-    uint32_t biosSideFlags =
-        boost::endian::little_to_native(cachedBufferHeader.biosFlags);
-    uint32_t bmcSideFlags =
-        boost::endian::little_to_native(cachedBufferHeader.bmcFlags);
-
-    // (BIOS_switch ^ BMC_switch) & BIT0 == BIT0 -> unread log
-    // This means if the ueSwitch bit differs, there's an unread log.
-    if (!((biosSideFlags ^ bmcSideFlags) &
-          static_cast<uint32_t>(BufferFlags::ueSwitch)))
+    if (!isUeLogPending())
     {
         return {};
     }
     // UE log should be present and unread by BMC, read from end of header
     // (0x30) to the size of the UE region specified in the header.
     size_t ueRegionOffset = sizeof(struct CircularBufferHeader);
-    std::vector<uint8_t> ueLogData =
-        dataInterface->read(ueRegionOffset, currentUeRegionSize);
+    std::vector<uint8_t> ueLogData(currentUeRegionSize);
+    uint32_t bytesRead = dataInterface->readInto(ueRegionOffset, ueLogData);
 
-    if (ueLogData.size() == currentUeRegionSize)
+    if (bytesRead == currentUeRegionSize)
     {
         return ueLogData;
     }
     stdplus::print(stderr,
                    "[readUeLogFromReservedRegion] Failed to read "
                    "full UE log. Expected {}, got {}\n",
-                   currentUeRegionSize, ueLogData.size());
+                   currentUeRegionSize, bytesRead);
     // Throwing an exception allows main loop to handle re-init.
     throw std::runtime_error(
         std::format("Failed to read full UE log. Expected {}, got {}",
-                    currentUeRegionSize, ueLogData.size()));
+                    currentUeRegionSize, bytesRead));
+}
+
+bool BufferImpl::isUeLogPending() const
+{
+    if (boost::endian::little_to_native(cachedBufferHeader.ueRegionSize) == 0)
+    {
+        return false;
+    }
+
+    uint32_t biosSideFlags =
+        boost::endian::little_to_native(cachedBufferHeader.biosFlags);
+    uint32_t bmcSideFlags =
+        boost::endian::little_to_native(cachedBufferHeader.bmcFlags);
+
+    // (BIOS_switch ^ BMC_switch) & BIT0 == BIT0 -> unread log
+    // This means if the ueSwitch bit differs, there's an unread log.
+    return (biosSideFlags ^ bmcSideFlags) &
+           static_cast<uint32_t>(BufferFlags::ueSwitch);
 }
 
 bool BufferImpl::checkForOverflowAndAcknowledge()
 {
     // Ensure cachedBufferHeader is up-to-date
     readBufferHeader();
+    return acknowledgeOverflow();
+}
 
+bool BufferImpl::acknowledgeOverflow()
+{
     uint32_t biosSideFlags =
         boost::endian::little_to_native(cachedBufferHeader.biosFlags);
     uint32_t bmcSideFlags =
@@ -290,6 +356,8 @@ bool BufferImpl::checkForOverflowAndAcknowledge()
         uint32_t newBmcFlags =
             bmcSideFlags ^ static_cast<uint32_t>(BufferFlags::overflow);
         updateBmcFlags(newBmcFlags);
+        ++sequenceStats.overflows;
+        overflowGapPending = true;
 
         // Overflow was detected and acknowledged
         return true;
@@ -306,17 +374,16 @@ EntryPair BufferImpl::readEntry()
 
     // wraparonudRead may throw if entrySize was bigger than the buffer or if it
     // was not able to read all the bytes, let it propagate up the stack
-    std::vector<uint8_t> entry = wraparoundRead(
-        boost::endian::little_to_native(cachedBufferHeader.bmcReadPtr),
-        entrySize);
+    std::vector<uint8_t> entry(entrySize);
+    wraparoundReadInto(
+        boost::endian::little_to_native(cachedBufferHeader.bmcReadPtr), entry);
 
     // Calculate the checksum
-    uint8_t* entryHeaderPtr = reinterpret_cast<uint8_t*>(&entryHeader);
     uint8_t checksum =
-        std::accumulate(entryHeaderPtr,
-                        entryHeaderPtr + sizeof(struct QueueEntryHeader), 0,
-                        std::bit_xor<void>()) ^
-        std::accumulate(entry.begin(), entry.end(), 0, std::bit_xor<void>());
+        calculateChecksum(std::span<const uint8_t>(
+            reinterpret_cast<const uint8_t*>(&entryHeader),
+            sizeof(struct QueueEntryHeader))) ^
+        calculateChecksum(entry);
 
     if (checksum != 0)
     {
@@ -327,11 +394,175 @@ EntryPair BufferImpl::readEntry()
     return {entryHeader, entry};
 }
 
+uint8_t BufferImpl::calculateChecksum(std::span<const uint8_t> entry)
+{
+    return xorChecksum(entry);
+}
+
+struct QueueEntryHeader BufferImpl::parseEntry(std::span<const uint8_t> bytes)
+{
+    constexpr size_t headerSize = sizeof(struct QueueEntryHeader);
+    if (bytes.size() < headerSize)
+    {
+        throw std::runtime_error(std::format(
+            "[parseEntry] Only '{}' bytes left, which is smaller than the "
+            "entry header",
+            bytes.size()));
+    }
+
+    struct QueueEntryHeader entryHeader;
+    std::copy_n(bytes.begin(), headerSize,
+                reinterpret_cast<uint8_t*>(&entryHeader));
+    size_t entrySize = boost::endian::little_to_native(entryHeader.entrySize);
+    if (headerSize + entrySize > bytes.size())
+    {
+        throw std::runtime_error(std::format(
+            "[parseEntry] Entry size '{}' runs past the '{}' pending bytes "
+            "left in the queue",
+            entrySize, bytes.size() - headerSize));
+    }
+
+    // The entry is validated where it is, it only gets copied if the caller
+    // asks for a copy
+    uint8_t checksum = calculateChecksum(bytes.first(headerSize + entrySize));
+    if (checksum != 0)
+    {
+        throw std::runtime_error(std::format(
+            "[parseEntry] Checksum was '{}', expected '0'", checksum));
+    }
+    return entryHeader;
+}
+
+std::optional<struct QueueEntryHeader>
+    BufferImpl::checkEntry(std::span<const uint8_t> bytes)
+{
+    constexpr size_t headerSize = sizeof(struct QueueEntryHeader);
+    if (bytes.size() < headerSize)
+    {
+        return std::nullopt;
+    }
+
+    struct QueueEntryHeader entryHeader;
+    std::copy_n(bytes.begin(), headerSize,
+                reinterpret_cast<uint8_t*>(&entryHeader));
+    size_t entrySize = boost::endian::little_to_native(entryHeader.entrySize);
+    if (headerSize + entrySize > bytes.size() ||
+        calculateChecksum(bytes.first(headerSize + entrySize)) != 0)
+    {
+        return std::nullopt;
+    }
+    return entryHeader;
+}
+
+std::optional<size_t>
+    BufferImpl::findNextEntry(std::span<const uint8_t> pendingBytes,
+                              size_t corruptOffset,
+                              std::optional<uint16_t> prevSequenceId)
+{
+    constexpr size_t headerSize = sizeof(struct QueueEntryHeader);
+    for (size_t offset = corruptOffset + 1;
+         offset + headerSize <= pendingBytes.size(); ++offset)
+    {
+        std::optional<struct QueueEntryHeader> candidate =
+            checkEntry(pendingBytes.subspan(offset));
+        // BIOS never logs empty entries, while zeroed memory always looks
+        // like a valid empty entry
+        if (!candidate || candidate->entrySize == 0)
+        {
+            continue;
+        }
+
+        const uint16_t sequenceId =
+            boost::endian::little_to_native(candidate->sequenceId);
+        if (prevSequenceId)
+        {
+            // Every lost entry takes up more than a header worth of the
+            // skipped bytes, which bounds how far the sequence ID can jump
+            const uint16_t entriesLost =
+                sequenceId - static_cast<uint16_t>(*prevSequenceId + 1);
+            if (entriesLost > (offset - corruptOffset) / headerSize)
+            {
+                continue;
+            }
+        }
+
+        // Confirm the candidate with what follows it, a single 8 bit checksum
+        // is too easy to match by chance
+        const size_t nextOffset =
+            offset + headerSize +
+            boost::endian::little_to_native(candidate->entrySize);
+        if (nextOffset == pendingBytes.size())
+        {
+            return offset;
+        }
+        std::optional<struct QueueEntryHeader> next =
+            checkEntry(pendingBytes.subspan(nextOffset));
+        if (next && boost::endian::little_to_native(next->sequenceId) ==
+                        static_cast<uint16_t>(sequenceId + 1))
+        {
+            return offset;
+        }
+    }
+    return std::nullopt;
+}
+
+size_t BufferImpl::resync(std::span<const uint8_t> pendingBytes,
+                          size_t corruptOffset,
+                          std::optional<uint16_t> prevSequenceId,
+                          std::string_view reason)
+{
+    std::optional<size_t> nextEntry =
+        findNextEntry(pendingBytes, corruptOffset, prevSequenceId);
+    size_t bytesSkipped = pendingBytes.size() - corruptOffset;
+    if (nextEntry)
+    {
+        bytesSkipped = *nextEntry - corruptOffset;
+    }
+    else
+    {
+        ++recoveryStats.writePtrFallbacks;
+    }
+    ++recoveryStats.resyncs;
+    recoveryStats.bytesSkipped += bytesSkipped;
+    resyncGapPending = true;
+
+    stdplus::print(stderr,
+                   "[readPendingErrorLogs] {}. Skipped '{}' bytes to {}\n",
+                   reason, bytesSkipped,
+                   nextEntry ? "the next valid entry" : "biosWritePtr");
+    return bytesSkipped;
+}
+
 std::vector<EntryPair> BufferImpl::readErrorLogs()
 {
     // Reading the buffer header will update the cachedBufferHeader
     readBufferHeader();
+    std::vector<EntryPair> entryPairs = readPendingErrorLogs();
+
+    // The caller gets its own copy of every entry, consider them all consumed
+    for (size_t i = 0; i < entryPairs.size(); ++i)
+    {
+        markEntryConsumed();
+    }
+    commitReadPtr();
+    return entryPairs;
+}
+
+PollResult BufferImpl::poll()
+{
+    // This is the only header read for the whole tick, everything below works
+    // off the cachedBufferHeader
+    readBufferHeader();
 
+    PollResult result;
+    result.ueLogPending = isUeLogPending();
+    result.overflowAcknowledged = acknowledgeOverflow();
+    result.queueBytesPending = getQueueBytesPending();
+    return result;
+}
+
+size_t BufferImpl::getQueueBytesPending()
+{
     const size_t maxOffset = getMaxOffset();
     size_t currentBiosWritePtr =
         boost::endian::little_to_native(cachedBufferHeader.biosWritePtr);
@@ -346,51 +577,280 @@ std::vector<EntryPair> BufferImpl::readErrorLogs()
         boost::endian::little_to_native(cachedBufferHeader.bmcReadPtr);
     if (currentReadPtr > maxOffset)
     {
-        throw std::runtime_error(std::format(
-            "[readErrorLogs] currentReadPtr was '{}' which was bigger "
-            "than maxOffset '{}'",
-            currentReadPtr, maxOffset));
+        // The read pointer is ours, there is no telling where the unread
+        // entries start. Drop them and realign with BIOS rather than wiping
+        // the whole buffer.
+        stdplus::print(stderr,
+                       "[readErrorLogs] currentReadPtr was '{}' which was "
+                       "bigger than maxOffset '{}'. Skipping to "
+                       "biosWritePtr '{}'\n",
+                       currentReadPtr, maxOffset, currentBiosWritePtr);
+        ++recoveryStats.resyncs;
+        ++recoveryStats.writePtrFallbacks;
+        resyncGapPending = true;
+        updateReadPtr(currentBiosWritePtr);
+        resetPendingEntries(currentBiosWritePtr);
+        return 0;
     }
 
-    size_t bytesToRead;
-    if (currentBiosWritePtr == currentReadPtr)
+    if (currentBiosWritePtr >= currentReadPtr)
     {
-        // No new payload was detected, return an empty vector gracefully
-        return {};
+        // Simply subtract in this case
+        return currentBiosWritePtr - currentReadPtr;
     }
+    // Calculate the bytes to the "end" (maxOffset - ReadPtr) +
+    // bytes to read from the "beginning" (0 +  WritePtr)
+    return (maxOffset - currentReadPtr) + currentBiosWritePtr;
+}
 
-    if (currentBiosWritePtr > currentReadPtr)
+std::vector<EntryPair> BufferImpl::readPendingErrorLogs()
+{
+    std::vector<EntryPair> entryPairs;
+    forEachPendingEntry([&entryPairs](
+                            const struct QueueEntryHeader& entryHeader,
+                            std::span<const uint8_t> entry) {
+        entryPairs.emplace_back(
+            entryHeader, std::vector<uint8_t>(entry.begin(), entry.end()));
+    });
+
+    // The read pointer is only moved once the entries have been consumed, see
+    // markEntryConsumed and commitReadPtr
+    return entryPairs;
+}
+
+size_t BufferImpl::drain(EntryVisitor visitor)
+{
+    size_t numEntries = 0;
+    try
     {
-        // Simply subtract in this case
-        bytesToRead = currentBiosWritePtr - currentReadPtr;
+        forEachPendingEntry([&](const struct QueueEntryHeader& entryHeader,
+                                std::span<const uint8_t> entry) {
+            visitor(entryHeader, entry);
+            markEntryConsumed();
+            ++numEntries;
+        });
     }
-    else
+    catch (...)
     {
-        // Calculate the bytes to the "end" (maxOffset - ReadPtr) +
-        // bytes to read from the "beginning" (0 +  WritePtr)
-        bytesToRead = (maxOffset - currentReadPtr) + currentBiosWritePtr;
+        // Don't make BIOS resend what was already handled
+        commitReadPtr();
+        throw;
     }
+    commitReadPtr();
+    return numEntries;
+}
+
+void BufferImpl::forEachPendingEntry(EntryVisitor visitor)
+{
+    // Entries from a previous batch that were never consumed will be read
+    // again, since the read pointer was not moved past them
+    uint32_t entryEnd =
+        boost::endian::little_to_native(cachedBufferHeader.bmcReadPtr);
+    resetPendingEntries(entryEnd);
+
+    size_t bytesToRead = getQueueBytesPending();
+    if (bytesToRead == 0)
+    {
+        // No new payload was detected
+        return;
+    }
+
+    // Copy the whole pending range in at most 2 reads, and parse the entries
+    // out of local memory rather than going back to the buffer for each one.
+    // queueShadow is only sized once, so draining any amount of entries does
+    // not allocate.
+    const size_t maxOffset = getMaxOffset();
+    if (queueShadow.size() < maxOffset)
+    {
+        queueShadow.resize(maxOffset);
+    }
+    std::span<uint8_t> pendingBytes =
+        std::span(queueShadow).first(bytesToRead);
+    readQueueRange(
+        boost::endian::little_to_native(cachedBufferHeader.bmcReadPtr),
+        pendingBytes);
 
     size_t byteRead = 0;
-    std::vector<EntryPair> entryPairs;
+    std::optional<uint16_t> prevSequenceId = lastSequenceId;
     while (byteRead < bytesToRead)
     {
-        EntryPair entryPair = readEntry();
-        byteRead += sizeof(struct QueueEntryHeader) + entryPair.second.size();
-        entryPairs.push_back(entryPair);
+        std::span<const uint8_t> entryBytes = pendingBytes.subspan(byteRead);
+        struct QueueEntryHeader entryHeader;
+        try
+        {
+            entryHeader = parseEntry(entryBytes);
+        }
+        catch (const std::runtime_error& e)
+        {
+            // Skip the corrupt entry instead of failing the whole batch, the
+            // bytes skipped are released along with the next entry consumed
+            const size_t bytesSkipped =
+                resync(pendingBytes, byteRead, prevSequenceId, e.what());
+            byteRead += bytesSkipped;
+            entryEnd = (entryEnd + bytesSkipped) % maxOffset;
+            continue;
+        }
+        std::span<const uint8_t> entry = entryBytes.subspan(
+            sizeof(struct QueueEntryHeader),
+            boost::endian::little_to_native(entryHeader.entrySize));
+        const size_t entryAndHeaderSize =
+            sizeof(struct QueueEntryHeader) + entry.size();
+        byteRead += entryAndHeaderSize;
+
+        entryEnd = (entryEnd + entryAndHeaderSize) % maxOffset;
+        prevSequenceId =
+            boost::endian::little_to_native(entryHeader.sequenceId);
+        pendingEntries.push_back(
+            {entryEnd, *prevSequenceId, resyncGapPending});
+        resyncGapPending = false;
+        if (byteRead == bytesToRead)
+        {
+            // Known before the visitor runs, so that consuming the last entry
+            // also releases everything up to biosWritePtr
+            batchEndReadPtr = entryEnd;
+        }
+
+        visitor(entryHeader, entry);
+    }
+    batchEndReadPtr = entryEnd;
+}
+
+void BufferImpl::markEntryConsumed()
+{
+    if (numEntriesConsumed >= pendingEntries.size())
+    {
+        throw std::runtime_error(
+            "[markEntryConsumed] No pending entry left to mark as consumed");
+    }
+    const PendingEntry& pendingEntry = pendingEntries[numEntriesConsumed++];
+    const uint32_t entryEnd = pendingEntry.end;
+    trackSequenceId(pendingEntry.sequenceId, pendingEntry.afterResync);
+    const uint32_t entryBytes =
+        (entryEnd + getMaxOffset() - consumedReadPtr) % getMaxOffset();
+    consumedReadPtr = entryEnd;
+    ++entriesSinceCommit;
+    bytesSinceCommit += entryBytes;
+
+    bool commit = false;
+    switch (commitPolicy.mode)
+    {
+        case ReadPtrCommitMode::perEntry:
+            commit = true;
+            break;
+        case ReadPtrCommitMode::everyNEntries:
+            commit = entriesSinceCommit >= commitPolicy.threshold;
+            break;
+        case ReadPtrCommitMode::everyNBytes:
+            commit = bytesSinceCommit >= commitPolicy.threshold;
+            break;
+        case ReadPtrCommitMode::perBatch:
+            break;
+    }
+    if (commit)
+    {
+        commitReadPtr();
+    }
+}
 
-        // Note: readEntry() will update cachedBufferHeader.bmcReadPtr
-        currentReadPtr =
-            boost::endian::little_to_native(cachedBufferHeader.bmcReadPtr);
+void BufferImpl::commitReadPtr()
+{
+    entriesSinceCommit = 0;
+    bytesSinceCommit = 0;
+    if (numEntriesConsumed == pendingEntries.size())
+    {
+        // Also release any corrupt bytes skipped after the last entry
+        consumedReadPtr = batchEndReadPtr;
     }
-    if (currentBiosWritePtr != currentReadPtr)
+    if (consumedReadPtr ==
+        boost::endian::little_to_native(cachedBufferHeader.bmcReadPtr))
     {
-        throw std::runtime_error(std::format(
-            "[readErrorLogs] biosWritePtr '{}' and bmcReaddPtr '{}' "
-            "are not identical after reading through all the logs",
-            currentBiosWritePtr, currentReadPtr));
+        return;
     }
-    return entryPairs;
+    updateReadPtr(consumedReadPtr);
+}
+
+void BufferImpl::trackSequenceId(uint16_t sequenceId, bool afterResync)
+{
+    ++sequenceStats.entries;
+    if (!lastSequenceId)
+    {
+        lastSequenceId = sequenceId;
+        return;
+    }
+
+    // Sequence IDs are 16 bits and wrap around, work with the distance from
+    // the expected ID modulo 2^16
+    const uint16_t expectedSequenceId = *lastSequenceId + 1;
+    const uint16_t ahead = sequenceId - expectedSequenceId;
+    const uint16_t behind = *lastSequenceId - sequenceId;
+    // Only entries still in the queue can show up again or out of order
+    const size_t maxEntriesInQueue =
+        getMaxOffset() / (sizeof(struct QueueEntryHeader) + 1);
+
+    if (ahead == 0)
+    {
+        lastSequenceId = sequenceId;
+    }
+    else if (ahead < 0x8000)
+    {
+        ++sequenceStats.gaps;
+        sequenceStats.entriesLost += ahead;
+        const char* cause = "";
+        if (afterResync)
+        {
+            sequenceStats.entriesLostToResync += ahead;
+            cause = " after skipping corrupt bytes";
+        }
+        else if (overflowGapPending)
+        {
+            sequenceStats.entriesLostToOverflow += ahead;
+            overflowGapPending = false;
+            cause = " after an overflow";
+        }
+        stdplus::print(stderr,
+                       "[markEntryConsumed] Sequence ID jumped from '{}' to "
+                       "'{}'{}, '{}' entries lost\n",
+                       *lastSequenceId, sequenceId, cause, ahead);
+        lastSequenceId = sequenceId;
+    }
+    else if (behind == 0)
+    {
+        ++sequenceStats.duplicates;
+    }
+    else if (behind <= maxEntriesInQueue)
+    {
+        // Keep expecting the entry after the newest one seen
+        ++sequenceStats.reordered;
+    }
+    else
+    {
+        ++sequenceStats.restarts;
+        stdplus::print(stderr,
+                       "[markEntryConsumed] Sequence ID restarted from '{}' "
+                       "to '{}'\n",
+                       *lastSequenceId, sequenceId);
+        lastSequenceId = sequenceId;
+    }
+}
+
+RecoveryStats BufferImpl::getRecoveryStats() const
+{
+    return recoveryStats;
+}
+
+SequenceStats BufferImpl::getSequenceStats() const
+{
+    return sequenceStats;
+}
+
+void BufferImpl::resetPendingEntries(uint32_t readPtr)
+{
+    consumedReadPtr = readPtr;
+    batchEndReadPtr = readPtr;
+    pendingEntries.clear();
+    numEntriesConsumed = 0;
+    entriesSinceCommit = 0;
+    bytesSinceCommit = 0;
 }
 
 size_t BufferImpl::getMaxOffset()
@@ -0,0 +1,223 @@
+#include "checksum/checksum.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <span>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace bios_bmc_smm_error_logger
+{
+
+namespace
+{
+
+// Kernels return the XOR of all the bytes
+using XorKernel = uint8_t (*)(const uint8_t* bytes, size_t length);
+
+uint8_t foldWord(uint64_t word)
+{
+    word ^= word >> 32;
+    word ^= word >> 16;
+    word ^= word >> 8;
+    return static_cast<uint8_t>(word);
+}
+
+uint8_t xorPortable(const uint8_t* bytes, size_t length)
+{
+    uint64_t acc = 0;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        acc ^= word;
+    }
+
+    uint8_t checksum = foldWord(acc);
+    for (; i < length; ++i)
+    {
+        checksum ^= bytes[i];
+    }
+    return checksum;
+}
+
+// Finish the bytes left over by a vector kernel
+uint8_t xorTail(const uint8_t* bytes, size_t done, size_t length)
+{
+    return xorPortable(bytes + done, length - done);
+}
+
+#if defined(__SSE2__)
+uint8_t xorSse2(const uint8_t* bytes, size_t length)
+{
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + sizeof(__m128i) <= length; i += sizeof(__m128i))
+    {
+        acc = _mm_xor_si128(
+            acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i)));
+    }
+
+    uint64_t lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+    return foldWord(lanes[0] ^ lanes[1]) ^ xorTail(bytes, i, length);
+}
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2"))) uint8_t
+    xorAvx2(const uint8_t* bytes, size_t length)
+{
+    // Two accumulators so that consecutive loads do not wait on each other
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 2 * sizeof(__m256i) <= length; i += 2 * sizeof(__m256i))
+    {
+        acc0 = _mm256_xor_si256(
+            acc0,
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + i)));
+        acc1 = _mm256_xor_si256(
+            acc1, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+                      bytes + i + sizeof(__m256i))));
+    }
+    for (; i + sizeof(__m256i) <= length; i += sizeof(__m256i))
+    {
+        acc0 = _mm256_xor_si256(
+            acc0,
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + i)));
+    }
+
+    uint64_t lanes[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes),
+                        _mm256_xor_si256(acc0, acc1));
+    return foldWord(lanes[0] ^ lanes[1] ^ lanes[2] ^ lanes[3]) ^
+           xorTail(bytes, i, length);
+}
+#endif
+
+#if defined(__ARM_NEON)
+uint8_t xorNeon(const uint8_t* bytes, size_t length)
+{
+    uint8x16_t acc = vdupq_n_u8(0);
+    size_t i = 0;
+    for (; i + sizeof(uint8x16_t) <= length; i += sizeof(uint8x16_t))
+    {
+        acc = veorq_u8(acc, vld1q_u8(bytes + i));
+    }
+
+    uint64x2_t lanes = vreinterpretq_u64_u8(acc);
+    return foldWord(vgetq_lane_u64(lanes, 0) ^ vgetq_lane_u64(lanes, 1)) ^
+           xorTail(bytes, i, length);
+}
+#endif
+
+XorKernel getXorKernel(ChecksumKernel kernel)
+{
+    if (!isChecksumKernelSupported(kernel))
+    {
+        throw std::runtime_error(
+            std::format("[getXorKernel] Checksum kernel '{}' is not supported",
+                        static_cast<int>(kernel)));
+    }
+    switch (kernel)
+    {
+#if defined(__SSE2__)
+        case ChecksumKernel::sse2:
+            return xorSse2;
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+        case ChecksumKernel::avx2:
+            return xorAvx2;
+#endif
+#if defined(__ARM_NEON)
+        case ChecksumKernel::neon:
+            return xorNeon;
+#endif
+        default:
+            return xorPortable;
+    }
+}
+
+XorKernel bestXorKernel()
+{
+    static const XorKernel kernel = getXorKernel(bestChecksumKernel());
+    return kernel;
+}
+
+// Below this, the kernels do not get to use their vectors and the indirect
+// call costs more than it saves
+constexpr size_t minKernelSize = 16;
+
+} // namespace
+
+bool isChecksumKernelSupported(ChecksumKernel kernel)
+{
+    switch (kernel)
+    {
+        case ChecksumKernel::portable:
+            return true;
+        case ChecksumKernel::sse2:
+#if defined(__SSE2__)
+            return true;
+#else
+            return false;
+#endif
+        case ChecksumKernel::avx2:
+#if defined(__x86_64__) || defined(__i386__)
+            return __builtin_cpu_supports("avx2");
+#else
+            return false;
+#endif
+        case ChecksumKernel::neon:
+            // NEON is only used when the build targets it, there is no
+            // portable runtime check for it on 32-bit ARM
+#if defined(__ARM_NEON)
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+ChecksumKernel bestChecksumKernel()
+{
+    static const ChecksumKernel best = [] {
+        for (ChecksumKernel kernel :
+             {ChecksumKernel::avx2, ChecksumKernel::sse2, ChecksumKernel::neon})
+        {
+            if (isChecksumKernelSupported(kernel))
+            {
+                return kernel;
+            }
+        }
+        return ChecksumKernel::portable;
+    }();
+    return best;
+}
+
+uint8_t xorChecksum(std::span<const uint8_t> bytes)
+{
+    if (bytes.size() < minKernelSize)
+    {
+        return xorPortable(bytes.data(), bytes.size());
+    }
+    return bestXorKernel()(bytes.data(), bytes.size());
+}
+
+uint8_t xorChecksum(ChecksumKernel kernel, std::span<const uint8_t> bytes)
+{
+    return getXorKernel(kernel)(bytes.data(), bytes.size());
+}
+
+} // namespace bios_bmc_smm_error_logger
@@ -0,0 +1,293 @@
+#include "checksum/crc32.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#if defined(__aarch64__)
+#include <arm_acle.h>
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
+namespace bios_bmc_smm_error_logger
+{
+
+namespace
+{
+
+/**
+ * @brief CRC-32 divisor.
+ *
+ * This is equivalent to the one used by IEEE802.3.
+ */
+constexpr uint32_t crcDevisor = 0xedb88320;
+
+constexpr size_t numSlices = 8;
+
+// Small enough for the appended bytes to still be in L1 when the CRC reads
+// them
+constexpr size_t appendChunkSize = 4096;
+
+// crcTables[0] is the usual byte at a time table. crcTables[k][i] is the CRC
+// of byte i followed by k zero bytes, which lets slicing-by-8 look up the 8
+// bytes of a word independently and XOR the results.
+constexpr std::array<std::array<uint32_t, UINT8_MAX + 1>, numSlices>
+    crcTables = [] {
+        std::array<std::array<uint32_t, UINT8_MAX + 1>, numSlices> tables{};
+        for (uint32_t i = 0; i < tables[0].size(); ++i)
+        {
+            uint32_t rem = i;
+            for (uint8_t k = 0; k < 8; ++k)
+            {
+                rem = (rem & 1) ? (rem >> 1) ^ crcDevisor : rem >> 1;
+            }
+            tables[0][i] = rem;
+        }
+        for (size_t k = 1; k < numSlices; ++k)
+        {
+            for (uint32_t i = 0; i < tables[k].size(); ++i)
+            {
+                const uint32_t prev = tables[k - 1][i];
+                tables[k][i] = tables[0][prev & 0xff] ^ (prev >> 8);
+            }
+        }
+        return tables;
+    }();
+
+static_assert(crcTables[0][1] == 0x77073096, "Wrong CRC-32 table");
+
+using Crc32Fn = uint32_t (*)(uint32_t crc, const uint8_t* bytes,
+                             size_t length);
+
+uint32_t crc32Bytewise(uint32_t crc, const uint8_t* bytes, size_t length)
+{
+    for (size_t i = 0; i < length; ++i)
+    {
+        crc = crcTables[0][(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+uint32_t crc32SlicingBy8(uint32_t crc, const uint8_t* bytes, size_t length)
+{
+    size_t i = 0;
+    for (; i + numSlices <= length; i += numSlices)
+    {
+        // Assembled byte by byte so that this works on any endianness, the
+        // compiler turns it into plain loads on little-endian CPUs
+        const uint32_t lo =
+            crc ^ (bytes[i] | (bytes[i + 1] << 8) | (bytes[i + 2] << 16) |
+                   (static_cast<uint32_t>(bytes[i + 3]) << 24));
+        crc = crcTables[7][lo & 0xff] ^ crcTables[6][(lo >> 8) & 0xff] ^
+              crcTables[5][(lo >> 16) & 0xff] ^ crcTables[4][lo >> 24] ^
+              crcTables[3][bytes[i + 4]] ^ crcTables[2][bytes[i + 5]] ^
+              crcTables[1][bytes[i + 6]] ^ crcTables[0][bytes[i + 7]];
+    }
+    return crc32Bytewise(crc, bytes + i, length - i);
+}
+
+#if defined(__aarch64__)
+__attribute__((target("+crc"))) uint32_t
+    crc32Armv8(uint32_t crc, const uint8_t* bytes, size_t length)
+{
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        __builtin_memcpy(&word, bytes + i, sizeof(word));
+        crc = __crc32d(crc, word);
+    }
+    for (; i < length; ++i)
+    {
+        crc = __crc32b(crc, bytes[i]);
+    }
+    return crc;
+}
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+// Folds 64 bytes at a time with carry-less multiplications, then reduces the
+// remainder with a Barrett reduction. Constants are from "Fast CRC
+// Computation for Generic Polynomials Using PCLMULQDQ Instruction" (Intel),
+// for the bit-reflected IEEE 802.3 polynomial.
+constexpr size_t pclmulMinLength = 64;
+
+__attribute__((target("pclmul,sse4.1"))) __m128i load(const uint8_t* ptr)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+}
+
+// Multiply both halves of x by the constants in k and add in the next block
+__attribute__((target("pclmul,sse4.1"))) __m128i fold(__m128i x, __m128i k,
+                                                       __m128i next)
+{
+    return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x11),
+                                       _mm_clmulepi64_si128(x, k, 0x00)),
+                         next);
+}
+
+__attribute__((target("pclmul,sse4.1"))) uint32_t
+    crc32PclmulBlocks(uint32_t crc, const uint8_t* bytes, size_t length)
+{
+    const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+    const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+    const __m128i k5k0 = _mm_set_epi64x(0x0000000000, 0x0163cd6124);
+    const __m128i poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+    const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+    __m128i x1 = _mm_xor_si128(load(bytes), _mm_cvtsi32_si128(crc));
+    __m128i x2 = load(bytes + 0x10);
+    __m128i x3 = load(bytes + 0x20);
+    __m128i x4 = load(bytes + 0x30);
+    bytes += 64;
+    length -= 64;
+
+    while (length >= 64)
+    {
+        x1 = fold(x1, k1k2, load(bytes));
+        x2 = fold(x2, k1k2, load(bytes + 0x10));
+        x3 = fold(x3, k1k2, load(bytes + 0x20));
+        x4 = fold(x4, k1k2, load(bytes + 0x30));
+        bytes += 64;
+        length -= 64;
+    }
+
+    // Fold the 4 lanes into one, then any 16 byte blocks left
+    x1 = fold(x1, k3k4, x2);
+    x1 = fold(x1, k3k4, x3);
+    x1 = fold(x1, k3k4, x4);
+    while (length >= 16)
+    {
+        x1 = fold(x1, k3k4, load(bytes));
+        bytes += 16;
+        length -= 16;
+    }
+
+    // Fold 128 bits to 64 bits
+    x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, mask32);
+    x1 = _mm_xor_si128(_mm_clmulepi64_si128(x1, k5k0, 0x00), x2);
+
+    // Barrett reduction to 32 bits
+    x2 = _mm_and_si128(x1, mask32);
+    x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+    x2 = _mm_and_si128(x2, mask32);
+    x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    return _mm_extract_epi32(x1, 1);
+}
+
+uint32_t crc32Pclmul(uint32_t crc, const uint8_t* bytes, size_t length)
+{
+    if (length < pclmulMinLength)
+    {
+        return crc32SlicingBy8(crc, bytes, length);
+    }
+    // The folding works on whole 16 byte blocks
+    const size_t blocksLength = length & ~static_cast<size_t>(15);
+    crc = crc32PclmulBlocks(crc, bytes, blocksLength);
+    return crc32SlicingBy8(crc, bytes + blocksLength, length - blocksLength);
+}
+#endif
+
+Crc32Fn getCrc32Fn(Crc32Kernel kernel)
+{
+    if (!isCrc32KernelSupported(kernel))
+    {
+        throw std::runtime_error(
+            std::format("[getCrc32Fn] CRC-32 kernel '{}' is not supported",
+                        static_cast<int>(kernel)));
+    }
+    switch (kernel)
+    {
+#if defined(__aarch64__)
+        case Crc32Kernel::armv8:
+            return crc32Armv8;
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+        case Crc32Kernel::pclmul:
+            return crc32Pclmul;
+#endif
+        default:
+            return crc32SlicingBy8;
+    }
+}
+
+} // namespace
+
+bool isCrc32KernelSupported(Crc32Kernel kernel)
+{
+    switch (kernel)
+    {
+        case Crc32Kernel::slicingBy8:
+            return true;
+        case Crc32Kernel::armv8:
+#if defined(__aarch64__)
+            return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#else
+            return false;
+#endif
+        case Crc32Kernel::pclmul:
+#if defined(__x86_64__) || defined(__i386__)
+            return __builtin_cpu_supports("pclmul") &&
+                   __builtin_cpu_supports("sse4.1");
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+Crc32Kernel bestCrc32Kernel()
+{
+    static const Crc32Kernel best = [] {
+        for (Crc32Kernel kernel : {Crc32Kernel::armv8, Crc32Kernel::pclmul})
+        {
+            if (isCrc32KernelSupported(kernel))
+            {
+                return kernel;
+            }
+        }
+        return Crc32Kernel::slicingBy8;
+    }();
+    return best;
+}
+
+uint32_t crc32Update(uint32_t crc, std::span<const uint8_t> bytes)
+{
+    static const Crc32Fn fn = getCrc32Fn(bestCrc32Kernel());
+    return fn(crc, bytes.data(), bytes.size());
+}
+
+uint32_t crc32Update(Crc32Kernel kernel, uint32_t crc,
+                     std::span<const uint8_t> bytes)
+{
+    return getCrc32Fn(kernel)(crc, bytes.data(), bytes.size());
+}
+
+uint32_t crc32Append(uint32_t crc, std::span<const uint8_t> bytes,
+                     std::vector<uint8_t>& dest)
+{
+    dest.reserve(dest.size() + bytes.size());
+    for (size_t offset = 0; offset < bytes.size(); offset += appendChunkSize)
+    {
+        std::span<const uint8_t> chunk = bytes.subspan(
+            offset, std::min(appendChunkSize, bytes.size() - offset));
+        dest.insert(dest.end(), chunk.begin(), chunk.end());
+        crc = crc32Update(crc, chunk);
+    }
+    return crc;
+}
+
+} // namespace bios_bmc_smm_error_logger
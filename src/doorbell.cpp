@@ -0,0 +1,111 @@
+#include "doorbell.hpp"
+
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <string_view>
+
+namespace bios_bmc_smm_error_logger
+{
+
+namespace
+{
+
+int checkedFd(int fd, std::string_view what)
+{
+    if (fd < 0)
+    {
+        throw std::runtime_error(
+            std::format("{} failed: {}", what, std::strerror(errno)));
+    }
+    return fd;
+}
+
+} // namespace
+
+EventFdDoorbell::EventFdDoorbell() :
+    fd(checkedFd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK),
+                 "[EventFdDoorbell] eventfd"))
+{}
+
+int EventFdDoorbell::getFd() const
+{
+    return fd.get();
+}
+
+uint64_t EventFdDoorbell::acknowledge()
+{
+    // Reading an eventfd returns the sum of all writes and resets it to 0
+    uint64_t rings = 0;
+    if (::read(fd.get(), &rings, sizeof(rings)) != sizeof(rings))
+    {
+        if (errno == EAGAIN)
+        {
+            return 0;
+        }
+        throw std::runtime_error(std::format(
+            "[EventFdDoorbell] read failed: {}", std::strerror(errno)));
+    }
+    return rings;
+}
+
+void EventFdDoorbell::ring()
+{
+    const uint64_t one = 1;
+    if (::write(fd.get(), &one, sizeof(one)) != sizeof(one))
+    {
+        throw std::runtime_error(std::format(
+            "[EventFdDoorbell] write failed: {}", std::strerror(errno)));
+    }
+}
+
+UioDoorbell::UioDoorbell(const std::string& devicePath) :
+    fd(checkedFd(
+        ::open(devicePath.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC),
+        std::format("[UioDoorbell] Opening '{}'", devicePath)))
+{
+    enableInterrupt();
+}
+
+int UioDoorbell::getFd() const
+{
+    return fd.get();
+}
+
+uint64_t UioDoorbell::acknowledge()
+{
+    // UIO reads return the total number of interrupts so far
+    uint32_t eventCount = 0;
+    if (::read(fd.get(), &eventCount, sizeof(eventCount)) !=
+        sizeof(eventCount))
+    {
+        if (errno == EAGAIN)
+        {
+            return 0;
+        }
+        throw std::runtime_error(std::format("[UioDoorbell] read failed: {}",
+                                             std::strerror(errno)));
+    }
+    const uint32_t rings = eventCount - lastEventCount;
+    lastEventCount = eventCount;
+    enableInterrupt();
+    return rings;
+}
+
+void UioDoorbell::enableInterrupt()
+{
+    const uint32_t enable = 1;
+    if (::write(fd.get(), &enable, sizeof(enable)) != sizeof(enable))
+    {
+        throw std::runtime_error(std::format(
+            "[UioDoorbell] Enabling the interrupt failed: {}",
+            std::strerror(errno)));
+    }
+}
+
+} // namespace bios_bmc_smm_error_logger
@@ -0,0 +1,333 @@
+#include "entry_journal.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <boost/endian/conversion.hpp>
+#include <stdplus/print.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+
+namespace bios_bmc_smm_error_logger
+{
+
+namespace
+{
+
+constexpr size_t recordHeaderSize = sizeof(struct JournalRecordHeader);
+
+int openJournal(const std::string& path)
+{
+    const int fd =
+        ::open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        throw std::runtime_error(
+            std::format("[EntryJournalWriter] Opening '{}' failed: {}", path,
+                        std::strerror(errno)));
+    }
+    return fd;
+}
+
+int openForRead(const std::string& path)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw std::runtime_error(
+            std::format("[EntryJournalWriter] Opening '{}' failed: {}", path,
+                        std::strerror(errno)));
+    }
+    return fd;
+}
+
+/** @brief Read exactly size bytes at offset, false if the file is shorter */
+bool readAllAt(int fd, void* data, size_t size, size_t offset)
+{
+    size_t done = 0;
+    while (done < size)
+    {
+        const ssize_t ret = ::pread(fd, static_cast<uint8_t*>(data) + done,
+                                    size - done, offset + done);
+        if (ret < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (ret <= 0)
+        {
+            return false;
+        }
+        done += ret;
+    }
+    return true;
+}
+
+void checkFileHeader(const JournalFileHeader& header, const std::string& path)
+{
+    if (header.magic != journalMagic)
+    {
+        throw std::runtime_error(
+            std::format("'{}' is not an entry journal", path));
+    }
+    if (boost::endian::little_to_native(header.version) != journalVersion)
+    {
+        throw std::runtime_error(std::format(
+            "'{}' is a version '{}' entry journal, expected '{}'", path,
+            boost::endian::little_to_native(header.version), journalVersion));
+    }
+}
+
+} // namespace
+
+EntryJournalWriter::EntryJournalWriter(const std::string& path,
+                                       size_t bufferSize) :
+    fd(openJournal(path)), bufferSize(bufferSize)
+{
+    buffer.reserve(bufferSize);
+
+    struct stat fileStat;
+    if (::fstat(fd.get(), &fileStat) != 0)
+    {
+        throw std::runtime_error(
+            std::format("[EntryJournalWriter] fstat of '{}' failed: {}", path,
+                        std::strerror(errno)));
+    }
+    const size_t fileSize = fileStat.st_size;
+    if (fileSize == 0)
+    {
+        JournalFileHeader header = {};
+        header.magic = journalMagic;
+        header.version = boost::endian::native_to_little(journalVersion);
+        const uint8_t* headerPtr = reinterpret_cast<const uint8_t*>(&header);
+        buffer.insert(buffer.end(), headerPtr, headerPtr + sizeof(header));
+        writeBuffered();
+        return;
+    }
+
+    // Appending to an existing journal, which has to be one
+    stdplus::ManagedFd readFd(openForRead(path));
+    JournalFileHeader header = {};
+    if (!readAllAt(readFd.get(), &header, sizeof(header), 0))
+    {
+        throw std::runtime_error(std::format(
+            "[EntryJournalWriter] Failed to read the header of '{}'", path));
+    }
+    checkFileHeader(header, path);
+
+    // A record cut short by a crash would have the new records appended after
+    // it, so it is dropped before anything is appended
+    size_t offset = sizeof(header);
+    struct JournalRecordHeader recordHeader;
+    while (fileSize - offset >= recordHeaderSize &&
+           readAllAt(readFd.get(), &recordHeader, recordHeaderSize, offset))
+    {
+        const size_t payloadSize =
+            boost::endian::little_to_native(recordHeader.payloadSize);
+        if (fileSize - offset - recordHeaderSize < payloadSize)
+        {
+            break;
+        }
+        offset += recordHeaderSize + payloadSize;
+    }
+    if (offset != fileSize)
+    {
+        stdplus::print(stderr, "Journal '{}' ends in a torn record, dropping "
+                               "its last {} bytes\n",
+                       path, fileSize - offset);
+        if (::ftruncate(fd.get(), offset) != 0)
+        {
+            throw std::runtime_error(
+                std::format("[EntryJournalWriter] Truncating '{}' failed: {}",
+                            path, std::strerror(errno)));
+        }
+    }
+}
+
+EntryJournalWriter::~EntryJournalWriter()
+{
+    try
+    {
+        flush();
+    }
+    catch (const std::exception&)
+    {
+        // Nothing left to report the lost records to
+    }
+}
+
+void EntryJournalWriter::appendEntry(const struct QueueEntryHeader& entryHeader,
+                                     std::span<const uint8_t> entry)
+{
+    append(JournalRecordKind::queueEntry, entryHeader, entry);
+}
+
+void EntryJournalWriter::appendUeLog(std::span<const uint8_t> ueLog)
+{
+    append(JournalRecordKind::ueLog, {}, ueLog);
+}
+
+void EntryJournalWriter::append(JournalRecordKind kind,
+                                const struct QueueEntryHeader& entryHeader,
+                                std::span<const uint8_t> payload)
+{
+    struct JournalRecordHeader recordHeader = {};
+    const auto sinceEpoch =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch());
+    recordHeader.timestampNs = boost::endian::native_to_little(
+        static_cast<uint64_t>(sinceEpoch.count()));
+    recordHeader.payloadSize =
+        boost::endian::native_to_little(static_cast<uint32_t>(payload.size()));
+    recordHeader.kind = static_cast<uint8_t>(kind);
+    recordHeader.entryHeader = entryHeader;
+    const uint8_t* recordHeaderPtr =
+        reinterpret_cast<const uint8_t*>(&recordHeader);
+
+    std::lock_guard lock(mutex);
+    if (buffer.size() + recordHeaderSize + payload.size() > bufferSize)
+    {
+        writeBuffered();
+    }
+    buffer.insert(buffer.end(), recordHeaderPtr,
+                  recordHeaderPtr + recordHeaderSize);
+    buffer.insert(buffer.end(), payload.begin(), payload.end());
+    ++numRecords;
+}
+
+void EntryJournalWriter::flush()
+{
+    std::lock_guard lock(mutex);
+    writeBuffered();
+}
+
+uint64_t EntryJournalWriter::getNumRecords() const
+{
+    std::lock_guard lock(mutex);
+    return numRecords;
+}
+
+void EntryJournalWriter::writeBuffered()
+{
+    size_t written = 0;
+    while (written < buffer.size())
+    {
+        const ssize_t ret = ::write(fd.get(), buffer.data() + written,
+                                    buffer.size() - written);
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            // Drop what could not be written, the next records still get a
+            // chance
+            buffer.clear();
+            throw std::runtime_error(
+                std::format("[EntryJournalWriter] write failed: {}",
+                            std::strerror(errno)));
+        }
+        written += ret;
+    }
+    buffer.clear();
+}
+
+EntryJournalReader::EntryJournalReader(const std::string& path)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw std::runtime_error(
+            std::format("[EntryJournalReader] Opening '{}' failed: {}", path,
+                        std::strerror(errno)));
+    }
+    struct stat fileStat;
+    if (::fstat(fd, &fileStat) != 0 ||
+        static_cast<size_t>(fileStat.st_size) < sizeof(JournalFileHeader))
+    {
+        ::close(fd);
+        throw std::runtime_error(std::format(
+            "[EntryJournalReader] '{}' is too small to be an entry journal",
+            path));
+    }
+    mappedSize = fileStat.st_size;
+    void* mapped = ::mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        throw std::runtime_error(
+            std::format("[EntryJournalReader] Mapping '{}' failed: {}", path,
+                        std::strerror(errno)));
+    }
+    data = static_cast<const uint8_t*>(mapped);
+
+    JournalFileHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    try
+    {
+        checkFileHeader(header, path);
+    }
+    catch (const std::exception&)
+    {
+        ::munmap(const_cast<uint8_t*>(data), mappedSize);
+        throw;
+    }
+}
+
+EntryJournalReader::~EntryJournalReader()
+{
+    ::munmap(const_cast<uint8_t*>(data), mappedSize);
+}
+
+size_t EntryJournalReader::forEach(RecordVisitor visitor) const
+{
+    size_t offset = sizeof(JournalFileHeader);
+    size_t numRecords = 0;
+    while (mappedSize - offset >= recordHeaderSize)
+    {
+        struct JournalRecordHeader recordHeader;
+        std::memcpy(&recordHeader, data + offset, recordHeaderSize);
+        const size_t payloadSize =
+            boost::endian::little_to_native(recordHeader.payloadSize);
+        if (mappedSize - offset - recordHeaderSize < payloadSize)
+        {
+            break;
+        }
+
+        JournalRecord record;
+        const std::chrono::nanoseconds sinceEpoch(
+            boost::endian::little_to_native(recordHeader.timestampNs));
+        record.timestamp = std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                sinceEpoch));
+        record.kind = static_cast<JournalRecordKind>(recordHeader.kind);
+        record.entryHeader = recordHeader.entryHeader;
+        record.payload =
+            std::span(data + offset + recordHeaderSize, payloadSize);
+        visitor(record);
+
+        offset += recordHeaderSize + payloadSize;
+        ++numRecords;
+    }
+    return numRecords;
+}
+
+bool EntryJournalReader::isTruncated() const
+{
+    size_t offset = sizeof(JournalFileHeader);
+    forEach([&offset](const JournalRecord& record) {
+        offset += recordHeaderSize + record.payload.size();
+    });
+    return offset != mappedSize;
+}
+
+size_t EntryJournalReader::size() const
+{
+    return mappedSize;
+}
+
+} // namespace bios_bmc_smm_error_logger
@@ -0,0 +1,151 @@
+#include "entry_pipeline.hpp"
+
+#include <stdplus/print.hpp>
+
+#include <exception>
+#include <utility>
+
+namespace bios_bmc_smm_error_logger
+{
+
+namespace
+{
+
+// Thrown from the drain visitor to stop draining, the entry it is thrown for
+// is left in the buffer
+struct QueueFull
+{};
+
+} // namespace
+
+EntryPipeline::EntryPipeline(DecodeFunction decode, size_t queueDepth,
+                             BatchDoneFunction batchDone) :
+    decode(std::move(decode)), batchDone(std::move(batchDone)),
+    ring(queueDepth)
+{
+    worker = std::jthread(std::bind_front(&EntryPipeline::decodeLoop, this));
+}
+
+EntryPipeline::~EntryPipeline()
+{
+    worker.request_stop();
+    doorbell.fetch_add(1, std::memory_order_release);
+    doorbell.notify_one();
+}
+
+size_t EntryPipeline::drain(BufferInterface& buffer)
+{
+    size_t numQueued = 0;
+    try
+    {
+        buffer.drain([this, &numQueued](
+                         const struct QueueEntryHeader& entryHeader,
+                         std::span<const uint8_t> entry) {
+            Slot* slot = ring.producerSlot();
+            if (slot == nullptr)
+            {
+                throw QueueFull{};
+            }
+            slot->entryHeader = entryHeader;
+            slot->entry.assign(entry.begin(), entry.end());
+            ring.publish();
+            ++numQueued;
+        });
+        stalled = false;
+    }
+    catch (const QueueFull&)
+    {
+        queueFullStalls.fetch_add(1, std::memory_order_relaxed);
+        if (!stalled)
+        {
+            stdplus::print(
+                stderr,
+                "[EntryPipeline] Decode queue is full, leaving entries in the "
+                "buffer until the decode stage catches up\n");
+        }
+        stalled = true;
+    }
+
+    if (numQueued > 0)
+    {
+        const uint64_t depth = ring.published() - ring.released();
+        if (depth > maxQueueDepth.load(std::memory_order_relaxed))
+        {
+            maxQueueDepth.store(depth, std::memory_order_relaxed);
+        }
+        doorbell.fetch_add(1, std::memory_order_release);
+        doorbell.notify_one();
+    }
+    return numQueued;
+}
+
+void EntryPipeline::waitIdle() const
+{
+    ring.waitForRelease(ring.published());
+}
+
+PipelineStats EntryPipeline::getStats() const
+{
+    // Released first, so that it never looks like more entries were decoded
+    // than queued
+    const uint64_t released = ring.released();
+    return {
+        .entriesQueued = ring.published(),
+        .entriesDecoded = released,
+        .decodeErrors = decodeErrors.load(std::memory_order_relaxed),
+        .queueFullStalls = queueFullStalls.load(std::memory_order_relaxed),
+        .maxQueueDepth = maxQueueDepth.load(std::memory_order_relaxed),
+    };
+}
+
+void EntryPipeline::decodeLoop(std::stop_token stopToken)
+{
+    while (true)
+    {
+        // Read the doorbell before looking at the ring, so an entry queued
+        // after the ring was found empty always wakes us up
+        const uint32_t seen = doorbell.load(std::memory_order_acquire);
+        Slot* slot = ring.consumerSlot();
+        if (slot == nullptr)
+        {
+            if (stopToken.stop_requested())
+            {
+                return;
+            }
+            doorbell.wait(seen, std::memory_order_acquire);
+            continue;
+        }
+
+        try
+        {
+            decode(slot->entryHeader, slot->entry);
+        }
+        catch (const std::exception& e)
+        {
+            decodeErrors.fetch_add(1, std::memory_order_relaxed);
+            stdplus::print(stderr,
+                           "[EntryPipeline] Failed to decode entry: {}\n",
+                           e.what());
+        }
+        // Nothing else is queued, the batch is done. Run before the slot is
+        // handed back, so waitIdle also waits for it.
+        if (batchDone && ring.published() == ring.released() + 1)
+        {
+            try
+            {
+                batchDone();
+            }
+            catch (const std::exception& e)
+            {
+                decodeErrors.fetch_add(1, std::memory_order_relaxed);
+                stdplus::print(stderr,
+                               "[EntryPipeline] Failed to finish a batch: {}\n",
+                               e.what());
+            }
+        }
+        // The slot is only handed back once decode is done with it
+        ring.release();
+    }
+}
+
+} // namespace bios_bmc_smm_error_logger
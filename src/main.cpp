@@ -1,10 +1,22 @@
 #include "config.h"
 
 #include "buffer.hpp"
+#include "doorbell.hpp"
+#include "entry_journal.hpp"
+#include "entry_pipeline.hpp"
 #include "pci_handler.hpp"
+#include "poll_scheduler.hpp"
+#include "shared_memory_handler.hpp"
 #include "rde/external_storer_file.hpp"
 #include "rde/external_storer_interface.hpp"
+#include "rde/external_storer_segment.hpp"
+#include "rde/log_entry_store_dbus_handler.hpp"
 #include "rde/rde_handler.hpp"
+#if IO_URING
+#include "rde/external_storer_uring.hpp"
+#endif
+
+#include <unistd.h>
 
 #include <boost/asio.hpp>
 #include <boost/endian/conversion.hpp>
@@ -14,16 +26,22 @@
 #include <stdplus/fd/managed.hpp>
 #include <stdplus/print.hpp>
 
+#include <algorithm>
 #include <chrono>
 #include <filesystem>
 #include <format>
 #include <fstream>
 #include <functional>
 #include <memory>
+#include <span>
+#include <string_view>
 
 namespace
 {
 constexpr std::chrono::milliseconds readIntervalinMs(READ_INTERVAL_MS);
+constexpr std::chrono::milliseconds maxReadIntervalinMs(READ_INTERVAL_MAX_MS);
+constexpr std::chrono::milliseconds doorbellSafetyIntervalinMs(
+    DOORBELL_SAFETY_INTERVAL_MS);
 constexpr std::size_t memoryRegionSize = MEMORY_REGION_SIZE;
 constexpr std::size_t memoryRegionOffset = MEMORY_REGION_OFFSET;
 constexpr uint32_t bmcInterfaceVersion = BMC_INTERFACE_VERSION;
@@ -32,30 +50,77 @@ constexpr uint16_t ueRegionSize = UE_REGION_SIZE;
 static constexpr std::array<uint32_t, 4> magicNumber = {
     MAGIC_NUMBER_BYTE1, MAGIC_NUMBER_BYTE2, MAGIC_NUMBER_BYTE3,
     MAGIC_NUMBER_BYTE4};
+constexpr bios_bmc_smm_error_logger::ReadPtrCommitPolicy readPtrCommitPolicy{
+    .mode = bios_bmc_smm_error_logger::ReadPtrCommitMode::READ_PTR_COMMIT_MODE,
+    .threshold = READ_PTR_COMMIT_THRESHOLD};
+constexpr std::size_t decodeQueueDepth = DECODE_QUEUE_DEPTH;
+constexpr std::chrono::milliseconds counterFlushIntervalinMs(
+    COUNTER_FLUSH_INTERVAL_MS);
+constexpr std::string_view captureJournalPath = CAPTURE_JOURNAL_PATH;
+constexpr uint64_t logEntryMaxBytes = LOG_ENTRY_MAX_BYTES;
+constexpr std::string_view retentionIndexPath = RETENTION_INDEX_PATH;
+constexpr std::size_t logEntryReapBacklog = LOG_ENTRY_REAP_BACKLOG;
+constexpr std::string_view logEntrySegmentsPath = LOG_ENTRY_SEGMENTS_PATH;
+constexpr std::size_t logEntrySegmentSize = LOG_ENTRY_SEGMENT_SIZE;
 } // namespace
 
 using namespace bios_bmc_smm_error_logger;
 
-void readLoop(boost::asio::steady_timer* t,
-              const std::shared_ptr<BufferInterface>& bufferInterface,
-              const std::shared_ptr<rde::RdeCommandHandler>& rdeCommandHandler,
+// The capture journal is a debugging aid, failing to write it must not get
+// in the way of processing the logs
+template <typename Capture>
+void captureToJournal(Capture&& capture)
+{
+    try
+    {
+        capture();
+    }
+    catch (const std::exception& e)
+    {
+        stdplus::print(stderr, "Capture journal write failed: {}\n",
+                       e.what());
+    }
+}
+
+void readLoop(boost::asio::steady_timer* t, PollScheduler* scheduler,
+              BufferInterface* bufferInterface,
+              rde::RdeCommandHandler* rdeCommandHandler,
+              EntryPipeline* entryPipeline, EntryJournalWriter* journal,
               const boost::system::error_code& error)
 {
-    if (error)
+    // The doorbell cancels the timer to poll right away
+    if (error && error != boost::asio::error::operation_aborted)
     {
         stdplus::print(stderr, "Async wait failed {}\n", error.message());
         return;
     }
 
+    PollActivity activity{};
     try
     {
-        std::vector<uint8_t> ueLog =
-            bufferInterface->readUeLogFromReservedRegion();
+        // One header read per tick, the rest only touches the buffer when
+        // there is work pending
+        PollResult pollResult = bufferInterface->poll();
+        activity.queueBytesPending = pollResult.queueBytesPending;
+        activity.queueCapacity = bufferInterface->getMaxOffset();
+
+        std::vector<uint8_t> ueLog;
+        if (pollResult.ueLogPending)
+        {
+            ueLog = bufferInterface->readPendingUeLog();
+        }
         if (!ueLog.empty())
         {
             stdplus::print(
                 stdout,
                 "UE log found in reserved region, attempting to process\n");
+            if (journal != nullptr)
+            {
+                captureToJournal([&]() { journal->appendUeLog(ueLog); });
+            }
+            // rdeCommandHandler is owned by the decode stage, let it finish
+            // the queued entries before using it from here
+            entryPipeline->waitIdle();
 
             // UE log is BEJ encoded data, requiring RdeOperationInitRequest
             rde::RdeDecodeStatus ueDecodeStatus =
@@ -79,28 +144,33 @@ void readLoop(boost::asio::steady_timer* t,
             bufferInterface->updateBmcFlags(newBmcFlags);
         }
 
-        if (bufferInterface->checkForOverflowAndAcknowledge())
+        if (pollResult.overflowAcknowledged)
         {
+            // The entries lost to this overflow are only known once BIOS
+            // logs again, report the totals so far to correlate with
+            SequenceStats sequenceStats = bufferInterface->getSequenceStats();
+            PipelineStats pipelineStats = entryPipeline->getStats();
             stdplus::print(
                 stdout,
-                "[WARN] Buffer overflow had occured and has been acked\n");
+                "[WARN] Buffer overflow had occured and has been acked. "
+                "Overflows: {}, entries lost: {} ({} to overflows), decode "
+                "queue full: {} times, worst queue fill: {}/{} bytes\n",
+                sequenceStats.overflows, sequenceStats.entriesLost,
+                sequenceStats.entriesLostToOverflow,
+                pipelineStats.queueFullStalls,
+                scheduler->getStats().maxQueueFill,
+                scheduler->getStats().queueCapacity);
         }
 
-        std::vector<EntryPair> entryPairs = bufferInterface->readErrorLogs();
-        for (const auto& [entryHeader, entry] : entryPairs)
+        if (pollResult.queueBytesPending > 0)
         {
-            rde::RdeDecodeStatus rdeDecodeStatus =
-                rdeCommandHandler->decodeRdeCommand(
-                    entry, static_cast<rde::RdeCommandType>(
-                               entryHeader.rdeCommandType));
-            if (rdeDecodeStatus == rde::RdeDecodeStatus::RdeStopFlagReceived)
-            {
-                auto bufferHeader = bufferInterface->getCachedBufferHeader();
-                auto newbmcFlags =
-                    boost::endian::little_to_native(bufferHeader.bmcFlags) |
-                    static_cast<uint32_t>(BmcFlags::ready);
-                bufferInterface->updateBmcFlags(newbmcFlags);
-            }
+            // Entries are decoded on the pipeline's worker thread, BIOS gets
+            // the space back as soon as they are queued
+            const uint64_t queueFullStalls =
+                entryPipeline->getStats().queueFullStalls;
+            entryPipeline->drain(*bufferInterface);
+            activity.drainStalled =
+                entryPipeline->getStats().queueFullStalls != queueFullStalls;
         }
     }
     catch (const std::exception& e)
@@ -163,9 +233,59 @@ void readLoop(boost::asio::steady_timer* t,
         }
     }
 
-    t->expires_after(readIntervalinMs);
-    t->async_wait(
-        std::bind_front(readLoop, t, bufferInterface, rdeCommandHandler));
+    if (journal != nullptr)
+    {
+        // One write per tick for everything captured since the last one
+        captureToJournal([journal]() { journal->flush(); });
+    }
+
+    // Deadlines are absolute, so the time spent above does not push the
+    // polls back
+    const auto now = boost::asio::steady_timer::clock_type::now();
+    t->expires_at(scheduler->next(now, activity));
+    if (scheduler->burstEnded())
+    {
+        PollSchedulerStats stats = scheduler->getStats();
+        stdplus::print(
+            stdout,
+            "Queue idle, polling every {}ms. Wakeups per second: {:.1f}, "
+            "worst queue fill: {}/{} bytes\n",
+            scheduler->getInterval().count(), stats.wakeupsPerSecond,
+            stats.maxQueueFill, stats.queueCapacity);
+    }
+    t->async_wait(std::bind_front(readLoop, t, scheduler, bufferInterface,
+                                  rdeCommandHandler, entryPipeline, journal));
+}
+
+void waitForDoorbell(boost::asio::posix::stream_descriptor* descriptor,
+                     Doorbell* doorbell, boost::asio::steady_timer* t,
+                     const boost::system::error_code& error)
+{
+    if (error)
+    {
+        stdplus::print(stderr,
+                       "Doorbell wait failed {}, falling back to polling\n",
+                       error.message());
+        return;
+    }
+
+    try
+    {
+        doorbell->acknowledge();
+    }
+    catch (const std::exception& e)
+    {
+        stdplus::print(stderr,
+                       "Doorbell acknowledge failed {}, falling back to "
+                       "polling\n",
+                       e.what());
+        return;
+    }
+    // Wakes up readLoop, unless its handler is already queued
+    t->cancel();
+    descriptor->async_wait(
+        boost::asio::posix::stream_descriptor::wait_read,
+        std::bind_front(waitForDoorbell, descriptor, doorbell, t));
 }
 
 int main()
@@ -174,36 +294,207 @@ int main()
     boost::asio::steady_timer t(io, readIntervalinMs);
 
     // bufferHandler initialization
-    std::unique_ptr<stdplus::ManagedFd> managedFd =
-        std::make_unique<stdplus::ManagedFd>(stdplus::fd::open(
-            "/dev/mem",
-            stdplus::fd::OpenFlags(stdplus::fd::OpenAccess::ReadWrite)
-                .set(stdplus::fd::OpenFlag::Sync)));
-    std::unique_ptr<DataInterface> pciDataHandler =
-        std::make_unique<PciDataHandler>(memoryRegionOffset, memoryRegionSize,
-                                         std::move(managedFd));
+    std::unique_ptr<Doorbell> uioDoorbell;
+    if constexpr (DOORBELL_UIO)
+    {
+        try
+        {
+            uioDoorbell = std::make_unique<UioDoorbell>(DOORBELL_UIO_DEVICE);
+        }
+        catch (const std::exception& e)
+        {
+            stdplus::print(stderr, "{}, polling without a doorbell\n",
+                           e.what());
+        }
+    }
+    std::unique_ptr<DataInterface> dataHandler;
+    if constexpr (SHARED_MEMORY_TRANSPORT)
+    {
+        // For running against bios-simulator instead of a real BIOS
+        dataHandler = SharedMemoryDataHandler::openFile(
+            SHARED_MEMORY_PATH, memoryRegionSize, std::move(uioDoorbell));
+    }
+    else
+    {
+        std::unique_ptr<stdplus::ManagedFd> managedFd =
+            std::make_unique<stdplus::ManagedFd>(stdplus::fd::open(
+                "/dev/mem",
+                stdplus::fd::OpenFlags(stdplus::fd::OpenAccess::ReadWrite)
+                    .set(stdplus::fd::OpenFlag::Sync)));
+        dataHandler = std::make_unique<PciDataHandler>(
+            memoryRegionOffset, memoryRegionSize, std::move(managedFd),
+            std::move(uioDoorbell));
+    }
+    Doorbell* doorbell = dataHandler->getDoorbell();
     std::shared_ptr<BufferInterface> bufferHandler =
-        std::make_shared<BufferImpl>(std::move(pciDataHandler));
+        std::make_shared<BufferImpl>(std::move(dataHandler),
+                                     readPtrCommitPolicy);
 
     // rdeCommandHandler initialization
     std::shared_ptr<sdbusplus::asio::connection> conn =
         std::make_shared<sdbusplus::asio::connection>(io);
     conn->request_name("xyz.openbmc_project.bios_bmc_smm_error_logger");
 
-    std::unique_ptr<rde::FileHandlerInterface> fileIface =
-        std::make_unique<rde::ExternalStorerFileWriter>("/run/bmcweb");
-    std::unique_ptr<rde::ExternalStorerInterface> exFileIface =
+    std::unique_ptr<rde::FileHandlerInterface> fileIface;
+#if IO_URING
+    try
+    {
+        fileIface =
+            std::make_unique<rde::ExternalStorerUringWriter>(io, "/run/bmcweb");
+    }
+    catch (const std::runtime_error& e)
+    {
+        stdplus::print(stderr, "{}, writing files synchronously\n", e.what());
+    }
+#endif
+    if (!fileIface)
+    {
+        fileIface =
+            std::make_unique<rde::ExternalStorerFileWriter>("/run/bmcweb");
+    }
+    // LogEntries are appended to segments rather than getting a directory
+    // each, if configured. Consumers read them over D-Bus then.
+    const rde::LogEntrySegmentStore* segmentStore = nullptr;
+    if constexpr (!logEntrySegmentsPath.empty())
+    {
+        try
+        {
+            auto segmentWriter =
+                std::make_unique<rde::ExternalStorerSegmentWriter>(
+                    std::make_unique<rde::LogEntrySegmentStore>(
+                        std::string(logEntrySegmentsPath),
+                        logEntrySegmentSize),
+                    std::move(fileIface));
+            segmentStore = &segmentWriter->getStore();
+            fileIface = std::move(segmentWriter);
+        }
+        catch (const std::runtime_error& e)
+        {
+            stdplus::print(stderr, "{}, keeping a directory per log entry\n",
+                           e.what());
+        }
+    }
+    std::unique_ptr<rde::ExternalStorerFileInterface> exFileIface =
         std::make_unique<rde::ExternalStorerFileInterface>(
-            conn, "/run/bmcweb", std::move(fileIface));
+            conn, "/run/bmcweb", std::move(fileIface), 20, 980,
+            counterFlushIntervalinMs, logEntryMaxBytes,
+            std::string(retentionIndexPath), logEntryReapBacklog);
+    rde::ExternalStorerFileInterface* fileStorer = exFileIface.get();
     std::shared_ptr<rde::RdeCommandHandler> rdeCommandHandler =
         std::make_unique<rde::RdeCommandHandler>(std::move(exFileIface));
+    std::unique_ptr<rde::LogEntryStoreDbusHandler> logEntryStoreHandler;
+    if (segmentStore != nullptr)
+    {
+        logEntryStoreHandler =
+            std::make_unique<rde::LogEntryStoreDbusHandler>(conn,
+                                                            *segmentStore);
+    }
+
+    // Every entry read is captured for replaying offline, if configured
+    std::unique_ptr<EntryJournalWriter> journal;
+    if constexpr (!captureJournalPath.empty())
+    {
+        try
+        {
+            journal = std::make_unique<EntryJournalWriter>(
+                std::string(captureJournalPath));
+        }
+        catch (const std::runtime_error& e)
+        {
+            stdplus::print(stderr, "{}, running without capture\n",
+                           e.what());
+        }
+    }
+
+    // The decode stage runs on its own thread. The buffer and D-Bus belong
+    // to the io_context, so anything touching them is posted back to it.
+    std::shared_ptr<EntryPipeline> entryPipeline =
+        std::make_shared<EntryPipeline>(
+            [&io, bufferHandler, rdeCommandHandler, fileStorer,
+             journal = journal.get()](const QueueEntryHeader& entryHeader,
+                                      std::span<const uint8_t> entry) {
+                // Captured before decoding, so entries the decoder chokes on
+                // are in the journal too
+                if (journal != nullptr)
+                {
+                    captureToJournal([&]() {
+                        journal->appendEntry(entryHeader, entry);
+                    });
+                }
+                // The LogEntries of the batch are written together once the
+                // decode queue is empty
+                fileStorer->beginBatch();
+                rde::RdeDecodeStatus rdeDecodeStatus =
+                    rdeCommandHandler->decodeRdeCommand(
+                        entry, static_cast<rde::RdeCommandType>(
+                                   entryHeader.rdeCommandType));
+                if (rdeDecodeStatus ==
+                    rde::RdeDecodeStatus::RdeStopFlagReceived)
+                {
+                    boost::asio::post(io, [bufferHandler]() {
+                        auto bufferHeader =
+                            bufferHandler->getCachedBufferHeader();
+                        auto newbmcFlags =
+                            boost::endian::little_to_native(
+                                bufferHeader.bmcFlags) |
+                            static_cast<uint32_t>(BmcFlags::ready);
+                        bufferHandler->updateBmcFlags(newbmcFlags);
+                    });
+                }
+            },
+            decodeQueueDepth, [fileStorer]() { fileStorer->commitBatch(); });
 
     bufferHandler->initialize(bmcInterfaceVersion, queueSize, ueRegionSize,
                               magicNumber);
 
-    t.async_wait(std::bind_front(readLoop, &t, std::move(bufferHandler),
-                                 std::move(rdeCommandHandler)));
+    // With a doorbell the timer is only a safety net for missed rings, so
+    // it can back off much further when idle
+    boost::asio::posix::stream_descriptor doorbellDescriptor(io);
+    PollSchedulerConfig schedulerConfig = {
+        .minInterval = readIntervalinMs, .maxInterval = maxReadIntervalinMs};
+    if (doorbell != nullptr)
+    {
+        // The descriptor closes what it is given, the doorbell keeps its fd
+        doorbellDescriptor.assign(::dup(doorbell->getFd()));
+        doorbellDescriptor.async_wait(
+            boost::asio::posix::stream_descriptor::wait_read,
+            std::bind_front(waitForDoorbell, &doorbellDescriptor, doorbell,
+                            &t));
+        schedulerConfig.maxInterval =
+            std::max(maxReadIntervalinMs, doorbellSafetyIntervalinMs);
+    }
+    PollScheduler scheduler(schedulerConfig,
+                            boost::asio::steady_timer::clock_type::now());
+    // main owns what the read loop uses, so it can be torn down in order
+    // while the io_context is still there
+    t.async_wait(std::bind_front(readLoop, &t, &scheduler, bufferHandler.get(),
+                                 rdeCommandHandler.get(), entryPipeline.get(),
+                                 journal.get()));
+
+    boost::asio::signal_set signals(io, SIGINT, SIGTERM);
+    signals.async_wait(
+        [&io](const boost::system::error_code& error, int signalNumber) {
+            if (!error)
+            {
+                stdplus::print(stdout, "Signal {} received, stopping\n",
+                               signalNumber);
+                io.stop();
+            }
+        });
     io.run();
 
+    // Let the decode stage finish the entries it has, then write out the
+    // counters still cached
+    entryPipeline->waitIdle();
+    fileStorer->flushCounters();
+
+    // The storer and its writer close the eventfd registered with the
+    // io_context and post to it, so they go before it does. The decode stage
+    // uses the storer, and the D-Bus handler its segment store.
+    entryPipeline.reset();
+    logEntryStoreHandler.reset();
+    rdeCommandHandler.reset();
+    journal.reset();
+
     return 0;
 }
@@ -0,0 +1,94 @@
+#include "mmio_copy.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+
+namespace bios_bmc_smm_error_logger
+{
+
+namespace
+{
+
+// Widest access that is still issued as a single load/store on the target.
+// 64-bit accesses on a 32-bit CPU are split by the compiler, so fall back to
+// 32-bit words there.
+using MmioWord = std::conditional_t<sizeof(uintptr_t) >= sizeof(uint64_t),
+                                    uint64_t, uint32_t>;
+
+constexpr size_t wordSize = sizeof(MmioWord);
+
+size_t bytesUntilAligned(const volatile uint8_t* ptr, size_t length)
+{
+    const size_t misalignment = reinterpret_cast<uintptr_t>(ptr) % wordSize;
+    if (misalignment == 0)
+    {
+        return 0;
+    }
+    return std::min(wordSize - misalignment, length);
+}
+
+} // namespace
+
+void copyFromMmio(const volatile uint8_t* src, std::span<uint8_t> dest)
+{
+    uint8_t* out = dest.data();
+    size_t length = dest.size();
+
+    // Byte accesses until the device address is word aligned
+    const size_t head = bytesUntilAligned(src, length);
+    for (size_t i = 0; i < head; ++i)
+    {
+        *out++ = *src++;
+    }
+    length -= head;
+
+    // The destination may still be unaligned, so go through a local word
+    const volatile MmioWord* wordSrc =
+        reinterpret_cast<const volatile MmioWord*>(src);
+    for (; length >= wordSize; length -= wordSize)
+    {
+        const MmioWord word = *wordSrc++;
+        std::memcpy(out, &word, wordSize);
+        out += wordSize;
+    }
+
+    src = reinterpret_cast<const volatile uint8_t*>(wordSrc);
+    for (size_t i = 0; i < length; ++i)
+    {
+        *out++ = *src++;
+    }
+}
+
+void copyToMmio(volatile uint8_t* dest, std::span<const uint8_t> src)
+{
+    const uint8_t* in = src.data();
+    size_t length = src.size();
+
+    const size_t head = bytesUntilAligned(dest, length);
+    for (size_t i = 0; i < head; ++i)
+    {
+        *dest++ = *in++;
+    }
+    length -= head;
+
+    volatile MmioWord* wordDest = reinterpret_cast<volatile MmioWord*>(dest);
+    for (; length >= wordSize; length -= wordSize)
+    {
+        MmioWord word;
+        std::memcpy(&word, in, wordSize);
+        *wordDest++ = word;
+        in += wordSize;
+    }
+
+    dest = reinterpret_cast<volatile uint8_t*>(wordDest);
+    for (size_t i = 0; i < length; ++i)
+    {
+        *dest++ = *in++;
+    }
+}
+
+} // namespace bios_bmc_smm_error_logger
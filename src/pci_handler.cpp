@@ -1,5 +1,7 @@
 #include "pci_handler.hpp"
 
+#include "mmio_copy.hpp"
+
 #include <fcntl.h>
 
 #include <stdplus/fd/managed.hpp>
@@ -17,11 +19,14 @@ namespace bios_bmc_smm_error_logger
 {
 
 PciDataHandler::PciDataHandler(uint32_t regionAddress, size_t regionSize,
-                               std::unique_ptr<stdplus::fd::Fd> fd) :
+                               std::unique_ptr<stdplus::fd::Fd> fd,
+                               std::unique_ptr<Doorbell> doorbell) :
     regionSize(regionSize), fd(std::move(fd)),
     mmap(stdplus::fd::MMap(
         *this->fd, regionSize, stdplus::fd::ProtFlags{PROT_READ | PROT_WRITE},
-        stdplus::fd::MMapFlags{stdplus::fd::MMapAccess::Shared}, regionAddress))
+        stdplus::fd::MMapFlags{stdplus::fd::MMapAccess::Shared},
+        regionAddress)),
+    doorbell(std::move(doorbell))
 {}
 
 std::vector<uint8_t> PciDataHandler::read(const uint32_t offset,
@@ -40,19 +45,36 @@ std::vector<uint8_t> PciDataHandler::read(const uint32_t offset,
     uint32_t finalLength =
         (offset + length < regionSize) ? length : regionSize - offset;
     std::vector<uint8_t> results(finalLength);
+    readInto(offset, results);
+    return results;
+}
+
+uint32_t PciDataHandler::readInto(const uint32_t offset,
+                                  std::span<uint8_t> bytes)
+{
+    const size_t length = bytes.size();
+    if (offset > regionSize || length == 0)
+    {
+        stdplus::print(stderr,
+                       "[readInto] Offset [{}] was bigger than regionSize [{}] "
+                       "OR length [{}] was equal to 0\n",
+                       offset, regionSize, length);
+        return 0;
+    }
+
+    // Read up to regionSize in case the offset + length overflowed
+    uint32_t finalLength =
+        (offset + length < regionSize) ? length : regionSize - offset;
 
     // Use a volatile pointer to ensure every access reads directly from the
     // memory-mapped region, preventing compiler optimizations like caching.
     const volatile uint8_t* src =
         reinterpret_cast<volatile const uint8_t*>(mmap.get().data() + offset);
 
-    // Perform a byte-by-byte copy to avoid undefined behavior with memcpy on
-    // volatile memory.
-    for (uint32_t i = 0; i < finalLength; ++i)
-    {
-        results[i] = src[i];
-    }
-    return results;
+    // memcpy is undefined behavior on volatile memory, use word-wide volatile
+    // accesses instead.
+    copyFromMmio(src, bytes.first(finalLength));
+    return finalLength;
 }
 
 uint32_t PciDataHandler::write(const uint32_t offset,
@@ -76,11 +98,8 @@ uint32_t PciDataHandler::write(const uint32_t offset,
     volatile uint8_t* dest =
         reinterpret_cast<volatile uint8_t*>(mmap.get().data() + offset);
 
-    // Perform a byte-by-byte copy to ensure volatile semantics.
-    for (uint16_t i = 0; i < finalLength; ++i)
-    {
-        dest[i] = bytes[i];
-    }
+    // Perform a word-wide volatile copy to ensure volatile semantics.
+    copyToMmio(dest, bytes.first(finalLength));
     return finalLength;
 }
 
@@ -89,4 +108,9 @@ uint32_t PciDataHandler::getMemoryRegionSize()
     return regionSize;
 }
 
+Doorbell* PciDataHandler::getDoorbell()
+{
+    return doorbell.get();
+}
+
 } // namespace bios_bmc_smm_error_logger
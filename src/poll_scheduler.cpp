@@ -0,0 +1,89 @@
+#include "poll_scheduler.hpp"
+
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+
+namespace bios_bmc_smm_error_logger
+{
+
+PollScheduler::PollScheduler(PollSchedulerConfig config,
+                             Clock::time_point start) :
+    config(config), interval(config.minInterval), deadline(start),
+    windowStart(start)
+{
+    if (config.minInterval <= std::chrono::milliseconds::zero() ||
+        config.minInterval > config.maxInterval)
+    {
+        throw std::invalid_argument(std::format(
+            "[PollScheduler] Intervals must be 0 < '{}ms' <= '{}ms'",
+            config.minInterval.count(), config.maxInterval.count()));
+    }
+}
+
+PollScheduler::Clock::time_point PollScheduler::next(
+    Clock::time_point now, const PollActivity& activity)
+{
+    ++wakeups;
+    ++windowWakeups;
+    const auto windowLength = now - windowStart;
+    if (windowLength >= std::chrono::seconds(1))
+    {
+        // Idle polls can be further apart than a second, so scale the count
+        // to the actual length of the window
+        wakeupsPerSecond = windowWakeups * std::chrono::seconds(1) /
+                           std::chrono::duration<double>(windowLength);
+        windowWakeups = 0;
+        windowStart = now;
+    }
+    if (activity.queueBytesPending >= maxQueueFill)
+    {
+        maxQueueFill = activity.queueBytesPending;
+        queueCapacity = activity.queueCapacity;
+    }
+
+    // A poll woken early, e.g. by the doorbell, starts the next interval now
+    // rather than at the deadline it was woken ahead of
+    backedOff = false;
+    if (activity.queueBytesPending > 0)
+    {
+        interval = config.minInterval;
+        if (!activity.drainStalled)
+        {
+            // BIOS is logging, check again right away for entries that
+            // arrived while this batch was being drained
+            deadline = now;
+            return deadline;
+        }
+        // Waiting on the decode stage rather than on BIOS, polling right away
+        // would only spin
+        deadline = std::min(deadline, now) + interval;
+    }
+    else
+    {
+        deadline = std::min(deadline, now) + interval;
+        backedOff = interval < config.maxInterval &&
+                    interval * 2 >= config.maxInterval;
+        interval = std::min(interval * 2, config.maxInterval);
+    }
+
+    // Don't try to make up for polls missed while this one was running late,
+    // just poll once and carry on from there
+    if (deadline < now)
+    {
+        deadline = now;
+    }
+    return deadline;
+}
+
+PollSchedulerStats PollScheduler::getStats() const
+{
+    return {
+        .wakeups = wakeups,
+        .wakeupsPerSecond = wakeupsPerSecond,
+        .maxQueueFill = maxQueueFill,
+        .queueCapacity = queueCapacity,
+    };
+}
+
+} // namespace bios_bmc_smm_error_logger
@@ -1,18 +1,176 @@
 #include "rde/external_storer_file.hpp"
 
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_io.hpp>
 #include <stdplus/print.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
 #include <format>
-#include <fstream>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdexcept>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 namespace bios_bmc_smm_error_logger
 {
 namespace rde
 {
 
+namespace
+{
+
+constexpr mode_t dirMode = 0755;
+constexpr mode_t fileMode = 0644;
+// Directories files are created in, LogServices/<id>/Entries and the parents
+// of the counters. Past that the cache starts over.
+constexpr size_t maxCachedDirs = 64;
+// Counter PDRs remembered by the write-back cache. The paths come from BIOS,
+// past that clean ones are forgotten and dirty ones are written right away.
+constexpr size_t maxCounterFiles = 256;
+
+/** @brief relativePath without "." or ".." parts, empty for baseDir itself */
+std::filesystem::path normalize(const std::filesystem::path& relativePath)
+{
+    std::filesystem::path normalized;
+    for (const auto& part : relativePath.lexically_normal())
+    {
+        if (!part.empty() && part != ".")
+        {
+            normalized /= part;
+        }
+    }
+    return normalized;
+}
+
+/** @brief Write all of the parts to fd, a few at a time with writev */
+bool writeParts(int fd, std::span<const std::string_view> parts)
+{
+    size_t next = 0;
+    size_t offset = 0;
+    while (next < parts.size())
+    {
+        std::array<iovec, 64> iov;
+        size_t numIov = 0;
+        for (size_t i = next; i < parts.size() && numIov < iov.size(); ++i)
+        {
+            std::string_view part =
+                i == next ? parts[i].substr(offset) : parts[i];
+            if (!part.empty())
+            {
+                iov[numIov++] = {const_cast<char*>(part.data()), part.size()};
+            }
+        }
+        if (numIov == 0)
+        {
+            return true;
+        }
+
+        const ssize_t written = ::writev(fd, iov.data(), numIov);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        size_t left = written;
+        while (next < parts.size() && left >= parts[next].size() - offset)
+        {
+            left -= parts[next].size() - offset;
+            offset = 0;
+            ++next;
+        }
+        offset += left;
+    }
+    return true;
+}
+
+/** @brief Bytes of tmpfs an index.json of the given size takes up */
+uint32_t getTmpfsSize(size_t size)
+{
+    static const size_t pageSize = ::sysconf(_SC_PAGESIZE);
+    // tmpfs hands out whole pages
+    return (size + pageSize - 1) / pageSize * pageSize;
+}
+
+/** @brief Open the retention index, in memory only if the file can't be */
+std::unique_ptr<LogEntryRetentionIndex>
+    openRetentionIndex(const std::string& path, uint32_t maxSavedEntries,
+                       uint32_t maxEntries, uint64_t maxBytes,
+                       uint32_t maxPendingRemovals)
+{
+    if (!path.empty())
+    {
+        try
+        {
+            return std::make_unique<LogEntryRetentionIndex>(
+                path, maxSavedEntries, maxEntries, maxBytes,
+                maxPendingRemovals);
+        }
+        catch (const std::runtime_error& e)
+        {
+            stdplus::print(stderr,
+                           "{}, log entries are only tracked in memory\n",
+                           e.what());
+        }
+    }
+    return std::make_unique<LogEntryRetentionIndex>(
+        "", maxSavedEntries, maxEntries, maxBytes, maxPendingRemovals);
+}
+
+/** @brief Remove name under dirFd and, if it is a directory, all in it */
+bool removeAt(int dirFd, const char* name)
+{
+    if (::unlinkat(dirFd, name, 0) == 0 || errno == ENOENT)
+    {
+        return true;
+    }
+    if (errno != EISDIR)
+    {
+        return false;
+    }
+
+    const int fd =
+        ::openat(dirFd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return false;
+    }
+    DIR* dir = ::fdopendir(fd);
+    if (dir == nullptr)
+    {
+        ::close(fd);
+        return false;
+    }
+    bool removed = true;
+    while (const dirent* entry = ::readdir(dir))
+    {
+        const std::string_view entryName = entry->d_name;
+        if (entryName != "." && entryName != "..")
+        {
+            removed = removeAt(::dirfd(dir), entry->d_name) && removed;
+        }
+    }
+    ::closedir(dir);
+    return (::unlinkat(dirFd, name, AT_REMOVEDIR) == 0 || errno == ENOENT) &&
+           removed;
+}
+
+} // namespace
+
 ExternalStorerFileWriter::ExternalStorerFileWriter(std::string_view baseDir) :
     baseDir(baseDir)
 {}
@@ -28,6 +186,24 @@ std::filesystem::path ExternalStorerFileWriter::getRelativePath(
     return path;
 }
 
+uint32_t FileHandlerInterface::getStoredSize(
+    [[maybe_unused]] const std::string& folderPath, size_t size) const
+{
+    return getTmpfsSize(size);
+}
+
+std::filesystem::path ExternalStorerFileWriter::getNormalizedPath(
+    const std::string& path_str) const
+{
+    return normalize(getRelativePath(path_str));
+}
+
+void ExternalStorerFileWriter::forgetDirs() const
+{
+    std::lock_guard lock(mutex);
+    dirFds.clear();
+}
+
 bool ExternalStorerFileWriter::isValidPath(const std::string& folderPath) const
 {
     std::filesystem::path relativePath = getRelativePath(folderPath);
@@ -53,6 +229,74 @@ bool ExternalStorerFileWriter::isValidPath(const std::string& folderPath) const
     return true;
 }
 
+int ExternalStorerFileWriter::getDirFd(
+    const std::filesystem::path& relativePath) const
+{
+    if (!baseDirFd)
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(baseDir, ec);
+        int fd = ::open(baseDir.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return -1;
+        }
+        baseDirFd.emplace(std::move(fd));
+    }
+    if (relativePath.empty())
+    {
+        return baseDirFd->get();
+    }
+    auto it = dirFds.find(relativePath.native());
+    if (it != dirFds.end())
+    {
+        return it->second.get();
+    }
+
+    // Walk down from baseDir, creating what is missing on the way
+    std::optional<stdplus::ManagedFd> dirFd;
+    for (const auto& part : relativePath)
+    {
+        const int parentFd = dirFd ? dirFd->get() : baseDirFd->get();
+        if (::mkdirat(parentFd, part.c_str(), dirMode) != 0 && errno != EEXIST)
+        {
+            return -1;
+        }
+        int fd = ::openat(parentFd, part.c_str(),
+                          O_PATH | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return -1;
+        }
+        dirFd.emplace(std::move(fd));
+    }
+    if (dirFds.size() >= maxCachedDirs)
+    {
+        dirFds.clear();
+    }
+    return dirFds.try_emplace(relativePath.native(), std::move(*dirFd))
+        .first->second.get();
+}
+
+int ExternalStorerFileWriter::openIndexFile(
+    const std::filesystem::path& relativePath) const
+{
+    const std::filesystem::path folder = relativePath.filename();
+    const int parentFd = getDirFd(relativePath.parent_path());
+    if (parentFd < 0)
+    {
+        return -1;
+    }
+    if (!folder.empty() && ::mkdirat(parentFd, folder.c_str(), dirMode) != 0 &&
+        errno != EEXIST)
+    {
+        return -1;
+    }
+    // If the file already exist, overwrite it.
+    return ::openat(parentFd, (folder / "index.json").c_str(),
+                    O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, fileMode);
+}
+
 bool ExternalStorerFileWriter::createFolder(const std::string& folderPath) const
 {
     if (!isValidPath(folderPath))
@@ -60,35 +304,60 @@ bool ExternalStorerFileWriter::createFolder(const std::string& folderPath) const
         stdplus::print(stderr, "Invalid path detected: {}\n", folderPath);
         return false;
     }
-    std::filesystem::path path(baseDir / getRelativePath(folderPath));
-    if (!std::filesystem::is_directory(path))
+    const std::filesystem::path relativePath = getNormalizedPath(folderPath);
+
+    std::lock_guard lock(mutex);
+    int fd = getDirFd(relativePath);
+    if (fd < 0 && errno == ENOENT)
     {
-        stdplus::print(stderr, "no directory at {}, creating.\n",
-                       path.string());
-        if (!std::filesystem::create_directories(path))
-        {
-            stdplus::print(stderr, "Failed to create a folder at {}\n",
-                           path.string());
-            return false;
-        }
+        // A cached directory was removed behind our back, walk again
+        dirFds.clear();
+        fd = getDirFd(relativePath);
+    }
+    if (fd < 0)
+    {
+        stdplus::print(stderr, "Failed to create a folder at {}: {}\n",
+                       (baseDir / relativePath).string(),
+                       std::strerror(errno));
+        return false;
     }
     return true;
 }
 
-bool ExternalStorerFileWriter::createFile(const std::string& folderPath,
-                                          const nlohmann::json& jsonPdr) const
+bool ExternalStorerFileWriter::createFile(
+    const std::string& folderPath,
+    std::span<const std::string_view> jsonParts) const
 {
-    // createFolder will check isValidPath
-    if (!createFolder(folderPath))
+    if (!isValidPath(folderPath))
     {
+        stdplus::print(stderr, "Invalid path detected: {}\n", folderPath);
+        return false;
+    }
+    const std::filesystem::path relativePath = getNormalizedPath(folderPath);
+
+    std::lock_guard lock(mutex);
+    int fd = openIndexFile(relativePath);
+    if (fd < 0 && errno == ENOENT)
+    {
+        // A cached directory was removed behind our back, walk again
+        dirFds.clear();
+        fd = openIndexFile(relativePath);
+    }
+    if (fd < 0)
+    {
+        stdplus::print(stderr, "Failed to create {}/index.json: {}\n",
+                       (baseDir / relativePath).string(),
+                       std::strerror(errno));
+        return false;
+    }
+    stdplus::ManagedFd file(std::move(fd));
+    if (!writeParts(file.get(), jsonParts))
+    {
+        stdplus::print(stderr, "Failed to write {}/index.json: {}\n",
+                       (baseDir / relativePath).string(),
+                       std::strerror(errno));
         return false;
     }
-    std::filesystem::path path(
-        baseDir / getRelativePath(folderPath) / "index.json");
-    // If the file already exist, overwrite it.
-    std::ofstream output(path);
-    output << jsonPdr;
-    output.close();
     return true;
 }
 
@@ -99,9 +368,47 @@ bool ExternalStorerFileWriter::removeAll(const std::string& filePath) const
         stdplus::print(stderr, "Invalid path detected: {}\n", filePath);
         return false;
     }
-    // Attempt to delete the file
+    const std::filesystem::path relativePath = getNormalizedPath(filePath);
+
+    // The removal itself runs without the lock held, so files can be created
+    // while an old LogEntry is deleted
+    int parentFd = -1;
+    {
+        std::lock_guard lock(mutex);
+        // The dirfds under what is removed would point to removed directories
+        const std::string& removed = relativePath.native();
+        std::erase_if(dirFds, [&removed](const auto& dir) {
+            return removed.empty() || dir.first == removed ||
+                   (dir.first.starts_with(removed) &&
+                    dir.first[removed.size()] == '/');
+        });
+
+        if (relativePath.empty())
+        {
+            baseDirFd.reset();
+        }
+        else
+        {
+            // Old LogEntries are removed from the cached Entries directory
+            const std::filesystem::path parentPath = relativePath.parent_path();
+            auto parent = dirFds.find(parentPath.native());
+            if (parent != dirFds.end())
+            {
+                parentFd = ::fcntl(parent->second.get(), F_DUPFD_CLOEXEC, 0);
+            }
+            else if (parentPath.empty() && baseDirFd)
+            {
+                parentFd = ::fcntl(baseDirFd->get(), F_DUPFD_CLOEXEC, 0);
+            }
+        }
+    }
+    if (parentFd >= 0)
+    {
+        stdplus::ManagedFd parent(std::move(parentFd));
+        return removeAt(parent.get(), relativePath.filename().c_str());
+    }
     std::error_code ec;
-    std::filesystem::remove_all(baseDir / getRelativePath(filePath), ec);
+    std::filesystem::remove_all(baseDir / relativePath, ec);
     if (ec)
     {
         return false;
@@ -113,59 +420,110 @@ ExternalStorerFileInterface::ExternalStorerFileInterface(
     const std::shared_ptr<sdbusplus::asio::connection>& conn,
     std::string_view rootPath,
     std::unique_ptr<FileHandlerInterface> fileHandler,
-    uint32_t numSavedLogEntries, uint32_t numLogEntries) :
+    uint32_t numSavedLogEntries, uint32_t numLogEntries,
+    std::chrono::milliseconds counterFlushInterval, uint64_t maxLogEntryBytes,
+    const std::string& retentionIndexPath, size_t reapBacklog) :
     rootPath(rootPath), fileHandler(std::move(fileHandler)), logServiceId(""),
-    cperNotifier(std::make_unique<CperFileNotifierHandler>(conn)),
-    maxNumSavedLogEntries(numSavedLogEntries), maxNumLogEntries(numLogEntries)
-{}
+    cperNotifier(conn ? std::make_unique<CperFileNotifierHandler>(conn)
+                      : nullptr),
+    // Evicted entries not removed yet: the backlog, the batch the reaper is
+    // deleting and the one an asynchronous fileHandler may still be on, plus
+    // one being deleted right away
+    retentionIndex(openRetentionIndex(
+        retentionIndexPath, numSavedLogEntries, numLogEntries,
+        maxLogEntryBytes, static_cast<uint32_t>(3 * reapBacklog + 1))),
+    counterFlushInterval(counterFlushInterval), maxReapBacklog(reapBacklog)
+{
+    if (counterFlushInterval > std::chrono::milliseconds(0))
+    {
+        counterFlusher = std::jthread(std::bind_front(
+            &ExternalStorerFileInterface::counterFlushLoop, this));
+    }
+    if (maxReapBacklog > 0)
+    {
+        this->reapBacklog.reserve(maxReapBacklog);
+        reaper = std::jthread(
+            std::bind_front(&ExternalStorerFileInterface::reapLoop, this));
+    }
 
-bool ExternalStorerFileInterface::publishJson(std::string_view jsonStr)
+    // Entries evicted before a crash may still be there
+    for (const RetainedLogEntry& entry : retentionIndex->getPendingRemovals())
+    {
+        removeLogEntry(entry.id,
+                       getLogEntryPath(entry.logServiceId,
+                                       boost::uuids::to_string(entry.id)));
+    }
+    this->fileHandler->flush();
+}
+
+ExternalStorerFileInterface::~ExternalStorerFileInterface()
 {
-    nlohmann::json jsonDecoded;
-    try
+    commitBatch();
+    // The reaper deletes what is still in the backlog before it stops
+    if (reaper.joinable())
     {
-        jsonDecoded = nlohmann::json::parse(jsonStr);
+        reaper.request_stop();
+        reaper.join();
     }
-    catch (nlohmann::json::parse_error& e)
+    applyRemovals();
+    // The flusher is done before the last flush, so nothing is written twice
+    if (counterFlusher.joinable())
+    {
+        counterFlusher.request_stop();
+        counterFlusher.join();
+    }
+    flushCounters();
+}
+
+bool ExternalStorerFileInterface::publishJson(std::string_view jsonStr)
+{
+    // Only the fields the PDR is routed on are looked at, the JSON is written
+    // out the way libbej decoded it
+    if (!scanner.scan(jsonStr))
     {
-        stdplus::print(stderr, "JSON parse error: \n{}\n", e.what());
+        stdplus::print(stderr, "JSON parse error: \n{}\n", jsonStr);
         return false;
     }
 
     // We need to know the type to determine how to process the decoded JSON
     // output.
-    if (!jsonDecoded.contains("@odata.type"))
+    std::optional<std::string> odataType =
+        JsonObjectScanner::getString(scanner.find("@odata.type"));
+    if (!odataType)
     {
         stdplus::print(stderr, "@odata.type field doesn't exist in:\n {}\n",
-                       jsonDecoded.dump(4));
+                       jsonStr);
         return false;
     }
 
-    auto schemaType = getSchemaType(jsonDecoded);
+    bool published = false;
+    auto schemaType = getSchemaType(*odataType);
     if (schemaType == JsonPdrType::logEntry)
     {
-        return processLogEntry(jsonDecoded);
+        published = processLogEntry();
     }
-    if (schemaType == JsonPdrType::logService)
+    else if (schemaType == JsonPdrType::logService)
+    {
+        published = processLogService(jsonStr);
+    }
+    else
     {
-        return processLogService(jsonDecoded);
+        published = processOtherTypes(jsonStr);
     }
-    return processOtherTypes(jsonDecoded);
+    // Files are handed over one by one, and written out together from here
+    fileHandler->flush();
+    return published;
 }
 
-JsonPdrType ExternalStorerFileInterface::getSchemaType(
-    const nlohmann::json& jsonSchema) const
+JsonPdrType
+    ExternalStorerFileInterface::getSchemaType(std::string_view odataType) const
 {
-    auto logEntryFound =
-        std::string(jsonSchema["@odata.type"]).find("LogEntry");
-    if (logEntryFound != std::string::npos)
+    if (odataType.find("LogEntry") != std::string_view::npos)
     {
         return JsonPdrType::logEntry;
     }
 
-    auto logServiceFound =
-        std::string(jsonSchema["@odata.type"]).find("LogService");
-    if (logServiceFound != std::string::npos)
+    if (odataType.find("LogService") != std::string_view::npos)
     {
         return JsonPdrType::logService;
     }
@@ -173,10 +531,8 @@ JsonPdrType ExternalStorerFileInterface::getSchemaType(
     return JsonPdrType::other;
 }
 
-bool ExternalStorerFileInterface::processLogEntry(nlohmann::json& logEntry)
+bool ExternalStorerFileInterface::processLogEntry()
 {
-    // TODO: Add policies for LogEntry retention.
-    // https://github.com/openbmc/bios-bmc-smm-error-logger/issues/1.
     if (logServiceId.empty())
     {
         stdplus::print(stderr,
@@ -184,114 +540,419 @@ bool ExternalStorerFileInterface::processLogEntry(nlohmann::json& logEntry)
         return false;
     }
 
-    // Check to see if we are hitting the limit of filePathQueue, delete oldest
-    // log entry first before processing another entry
-    if (logEntryQueue.size() == maxNumLogEntries)
+    const boost::uuids::uuid id = randomGen();
+
+    // Populate the "Id" with the UUID we generated, and remove the @odata.id
+    // since ExternalStorer will fill it for a client. Everything else is
+    // copied from the decoded JSON as is.
+    const std::string entryId = boost::uuids::to_string(id);
+    const size_t begin = stagedJson.size();
+    stagedJson += R"({"Id":")";
+    stagedJson += entryId;
+    stagedJson += '"';
+    for (const JsonMember& member : scanner.getMembers())
     {
-        std::string oldestFilePath = std::move(logEntryQueue.front());
-        logEntryQueue.pop();
-
-        if (!fileHandler->removeAll(oldestFilePath))
+        if (member.key == "Id" || member.key == "@odata.id")
         {
-            stdplus::print(
-                stderr,
-                "Failed to delete the oldest entry path, not processing the next log,: {}\n",
-                oldestFilePath);
-            return false;
+            continue;
         }
+        stagedJson += ',';
+        stagedJson += member.text;
+    }
+    stagedJson += '}';
+    stagedLogEntries.push_back(
+        StagedLogEntry{.id = id,
+                       .subPath = getLogEntryPath(logServiceId, entryId),
+                       .begin = begin,
+                       .end = stagedJson.size(),
+                       .dropped = false});
+
+    if (batching)
+    {
+        return true;
     }
+    return writeStagedLogEntries();
+}
 
-    std::string id = boost::uuids::to_string(randomGen());
-    std::string subPath =
-        std::format("/redfish/v1/Systems/system/LogServices/{}/Entries/{}",
-                    logServiceId, id);
+void ExternalStorerFileInterface::beginBatch()
+{
+    batching = true;
+}
 
-    // Populate the "Id" with the UUID we generated.
-    logEntry["Id"] = id;
-    // Remove the @odata.id from the JSON since ExternalStorer will fill it for
-    // a client.
-    logEntry.erase("@odata.id");
+bool ExternalStorerFileInterface::commitBatch()
+{
+    batching = false;
+    return writeStagedLogEntries();
+}
 
-    stdplus::print(stderr, "Creating CPER file under path: {}. \n",
-                   rootPath + subPath);
-    if (!fileHandler->createFile(subPath, logEntry))
+bool ExternalStorerFileInterface::writeStagedLogEntries()
+{
+    if (stagedLogEntries.empty())
     {
-        stdplus::print(stderr,
-                       "Failed to create a file for log entry path: {}\n",
-                       rootPath + subPath);
-        return false;
+        return true;
     }
+    bool written = true;
+    applyRemovals();
 
-    cperNotifier->createEntry(rootPath + subPath + "/index.json");
+    // Make room for the whole batch first. The index takes in each entry
+    // before the next one is looked at, so the batch is evicted from as well
+    // if it doesn't fit on its own.
+    for (const StagedLogEntry& entry : stagedLogEntries)
+    {
+        const uint32_t entrySize =
+            fileHandler->getStoredSize(entry.subPath, entry.end - entry.begin);
+        while (std::optional<RetainedLogEntry> oldest =
+                   retentionIndex->getNextEviction(logServiceId, entrySize))
+        {
+            retentionIndex->evict(*oldest);
+            auto staged = std::ranges::find(stagedLogEntries, oldest->id,
+                                            &StagedLogEntry::id);
+            if (staged != stagedLogEntries.end())
+            {
+                // Never written, so there is nothing to remove
+                staged->dropped = true;
+                retentionIndex->markRemoved(oldest->id);
+                continue;
+            }
+            if (!removeLogEntry(oldest->id,
+                                getLogEntryPath(
+                                    oldest->logServiceId,
+                                    boost::uuids::to_string(oldest->id))))
+            {
+                written = false;
+            }
+        }
+        retentionIndex->add(entry.id, logServiceId, entrySize);
+    }
 
-    // Attempt to push to logEntrySavedQueue first, before pushing to
-    // logEntryQueue that can be popped
-    if (logEntrySavedQueue.size() < maxNumSavedLogEntries)
+    std::vector<std::string> notifyPaths;
+    notifyPaths.reserve(stagedLogEntries.size());
+    for (const StagedLogEntry& entry : stagedLogEntries)
     {
-        logEntrySavedQueue.push(std::move(subPath));
+        if (entry.dropped)
+        {
+            continue;
+        }
+        const std::string& subPath = entry.subPath;
+        stdplus::print(stderr, "Creating CPER file under path: {}. \n",
+                       rootPath + subPath);
+        if (!createFile(subPath, std::string_view(stagedJson).substr(
+                                     entry.begin, entry.end - entry.begin)))
+        {
+            // Stays in the index, deleting it later is a no-op
+            stdplus::print(stderr,
+                           "Failed to create a file for log entry path: {}\n",
+                           rootPath + subPath);
+            written = false;
+            continue;
+        }
+        // Entries kept elsewhere than in an index.json are read through the
+        // handler they are kept in
+        if (fileHandler->hasIndexFile(subPath))
+        {
+            notifyPaths.push_back(rootPath + subPath + "/index.json");
+        }
+    }
+    // bmcweb only hears of the entries once their files are there
+    if (cperNotifier)
+    {
+        fileHandler->flush(
+            [this, notifyPaths = std::move(notifyPaths)]() mutable {
+                cperNotifier->createEntries(std::move(notifyPaths));
+            });
     }
     else
     {
-        logEntryQueue.push(std::move(subPath));
+        fileHandler->flush();
     }
 
-    return true;
+    stagedLogEntries.clear();
+    stagedJson.clear();
+    return written;
 }
 
-bool ExternalStorerFileInterface::processLogService(
-    const nlohmann::json& logService)
+bool ExternalStorerFileInterface::processLogService(std::string_view jsonStr)
 {
-    if (!logService.contains("@odata.id"))
+    std::optional<std::string> odataId =
+        JsonObjectScanner::getString(scanner.find("@odata.id"));
+    if (!odataId)
     {
         stdplus::print(stderr, "@odata.id field doesn't exist in:\n {}\n",
-                       logService.dump(4));
+                       jsonStr);
         return false;
     }
 
-    if (!logService.contains("Id"))
+    std::optional<std::string> id =
+        JsonObjectScanner::getString(scanner.find("Id"));
+    if (!id)
+    {
+        stdplus::print(stderr, "Id field doesn't exist in:\n {}\n", jsonStr);
+        return false;
+    }
+    if (id->size() > LogEntryRetentionIndex::maxLogServiceIdSize)
     {
-        stdplus::print(stderr, "Id field doesn't exist in:\n {}\n",
-                       logService.dump(4));
+        stdplus::print(stderr, "Id field is too long in:\n {}\n", jsonStr);
         return false;
     }
 
-    logServiceId = logService["Id"].get<std::string>();
+    // The entries staged so far belong to the previous LogService
+    writeStagedLogEntries();
+    if (!retentionIndex->hasRoomForLogService(*id))
+    {
+        // Rather than filing its entries under the previous LogService
+        logServiceId.clear();
+        stdplus::print(stderr,
+                       "No room for LogService {} in the retention index, "
+                       "its log entries are dropped\n",
+                       *id);
+        return false;
+    }
+    logServiceId = std::move(*id);
 
-    if (!createFile(logService["@odata.id"].get<std::string>(), logService))
+    if (!createFile(*odataId, jsonStr))
     {
         stdplus::print(stderr,
                        "Failed to create LogService index file for:\n{}\n",
-                       logService.dump(4));
+                       jsonStr);
         return false;
     }
     // ExternalStorer needs a .../Entries/index.json file with no data.
-    nlohmann::json jEmpty = "{}"_json;
-    return createFile(logService["@odata.id"].get<std::string>() + "/Entries",
-                      jEmpty);
+    return createFile(*odataId + "/Entries", "{}");
 }
 
-bool ExternalStorerFileInterface::processOtherTypes(
-    const nlohmann::json& jsonPdr) const
+bool ExternalStorerFileInterface::processOtherTypes(std::string_view jsonStr)
 {
-    if (!jsonPdr.contains("@odata.id"))
+    std::optional<std::string> path =
+        JsonObjectScanner::getString(scanner.find("@odata.id"));
+    if (!path)
     {
         stdplus::print(stderr, "@odata.id field doesn't exist in:\n {}\n",
-                       jsonPdr.dump(4));
+                       jsonStr);
+        return false;
+    }
+
+    std::lock_guard lock(counterMutex);
+    auto it = counterFiles.find(*path);
+    if (it == counterFiles.end())
+    {
+        if (counterFiles.size() >= maxCounterFiles)
+        {
+            auto clean = std::ranges::find_if(
+                counterFiles, [](const auto& entry) {
+                    return !entry.second.dirty;
+                });
+            if (clean == counterFiles.end())
+            {
+                return writeCounter(*path, jsonStr);
+            }
+            counterFiles.erase(clean);
+        }
+        it = counterFiles.emplace(*path, CounterFile{}).first;
+    }
+    CounterFile& file = it->second;
+    if (counterFlushInterval == std::chrono::milliseconds(0))
+    {
+        if (file.written == jsonStr)
+        {
+            return true;
+        }
+        if (!writeCounter(*path, jsonStr))
+        {
+            return false;
+        }
+        file.written = jsonStr;
+        return true;
+    }
+
+    // Only the latest update is kept, and an update that puts back what is
+    // on disk leaves nothing to write
+    if (!file.dirty && file.written == jsonStr)
+    {
+        return true;
+    }
+    file.pending = jsonStr;
+    file.dirty = true;
+    if (!anyCounterDirty)
+    {
+        anyCounterDirty = true;
+        counterDirty.notify_one();
+    }
+    return true;
+}
+
+bool ExternalStorerFileInterface::writeCounter(const std::string& path,
+                                               std::string_view jsonStr)
+{
+    stdplus::print(stderr, "Creating error counter file under path: {}\n",
+                   path);
+    return createFile(path, jsonStr);
+}
+
+void ExternalStorerFileInterface::flushCounters()
+{
+    // Written without the lock held, so publishJson doesn't wait on the disk
+    std::vector<std::pair<std::string, std::string>> batch;
+    {
+        std::lock_guard lock(counterMutex);
+        anyCounterDirty = false;
+        for (auto& [path, file] : counterFiles)
+        {
+            if (!file.dirty)
+            {
+                continue;
+            }
+            file.dirty = false;
+            // The content is only kept until it is written
+            std::string pending = std::exchange(file.pending, {});
+            if (pending != file.written)
+            {
+                batch.emplace_back(path, std::move(pending));
+            }
+        }
+    }
+
+    for (auto& [path, content] : batch)
+    {
+        if (!writeCounter(path, content))
+        {
+            // The next update of the counter tries again
+            continue;
+        }
+        std::lock_guard lock(counterMutex);
+        // Forgotten in the meantime if the cache was full
+        auto it = counterFiles.find(path);
+        if (it != counterFiles.end())
+        {
+            it->second.written = std::move(content);
+        }
+    }
+    fileHandler->flush();
+}
+
+void ExternalStorerFileInterface::counterFlushLoop(std::stop_token stopToken)
+{
+    std::unique_lock lock(counterMutex);
+    while (true)
+    {
+        // Sleep until a counter changes, then give it the flush interval to
+        // collect further updates. Stopping leaves the last flush to the
+        // destructor.
+        if (!counterDirty.wait(lock, stopToken,
+                               [this]() { return anyCounterDirty; }))
+        {
+            return;
+        }
+        counterDirty.wait_for(lock, stopToken, counterFlushInterval,
+                              []() { return false; });
+        if (stopToken.stop_requested())
+        {
+            return;
+        }
+        lock.unlock();
+        flushCounters();
+        lock.lock();
+    }
+}
+
+bool ExternalStorerFileInterface::removeLogEntry(const boost::uuids::uuid& id,
+                                                 std::string subPath)
+{
+    // Makes room in the index for this eviction
+    applyRemovals();
+    if (reaper.joinable())
+    {
+        std::lock_guard lock(reapMutex);
+        if (reapBacklog.size() < maxReapBacklog)
+        {
+            reapBacklog.push_back(
+                EvictedLogEntry{.id = id, .subPath = std::move(subPath)});
+            reapReady.notify_one();
+            return true;
+        }
+    }
+
+    // The reaper is behind, the new entries wait for the deletion
+    if (!fileHandler->removeAll(subPath))
+    {
+        // Stays pending, it is tried again after a restart
+        stdplus::print(stderr, "Failed to delete the oldest entry path: {}\n",
+                       subPath);
         return false;
     }
+    fileHandler->flush([this, id]() { confirmRemovals(std::span(&id, 1)); });
+    return true;
+}
+
+void ExternalStorerFileInterface::confirmRemovals(
+    std::span<const boost::uuids::uuid> ids)
+{
+    std::lock_guard lock(reapMutex);
+    removedIds.insert(removedIds.end(), ids.begin(), ids.end());
+}
+
+void ExternalStorerFileInterface::applyRemovals()
+{
+    {
+        std::lock_guard lock(reapMutex);
+        appliedIds.swap(removedIds);
+    }
+    for (const boost::uuids::uuid& id : appliedIds)
+    {
+        retentionIndex->markRemoved(id);
+    }
+    appliedIds.clear();
+}
 
-    const std::string& path = jsonPdr["@odata.id"].get<std::string>();
+void ExternalStorerFileInterface::reapLoop(std::stop_token stopToken)
+{
+    // Swapped with the backlog, so neither allocates once both have grown
+    std::vector<EvictedLogEntry> batch;
+    batch.reserve(maxReapBacklog);
+    while (true)
+    {
+        {
+            std::unique_lock lock(reapMutex);
+            reapReady.wait(lock, stopToken,
+                           [this]() { return !reapBacklog.empty(); });
+            if (reapBacklog.empty())
+            {
+                return;
+            }
+            batch.swap(reapBacklog);
+        }
+        std::vector<boost::uuids::uuid> removed;
+        removed.reserve(batch.size());
+        for (const EvictedLogEntry& entry : batch)
+        {
+            if (!fileHandler->removeAll(entry.subPath))
+            {
+                stdplus::print(stderr,
+                               "Failed to delete the oldest entry path: {}\n",
+                               entry.subPath);
+                continue;
+            }
+            removed.push_back(entry.id);
+        }
+        // The index stops keeping track of them once they are gone
+        fileHandler->flush([this, removed = std::move(removed)]() {
+            confirmRemovals(removed);
+        });
+        batch.clear();
+    }
+}
 
-    stdplus::print(stderr,
-                   "Creating error counter file under path: {}.  content: {}\n",
-                   path, jsonPdr.dump());
-    return createFile(path, jsonPdr);
+bool ExternalStorerFileInterface::createFile(const std::string& subPath,
+                                             std::string_view jsonStr) const
+{
+    return fileHandler->createFile(subPath, std::span(&jsonStr, 1));
 }
 
-bool ExternalStorerFileInterface::createFile(
-    const std::string& subPath, const nlohmann::json& jsonPdr) const
+std::string
+    ExternalStorerFileInterface::getLogEntryPath(std::string_view serviceId,
+                                                 std::string_view entryId)
 {
-    return fileHandler->createFile(subPath, jsonPdr);
+    return std::format("/redfish/v1/Systems/system/LogServices/{}/Entries/{}",
+                       serviceId, entryId);
 }
 
 } // namespace rde
@@ -0,0 +1,81 @@
+#include "rde/external_storer_segment.hpp"
+
+#include <filesystem>
+#include <utility>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace rde
+{
+
+ExternalStorerSegmentWriter::ExternalStorerSegmentWriter(
+    std::unique_ptr<LogEntrySegmentStore> store,
+    std::unique_ptr<FileHandlerInterface> fileHandler) :
+    store(std::move(store)), fileHandler(std::move(fileHandler))
+{}
+
+bool ExternalStorerSegmentWriter::createFolder(
+    const std::string& folderPath) const
+{
+    return fileHandler->createFolder(folderPath);
+}
+
+bool ExternalStorerSegmentWriter::createFile(
+    const std::string& folderPath,
+    std::span<const std::string_view> jsonParts) const
+{
+    if (isLogEntryPath(folderPath))
+    {
+        return store->append(folderPath, jsonParts);
+    }
+    return fileHandler->createFile(folderPath, jsonParts);
+}
+
+bool ExternalStorerSegmentWriter::removeAll(const std::string& filePath) const
+{
+    if (isLogEntryPath(filePath))
+    {
+        return store->remove(filePath);
+    }
+    // Removing a LogService takes its LogEntries along
+    const bool removed = store->remove(filePath);
+    return fileHandler->removeAll(filePath) && removed;
+}
+
+void ExternalStorerSegmentWriter::flush(std::function<void()> done) const
+{
+    fileHandler->flush(std::move(done));
+}
+
+uint32_t ExternalStorerSegmentWriter::getStoredSize(
+    const std::string& folderPath, size_t size) const
+{
+    if (isLogEntryPath(folderPath))
+    {
+        return LogEntrySegmentStore::recordOverhead + folderPath.size() + size;
+    }
+    return fileHandler->getStoredSize(folderPath, size);
+}
+
+bool ExternalStorerSegmentWriter::hasIndexFile(
+    const std::string& folderPath) const
+{
+    return !isLogEntryPath(folderPath) &&
+           fileHandler->hasIndexFile(folderPath);
+}
+
+const LogEntrySegmentStore& ExternalStorerSegmentWriter::getStore() const
+{
+    return *store;
+}
+
+bool ExternalStorerSegmentWriter::isLogEntryPath(const std::string& path)
+{
+    const std::filesystem::path entryPath =
+        std::filesystem::path(path).lexically_normal();
+    return entryPath.has_filename() &&
+           entryPath.parent_path().filename() == "Entries";
+}
+
+} // namespace rde
+} // namespace bios_bmc_smm_error_logger
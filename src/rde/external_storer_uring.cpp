@@ -0,0 +1,557 @@
+#include "rde/external_storer_uring.hpp"
+
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <stdplus/print.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace rde
+{
+
+namespace
+{
+
+constexpr mode_t dirMode = 0755;
+constexpr mode_t fileMode = 0644;
+// Chains in flight at once, each has a fixed file slot. A chain is at most
+// four SQEs with a CQE each, which the ring holds all of.
+constexpr unsigned maxInFlight = 32;
+constexpr unsigned ringEntries = maxInFlight * 4;
+// user_data is the sequence number of the op and the step of its chain
+constexpr unsigned stepBits = 2;
+
+enum WriteStep : uint64_t
+{
+    mkdirStep,
+    openStep,
+    writeStep,
+    closeStep,
+};
+
+enum RemoveStep : uint64_t
+{
+    unlinkStep,
+    rmdirStep,
+};
+
+/** @brief Mark a prepared SQE as a step of the chain of an op */
+void setStep(io_uring_sqe* sqe, uint64_t seq, uint64_t step, unsigned flags)
+{
+    io_uring_sqe_set_flags(sqe, flags);
+    io_uring_sqe_set_data64(sqe, seq << stepBits | step);
+}
+
+} // namespace
+
+ExternalStorerUringWriter::ExternalStorerUringWriter(
+    boost::asio::io_context& io, std::string_view baseDir) :
+    ExternalStorerFileWriter(baseDir), eventFd(io)
+{
+    int ret = io_uring_queue_init(ringEntries, &ring, 0);
+    if (ret < 0)
+    {
+        throw std::runtime_error(
+            std::format("[ExternalStorerUringWriter] Setting up io_uring "
+                        "failed: {}",
+                        std::strerror(-ret)));
+    }
+    auto fail = [this](std::string_view what, int err) {
+        io_uring_queue_exit(&ring);
+        throw std::runtime_error(std::format(
+            "[ExternalStorerUringWriter] {}: {}", what, std::strerror(err)));
+    };
+
+    // mkdirat came after opening into a fixed file slot (5.15), so it stands
+    // in for that as well
+    io_uring_probe* probe = io_uring_get_probe_ring(&ring);
+    if (probe == nullptr)
+    {
+        fail("Probing io_uring failed", ENOSYS);
+    }
+    const bool supported = std::ranges::all_of(
+        std::array{IORING_OP_MKDIRAT, IORING_OP_OPENAT, IORING_OP_WRITE,
+                   IORING_OP_CLOSE, IORING_OP_UNLINKAT},
+        [probe](int op) { return io_uring_opcode_supported(probe, op); });
+    io_uring_free_probe(probe);
+    if (!supported)
+    {
+        fail("io_uring lacks file operations", EOPNOTSUPP);
+    }
+
+    ret = io_uring_register_files_sparse(&ring, maxInFlight);
+    if (ret < 0)
+    {
+        fail("Registering fixed files failed", -ret);
+    }
+    int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0)
+    {
+        fail("Creating an eventfd failed", errno);
+    }
+    ret = io_uring_register_eventfd(&ring, fd);
+    if (ret < 0)
+    {
+        ::close(fd);
+        fail("Registering the eventfd failed", -ret);
+    }
+    eventFd.assign(fd);
+
+    for (unsigned slot = maxInFlight; slot > 0; --slot)
+    {
+        freeSlots.push_back(slot - 1);
+    }
+    waitCompletions();
+    slowOpWorker = std::jthread(
+        std::bind_front(&ExternalStorerUringWriter::slowOpLoop, this));
+}
+
+ExternalStorerUringWriter::~ExternalStorerUringWriter()
+{
+    {
+        std::unique_lock lock(uringMutex);
+        boost::system::error_code ec;
+        eventFd.close(ec);
+        // What the flush callbacks refer to may be gone already
+        doneFns.clear();
+        while (!ops.empty())
+        {
+            reap();
+            if (ops.empty())
+            {
+                break;
+            }
+            // The worker may queue more SQEs once it is done, so the ring is
+            // only waited on with nothing left for the worker
+            if (numSlowOps > 0)
+            {
+                slowOpFinished.wait(lock);
+                continue;
+            }
+            io_uring_cqe* cqe = nullptr;
+            if (io_uring_wait_cqe(&ring, &cqe) < 0)
+            {
+                break;
+            }
+            reap();
+            doneFns.clear();
+        }
+    }
+    slowOpWorker.request_stop();
+    slowOpWorker.join();
+    io_uring_queue_exit(&ring);
+}
+
+bool ExternalStorerUringWriter::createFolder(
+    const std::string& folderPath) const
+{
+    if (!ExternalStorerFileWriter::createFolder(folderPath))
+    {
+        return false;
+    }
+    std::lock_guard lock(uringMutex);
+    knownDirs.insert(getNormalizedPath(folderPath).native());
+    return true;
+}
+
+bool ExternalStorerUringWriter::createFile(
+    const std::string& folderPath,
+    std::span<const std::string_view> jsonParts) const
+{
+    if (!isValidPath(folderPath))
+    {
+        stdplus::print(stderr, "Invalid path detected: {}\n", folderPath);
+        return false;
+    }
+    // The parts don't outlive the call, the write needs them until it is done
+    std::string data;
+    for (std::string_view part : jsonParts)
+    {
+        data += part;
+    }
+    enqueue(getNormalizedPath(folderPath).native(), std::move(data), false);
+    return true;
+}
+
+bool ExternalStorerUringWriter::removeAll(const std::string& filePath) const
+{
+    if (!isValidPath(filePath))
+    {
+        stdplus::print(stderr, "Invalid path detected: {}\n", filePath);
+        return false;
+    }
+    enqueue(getNormalizedPath(filePath).native(), "", true);
+    return true;
+}
+
+void ExternalStorerUringWriter::flush(std::function<void()> done) const
+{
+    {
+        std::lock_guard lock(uringMutex);
+        if (io_uring_sq_ready(&ring) > 0)
+        {
+            int ret = io_uring_submit(&ring);
+            if (ret < 0)
+            {
+                // Stays queued for the next submit
+                stdplus::print(stderr, "io_uring submit failed: {}\n",
+                               std::strerror(-ret));
+            }
+        }
+        if (done && !ops.empty())
+        {
+            doneFns.emplace_back(nextSeq, std::move(done));
+            return;
+        }
+    }
+    if (done)
+    {
+        done();
+    }
+}
+
+void ExternalStorerUringWriter::enqueue(std::string path, std::string data,
+                                        bool remove) const
+{
+    std::lock_guard lock(uringMutex);
+    if (remove)
+    {
+        std::erase_if(knownDirs, [&path](const std::string& dir) {
+            return path.empty() || dir == path ||
+                   (dir.starts_with(path) && dir[path.size()] == '/');
+        });
+    }
+    const uint64_t seq = nextSeq++;
+    std::deque<uint64_t>& queue = pathOps[path];
+    queue.push_back(seq);
+    Op& op = ops[seq];
+    op.dir = (baseDir / path).native();
+    op.file = (baseDir / path / "index.json").native();
+    op.path = std::move(path);
+    op.data = std::move(data);
+    op.remove = remove;
+    // Later calls for the path wait until this one is done
+    if (queue.size() == 1)
+    {
+        start(seq);
+    }
+}
+
+void ExternalStorerUringWriter::start(uint64_t seq) const
+{
+    if (freeSlots.empty())
+    {
+        waitingOps.push_back(seq);
+        return;
+    }
+    Op& op = ops.at(seq);
+    op.slot = freeSlots.back();
+    freeSlots.pop_back();
+    prepare(seq, op);
+}
+
+void ExternalStorerUringWriter::prepare(uint64_t seq, Op& op) const
+{
+    if (op.remove && op.path.empty())
+    {
+        // The chain only covers a LogEntry, take the long way for the rest
+        queueSlowOp(seq, op.path, true);
+        return;
+    }
+    if (!op.remove)
+    {
+        std::string parent =
+            std::filesystem::path(op.path).parent_path().native();
+        if (!knownDirs.contains(parent))
+        {
+            // Once per LogService, the entries under it are created async
+            queueSlowOp(seq, std::move(parent), false);
+            return;
+        }
+    }
+
+    const bool makeDir = !op.remove && !op.path.empty();
+    const unsigned numSqes = op.remove ? 2 : (makeDir ? 4 : 3);
+    if (io_uring_sq_space_left(&ring) < numSqes)
+    {
+        io_uring_submit(&ring);
+    }
+    op.pendingCqes = numSqes;
+    op.error = 0;
+
+    if (op.remove)
+    {
+        // The hardlink runs the rmdir whatever the unlink of the index.json
+        // comes back with
+        io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+        io_uring_prep_unlinkat(sqe, AT_FDCWD, op.file.c_str(), 0);
+        setStep(sqe, seq, unlinkStep, IOSQE_IO_HARDLINK);
+        sqe = io_uring_get_sqe(&ring);
+        io_uring_prep_unlinkat(sqe, AT_FDCWD, op.dir.c_str(), AT_REMOVEDIR);
+        setStep(sqe, seq, rmdirStep, 0);
+        return;
+    }
+
+    // Hardlinks go on past an existing directory, and close the file even if
+    // the write fails. A failed open cancels the rest.
+    io_uring_sqe* sqe = nullptr;
+    if (makeDir)
+    {
+        sqe = io_uring_get_sqe(&ring);
+        io_uring_prep_mkdirat(sqe, AT_FDCWD, op.dir.c_str(), dirMode);
+        setStep(sqe, seq, mkdirStep, IOSQE_IO_HARDLINK);
+    }
+    sqe = io_uring_get_sqe(&ring);
+    io_uring_prep_openat_direct(sqe, AT_FDCWD, op.file.c_str(),
+                                O_WRONLY | O_CREAT | O_TRUNC, fileMode,
+                                op.slot);
+    setStep(sqe, seq, openStep, IOSQE_IO_LINK);
+    sqe = io_uring_get_sqe(&ring);
+    io_uring_prep_write(sqe, op.slot, op.data.data(), op.data.size(), 0);
+    setStep(sqe, seq, writeStep, IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK);
+    sqe = io_uring_get_sqe(&ring);
+    io_uring_prep_close_direct(sqe, op.slot);
+    setStep(sqe, seq, closeStep, 0);
+}
+
+void ExternalStorerUringWriter::reap() const
+{
+    unsigned head = 0;
+    unsigned numCqes = 0;
+    io_uring_cqe* cqe = nullptr;
+    io_uring_for_each_cqe(&ring, head, cqe)
+    {
+        complete(cqe->user_data, cqe->res);
+        ++numCqes;
+    }
+    io_uring_cq_advance(&ring, numCqes);
+    // Ops that were waiting on the ones just done
+    if (io_uring_sq_ready(&ring) > 0)
+    {
+        io_uring_submit(&ring);
+    }
+}
+
+void ExternalStorerUringWriter::complete(uint64_t userData, int res) const
+{
+    const uint64_t seq = userData >> stepBits;
+    const uint64_t step = userData & ((1 << stepBits) - 1);
+    Op& op = ops.at(seq);
+    // A cancelled step is down to the error of an earlier one
+    const bool failed = res < 0 && res != -ECANCELED && op.error == 0;
+    if (op.remove)
+    {
+        // Whatever was there to unlink, the rmdir tells what is left
+        if (step == rmdirStep && failed && res != -ENOENT)
+        {
+            op.error = res;
+        }
+    }
+    else if (step == mkdirStep)
+    {
+        if (failed && res != -EEXIST)
+        {
+            op.error = res;
+        }
+    }
+    else if (failed)
+    {
+        op.error = res;
+    }
+    else if (step == writeStep && res >= 0 &&
+             static_cast<size_t>(res) != op.data.size())
+    {
+        op.error = -EIO;
+    }
+
+    if (--op.pendingCqes == 0)
+    {
+        finish(seq);
+    }
+}
+
+void ExternalStorerUringWriter::finish(uint64_t seq) const
+{
+    Op& op = ops.at(seq);
+    if (!op.remove && op.error == -ENOENT && !op.retried)
+    {
+        // A directory was removed behind our back, make it again
+        knownDirs.clear();
+        forgetDirs();
+        op.retried = true;
+        prepare(seq, op);
+        return;
+    }
+    if (op.remove && (op.error == -ENOTEMPTY || op.error == -ENOTDIR))
+    {
+        // More than a LogEntry
+        queueSlowOp(seq, op.path, true);
+        return;
+    }
+    if (op.remove && op.error != 0)
+    {
+        stdplus::print(stderr, "Failed to remove {}: {}\n", op.dir,
+                       std::strerror(-op.error));
+    }
+    else if (op.error != 0)
+    {
+        stdplus::print(stderr, "Failed to create {}: {}\n", op.file,
+                       std::strerror(-op.error));
+    }
+    release(seq);
+}
+
+void ExternalStorerUringWriter::release(uint64_t seq) const
+{
+    Op& op = ops.at(seq);
+    freeSlots.push_back(op.slot);
+    auto queue = pathOps.find(op.path);
+    queue->second.pop_front();
+    std::optional<uint64_t> next;
+    if (queue->second.empty())
+    {
+        pathOps.erase(queue);
+    }
+    else
+    {
+        next = queue->second.front();
+    }
+    ops.erase(seq);
+
+    // The slot goes to the op that has waited the longest
+    while (!waitingOps.empty() && !freeSlots.empty())
+    {
+        const uint64_t waiting = waitingOps.front();
+        waitingOps.pop_front();
+        start(waiting);
+    }
+    if (next)
+    {
+        start(*next);
+    }
+}
+
+void ExternalStorerUringWriter::queueSlowOp(uint64_t seq, std::string path,
+                                            bool remove) const
+{
+    slowOps.push_back({.seq = seq, .path = std::move(path), .remove = remove});
+    ++numSlowOps;
+    slowOpQueued.notify_one();
+}
+
+void ExternalStorerUringWriter::resumeAfterSlowOp(const SlowOp& slowOp,
+                                                  bool success) const
+{
+    Op& op = ops.at(slowOp.seq);
+    if (slowOp.remove)
+    {
+        if (!success)
+        {
+            stdplus::print(stderr, "Failed to remove {}\n", op.dir);
+        }
+        release(slowOp.seq);
+        return;
+    }
+    if (!success)
+    {
+        op.error = -ENOENT;
+        op.retried = true;
+        finish(slowOp.seq);
+        return;
+    }
+    knownDirs.insert(slowOp.path);
+    prepare(slowOp.seq, op);
+}
+
+void ExternalStorerUringWriter::slowOpLoop(std::stop_token stopToken)
+{
+    std::unique_lock lock(uringMutex);
+    while (slowOpQueued.wait(lock, stopToken,
+                             [this]() { return !slowOps.empty(); }))
+    {
+        const SlowOp slowOp = std::move(slowOps.front());
+        slowOps.pop_front();
+        lock.unlock();
+        const bool success =
+            slowOp.remove ? ExternalStorerFileWriter::removeAll(slowOp.path)
+                          : ExternalStorerFileWriter::createFolder(slowOp.path);
+        lock.lock();
+
+        resumeAfterSlowOp(slowOp, success);
+        if (io_uring_sq_ready(&ring) > 0)
+        {
+            io_uring_submit(&ring);
+        }
+        --numSlowOps;
+        slowOpFinished.notify_all();
+        // Flush callbacks waiting on the op are run on the io_context
+        if (eventFd.is_open())
+        {
+            ::eventfd_write(eventFd.native_handle(), 1);
+        }
+    }
+}
+
+std::vector<std::function<void()>> ExternalStorerUringWriter::takeDone() const
+{
+    std::vector<std::function<void()>> due;
+    auto it = doneFns.begin();
+    for (; it != doneFns.end(); ++it)
+    {
+        if (!ops.empty() && ops.begin()->first < it->first)
+        {
+            break;
+        }
+        due.push_back(std::move(it->second));
+    }
+    doneFns.erase(doneFns.begin(), it);
+    return due;
+}
+
+void ExternalStorerUringWriter::waitCompletions()
+{
+    eventFd.async_wait(
+        boost::asio::posix::descriptor_base::wait_read,
+        [this](const boost::system::error_code& ec) {
+            if (ec)
+            {
+                // Closed by the destructor
+                return;
+            }
+            uint64_t count = 0;
+            if (::read(eventFd.native_handle(), &count, sizeof(count)) < 0 &&
+                errno != EAGAIN)
+            {
+                stdplus::print(stderr, "Reading the io_uring eventfd failed: "
+                                       "{}\n",
+                               std::strerror(errno));
+            }
+            std::vector<std::function<void()>> due;
+            {
+                std::lock_guard lock(uringMutex);
+                reap();
+                due = takeDone();
+            }
+            for (const std::function<void()>& done : due)
+            {
+                done();
+            }
+            waitCompletions();
+        });
+}
+
+} // namespace rde
+} // namespace bios_bmc_smm_error_logger
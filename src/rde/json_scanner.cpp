@@ -0,0 +1,402 @@
+#include "rde/json_scanner.hpp"
+
+#include <charconv>
+#include <cstdint>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace rde
+{
+
+namespace
+{
+
+// Deeper nesting than any PDR has, the limit only keeps garbage input from
+// exhausting the stack
+constexpr size_t maxDepth = 128;
+
+bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+void appendUtf8(std::string& out, uint32_t codePoint)
+{
+    if (codePoint < 0x80)
+    {
+        out += static_cast<char>(codePoint);
+    }
+    else if (codePoint < 0x800)
+    {
+        out += static_cast<char>(0xc0 | (codePoint >> 6));
+        out += static_cast<char>(0x80 | (codePoint & 0x3f));
+    }
+    else if (codePoint < 0x10000)
+    {
+        out += static_cast<char>(0xe0 | (codePoint >> 12));
+        out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (codePoint & 0x3f));
+    }
+    else
+    {
+        out += static_cast<char>(0xf0 | (codePoint >> 18));
+        out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3f));
+        out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (codePoint & 0x3f));
+    }
+}
+
+std::optional<uint32_t> parseHex4(std::string_view str)
+{
+    uint32_t value = 0;
+    if (str.size() < 4)
+    {
+        return std::nullopt;
+    }
+    auto [ptr, ec] = std::from_chars(str.data(), str.data() + 4, value, 16);
+    if (ec != std::errc() || ptr != str.data() + 4)
+    {
+        return std::nullopt;
+    }
+    return value;
+}
+
+} // namespace
+
+bool JsonObjectScanner::scan(std::string_view jsonStr)
+{
+    json = jsonStr;
+    pos = 0;
+    members.clear();
+
+    skipWhitespace();
+    if (pos >= json.size() || json[pos] != '{' || !scanObject(0))
+    {
+        return false;
+    }
+    skipWhitespace();
+    return pos == json.size();
+}
+
+const std::vector<JsonMember>& JsonObjectScanner::getMembers() const
+{
+    return members;
+}
+
+const JsonMember* JsonObjectScanner::find(std::string_view key) const
+{
+    for (auto it = members.rbegin(); it != members.rend(); ++it)
+    {
+        if (it->key == key)
+        {
+            return &*it;
+        }
+    }
+    return nullptr;
+}
+
+std::optional<std::string> JsonObjectScanner::getString(
+    const JsonMember* member)
+{
+    if (member == nullptr || member->value.size() < 2 ||
+        member->value.front() != '"')
+    {
+        return std::nullopt;
+    }
+
+    std::string_view raw = member->value.substr(1, member->value.size() - 2);
+    std::string out;
+    out.reserve(raw.size());
+    for (size_t i = 0; i < raw.size(); ++i)
+    {
+        if (raw[i] != '\\')
+        {
+            out += raw[i];
+            continue;
+        }
+        // scan already made sure every escape is complete and valid
+        ++i;
+        switch (raw[i])
+        {
+            case 'b':
+                out += '\b';
+                break;
+            case 'f':
+                out += '\f';
+                break;
+            case 'n':
+                out += '\n';
+                break;
+            case 'r':
+                out += '\r';
+                break;
+            case 't':
+                out += '\t';
+                break;
+            case 'u':
+            {
+                uint32_t codePoint = *parseHex4(raw.substr(i + 1));
+                i += 4;
+                // A high surrogate followed by a low one is a single character
+                if (codePoint >= 0xd800 && codePoint < 0xdc00 &&
+                    raw.substr(i + 1, 2) == "\\u")
+                {
+                    std::optional<uint32_t> low = parseHex4(raw.substr(i + 3));
+                    if (low && *low >= 0xdc00 && *low < 0xe000)
+                    {
+                        codePoint =
+                            0x10000 + ((codePoint - 0xd800) << 10) +
+                            (*low - 0xdc00);
+                        i += 6;
+                    }
+                }
+                appendUtf8(out, codePoint);
+                break;
+            }
+            default:
+                // '"', '\\' and '/'
+                out += raw[i];
+                break;
+        }
+    }
+    return out;
+}
+
+bool JsonObjectScanner::scanValue(size_t depth)
+{
+    if (pos >= json.size())
+    {
+        return false;
+    }
+    switch (json[pos])
+    {
+        case '{':
+            return scanObject(depth + 1);
+        case '[':
+            return scanArray(depth + 1);
+        case '"':
+            return scanString();
+        default:
+            return scanLiteral();
+    }
+}
+
+bool JsonObjectScanner::scanObject(size_t depth)
+{
+    if (depth > maxDepth)
+    {
+        return false;
+    }
+    // Skip the '{'
+    ++pos;
+    skipWhitespace();
+    if (pos < json.size() && json[pos] == '}')
+    {
+        ++pos;
+        return true;
+    }
+
+    while (true)
+    {
+        const size_t memberStart = pos;
+        if (pos >= json.size() || json[pos] != '"' || !scanString())
+        {
+            return false;
+        }
+        const size_t keyEnd = pos;
+        skipWhitespace();
+        if (pos >= json.size() || json[pos] != ':')
+        {
+            return false;
+        }
+        ++pos;
+        skipWhitespace();
+        const size_t valueStart = pos;
+        if (!scanValue(depth))
+        {
+            return false;
+        }
+        if (depth == 0)
+        {
+            members.push_back(JsonMember{
+                .key = json.substr(memberStart + 1, keyEnd - memberStart - 2),
+                .value = json.substr(valueStart, pos - valueStart),
+                .text = json.substr(memberStart, pos - memberStart)});
+        }
+
+        skipWhitespace();
+        if (pos >= json.size())
+        {
+            return false;
+        }
+        if (json[pos] == '}')
+        {
+            ++pos;
+            return true;
+        }
+        if (json[pos] != ',')
+        {
+            return false;
+        }
+        ++pos;
+        skipWhitespace();
+    }
+}
+
+bool JsonObjectScanner::scanArray(size_t depth)
+{
+    if (depth > maxDepth)
+    {
+        return false;
+    }
+    // Skip the '['
+    ++pos;
+    skipWhitespace();
+    if (pos < json.size() && json[pos] == ']')
+    {
+        ++pos;
+        return true;
+    }
+
+    while (true)
+    {
+        if (!scanValue(depth))
+        {
+            return false;
+        }
+        skipWhitespace();
+        if (pos >= json.size())
+        {
+            return false;
+        }
+        if (json[pos] == ']')
+        {
+            ++pos;
+            return true;
+        }
+        if (json[pos] != ',')
+        {
+            return false;
+        }
+        ++pos;
+        skipWhitespace();
+    }
+}
+
+bool JsonObjectScanner::scanString()
+{
+    // Skip the opening '"'
+    ++pos;
+    while (pos < json.size())
+    {
+        const char c = json[pos];
+        if (c == '"')
+        {
+            ++pos;
+            return true;
+        }
+        if (static_cast<unsigned char>(c) < 0x20)
+        {
+            // Control characters have to be escaped
+            return false;
+        }
+        if (c == '\\')
+        {
+            ++pos;
+            if (pos >= json.size())
+            {
+                return false;
+            }
+            switch (json[pos])
+            {
+                case '"':
+                case '\\':
+                case '/':
+                case 'b':
+                case 'f':
+                case 'n':
+                case 'r':
+                case 't':
+                    break;
+                case 'u':
+                    if (!parseHex4(json.substr(pos + 1)))
+                    {
+                        return false;
+                    }
+                    pos += 4;
+                    break;
+                default:
+                    return false;
+            }
+        }
+        ++pos;
+    }
+    return false;
+}
+
+bool JsonObjectScanner::scanLiteral()
+{
+    for (std::string_view literal : {"true", "false", "null"})
+    {
+        if (json.substr(pos, literal.size()) == literal)
+        {
+            pos += literal.size();
+            return true;
+        }
+    }
+
+    // -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    auto skipDigits = [this]() {
+        const size_t start = pos;
+        while (pos < json.size() && isDigit(json[pos]))
+        {
+            ++pos;
+        }
+        return pos - start;
+    };
+    if (pos < json.size() && json[pos] == '-')
+    {
+        ++pos;
+    }
+    if (pos < json.size() && json[pos] == '0')
+    {
+        ++pos;
+    }
+    else if (skipDigits() == 0)
+    {
+        return false;
+    }
+    if (pos < json.size() && json[pos] == '.')
+    {
+        ++pos;
+        if (skipDigits() == 0)
+        {
+            return false;
+        }
+    }
+    if (pos < json.size() && (json[pos] == 'e' || json[pos] == 'E'))
+    {
+        ++pos;
+        if (pos < json.size() && (json[pos] == '+' || json[pos] == '-'))
+        {
+            ++pos;
+        }
+        if (skipDigits() == 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void JsonObjectScanner::skipWhitespace()
+{
+    while (pos < json.size() && (json[pos] == ' ' || json[pos] == '\t' ||
+                                 json[pos] == '\n' || json[pos] == '\r'))
+    {
+        ++pos;
+    }
+}
+
+} // namespace rde
+} // namespace bios_bmc_smm_error_logger
@@ -0,0 +1,544 @@
+#include "rde/log_entry_index.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <stdplus/print.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <stdexcept>
+#include <system_error>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace rde
+{
+
+/*
+ * Index file layout, host byte order:
+ *
+ *   Header
+ *   Record[maxSavedEntries], the first numSavedEntries are in use
+ *   Record[maxEntries], a ring of numEntries records starting at head
+ *   PendingRecord[maxPendingRemovals], a ring of numPending records starting
+ *   at pendingHead
+ */
+
+struct LogEntryRetentionIndex::Header
+{
+    std::array<uint8_t, 8> magic;
+    uint32_t version;
+    uint32_t maxSavedEntries;
+    uint32_t maxEntries;
+    uint32_t numSavedEntries;
+    uint32_t head;
+    uint32_t numEntries;
+    uint32_t maxPendingRemovals;
+    uint32_t pendingHead;
+    uint32_t numPending;
+    // NUL terminated, records refer to them by index
+    std::array<std::array<char, maxLogServiceIdSize + 1>, maxLogServices>
+        logServiceIds;
+};
+
+struct LogEntryRetentionIndex::Record
+{
+    std::array<uint8_t, 16> id;
+    uint32_t size;
+    uint8_t logService;
+    std::array<uint8_t, 3> reserved;
+};
+
+/*
+ * An evicted entry whose files may still be there. It keeps the ID of its
+ * LogService itself, so the slot can be taken over before it is removed.
+ */
+struct LogEntryRetentionIndex::PendingRecord
+{
+    std::array<uint8_t, 16> id;
+    uint32_t size;
+    uint8_t removed;
+    std::array<uint8_t, 3> reserved;
+    // NUL terminated
+    std::array<char, maxLogServiceIdSize + 1> logServiceId;
+};
+
+namespace
+{
+
+constexpr std::array<uint8_t, 8> indexMagic = {'B', 'B', 'S', 'M',
+                                               'R', 'I', 'D', 'X'};
+constexpr uint32_t indexVersion = 2;
+
+} // namespace
+
+LogEntryRetentionIndex::LogEntryRetentionIndex(const std::string& path,
+                                               uint32_t maxSavedEntries,
+                                               uint32_t maxEntries,
+                                               uint64_t maxBytes,
+                                               uint32_t maxPendingRemovals) :
+    maxSavedEntries(maxSavedEntries),
+    maxEntries(std::max<uint32_t>(maxEntries, 1)), maxBytes(maxBytes),
+    maxPendingRemovals(maxPendingRemovals),
+    mappedSize(sizeof(Header) +
+               (static_cast<size_t>(maxSavedEntries) + this->maxEntries) *
+                   sizeof(Record) +
+               static_cast<size_t>(maxPendingRemovals) * sizeof(PendingRecord))
+{
+    static_assert(sizeof(Record) == 24,
+                  "Size of LogEntryRetentionIndex::Record is incorrect.");
+    static_assert(
+        sizeof(PendingRecord) == 152,
+        "Size of LogEntryRetentionIndex::PendingRecord is incorrect.");
+    if (path.empty())
+    {
+        void* memory = ::mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED)
+        {
+            throw std::runtime_error(std::format(
+                "[LogEntryRetentionIndex] Allocating the index failed: {}",
+                std::strerror(errno)));
+        }
+        mapped = static_cast<uint8_t*>(memory);
+        reset();
+        return;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(
+        std::filesystem::path(path).parent_path(), ec);
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        throw std::runtime_error(
+            std::format("[LogEntryRetentionIndex] Opening '{}' failed: {}",
+                        path, std::strerror(errno)));
+    }
+    struct stat fileStat;
+    if (::fstat(fd, &fileStat) != 0)
+    {
+        const int err = errno;
+        ::close(fd);
+        throw std::runtime_error(
+            std::format("[LogEntryRetentionIndex] fstat of '{}' failed: {}",
+                        path, std::strerror(err)));
+    }
+    const size_t fileSize = fileStat.st_size;
+    if (fileSize != mappedSize && ::ftruncate(fd, mappedSize) != 0)
+    {
+        const int err = errno;
+        ::close(fd);
+        throw std::runtime_error(
+            std::format("[LogEntryRetentionIndex] Resizing '{}' failed: {}",
+                        path, std::strerror(err)));
+    }
+    void* memory = ::mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE,
+                          MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED)
+    {
+        throw std::runtime_error(
+            std::format("[LogEntryRetentionIndex] Mapping '{}' failed: {}",
+                        path, std::strerror(errno)));
+    }
+    mapped = static_cast<uint8_t*>(memory);
+
+    if (!isValid(fileSize))
+    {
+        if (fileSize != 0)
+        {
+            stdplus::print(stderr,
+                           "Retention index {} doesn't match the limits, "
+                           "starting over\n",
+                           path);
+        }
+        reset();
+        return;
+    }
+
+    // Only the records are kept in the file, the rest is counted from them
+    const Header& h = header();
+    for (uint32_t i = 0; i < h.numSavedEntries; ++i)
+    {
+        totalSize += savedRecord(i).size;
+        ++logServiceRefs[savedRecord(i).logService];
+    }
+    for (uint32_t i = 0; i < h.numEntries; ++i)
+    {
+        const Record& r = record((h.head + i) % this->maxEntries);
+        totalSize += r.size;
+        ++logServiceRefs[r.logService];
+    }
+}
+
+LogEntryRetentionIndex::~LogEntryRetentionIndex()
+{
+    ::munmap(mapped, mappedSize);
+}
+
+std::optional<RetainedLogEntry> LogEntryRetentionIndex::getNextEviction(
+    std::string_view logServiceId, uint32_t size) const
+{
+    const Header& h = header();
+    const bool toSaved = h.numSavedEntries < maxSavedEntries;
+    const bool hasOldest = h.numEntries > 0;
+    if (!toSaved && h.numEntries == maxEntries)
+    {
+        return toEntry(record(h.head), false);
+    }
+    if (maxBytes != 0 && totalSize + size > maxBytes && hasOldest)
+    {
+        return toEntry(record(h.head), false);
+    }
+
+    // A new LogService needs a slot no entry refers to anymore. The one of
+    // the LogService with the fewest entries is taken over, the entries of
+    // the other LogServices stay.
+    if (!findLogService(logServiceId) &&
+        std::ranges::find(logServiceRefs, 0U) == logServiceRefs.end())
+    {
+        std::optional<uint8_t> logService = findReclaimableLogService();
+        if (logService)
+        {
+            for (uint32_t i = 0; i < h.numEntries; ++i)
+            {
+                const Record& r = record((h.head + i) % maxEntries);
+                if (r.logService == *logService)
+                {
+                    return toEntry(r, false);
+                }
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+bool LogEntryRetentionIndex::hasRoomForLogService(
+    std::string_view logServiceId) const
+{
+    return findLogService(logServiceId) ||
+           std::ranges::find(logServiceRefs, 0U) != logServiceRefs.end() ||
+           findReclaimableLogService();
+}
+
+void LogEntryRetentionIndex::evict(const RetainedLogEntry& entry)
+{
+    if (entry.saved)
+    {
+        throw std::logic_error("Saved entries are never evicted");
+    }
+    Header& h = header();
+    uint32_t position = 0;
+    while (position < h.numEntries &&
+           !std::ranges::equal(record((h.head + position) % maxEntries).id,
+                               entry.id))
+    {
+        ++position;
+    }
+    if (position == h.numEntries)
+    {
+        throw std::logic_error("Entry to evict is not in the retention index");
+    }
+
+    const Record r = record((h.head + position) % maxEntries);
+    if (position == 0)
+    {
+        h.head = (h.head + 1) % maxEntries;
+    }
+    else
+    {
+        // Entries evicted to free a LogService slot can be anywhere in the
+        // ring, the newer ones move up to close the gap
+        for (uint32_t i = position; i + 1 < h.numEntries; ++i)
+        {
+            record((h.head + i) % maxEntries) =
+                record((h.head + i + 1) % maxEntries);
+        }
+    }
+    --h.numEntries;
+    totalSize -= r.size;
+    --logServiceRefs[r.logService];
+
+    if (maxPendingRemovals == 0)
+    {
+        return;
+    }
+    if (h.numPending == maxPendingRemovals)
+    {
+        // Past this many, evicted entries left behind by a crash are lost
+        // track of
+        stdplus::print(stderr,
+                       "Too many log entries waiting to be removed, no "
+                       "longer tracking the oldest\n");
+        h.pendingHead = (h.pendingHead + 1) % maxPendingRemovals;
+        --h.numPending;
+    }
+    PendingRecord& pending =
+        pendingRecord((h.pendingHead + h.numPending) % maxPendingRemovals);
+    pending = {};
+    pending.id = r.id;
+    pending.size = r.size;
+    std::ranges::copy(h.logServiceIds[r.logService],
+                      pending.logServiceId.begin());
+    // The record is in place before the count takes it in
+    ++h.numPending;
+}
+
+void LogEntryRetentionIndex::markRemoved(const boost::uuids::uuid& id)
+{
+    Header& h = header();
+    for (uint32_t i = 0; i < h.numPending; ++i)
+    {
+        PendingRecord& pending =
+            pendingRecord((h.pendingHead + i) % maxPendingRemovals);
+        if (std::ranges::equal(pending.id, id))
+        {
+            pending.removed = 1;
+            break;
+        }
+    }
+    // Removals finish out of order, the ring shrinks from its oldest end
+    while (h.numPending > 0 && pendingRecord(h.pendingHead).removed != 0)
+    {
+        h.pendingHead = (h.pendingHead + 1) % maxPendingRemovals;
+        --h.numPending;
+    }
+}
+
+void LogEntryRetentionIndex::add(const boost::uuids::uuid& id,
+                                 std::string_view logServiceId, uint32_t size)
+{
+    if (logServiceId.size() > maxLogServiceIdSize)
+    {
+        throw std::invalid_argument(
+            std::format("LogService ID '{}' is too long", logServiceId));
+    }
+    Header& h = header();
+    const bool toSaved = h.numSavedEntries < maxSavedEntries;
+    if (!toSaved && h.numEntries == maxEntries)
+    {
+        throw std::logic_error("No room in the retention index");
+    }
+
+    std::optional<uint8_t> logService = findLogService(logServiceId);
+    if (!logService)
+    {
+        auto freeSlot = std::ranges::find(logServiceRefs, 0U);
+        if (freeSlot == logServiceRefs.end())
+        {
+            throw std::logic_error("No LogService slot in the retention index");
+        }
+        logService = freeSlot - logServiceRefs.begin();
+        auto& slotId = h.logServiceIds[*logService];
+        slotId.fill('\0');
+        std::ranges::copy(logServiceId, slotId.begin());
+    }
+
+    Record r = {};
+    std::ranges::copy(id, r.id.begin());
+    r.size = size;
+    r.logService = *logService;
+    // The record is in place before the count takes it in
+    if (toSaved)
+    {
+        savedRecord(h.numSavedEntries) = r;
+        ++h.numSavedEntries;
+    }
+    else
+    {
+        record((h.head + h.numEntries) % maxEntries) = r;
+        ++h.numEntries;
+    }
+    totalSize += size;
+    ++logServiceRefs[*logService];
+}
+
+std::vector<RetainedLogEntry> LogEntryRetentionIndex::getEntries() const
+{
+    const Header& h = header();
+    std::vector<RetainedLogEntry> entries;
+    entries.reserve(getNumEntries());
+    for (uint32_t i = 0; i < h.numSavedEntries; ++i)
+    {
+        entries.push_back(toEntry(savedRecord(i), true));
+    }
+    for (uint32_t i = 0; i < h.numEntries; ++i)
+    {
+        entries.push_back(toEntry(record((h.head + i) % maxEntries), false));
+    }
+    return entries;
+}
+
+std::vector<RetainedLogEntry>
+    LogEntryRetentionIndex::getPendingRemovals() const
+{
+    const Header& h = header();
+    std::vector<RetainedLogEntry> entries;
+    for (uint32_t i = 0; i < h.numPending; ++i)
+    {
+        const PendingRecord& pending =
+            pendingRecord((h.pendingHead + i) % maxPendingRemovals);
+        if (pending.removed != 0)
+        {
+            continue;
+        }
+        RetainedLogEntry entry{.id = {},
+                               .logServiceId = pending.logServiceId.data(),
+                               .size = pending.size,
+                               .saved = false};
+        std::ranges::copy(pending.id, entry.id.begin());
+        entries.push_back(std::move(entry));
+    }
+    return entries;
+}
+
+size_t LogEntryRetentionIndex::getNumEntries() const
+{
+    return header().numSavedEntries + header().numEntries;
+}
+
+uint64_t LogEntryRetentionIndex::getTotalSize() const
+{
+    return totalSize;
+}
+
+LogEntryRetentionIndex::Header& LogEntryRetentionIndex::header() const
+{
+    return *reinterpret_cast<Header*>(mapped);
+}
+
+LogEntryRetentionIndex::Record&
+    LogEntryRetentionIndex::savedRecord(uint32_t index) const
+{
+    return reinterpret_cast<Record*>(mapped + sizeof(Header))[index];
+}
+
+LogEntryRetentionIndex::Record&
+    LogEntryRetentionIndex::record(uint32_t index) const
+{
+    return savedRecord(maxSavedEntries + index);
+}
+
+LogEntryRetentionIndex::PendingRecord&
+    LogEntryRetentionIndex::pendingRecord(uint32_t index) const
+{
+    return reinterpret_cast<PendingRecord*>(
+        mapped + sizeof(Header) +
+        (static_cast<size_t>(maxSavedEntries) + maxEntries) *
+            sizeof(Record))[index];
+}
+
+RetainedLogEntry LogEntryRetentionIndex::toEntry(const Record& record,
+                                                 bool saved) const
+{
+    RetainedLogEntry entry{.id = {},
+                           .logServiceId =
+                               header().logServiceIds[record.logService].data(),
+                           .size = record.size,
+                           .saved = saved};
+    std::ranges::copy(record.id, entry.id.begin());
+    return entry;
+}
+
+bool LogEntryRetentionIndex::isValid(size_t fileSize) const
+{
+    const Header& h = header();
+    if (fileSize != mappedSize || h.magic != indexMagic ||
+        h.version != indexVersion || h.maxSavedEntries != maxSavedEntries ||
+        h.maxEntries != maxEntries || h.numSavedEntries > maxSavedEntries ||
+        h.head >= maxEntries || h.numEntries > maxEntries ||
+        h.maxPendingRemovals != maxPendingRemovals ||
+        (maxPendingRemovals != 0 && h.pendingHead >= maxPendingRemovals) ||
+        h.numPending > maxPendingRemovals)
+    {
+        return false;
+    }
+    for (const auto& logServiceId : h.logServiceIds)
+    {
+        if (logServiceId.back() != '\0')
+        {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < h.numPending; ++i)
+    {
+        if (pendingRecord((h.pendingHead + i) % maxPendingRemovals)
+                .logServiceId.back() != '\0')
+        {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < h.numSavedEntries; ++i)
+    {
+        if (savedRecord(i).logService >= maxLogServices)
+        {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < h.numEntries; ++i)
+    {
+        if (record((h.head + i) % maxEntries).logService >= maxLogServices)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void LogEntryRetentionIndex::reset()
+{
+    std::memset(mapped, 0, mappedSize);
+    Header& h = header();
+    h.magic = indexMagic;
+    h.version = indexVersion;
+    h.maxSavedEntries = maxSavedEntries;
+    h.maxEntries = maxEntries;
+    h.maxPendingRemovals = maxPendingRemovals;
+    totalSize = 0;
+    logServiceRefs.fill(0);
+}
+
+std::optional<uint8_t>
+    LogEntryRetentionIndex::findReclaimableLogService() const
+{
+    const Header& h = header();
+    std::array<bool, maxLogServices> hasSaved = {};
+    for (uint32_t i = 0; i < h.numSavedEntries; ++i)
+    {
+        hasSaved[savedRecord(i).logService] = true;
+    }
+    std::optional<uint8_t> fewest;
+    for (size_t i = 0; i < maxLogServices; ++i)
+    {
+        if (!hasSaved[i] &&
+            (!fewest || logServiceRefs[i] < logServiceRefs[*fewest]))
+        {
+            fewest = i;
+        }
+    }
+    return fewest;
+}
+
+std::optional<uint8_t> LogEntryRetentionIndex::findLogService(
+    std::string_view logServiceId) const
+{
+    const Header& h = header();
+    for (size_t i = 0; i < maxLogServices; ++i)
+    {
+        if (logServiceRefs[i] != 0 && h.logServiceIds[i].data() == logServiceId)
+        {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+} // namespace rde
+} // namespace bios_bmc_smm_error_logger
@@ -0,0 +1,554 @@
+#include "rde/log_entry_segment_store.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <stdplus/print.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace rde
+{
+
+/*
+ * Segment file layout, host byte order, one record after the other:
+ *
+ *   RecordHeader
+ *   path, pathSize bytes without a NUL
+ *   JSON, dataSize bytes
+ */
+
+struct LogEntrySegmentStore::RecordHeader
+{
+    uint32_t magic;
+    // Cleared in place once the entry is removed or replaced
+    uint32_t live;
+    uint32_t pathSize;
+    uint32_t dataSize;
+};
+
+namespace
+{
+
+constexpr uint32_t recordMagic = 0x45534242; // "BBSE"
+constexpr mode_t fileMode = 0644;
+// Segments with less than 1/compactRatio of their bytes live are compacted
+constexpr uint64_t compactRatio = 4;
+
+std::string getSegmentName(uint64_t id)
+{
+    return std::format("{}.seg", id);
+}
+
+/** @brief The path without leading or trailing '/', "." or ".." parts */
+std::string getKey(const std::string& path)
+{
+    std::string key;
+    for (const auto& part :
+         std::filesystem::path(path).lexically_normal().relative_path())
+    {
+        if (part.empty() || part == "." || part == "..")
+        {
+            continue;
+        }
+        if (!key.empty())
+        {
+            key += '/';
+        }
+        key += part.native();
+    }
+    return key;
+}
+
+/** @brief pwritev all of iov at offset, a few at a time */
+bool writeAllAt(int fd, std::span<iovec> iov, off_t offset)
+{
+    while (!iov.empty())
+    {
+        const ssize_t written = ::pwritev(
+            fd, iov.data(), std::min<size_t>(iov.size(), IOV_MAX), offset);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        offset += written;
+        size_t left = written;
+        while (!iov.empty() && left >= iov.front().iov_len)
+        {
+            left -= iov.front().iov_len;
+            iov = iov.subspan(1);
+        }
+        if (left > 0)
+        {
+            iov.front().iov_base = static_cast<char*>(iov.front().iov_base) +
+                                   left;
+            iov.front().iov_len -= left;
+        }
+    }
+    return true;
+}
+
+/** @brief pread size bytes at offset */
+bool readAllAt(int fd, char* data, size_t size, off_t offset)
+{
+    while (size > 0)
+    {
+        const ssize_t bytes = ::pread(fd, data, size, offset);
+        if (bytes < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (bytes <= 0)
+        {
+            return false;
+        }
+        data += bytes;
+        size -= bytes;
+        offset += bytes;
+    }
+    return true;
+}
+
+} // namespace
+
+LogEntrySegmentStore::LogEntrySegmentStore(const std::string& dir,
+                                           size_t segmentSize) :
+    segmentSize(segmentSize)
+{
+    static_assert(sizeof(RecordHeader) == recordOverhead,
+                  "Size of LogEntrySegmentStore::RecordHeader is incorrect.");
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    int fd = ::open(dir.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw std::runtime_error(
+            std::format("[LogEntrySegmentStore] Opening '{}' failed: {}", dir,
+                        std::strerror(errno)));
+    }
+    dirFd.emplace(std::move(fd));
+
+    std::vector<uint64_t> ids;
+    for (const auto& file : std::filesystem::directory_iterator(dir, ec))
+    {
+        const std::string name = file.path().filename();
+        uint64_t id = 0;
+        auto [ptr, err] =
+            std::from_chars(name.data(), name.data() + name.size(), id);
+        if (err == std::errc() && std::string_view(ptr) == ".seg")
+        {
+            ids.push_back(id);
+        }
+    }
+    // Oldest first, so newer records of a path replace older ones
+    std::ranges::sort(ids);
+    for (uint64_t id : ids)
+    {
+        loadSegment(id);
+    }
+    for (auto it = segments.begin(); it != segments.end();)
+    {
+        if (it->second.liveBytes == 0 && std::next(it) != segments.end())
+        {
+            ::unlinkat(dirFd->get(), getSegmentName(it->first).c_str(), 0);
+            it = segments.erase(it);
+            continue;
+        }
+        ++it;
+    }
+
+    if (segments.empty() || segments.rbegin()->second.size >= segmentSize)
+    {
+        if (!rotate())
+        {
+            throw std::runtime_error(std::format(
+                "[LogEntrySegmentStore] Creating a segment in '{}' failed: {}",
+                dir, std::strerror(errno)));
+        }
+    }
+    else
+    {
+        current = segments.rbegin()->first;
+    }
+}
+
+bool LogEntrySegmentStore::append(const std::string& path,
+                                  std::span<const std::string_view> jsonParts)
+{
+    const std::string key = getKey(path);
+    std::lock_guard lock(mutex);
+    std::optional<Location> location = appendRecord(key, jsonParts);
+    if (!location)
+    {
+        stdplus::print(stderr, "Failed to append {} to segment {}: {}\n", key,
+                       current, std::strerror(errno));
+        return false;
+    }
+    auto [entry, inserted] = entries.try_emplace(key, *location);
+    segments.at(location->segment).keys.insert(entry->first);
+    if (!inserted)
+    {
+        // The new record is in place before the old one is dropped
+        const Location old = std::exchange(entry->second, *location);
+        if (old.segment != location->segment)
+        {
+            segments.at(old.segment).keys.erase(entry->first);
+        }
+        markDead(key, old);
+        release(old.segment);
+    }
+    return true;
+}
+
+bool LogEntrySegmentStore::remove(const std::string& path)
+{
+    const std::string key = getKey(path);
+    std::lock_guard lock(mutex);
+    bool removed = true;
+    std::vector<uint64_t> released;
+    auto drop = [this, &removed, &released](auto entry) {
+        removed = markDead(entry->first, entry->second) && removed;
+        released.push_back(entry->second.segment);
+        segments.at(entry->second.segment).keys.erase(entry->first);
+        return entries.erase(entry);
+    };
+
+    if (auto entry = entries.find(key); entry != entries.end())
+    {
+        drop(entry);
+    }
+    const std::string prefix = key.empty() ? key : key + '/';
+    for (auto entry = entries.lower_bound(prefix);
+         entry != entries.end() && entry->first.starts_with(prefix);)
+    {
+        entry = drop(entry);
+    }
+
+    std::ranges::sort(released);
+    const auto [first, last] = std::ranges::unique(released);
+    released.erase(first, last);
+    for (uint64_t id : released)
+    {
+        release(id);
+    }
+    return removed;
+}
+
+std::optional<std::string>
+    LogEntrySegmentStore::read(const std::string& path) const
+{
+    const std::string key = getKey(path);
+    std::lock_guard lock(mutex);
+    auto entry = entries.find(key);
+    if (entry == entries.end())
+    {
+        return std::nullopt;
+    }
+    return readRecord(entry->first, entry->second);
+}
+
+std::vector<std::string>
+    LogEntrySegmentStore::list(const std::string& path) const
+{
+    const std::string key = getKey(path);
+    const std::string prefix = key.empty() ? key : key + '/';
+    std::lock_guard lock(mutex);
+    std::vector<std::string> names;
+    for (auto entry = entries.lower_bound(prefix);
+         entry != entries.end() && entry->first.starts_with(prefix); ++entry)
+    {
+        std::string_view name = entry->first;
+        name.remove_prefix(prefix.size());
+        if (name.find('/') == std::string_view::npos)
+        {
+            names.emplace_back(name);
+        }
+    }
+    return names;
+}
+
+bool LogEntrySegmentStore::exportTo(
+    const FileHandlerInterface& fileHandler) const
+{
+    bool exported = true;
+    {
+        std::lock_guard lock(mutex);
+        for (const auto& [key, location] : entries)
+        {
+            std::optional<std::string> json = readRecord(key, location);
+            if (!json)
+            {
+                exported = false;
+                continue;
+            }
+            const std::string_view part = *json;
+            if (!fileHandler.createFile("/" + key, std::span(&part, 1)))
+            {
+                exported = false;
+            }
+        }
+    }
+    fileHandler.flush();
+    return exported;
+}
+
+size_t LogEntrySegmentStore::getNumEntries() const
+{
+    std::lock_guard lock(mutex);
+    return entries.size();
+}
+
+size_t LogEntrySegmentStore::getNumSegments() const
+{
+    std::lock_guard lock(mutex);
+    return segments.size();
+}
+
+void LogEntrySegmentStore::loadSegment(uint64_t id)
+{
+    const std::string name = getSegmentName(id);
+    int fd = ::openat(dirFd->get(), name.c_str(), O_RDWR | O_CLOEXEC);
+    struct stat fileStat;
+    if (fd < 0 || ::fstat(fd, &fileStat) != 0)
+    {
+        stdplus::print(stderr, "Failed to open segment {}: {}\n", name,
+                       std::strerror(errno));
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+        return;
+    }
+    Segment& segment =
+        segments
+            .try_emplace(id, Segment{.fd = stdplus::ManagedFd(std::move(fd))})
+            .first->second;
+    std::string content(fileStat.st_size, '\0');
+    if (!readAllAt(segment.fd.get(), content.data(), content.size(), 0))
+    {
+        content.clear();
+    }
+
+    uint64_t offset = 0;
+    while (offset + sizeof(RecordHeader) <= content.size())
+    {
+        RecordHeader header;
+        std::memcpy(&header, content.data() + offset, sizeof(header));
+        const uint64_t recordSize = sizeof(RecordHeader) +
+                                    static_cast<uint64_t>(header.pathSize) +
+                                    header.dataSize;
+        if (header.magic != recordMagic ||
+            offset + recordSize > content.size())
+        {
+            break;
+        }
+        if (header.live != 0)
+        {
+            const std::string_view key(
+                content.data() + offset + sizeof(RecordHeader),
+                header.pathSize);
+            const Location location{
+                .segment = id, .offset = offset, .dataSize = header.dataSize};
+            auto [entry, inserted] =
+                entries.try_emplace(std::string(key), location);
+            if (!inserted)
+            {
+                // Left behind by a replace or compaction that was cut short
+                const Location old = std::exchange(entry->second, location);
+                segments.at(old.segment).keys.erase(entry->first);
+                markDead(key, old);
+            }
+            segment.keys.insert(entry->first);
+            segment.liveBytes += recordSize;
+        }
+        offset += recordSize;
+    }
+    if (offset != content.size())
+    {
+        stdplus::print(stderr, "Segment {} has a torn record, dropping it\n",
+                       name);
+        if (::ftruncate(segment.fd.get(), offset) != 0)
+        {
+            stdplus::print(stderr, "Failed to truncate segment {}: {}\n",
+                           name, std::strerror(errno));
+        }
+    }
+    segment.size = offset;
+}
+
+bool LogEntrySegmentStore::rotate()
+{
+    const uint64_t id = segments.empty() ? 0 : segments.rbegin()->first + 1;
+    int fd = ::openat(dirFd->get(), getSegmentName(id).c_str(),
+                      O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, fileMode);
+    if (fd < 0)
+    {
+        return false;
+    }
+    segments.try_emplace(id, Segment{.fd = stdplus::ManagedFd(std::move(fd))});
+    current = id;
+    return true;
+}
+
+std::optional<LogEntrySegmentStore::Location>
+    LogEntrySegmentStore::appendRecord(
+        std::string_view key, std::span<const std::string_view> jsonParts)
+{
+    size_t dataSize = 0;
+    for (std::string_view part : jsonParts)
+    {
+        dataSize += part.size();
+    }
+    const uint64_t recordSize = sizeof(RecordHeader) + key.size() + dataSize;
+    // A record bigger than a segment gets one of its own
+    const Segment& last = segments.at(current);
+    if (last.size > 0 && last.size + recordSize > segmentSize && !rotate())
+    {
+        return std::nullopt;
+    }
+
+    Segment& segment = segments.at(current);
+    RecordHeader header{.magic = recordMagic,
+                        .live = 1,
+                        .pathSize = static_cast<uint32_t>(key.size()),
+                        .dataSize = static_cast<uint32_t>(dataSize)};
+    std::vector<iovec> iov;
+    iov.reserve(jsonParts.size() + 2);
+    iov.push_back({&header, sizeof(header)});
+    iov.push_back({const_cast<char*>(key.data()), key.size()});
+    for (std::string_view part : jsonParts)
+    {
+        iov.push_back({const_cast<char*>(part.data()), part.size()});
+    }
+    if (!writeAllAt(segment.fd.get(), iov, segment.size))
+    {
+        // Nothing after a record that is cut short is loaded
+        const int err = errno;
+        if (::ftruncate(segment.fd.get(), segment.size) != 0)
+        {
+            stdplus::print(stderr, "Failed to truncate segment {}: {}\n",
+                           current, std::strerror(errno));
+        }
+        errno = err;
+        return std::nullopt;
+    }
+
+    const Location location{.segment = current,
+                            .offset = segment.size,
+                            .dataSize = header.dataSize};
+    segment.size += recordSize;
+    segment.liveBytes += recordSize;
+    return location;
+}
+
+bool LogEntrySegmentStore::markDead(std::string_view key,
+                                    const Location& location)
+{
+    Segment& segment = segments.at(location.segment);
+    segment.liveBytes -= sizeof(RecordHeader) + key.size() + location.dataSize;
+    const uint32_t live = 0;
+    if (::pwrite(segment.fd.get(), &live, sizeof(live),
+                 location.offset + offsetof(RecordHeader, live)) !=
+        sizeof(live))
+    {
+        stdplus::print(stderr, "Failed to remove {} from segment {}: {}\n",
+                       key, location.segment, std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void LogEntrySegmentStore::release(uint64_t id)
+{
+    auto it = segments.find(id);
+    if (it == segments.end())
+    {
+        return;
+    }
+    Segment& segment = it->second;
+    if (id == current)
+    {
+        // Starts over rather than rotating
+        if (segment.liveBytes == 0 && segment.size > 0 &&
+            ::ftruncate(segment.fd.get(), 0) == 0)
+        {
+            segment.size = 0;
+        }
+        return;
+    }
+    if (segment.liveBytes == 0)
+    {
+        ::unlinkat(dirFd->get(), getSegmentName(id).c_str(), 0);
+        segments.erase(it);
+        return;
+    }
+    if (segment.liveBytes * compactRatio < segment.size)
+    {
+        compact(id);
+    }
+}
+
+void LogEntrySegmentStore::compact(uint64_t id)
+{
+    Segment& segment = segments.at(id);
+    for (auto key = segment.keys.begin(); key != segment.keys.end();)
+    {
+        Location& location = entries.find(*key)->second;
+        std::optional<std::string> json = readRecord(*key, location);
+        if (!json)
+        {
+            return;
+        }
+        const std::string_view part = *json;
+        std::optional<Location> moved = appendRecord(*key,
+                                                     std::span(&part, 1));
+        if (!moved)
+        {
+            return;
+        }
+        // Live in both segments until this one is gone, the newer record
+        // wins if the store is loaded in between
+        segment.liveBytes -=
+            sizeof(RecordHeader) + key->size() + location.dataSize;
+        location = *moved;
+        segments.at(moved->segment).keys.insert(*key);
+        key = segment.keys.erase(key);
+    }
+    ::unlinkat(dirFd->get(), getSegmentName(id).c_str(), 0);
+    segments.erase(id);
+}
+
+std::optional<std::string>
+    LogEntrySegmentStore::readRecord(std::string_view key,
+                                     const Location& location) const
+{
+    std::string json(location.dataSize, '\0');
+    if (!readAllAt(segments.at(location.segment).fd.get(), json.data(),
+                   json.size(),
+                   location.offset + sizeof(RecordHeader) + key.size()))
+    {
+        return std::nullopt;
+    }
+    return json;
+}
+
+} // namespace rde
+} // namespace bios_bmc_smm_error_logger
@@ -0,0 +1,41 @@
+#include "rde/log_entry_store_dbus_handler.hpp"
+
+#include <xyz/openbmc_project/Common/error.hpp>
+
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace rde
+{
+
+LogEntryStoreDbusHandler::LogEntryStoreDbusHandler(
+    const std::shared_ptr<sdbusplus::asio::connection>& conn,
+    const LogEntrySegmentStore& store) : objServer(conn)
+{
+    iface = objServer.add_interface(logEntriesPath, logEntriesInterface);
+    iface->register_method("List", [&store](const std::string& path) {
+        return store.list(path);
+    });
+    iface->register_method("Read", [&store](const std::string& path) {
+        std::optional<std::string> json = store.read(path);
+        if (!json)
+        {
+            throw sdbusplus::xyz::openbmc_project::Common::Error::
+                ResourceNotFound();
+        }
+        return std::move(*json);
+    });
+    iface->initialize();
+}
+
+LogEntryStoreDbusHandler::~LogEntryStoreDbusHandler()
+{
+    objServer.remove_interface(iface);
+}
+
+} // namespace rde
+} // namespace bios_bmc_smm_error_logger
@@ -1,5 +1,9 @@
 #include "rde/notifier_dbus_handler.hpp"
 
+#include <boost/asio/post.hpp>
+
+#include <utility>
+
 namespace bios_bmc_smm_error_logger
 {
 namespace rde
@@ -9,14 +13,25 @@ CperFileNotifierHandler::CperFileNotifierHandler(
     const std::shared_ptr<sdbusplus::asio::connection>& conn) :
     objManager(static_cast<sdbusplus::bus_t&>(*conn),
                CperFileNotifier::cperBasePath),
-    objServer(conn)
+    objServer(conn), io(conn->get_io_context())
 {}
 
-void CperFileNotifierHandler::createEntry(const std::string& filePath)
+void CperFileNotifierHandler::createEntries(std::vector<std::string> filePaths)
 {
-    auto obj =
-        std::make_unique<CperFileNotifier>(objServer, filePath, nextEntry);
-    ++nextEntry;
+    if (filePaths.empty())
+    {
+        return;
+    }
+    // Entries are decoded off the io_context thread, D-Bus objects may only be
+    // touched from it
+    boost::asio::post(io, [this, filePaths = std::move(filePaths)]() {
+        for (const std::string& filePath : filePaths)
+        {
+            auto obj = std::make_unique<CperFileNotifier>(objServer, filePath,
+                                                          nextEntry);
+            ++nextEntry;
+        }
+    });
 }
 
 } // namespace rde
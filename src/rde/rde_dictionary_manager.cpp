@@ -1,5 +1,7 @@
 #include "rde/rde_dictionary_manager.hpp"
 
+#include "checksum/crc32.hpp"
+
 #include <stdplus/print.hpp>
 
 #include <format>
@@ -9,28 +11,47 @@ namespace bios_bmc_smm_error_logger
 namespace rde
 {
 
+namespace
+{
+
+/** @brief Append data to a dictionary, advancing the CRC over it if set */
+void appendData(std::vector<uint8_t>& dictionary,
+                std::span<const uint8_t> data, uint32_t* crc)
+{
+    if (crc == nullptr)
+    {
+        dictionary.insert(dictionary.end(), data.begin(), data.end());
+        return;
+    }
+    *crc = crc32Append(*crc, data, dictionary);
+}
+
+} // namespace
+
 DictionaryManager::DictionaryManager() : validDictionaryCount(0) {}
 
 void DictionaryManager::startDictionaryEntry(
-    uint32_t resourceId, const std::span<const uint8_t> data)
+    uint32_t resourceId, const std::span<const uint8_t> data, uint32_t* crc)
 {
     // Check whether the resourceId is already available.
     auto itemIt = dictionaries.find(resourceId);
     if (itemIt == dictionaries.end())
     {
-        dictionaries[resourceId] =
-            std::make_unique<DictionaryEntry>(false, data);
-        return;
+        itemIt = dictionaries
+                     .emplace(resourceId, std::make_unique<DictionaryEntry>(
+                                              false, std::span<uint8_t>()))
+                     .first;
+    }
+    else
+    {
+        // Since we are creating a new dictionary on an existing entry,
+        // invalidate the existing entry.
+        invalidateDictionaryEntry(*itemIt->second);
     }
-
-    // Since we are creating a new dictionary on an existing entry, invalidate
-    // the existing entry.
-    invalidateDictionaryEntry(*itemIt->second);
 
     // Flush the existing data.
     itemIt->second->data.clear();
-    itemIt->second->data.insert(itemIt->second->data.begin(), data.begin(),
-                                data.end());
+    appendData(itemIt->second->data, data, crc);
 }
 
 bool DictionaryManager::markDataComplete(uint32_t resourceId)
@@ -45,8 +66,8 @@ bool DictionaryManager::markDataComplete(uint32_t resourceId)
     return true;
 }
 
-bool DictionaryManager::addDictionaryData(uint32_t resourceId,
-                                          const std::span<const uint8_t> data)
+bool DictionaryManager::addDictionaryData(
+    uint32_t resourceId, const std::span<const uint8_t> data, uint32_t* crc)
 {
     auto itemIt = dictionaries.find(resourceId);
     if (itemIt == dictionaries.end())
@@ -56,8 +77,7 @@ bool DictionaryManager::addDictionaryData(uint32_t resourceId,
     }
     // Since we are modifying an existing entry, invalidate the existing entry.
     invalidateDictionaryEntry(*itemIt->second);
-    itemIt->second->data.insert(itemIt->second->data.end(), data.begin(),
-                                data.end());
+    appendData(itemIt->second->data, data, crc);
     return true;
 }
 
@@ -1,5 +1,7 @@
 #include "rde/rde_handler.hpp"
 
+#include "checksum/crc32.hpp"
+
 #include <stdplus/print.hpp>
 
 #include <format>
@@ -10,21 +12,11 @@ namespace bios_bmc_smm_error_logger
 namespace rde
 {
 
-/**
- * @brief CRC-32 divisor.
- *
- * This is equivalent to the one used by IEEE802.3.
- */
-constexpr uint32_t crcDevisor = 0xedb88320;
-
 RdeCommandHandler::RdeCommandHandler(
     std::unique_ptr<ExternalStorerInterface> exStorer) :
     flagState(RdeDictTransferFlagState::RdeStateIdle),
-    exStorer(std::move(exStorer)), prevDictResourceId(0), crc(0xFFFFFFFF)
-{
-    // Initialize CRC table.
-    calcCrcTable();
-}
+    exStorer(std::move(exStorer)), prevDictResourceId(0), crc(crc32Init)
+{}
 
 RdeDecodeStatus RdeCommandHandler::decodeRdeCommand(
     std::span<const uint8_t> rdeCommand, RdeCommandType type)
@@ -209,30 +201,9 @@ RdeDecodeStatus RdeCommandHandler::multiPartReceiveResp(
     return ret;
 }
 
-void RdeCommandHandler::calcCrcTable()
-{
-    for (uint32_t i = 0; i < UINT8_MAX + 1; ++i)
-    {
-        uint32_t rem = i;
-        for (uint8_t k = 0; k < 8; ++k)
-        {
-            rem = (rem & 1) ? (rem >> 1) ^ crcDevisor : rem >> 1;
-        }
-        crcTable[i] = rem;
-    }
-}
-
-void RdeCommandHandler::updateCrc(std::span<const uint8_t> stream)
-{
-    for (uint32_t i = 0; i < stream.size_bytes(); ++i)
-    {
-        crc = crcTable[(crc ^ stream[i]) & 0xff] ^ (crc >> 8);
-    }
-}
-
 uint32_t RdeCommandHandler::finalChecksum()
 {
-    return (crc ^ 0xFFFFFFFF);
+    return crc32Final(crc);
 }
 
 RdeDecodeStatus RdeCommandHandler::handleCrc(
@@ -275,11 +246,10 @@ void RdeCommandHandler::handleFlagStart(const MultipartReceiveResHeader* header,
                                         uint32_t resourceId)
 {
     // This is a beginning of a dictionary. Reset CRC.
-    crc = 0xFFFFFFFF;
+    crc = crc32Init;
     std::span dataS(data, header->dataLengthBytes);
-    dictionaryManager.startDictionaryEntry(resourceId, dataS);
-    // Start checksum calculation only for the data portion.
-    updateCrc(dataS);
+    // Start checksum calculation only for the data portion, while copying it.
+    dictionaryManager.startDictionaryEntry(resourceId, dataS, &crc);
     flagState = RdeDictTransferFlagState::RdeStateStartRecvd;
 }
 
@@ -301,13 +271,13 @@ RdeDecodeStatus RdeCommandHandler::handleFlagMiddle(
         // Start of a new dictionary. Mark previous dictionary as
         // complete.
         dictionaryManager.markDataComplete(prevDictResourceId);
-        dictionaryManager.startDictionaryEntry(resourceId, dataS);
+        dictionaryManager.startDictionaryEntry(resourceId, dataS, &crc);
     }
     else
     {
         // Not a new dictionary. Add the received data to the existing
         // dictionary.
-        if (!dictionaryManager.addDictionaryData(resourceId, dataS))
+        if (!dictionaryManager.addDictionaryData(resourceId, dataS, &crc))
         {
             stdplus::print(stderr,
                            "Failed to add dictionary data: ResourceId: {}\n",
@@ -315,8 +285,8 @@ RdeDecodeStatus RdeCommandHandler::handleFlagMiddle(
             return RdeDecodeStatus::RdeDictionaryError;
         }
     }
-    // Continue checksum calculation only for the data portion.
-    updateCrc(dataS);
+    // The checksum calculation continued over the data portion as it was
+    // copied.
     return RdeDecodeStatus::RdeOk;
 }
 
@@ -340,11 +310,11 @@ RdeDecodeStatus RdeCommandHandler::handleFlagEnd(
         // Start of a new dictionary. Mark previous dictionary as
         // complete.
         dictionaryManager.markDataComplete(prevDictResourceId);
-        dictionaryManager.startDictionaryEntry(resourceId, dataS);
+        dictionaryManager.startDictionaryEntry(resourceId, dataS, &crc);
     }
     else
     {
-        if (!dictionaryManager.addDictionaryData(resourceId, dataS))
+        if (!dictionaryManager.addDictionaryData(resourceId, dataS, &crc))
         {
             stdplus::print(stderr,
                            "Failed to add dictionary data: ResourceId: {}\n",
@@ -354,10 +324,9 @@ RdeDecodeStatus RdeCommandHandler::handleFlagEnd(
     }
     dictionaryManager.markDataComplete(resourceId);
 
-    // Continue checksum calculation only for the data portion. At the end of
-    // data, we will have the DataIntegrityChecksum field. So omit that when
-    // calculating checksum.
-    updateCrc(dataS);
+    // The checksum calculation continued over the data portion as it was
+    // copied. At the end of data, we will have the DataIntegrityChecksum
+    // field, which is left out of it.
     auto ret = handleCrc(rdeCommand);
     if (ret != RdeDecodeStatus::RdeOk)
     {
@@ -372,18 +341,16 @@ RdeDecodeStatus RdeCommandHandler::handleFlagStartAndEnd(
     uint32_t resourceId)
 {
     // This is a beginning of a dictionary. Reset CRC.
-    crc = 0xFFFFFFFF;
+    crc = crc32Init;
     // This is a beginning and end of a dictionary.
+    // Do checksum calculation only for the data portion, while copying it. At
+    // the end of data, we will have the DataIntegrityChecksum field. So omit
+    // that when calculating checksum.
     dictionaryManager.startDictionaryEntry(
-        resourceId, std::span(data, header->dataLengthBytes));
+        resourceId, std::span(data, header->dataLengthBytes), &crc);
     dictionaryManager.markDataComplete(resourceId);
     flagState = RdeDictTransferFlagState::RdeStateIdle;
 
-    // Do checksum calculation only for the data portion. At the end of data, we
-    // will have the DataIntegrityChecksum field. So omit that when calculating
-    // checksum.
-    updateCrc(std::span(data, header->dataLengthBytes));
-
     auto ret = handleCrc(rdeCommand);
     if (ret != RdeDecodeStatus::RdeOk)
     {
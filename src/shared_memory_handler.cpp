@@ -0,0 +1,107 @@
+#include "shared_memory_handler.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <stdplus/fd/managed.hpp>
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+
+namespace bios_bmc_smm_error_logger
+{
+
+namespace
+{
+
+// Grow the file behind fd to at least regionSize, closing fd on failure
+int sizedFd(int fd, size_t regionSize, std::string_view what)
+{
+    if (fd < 0)
+    {
+        throw std::runtime_error(
+            std::format("{} failed: {}", what, std::strerror(errno)));
+    }
+    struct stat fileStat;
+    if (::fstat(fd, &fileStat) != 0 ||
+        (static_cast<size_t>(fileStat.st_size) < regionSize &&
+         ::ftruncate(fd, static_cast<off_t>(regionSize)) != 0))
+    {
+        const int error = errno;
+        ::close(fd);
+        throw std::runtime_error(std::format("{} failed to size the buffer: {}",
+                                             what, std::strerror(error)));
+    }
+    return fd;
+}
+
+} // namespace
+
+SharedMemoryDataHandler::SharedMemoryDataHandler(
+    int fd, size_t regionSize, std::unique_ptr<Doorbell> doorbell) :
+    PciDataHandler(/*regionAddress=*/0, regionSize,
+                   std::make_unique<stdplus::ManagedFd>(std::move(fd)),
+                   std::move(doorbell)),
+    mappedFd(fd), regionSize(regionSize)
+{}
+
+std::unique_ptr<SharedMemoryDataHandler> SharedMemoryDataHandler::createMemfd(
+    size_t regionSize, std::unique_ptr<Doorbell> doorbell)
+{
+    const int fd = sizedFd(
+        ::memfd_create("bios-bmc-smm-error-logger", MFD_CLOEXEC), regionSize,
+        "[createMemfd] memfd_create");
+    return std::unique_ptr<SharedMemoryDataHandler>(
+        new SharedMemoryDataHandler(fd, regionSize, std::move(doorbell)));
+}
+
+std::unique_ptr<SharedMemoryDataHandler> SharedMemoryDataHandler::openFile(
+    const std::string& path, size_t regionSize,
+    std::unique_ptr<Doorbell> doorbell)
+{
+    const int fd =
+        sizedFd(::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600),
+                regionSize, std::format("[openFile] Opening '{}'", path));
+    return std::unique_ptr<SharedMemoryDataHandler>(
+        new SharedMemoryDataHandler(fd, regionSize, std::move(doorbell)));
+}
+
+std::unique_ptr<SharedMemoryDataHandler> SharedMemoryDataHandler::share() const
+{
+    const int sharedFd = ::fcntl(mappedFd, F_DUPFD_CLOEXEC, 0);
+    if (sharedFd < 0)
+    {
+        throw std::runtime_error(std::format(
+            "[share] Failed to duplicate the fd: {}", std::strerror(errno)));
+    }
+    return std::unique_ptr<SharedMemoryDataHandler>(
+        new SharedMemoryDataHandler(sharedFd, regionSize, nullptr));
+}
+
+uint32_t SharedMemoryDataHandler::readInto(const uint32_t offset,
+                                           std::span<uint8_t> bytes)
+{
+    const uint32_t bytesRead = PciDataHandler::readInto(offset, bytes);
+    // Nothing read after this, e.g. the entries behind a write pointer, may
+    // be older than what was just read
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return bytesRead;
+}
+
+uint32_t SharedMemoryDataHandler::write(const uint32_t offset,
+                                        const std::span<const uint8_t> bytes)
+{
+    // Everything written before, e.g. the entries before the write pointer
+    // that publishes them, is visible first
+    std::atomic_thread_fence(std::memory_order_release);
+    return PciDataHandler::write(offset, bytes);
+}
+
+} // namespace bios_bmc_smm_error_logger
@@ -0,0 +1,256 @@
+#include "bios_producer.hpp"
+#include "buffer.hpp"
+#include "shared_memory_handler.hpp"
+
+#include <boost/endian/conversion.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace
+{
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+using ::testing::IsEmpty;
+
+class BiosProducerTest : public ::testing::Test
+{
+  protected:
+    BiosProducerTest()
+    {
+        auto bmcSide = SharedMemoryDataHandler::createMemfd(testRegionSize);
+        biosSide = bmcSide->share();
+        bufferImpl = std::make_unique<BufferImpl>(std::move(bmcSide));
+        bufferImpl->initialize(testBmcInterfaceVersion, testQueueSize,
+                               testUeRegionSize, testMagicNumber);
+        producer = std::make_unique<BiosProducer>(*biosSide);
+        producer->attach();
+    }
+
+    static std::vector<uint8_t> payload(uint16_t sequenceId, size_t size)
+    {
+        std::vector<uint8_t> bytes(size);
+        std::iota(bytes.begin(), bytes.end(), static_cast<uint8_t>(sequenceId));
+        return bytes;
+    }
+
+    // Drain the queue, returning the entries in order
+    std::vector<EntryPair> drain()
+    {
+        std::vector<EntryPair> entries;
+        bufferImpl->poll();
+        bufferImpl->drain([&entries](const QueueEntryHeader& entryHeader,
+                                     std::span<const uint8_t> entry) {
+            entries.emplace_back(
+                entryHeader, std::vector<uint8_t>(entry.begin(), entry.end()));
+        });
+        return entries;
+    }
+
+    static constexpr size_t testRegionSize = 0x1000;
+    static constexpr uint32_t testBmcInterfaceVersion = 123;
+    static constexpr uint16_t testQueueSize = 0x200;
+    static constexpr uint16_t testUeRegionSize = 0x50;
+    static constexpr std::array<uint32_t, 4> testMagicNumber = {
+        0x12345678, 0x22345678, 0x32345678, 0x42345678};
+    static constexpr size_t entryHeaderSize = sizeof(struct QueueEntryHeader);
+    static constexpr size_t testMaxOffset =
+        testQueueSize - sizeof(struct CircularBufferHeader) - testUeRegionSize;
+
+    std::unique_ptr<SharedMemoryDataHandler> biosSide;
+    std::unique_ptr<BufferImpl> bufferImpl;
+    std::unique_ptr<BiosProducer> producer;
+};
+
+TEST_F(BiosProducerTest, AttachBeforeInitializeFail)
+{
+    auto uninitialized = SharedMemoryDataHandler::createMemfd(testRegionSize);
+    BiosProducer uninitializedProducer(*uninitialized);
+    EXPECT_FALSE(uninitializedProducer.isBufferInitialized());
+    EXPECT_THROW(uninitializedProducer.attach(), std::runtime_error);
+    EXPECT_TRUE(producer->isBufferInitialized());
+}
+
+TEST_F(BiosProducerTest, EntriesReachBufferImpl)
+{
+    EXPECT_EQ(producer->getQueueFreeBytes(), testMaxOffset - 1);
+    EXPECT_TRUE(producer->writeEntry(0x2, payload(0, 0x20)));
+    EXPECT_TRUE(producer->writeEntry(0x1, payload(1, 0x7)));
+
+    std::vector<EntryPair> entries = drain();
+    ASSERT_EQ(entries.size(), 2U);
+    EXPECT_EQ(entries[0].first.sequenceId, 0);
+    EXPECT_EQ(entries[0].first.rdeCommandType, 0x2);
+    EXPECT_THAT(entries[0].second, ElementsAreArray(payload(0, 0x20)));
+    EXPECT_EQ(entries[1].first.sequenceId, 1);
+    EXPECT_EQ(entries[1].first.rdeCommandType, 0x1);
+    EXPECT_THAT(entries[1].second, ElementsAreArray(payload(1, 0x7)));
+    EXPECT_EQ(producer->getQueueFreeBytes(), testMaxOffset - 1);
+
+    BiosProducerStats stats = producer->getStats();
+    EXPECT_EQ(stats.entriesWritten, 2U);
+    EXPECT_EQ(stats.bytesWritten, 2 * sizeof(QueueEntryHeader) + 0x27);
+}
+
+TEST_F(BiosProducerTest, Wraparound)
+{
+    // Entries that don't divide the queue size evenly end up split across
+    // the end of the queue
+    constexpr size_t entrySize = 0x35;
+    for (uint16_t i = 0; i < 40; ++i)
+    {
+        ASSERT_TRUE(producer->writeEntry(0x2, payload(i, entrySize)));
+        std::vector<EntryPair> entries = drain();
+        ASSERT_EQ(entries.size(), 1U);
+        EXPECT_EQ(entries[0].first.sequenceId, i);
+        EXPECT_THAT(entries[0].second, ElementsAreArray(payload(i, entrySize)));
+    }
+    EXPECT_EQ(bufferImpl->getRecoveryStats().resyncs, 0U);
+}
+
+TEST_F(BiosProducerTest, FullQueueSignalsOverflowOnce)
+{
+    uint16_t numWritten = 0;
+    while (producer->writeEntry(0x2, payload(numWritten, 0x40)))
+    {
+        ++numWritten;
+    }
+    EXPECT_FALSE(producer->writeEntry(0x2, payload(0, 0x40)));
+    BiosProducerStats stats = producer->getStats();
+    EXPECT_EQ(stats.entriesDropped, 2U);
+    EXPECT_EQ(stats.overflowsSignaled, 1U);
+
+    PollResult pollResult = bufferImpl->poll();
+    EXPECT_TRUE(pollResult.overflowAcknowledged);
+    bufferImpl->drain([](const QueueEntryHeader&, std::span<const uint8_t>) {});
+
+    // The dropped entries show up as a gap once BIOS logs again
+    EXPECT_TRUE(producer->writeEntry(0x2, payload(0, 0x40)));
+    EXPECT_THAT(drain().size(), 1U);
+    SequenceStats sequenceStats = bufferImpl->getSequenceStats();
+    EXPECT_EQ(sequenceStats.overflows, 1U);
+    EXPECT_EQ(sequenceStats.entriesLostToOverflow, 2U);
+}
+
+TEST_F(BiosProducerTest, UeLog)
+{
+    const std::vector<uint8_t> ueLog = payload(7, 0x30);
+    EXPECT_TRUE(producer->writeUeLog(ueLog));
+    // The BMC hasn't read the first one yet
+    EXPECT_FALSE(producer->writeUeLog(ueLog));
+
+    PollResult pollResult = bufferImpl->poll();
+    ASSERT_TRUE(pollResult.ueLogPending);
+    std::vector<uint8_t> ueRegion = bufferImpl->readPendingUeLog();
+    ASSERT_EQ(ueRegion.size(), testUeRegionSize);
+    EXPECT_THAT(std::span(ueRegion).first(ueLog.size()),
+                ElementsAreArray(ueLog));
+
+    EXPECT_THROW(producer->writeUeLog(payload(0, testUeRegionSize + 1)),
+                 std::invalid_argument);
+    BiosProducerStats stats = producer->getStats();
+    EXPECT_EQ(stats.ueLogsWritten, 1U);
+    EXPECT_EQ(stats.ueLogsDropped, 1U);
+}
+
+TEST_F(BiosProducerTest, ReattachAfterBmcInitialize)
+{
+    EXPECT_TRUE(producer->writeEntry(0x2, payload(0, 0x20)));
+    bufferImpl->initialize(testBmcInterfaceVersion, testQueueSize,
+                           testUeRegionSize, testMagicNumber);
+
+    EXPECT_TRUE(producer->writeEntry(0x2, payload(1, 0x20)));
+    EXPECT_EQ(producer->getStats().reattaches, 1U);
+    std::vector<EntryPair> entries = drain();
+    ASSERT_EQ(entries.size(), 1U);
+    EXPECT_EQ(entries[0].first.sequenceId, 1);
+}
+
+TEST_F(BiosProducerTest, ConcurrentProducer)
+{
+    // BIOS logs from another thread as fast as it can, with random entry
+    // sizes. Every entry either arrives intact and in order or is accounted
+    // for as lost.
+    constexpr uint32_t numEntries = 20000;
+    std::atomic<bool> done = false;
+    std::thread bios([&]() {
+        std::mt19937 random(1);
+        std::uniform_int_distribution<size_t> entrySize(1, 0x60);
+        for (uint32_t i = 0; i < numEntries; ++i)
+        {
+            const size_t size = entrySize(random);
+            // Mostly wait for the BMC to make room, but now and then log
+            // regardless, the way BIOS does when it can't wait
+            while (i % 64 != 0 &&
+                   producer->getQueueFreeBytes() < size + entryHeaderSize)
+            {
+                std::this_thread::yield();
+            }
+            const uint16_t sequenceId = producer->getStats().entriesWritten +
+                                        producer->getStats().entriesDropped;
+            producer->writeEntry(0x2, payload(sequenceId, size));
+        }
+        // Make sure the last entry gets through, so no loss goes unnoticed
+        while (!producer->writeEntry(0x2, payload(0, 0)))
+        {
+            std::this_thread::yield();
+        }
+        done = true;
+    });
+
+    uint64_t numReceived = 0;
+    std::optional<uint16_t> prevSequenceId;
+    bool last = false;
+    while (!last)
+    {
+        last = done;
+        if (bufferImpl->poll().queueBytesPending == 0)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        bufferImpl->drain([&](const QueueEntryHeader& entryHeader,
+                              std::span<const uint8_t> entry) {
+            const uint16_t sequenceId =
+                boost::endian::little_to_native(entryHeader.sequenceId);
+            if (prevSequenceId)
+            {
+                ASSERT_GT(static_cast<uint16_t>(sequenceId - *prevSequenceId),
+                          0);
+            }
+            prevSequenceId = sequenceId;
+            if (!entry.empty())
+            {
+                EXPECT_EQ(entry[0], static_cast<uint8_t>(sequenceId));
+            }
+            ++numReceived;
+        });
+    }
+    bios.join();
+
+    BiosProducerStats stats = producer->getStats();
+    EXPECT_EQ(numReceived, stats.entriesWritten);
+    EXPECT_GE(stats.entriesWritten + stats.entriesDropped, numEntries + 1);
+    EXPECT_GT(stats.entriesWritten, numEntries / 2);
+    SequenceStats sequenceStats = bufferImpl->getSequenceStats();
+    EXPECT_EQ(sequenceStats.entriesLost, stats.entriesDropped);
+    EXPECT_EQ(bufferImpl->getRecoveryStats().resyncs, 0U);
+}
+
+} // namespace
+} // namespace bios_bmc_smm_error_logger
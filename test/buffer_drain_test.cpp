@@ -0,0 +1,154 @@
+#include "buffer.hpp"
+#include "fake_bios_test.hpp"
+
+#include <boost/endian/conversion.hpp>
+
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace
+{
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+class BufferDrainTest : public FakeBiosTest
+{
+  protected:
+    // Drain the queue, recording the sequence IDs seen by the visitor
+    // @return the number of entries drained
+    size_t drainInto(std::vector<uint16_t>& sequenceIds)
+    {
+        bufferImpl->poll();
+        return bufferImpl->drain(
+            [&sequenceIds](const QueueEntryHeader& entryHeader,
+                           std::span<const uint8_t>) {
+                sequenceIds.push_back(
+                    boost::endian::little_to_native(entryHeader.sequenceId));
+            });
+    }
+};
+
+TEST_F(BufferDrainTest, EmptyQueue)
+{
+    const size_t numWrites = fakeDataInterface->numWrites;
+    std::vector<uint16_t> sequenceIds;
+    EXPECT_EQ(drainInto(sequenceIds), 0U);
+    EXPECT_THAT(sequenceIds, IsEmpty());
+    EXPECT_EQ(fakeDataInterface->numWrites, numWrites);
+}
+
+TEST_F(BufferDrainTest, EntriesAreSpansIntoTheQueue)
+{
+    writeEntry(1, testEntrySize);
+    writeEntry(2, 0x10);
+    bufferImpl->poll();
+    const size_t numWrites = fakeDataInterface->numWrites;
+
+    std::vector<std::vector<uint8_t>> entries;
+    EXPECT_EQ(bufferImpl->drain([&entries](const QueueEntryHeader& entryHeader,
+                                           std::span<const uint8_t> entry) {
+        EXPECT_EQ(boost::endian::little_to_native(entryHeader.entrySize),
+                  entry.size());
+        entries.emplace_back(entry.begin(), entry.end());
+    }),
+              2U);
+
+    ASSERT_EQ(entries.size(), 2U);
+    EXPECT_EQ(entries[0].size(), testEntrySize);
+    EXPECT_EQ(entries[0][0], 1);
+    EXPECT_EQ(entries[1].size(), 0x10U);
+    EXPECT_EQ(entries[1][0x0f], 2 + 0x0f);
+    // Everything is released to BIOS in a single commit
+    EXPECT_EQ(bmcReadPtr(), biosWritePtr());
+    EXPECT_EQ(fakeDataInterface->numWrites, numWrites + 1);
+}
+
+TEST_F(BufferDrainTest, WraparoundEntry)
+{
+    // Fill up most of the queue so that the next entries wrap around
+    const size_t entryAndHeaderSize = entryHeaderSize + testEntrySize;
+    const uint16_t numEntries = testMaxOffset / entryAndHeaderSize;
+    std::vector<uint16_t> sequenceIds;
+    for (uint16_t i = 0; i < numEntries; ++i)
+    {
+        writeEntry(i, testEntrySize);
+    }
+    drainInto(sequenceIds);
+
+    sequenceIds.clear();
+    writeEntry(numEntries, testEntrySize);
+    writeEntry(numEntries + 1, testEntrySize);
+    EXPECT_EQ(drainInto(sequenceIds), 2U);
+    EXPECT_THAT(sequenceIds, ElementsAre(numEntries, numEntries + 1));
+    EXPECT_EQ(bmcReadPtr(), biosWritePtr());
+}
+
+TEST_F(BufferDrainTest, ThrowingVisitorKeepsEntry)
+{
+    writeEntry(1, testEntrySize);
+    const uint32_t secondEntryOffset = writeEntry(2, testEntrySize);
+    writeEntry(3, testEntrySize);
+    bufferImpl->poll();
+
+    EXPECT_THROW(bufferImpl->drain([](const QueueEntryHeader& entryHeader,
+                                      std::span<const uint8_t>) {
+        if (boost::endian::little_to_native(entryHeader.sequenceId) == 2)
+        {
+            throw std::runtime_error("storage failure");
+        }
+    }),
+                 std::runtime_error);
+    // Entry 1 was handled and is released, entry 2 was not
+    EXPECT_EQ(bmcReadPtr(), secondEntryOffset);
+
+    std::vector<uint16_t> sequenceIds;
+    EXPECT_EQ(drainInto(sequenceIds), 2U);
+    EXPECT_THAT(sequenceIds, ElementsAre(2, 3));
+    EXPECT_EQ(bmcReadPtr(), biosWritePtr());
+}
+
+TEST_F(BufferDrainTest, SkipsCorruptEntry)
+{
+    writeEntry(1, testEntrySize);
+    const uint32_t corruptEntryOffset = writeEntry(2, testEntrySize);
+    writeEntry(3, testEntrySize);
+    queueByte(corruptEntryOffset + entryHeaderSize) ^= 0xff;
+
+    std::vector<uint16_t> sequenceIds;
+    EXPECT_EQ(drainInto(sequenceIds), 2U);
+    EXPECT_THAT(sequenceIds, ElementsAre(1, 3));
+    EXPECT_EQ(bmcReadPtr(), biosWritePtr());
+    EXPECT_EQ(bufferImpl->getRecoveryStats().resyncs, 1U);
+    EXPECT_EQ(bufferImpl->getSequenceStats().entriesLostToResync, 1U);
+}
+
+TEST_F(BufferDrainTest, MatchesReadPendingErrorLogs)
+{
+    writeEntry(1, testEntrySize);
+    writeEntry(2, testEntrySize);
+    bufferImpl->poll();
+    std::vector<EntryPair> entryPairs = bufferImpl->readPendingErrorLogs();
+
+    // Nothing was consumed, so drain hands out the same entries again
+    std::vector<std::vector<uint8_t>> entries;
+    bufferImpl->drain(
+        [&entries](const QueueEntryHeader&, std::span<const uint8_t> entry) {
+            entries.emplace_back(entry.begin(), entry.end());
+        });
+    ASSERT_EQ(entries.size(), entryPairs.size());
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        EXPECT_EQ(entries[i], entryPairs[i].second);
+    }
+}
+
+} // namespace
+} // namespace bios_bmc_smm_error_logger
@@ -0,0 +1,216 @@
+#include "buffer.hpp"
+#include "fake_bios_test.hpp"
+
+#include <boost/endian/arithmetic.hpp>
+#include <boost/endian/conversion.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace
+{
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+/**
+ * Fault injection tests for the recovery from a corrupt error log queue. The
+ * tests corrupt some of the entries written by the fake BIOS and check what
+ * the BMC side is still able to drain.
+ */
+using BufferResyncTest = FakeBiosTest;
+
+TEST_F(BufferResyncTest, CleanQueueDoesNotResync)
+{
+    writeEntry(1, testEntrySize);
+    writeEntry(2, testEntrySize);
+    EXPECT_THAT(drain(), ElementsAre(1, 2));
+    EXPECT_EQ(bmcReadPtr(), biosWritePtr());
+    EXPECT_EQ(bufferImpl->getRecoveryStats().resyncs, 0U);
+}
+
+TEST_F(BufferResyncTest, CorruptPayloadSkipsOneEntry)
+{
+    writeEntry(1, testEntrySize);
+    uint32_t corruptOffset = writeEntry(2, testEntrySize);
+    writeEntry(3, testEntrySize);
+    writeEntry(4, testEntrySize);
+    queueByte(corruptOffset + entryHeaderSize + 5) ^= 0x40;
+
+    EXPECT_THAT(drain(), ElementsAre(1, 3, 4));
+    EXPECT_EQ(bmcReadPtr(), biosWritePtr());
+
+    RecoveryStats stats = bufferImpl->getRecoveryStats();
+    EXPECT_EQ(stats.resyncs, 1U);
+    EXPECT_EQ(stats.bytesSkipped, entryHeaderSize + testEntrySize);
+    EXPECT_EQ(stats.writePtrFallbacks, 0U);
+}
+
+TEST_F(BufferResyncTest, CorruptEntrySizeSkipsOneEntry)
+{
+    writeEntry(1, testEntrySize);
+    uint32_t corruptOffset = writeEntry(2, testEntrySize);
+    writeEntry(3, testEntrySize);
+    // An entry size pointing into the middle of the next entry
+    queueByte(corruptOffset + offsetof(struct QueueEntryHeader, entrySize)) =
+        testEntrySize + 3;
+
+    EXPECT_THAT(drain(), ElementsAre(1, 3));
+    EXPECT_EQ(bufferImpl->getRecoveryStats().bytesSkipped,
+              entryHeaderSize + testEntrySize);
+}
+
+TEST_F(BufferResyncTest, CorruptFirstEntryWithoutHistory)
+{
+    // No entry was ever read, so the sequence IDs can't be checked against
+    // the last valid entry
+    uint32_t corruptOffset = writeEntry(7, testEntrySize);
+    writeEntry(8, testEntrySize);
+    writeEntry(9, testEntrySize);
+    queueByte(corruptOffset) ^= 0x1;
+
+    EXPECT_THAT(drain(), ElementsAre(8, 9));
+    EXPECT_EQ(bmcReadPtr(), biosWritePtr());
+}
+
+TEST_F(BufferResyncTest, ConsecutiveCorruptEntries)
+{
+    writeEntry(1, testEntrySize);
+    uint32_t firstCorruptOffset = writeEntry(2, testEntrySize);
+    uint32_t secondCorruptOffset = writeEntry(3, 0x10);
+    writeEntry(4, testEntrySize);
+    writeEntry(5, testEntrySize);
+    queueByte(firstCorruptOffset + entryHeaderSize) ^= 0xff;
+    queueByte(secondCorruptOffset + entryHeaderSize) ^= 0xff;
+
+    EXPECT_THAT(drain(), ElementsAre(1, 4, 5));
+    EXPECT_EQ(bufferImpl->getRecoveryStats().bytesSkipped,
+              2 * entryHeaderSize + testEntrySize + 0x10);
+}
+
+TEST_F(BufferResyncTest, CorruptLastEntryFallsBackToWritePtr)
+{
+    writeEntry(1, testEntrySize);
+    writeEntry(2, testEntrySize);
+    uint32_t corruptOffset = writeEntry(3, testEntrySize);
+    queueByte(corruptOffset + entryHeaderSize + testEntrySize - 1) ^= 0x2;
+
+    EXPECT_THAT(drain(), ElementsAre(1, 2));
+    // The corrupt bytes after the last entry are released too
+    EXPECT_EQ(bmcReadPtr(), biosWritePtr());
+
+    RecoveryStats stats = bufferImpl->getRecoveryStats();
+    EXPECT_EQ(stats.resyncs, 1U);
+    EXPECT_EQ(stats.writePtrFallbacks, 1U);
+    EXPECT_EQ(stats.bytesSkipped, entryHeaderSize + testEntrySize);
+}
+
+TEST_F(BufferResyncTest, ValidLookingBytesInCorruptEntryAreSkipped)
+{
+    writeEntry(1, testEntrySize);
+    uint32_t corruptOffset = writeEntry(2, testEntrySize);
+    writeEntry(3, testEntrySize);
+
+    // Embed what looks like a valid entry with a far away sequence ID in the
+    // payload of the corrupt entry
+    struct QueueEntryHeader bogusHeader{};
+    bogusHeader.sequenceId = boost::endian::native_to_little<uint16_t>(100);
+    bogusHeader.entrySize = boost::endian::native_to_little<uint16_t>(2);
+    bogusHeader.checksum = 100 ^ 2;
+    const uint8_t* bogusHeaderPtr =
+        reinterpret_cast<const uint8_t*>(&bogusHeader);
+    for (size_t i = 0; i < entryHeaderSize + 2; ++i)
+    {
+        queueByte(corruptOffset + entryHeaderSize + 4 + i) =
+            i < entryHeaderSize ? bogusHeaderPtr[i] : 0;
+    }
+    // A valid entry XORs to 0, so the payload still needs corrupting
+    queueByte(corruptOffset + entryHeaderSize) ^= 0x1;
+
+    EXPECT_THAT(drain(), ElementsAre(1, 3));
+}
+
+TEST_F(BufferResyncTest, ResyncAcrossWraparound)
+{
+    // Move both pointers close to the end of the queue
+    const uint32_t startPtr = testMaxOffset - entryHeaderSize - 10;
+    setBiosWritePtr(startPtr);
+    bufferImpl->updateReadPtr(startPtr);
+
+    uint32_t corruptOffset = writeEntry(1, testEntrySize);
+    writeEntry(2, testEntrySize);
+    writeEntry(3, testEntrySize);
+    // The corrupt entry is split by the end of the queue
+    queueByte(corruptOffset + entryHeaderSize + testEntrySize - 1) ^= 0x80;
+
+    EXPECT_THAT(drain(), ElementsAre(2, 3));
+    EXPECT_EQ(bmcReadPtr(), biosWritePtr());
+}
+
+TEST_F(BufferResyncTest, DrainingContinuesAfterResync)
+{
+    writeEntry(1, testEntrySize);
+    uint32_t corruptOffset = writeEntry(2, testEntrySize);
+    queueByte(corruptOffset + entryHeaderSize) ^= 0x1;
+    EXPECT_THAT(drain(), ElementsAre(1));
+
+    writeEntry(3, testEntrySize);
+    writeEntry(4, testEntrySize);
+    EXPECT_THAT(drain(), ElementsAre(3, 4));
+    EXPECT_EQ(bufferImpl->getRecoveryStats().resyncs, 1U);
+}
+
+TEST_F(BufferResyncTest, UnconsumedEntryAfterResyncIsReadAgain)
+{
+    uint32_t corruptOffset = writeEntry(1, testEntrySize);
+    writeEntry(2, testEntrySize);
+    queueByte(corruptOffset + entryHeaderSize) ^= 0x1;
+
+    // Entry 2 is read but never consumed, so the read pointer stays on the
+    // corrupt entry
+    bufferImpl->poll();
+    EXPECT_EQ(bufferImpl->readPendingErrorLogs().size(), 1U);
+    bufferImpl->commitReadPtr();
+    EXPECT_EQ(bmcReadPtr(), corruptOffset);
+
+    EXPECT_THAT(drain(), ElementsAre(2));
+    EXPECT_EQ(bufferImpl->getRecoveryStats().resyncs, 2U);
+}
+
+TEST_F(BufferResyncTest, CorruptReadPtrFallsBackToWritePtr)
+{
+    writeEntry(1, testEntrySize);
+    header().bmcReadPtr =
+        boost::endian::native_to_little<uint32_t>(testMaxOffset + 1);
+
+    EXPECT_THAT(drain(), IsEmpty());
+    EXPECT_EQ(bmcReadPtr(), biosWritePtr());
+    EXPECT_EQ(bufferImpl->getRecoveryStats().writePtrFallbacks, 1U);
+
+    writeEntry(2, testEntrySize);
+    EXPECT_THAT(drain(), ElementsAre(2));
+}
+
+TEST_F(BufferResyncTest, ResyncDoesNotWipeTheBuffer)
+{
+    writeEntry(1, testEntrySize);
+    uint32_t corruptOffset = writeEntry(2, testEntrySize);
+    writeEntry(3, testEntrySize);
+    queueByte(corruptOffset + entryHeaderSize) ^= 0x1;
+    fakeDataInterface->numWrites = 0;
+    fakeDataInterface->bytesWritten = 0;
+
+    EXPECT_THAT(drain(), ElementsAre(1, 3));
+    // Only the read pointer was written
+    EXPECT_EQ(fakeDataInterface->numWrites, 1U);
+    EXPECT_EQ(fakeDataInterface->bytesWritten, sizeof(little_uint24_t));
+}
+
+} // namespace
+} // namespace bios_bmc_smm_error_logger
@@ -0,0 +1,172 @@
+#include "buffer.hpp"
+#include "fake_bios_test.hpp"
+
+#include <cstdint>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace
+{
+
+using ::testing::ElementsAre;
+
+using BufferSequenceTest = FakeBiosTest;
+
+TEST_F(BufferSequenceTest, InOrderAcrossTicks)
+{
+    writeEntry(1, testEntrySize);
+    writeEntry(2, testEntrySize);
+    EXPECT_THAT(drain(), ElementsAre(1, 2));
+    writeEntry(3, testEntrySize);
+    EXPECT_THAT(drain(), ElementsAre(3));
+
+    SequenceStats stats = bufferImpl->getSequenceStats();
+    EXPECT_EQ(stats.entries, 3U);
+    EXPECT_EQ(stats.gaps, 0U);
+    EXPECT_EQ(stats.entriesLost, 0U);
+}
+
+TEST_F(BufferSequenceTest, SequenceIdWraparound)
+{
+    writeEntry(0xfffe, testEntrySize);
+    writeEntry(0xffff, testEntrySize);
+    writeEntry(0, testEntrySize);
+    writeEntry(1, testEntrySize);
+    EXPECT_THAT(drain(), ElementsAre(0xfffe, 0xffff, 0, 1));
+
+    SequenceStats stats = bufferImpl->getSequenceStats();
+    EXPECT_EQ(stats.gaps, 0U);
+    EXPECT_EQ(stats.restarts, 0U);
+}
+
+TEST_F(BufferSequenceTest, GapAcrossTicks)
+{
+    writeEntry(1, testEntrySize);
+    EXPECT_THAT(drain(), ElementsAre(1));
+    writeEntry(4, testEntrySize);
+    EXPECT_THAT(drain(), ElementsAre(4));
+
+    SequenceStats stats = bufferImpl->getSequenceStats();
+    EXPECT_EQ(stats.gaps, 1U);
+    EXPECT_EQ(stats.entriesLost, 2U);
+    EXPECT_EQ(stats.entriesLostToOverflow, 0U);
+    EXPECT_EQ(stats.entriesLostToResync, 0U);
+}
+
+TEST_F(BufferSequenceTest, GapAcrossSequenceIdWraparound)
+{
+    writeEntry(0xfffe, testEntrySize);
+    writeEntry(1, testEntrySize);
+    EXPECT_THAT(drain(), ElementsAre(0xfffe, 1));
+
+    SequenceStats stats = bufferImpl->getSequenceStats();
+    EXPECT_EQ(stats.gaps, 1U);
+    EXPECT_EQ(stats.entriesLost, 2U);
+}
+
+TEST_F(BufferSequenceTest, Duplicate)
+{
+    writeEntry(1, testEntrySize);
+    writeEntry(2, testEntrySize);
+    writeEntry(2, testEntrySize);
+    writeEntry(3, testEntrySize);
+    EXPECT_THAT(drain(), ElementsAre(1, 2, 2, 3));
+
+    SequenceStats stats = bufferImpl->getSequenceStats();
+    EXPECT_EQ(stats.duplicates, 1U);
+    EXPECT_EQ(stats.gaps, 0U);
+}
+
+TEST_F(BufferSequenceTest, Reordered)
+{
+    writeEntry(1, testEntrySize);
+    writeEntry(3, testEntrySize);
+    writeEntry(2, testEntrySize);
+    writeEntry(4, testEntrySize);
+    EXPECT_THAT(drain(), ElementsAre(1, 3, 2, 4));
+
+    // Entry 2 looks lost until it shows up, entry 4 is in order again
+    SequenceStats stats = bufferImpl->getSequenceStats();
+    EXPECT_EQ(stats.gaps, 1U);
+    EXPECT_EQ(stats.entriesLost, 1U);
+    EXPECT_EQ(stats.reordered, 1U);
+}
+
+TEST_F(BufferSequenceTest, Restart)
+{
+    writeEntry(500, testEntrySize);
+    writeEntry(0, testEntrySize);
+    writeEntry(1, testEntrySize);
+    EXPECT_THAT(drain(), ElementsAre(500, 0, 1));
+
+    SequenceStats stats = bufferImpl->getSequenceStats();
+    EXPECT_EQ(stats.restarts, 1U);
+    EXPECT_EQ(stats.gaps, 0U);
+    EXPECT_EQ(stats.reordered, 0U);
+}
+
+TEST_F(BufferSequenceTest, GapAfterOverflow)
+{
+    writeEntry(1, testEntrySize);
+    writeEntry(2, testEntrySize);
+    signalOverflow();
+    // The gap shows up after the entries that made it into the queue
+    EXPECT_THAT(drain(), ElementsAre(1, 2));
+    writeEntry(6, testEntrySize);
+    writeEntry(9, testEntrySize);
+    EXPECT_THAT(drain(), ElementsAre(6, 9));
+
+    SequenceStats stats = bufferImpl->getSequenceStats();
+    EXPECT_EQ(stats.overflows, 1U);
+    EXPECT_EQ(stats.gaps, 2U);
+    EXPECT_EQ(stats.entriesLost, 5U);
+    // Only the first gap is blamed on the overflow
+    EXPECT_EQ(stats.entriesLostToOverflow, 3U);
+}
+
+TEST_F(BufferSequenceTest, GapAfterResync)
+{
+    writeEntry(1, testEntrySize);
+    uint32_t corruptOffset = writeEntry(2, testEntrySize);
+    writeEntry(3, testEntrySize);
+    queueByte(corruptOffset + entryHeaderSize) ^= 0x1;
+    EXPECT_THAT(drain(), ElementsAre(1, 3));
+
+    SequenceStats stats = bufferImpl->getSequenceStats();
+    EXPECT_EQ(stats.entriesLost, 1U);
+    EXPECT_EQ(stats.entriesLostToResync, 1U);
+}
+
+TEST_F(BufferSequenceTest, GapAfterTrailingResync)
+{
+    writeEntry(1, testEntrySize);
+    uint32_t corruptOffset = writeEntry(2, testEntrySize);
+    queueByte(corruptOffset + entryHeaderSize) ^= 0x1;
+    EXPECT_THAT(drain(), ElementsAre(1));
+    writeEntry(3, testEntrySize);
+    EXPECT_THAT(drain(), ElementsAre(3));
+
+    EXPECT_EQ(bufferImpl->getSequenceStats().entriesLostToResync, 1U);
+}
+
+TEST_F(BufferSequenceTest, UnconsumedEntriesAreNotCounted)
+{
+    writeEntry(1, testEntrySize);
+    writeEntry(2, testEntrySize);
+    bufferImpl->poll();
+    EXPECT_EQ(bufferImpl->readPendingErrorLogs().size(), 2U);
+    bufferImpl->markEntryConsumed();
+    bufferImpl->commitReadPtr();
+
+    // Entry 2 is read again, without being counted as a duplicate
+    EXPECT_THAT(drain(), ElementsAre(2));
+    SequenceStats stats = bufferImpl->getSequenceStats();
+    EXPECT_EQ(stats.entries, 2U);
+    EXPECT_EQ(stats.duplicates, 0U);
+}
+
+} // namespace
+} // namespace bios_bmc_smm_error_logger
@@ -8,6 +8,7 @@
 #include <array>
 #include <cstdint>
 #include <memory>
+#include <stdexcept>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -21,6 +22,7 @@ using ::testing::_;
 using ::testing::ElementsAreArray;
 using ::testing::InSequence;
 using ::testing::Return;
+using ::testing::SizeIs;
 
 class BufferTest : public ::testing::Test
 {
@@ -140,8 +142,8 @@ TEST_F(BufferTest, BufferInitializePass)
 TEST_F(BufferTest, BufferHeaderReadFail)
 {
     std::vector<std::uint8_t> testBytesRead{};
-    EXPECT_CALL(*dataInterfaceMockPtr, read(0, bufferHeaderSize))
-        .WillOnce(Return(testBytesRead));
+    EXPECT_CALL(*dataInterfaceMockPtr, readInto(0, SizeIs(bufferHeaderSize)))
+        .WillOnce(ReadIntoBytes(testBytesRead));
     EXPECT_THROW(
         try {
             bufferImpl->readBufferHeader();
@@ -161,8 +163,8 @@ TEST_F(BufferTest, BufferHeaderReadPass)
         testInitializationHeaderPtr,
         testInitializationHeaderPtr + bufferHeaderSize);
 
-    EXPECT_CALL(*dataInterfaceMockPtr, read(0, bufferHeaderSize))
-        .WillOnce(Return(testInitializationHeaderVector));
+    EXPECT_CALL(*dataInterfaceMockPtr, readInto(0, SizeIs(bufferHeaderSize)))
+        .WillOnce(ReadIntoBytes(testInitializationHeaderVector));
     EXPECT_NO_THROW(bufferImpl->readBufferHeader());
     EXPECT_EQ(bufferImpl->getCachedBufferHeader(), testInitializationHeader);
 }
@@ -331,8 +333,8 @@ TEST_F(BufferTest, ReadUeLog_NoUeRegionConfigured)
 
     uint8_t* headerPtr = reinterpret_cast<uint8_t*>(&header);
     std::vector<uint8_t> headerBytes(headerPtr, headerPtr + bufferHeaderSize);
-    EXPECT_CALL(*dataInterfaceMockPtr, read(0, bufferHeaderSize))
-        .WillOnce(Return(headerBytes));
+    EXPECT_CALL(*dataInterfaceMockPtr, readInto(0, SizeIs(bufferHeaderSize)))
+        .WillOnce(ReadIntoBytes(headerBytes));
 
     auto result = bufferImpl->readUeLogFromReservedRegion();
     EXPECT_TRUE(result.empty());
@@ -350,8 +352,8 @@ TEST_F(BufferTest, ReadUeLog_NotPresentDueToFlags)
 
     uint8_t* headerPtr = reinterpret_cast<uint8_t*>(&header);
     std::vector<uint8_t> headerBytes(headerPtr, headerPtr + bufferHeaderSize);
-    EXPECT_CALL(*dataInterfaceMockPtr, read(0, bufferHeaderSize))
-        .WillOnce(Return(headerBytes));
+    EXPECT_CALL(*dataInterfaceMockPtr, readInto(0, SizeIs(bufferHeaderSize)))
+        .WillOnce(ReadIntoBytes(headerBytes));
 
     auto result = bufferImpl->readUeLogFromReservedRegion();
     EXPECT_TRUE(result.empty());
@@ -369,13 +371,13 @@ TEST_F(BufferTest, ReadUeLog_PresentAndSuccessfullyRead)
 
     uint8_t* headerPtr = reinterpret_cast<uint8_t*>(&header);
     std::vector<uint8_t> headerBytes(headerPtr, headerPtr + bufferHeaderSize);
-    EXPECT_CALL(*dataInterfaceMockPtr, read(0, bufferHeaderSize))
-        .WillOnce(Return(headerBytes));
+    EXPECT_CALL(*dataInterfaceMockPtr, readInto(0, SizeIs(bufferHeaderSize)))
+        .WillOnce(ReadIntoBytes(headerBytes));
 
     size_t ueRegionOffset = bufferHeaderSize;
     std::vector<uint8_t> ueData(ueSize, 0xAA);
-    EXPECT_CALL(*dataInterfaceMockPtr, read(ueRegionOffset, ueSize))
-        .WillOnce(Return(ueData));
+    EXPECT_CALL(*dataInterfaceMockPtr, readInto(ueRegionOffset, SizeIs(ueSize)))
+        .WillOnce(ReadIntoBytes(ueData));
 
     auto result = bufferImpl->readUeLogFromReservedRegion();
     ASSERT_FALSE(result.empty());
@@ -399,13 +401,13 @@ TEST_F(BufferTest, ReadUeLog_PresentButReadFails)
 
     uint8_t* headerPtr = reinterpret_cast<uint8_t*>(&header);
     std::vector<uint8_t> headerBytes(headerPtr, headerPtr + bufferHeaderSize);
-    EXPECT_CALL(*dataInterfaceMockPtr, read(0, bufferHeaderSize))
-        .WillOnce(Return(headerBytes));
+    EXPECT_CALL(*dataInterfaceMockPtr, readInto(0, SizeIs(bufferHeaderSize)))
+        .WillOnce(ReadIntoBytes(headerBytes));
 
     size_t ueRegionOffset = bufferHeaderSize;
     std::vector<uint8_t> shortUeData(ueSize - 1, 0xAA); // Short read
-    EXPECT_CALL(*dataInterfaceMockPtr, read(ueRegionOffset, ueSize))
-        .WillOnce(Return(shortUeData));
+    EXPECT_CALL(*dataInterfaceMockPtr, readInto(ueRegionOffset, SizeIs(ueSize)))
+        .WillOnce(ReadIntoBytes(shortUeData));
 
     // Expect an exception due to short read, which is treated as corruption for
     // UE log
@@ -431,8 +433,8 @@ TEST_F(BufferTest, CheckOverflow_NotPresentDueToFlags)
 
     uint8_t* headerPtr = reinterpret_cast<uint8_t*>(&header);
     std::vector<uint8_t> headerBytes(headerPtr, headerPtr + bufferHeaderSize);
-    EXPECT_CALL(*dataInterfaceMockPtr, read(0, bufferHeaderSize))
-        .WillOnce(Return(headerBytes));
+    EXPECT_CALL(*dataInterfaceMockPtr, readInto(0, SizeIs(bufferHeaderSize)))
+        .WillOnce(ReadIntoBytes(headerBytes));
 
     bool overflowDetected = bufferImpl->checkForOverflowAndAcknowledge();
     ASSERT_FALSE(overflowDetected);
@@ -448,8 +450,8 @@ TEST_F(BufferTest, CheckOverflow_PresentAndAcknowledged)
 
     uint8_t* headerPtr = reinterpret_cast<uint8_t*>(&header);
     std::vector<uint8_t> headerBytes(headerPtr, headerPtr + bufferHeaderSize);
-    EXPECT_CALL(*dataInterfaceMockPtr, read(0, bufferHeaderSize))
-        .WillOnce(Return(headerBytes));
+    EXPECT_CALL(*dataInterfaceMockPtr, readInto(0, SizeIs(bufferHeaderSize)))
+        .WillOnce(ReadIntoBytes(headerBytes));
 
     uint32_t expectedNewBmcFlags =
         static_cast<uint32_t>(BufferFlags::overflow); // BMC toggles its bit
@@ -474,6 +476,76 @@ TEST_F(BufferTest, CheckOverflow_PresentAndAcknowledged)
               expectedNewBmcFlags);
 }
 
+TEST_F(BufferTest, PollIdleReadsHeaderOnce)
+{
+    uint8_t* headerPtr = reinterpret_cast<uint8_t*>(&testInitializationHeader);
+    std::vector<uint8_t> headerBytes(headerPtr, headerPtr + bufferHeaderSize);
+    // Newer expectations take precedence, so anything but the single header
+    // read hits the Times(0) expectations below
+    EXPECT_CALL(*dataInterfaceMockPtr, readInto(_, _)).Times(0);
+    EXPECT_CALL(*dataInterfaceMockPtr, write(_, _)).Times(0);
+    EXPECT_CALL(*dataInterfaceMockPtr, readInto(0, SizeIs(bufferHeaderSize)))
+        .WillOnce(ReadIntoBytes(headerBytes));
+
+    PollResult result = bufferImpl->poll();
+    EXPECT_TRUE(result.idle());
+    EXPECT_FALSE(result.ueLogPending);
+    EXPECT_FALSE(result.overflowAcknowledged);
+    EXPECT_EQ(result.queueBytesPending, 0U);
+}
+
+TEST_F(BufferTest, PollAllWorkPending)
+{
+    InSequence s;
+    struct CircularBufferHeader header = testInitializationHeader;
+    header.biosFlags = boost::endian::native_to_little<uint32_t>(
+        static_cast<uint32_t>(BufferFlags::ueSwitch) |
+        static_cast<uint32_t>(BufferFlags::overflow));
+    header.bmcFlags = boost::endian::native_to_little<uint32_t>(0);
+    header.bmcReadPtr = boost::endian::native_to_little<uint32_t>(0x10);
+    header.biosWritePtr = boost::endian::native_to_little<uint32_t>(0x30);
+
+    uint8_t* headerPtr = reinterpret_cast<uint8_t*>(&header);
+    std::vector<uint8_t> headerBytes(headerPtr, headerPtr + bufferHeaderSize);
+    EXPECT_CALL(*dataInterfaceMockPtr, readInto(0, SizeIs(bufferHeaderSize)))
+        .WillOnce(ReadIntoBytes(headerBytes));
+
+    // Only the overflow is acknowledged by poll, the UE log is left for the
+    // caller to process
+    const std::vector<uint8_t> expectedFlagWrite{
+        static_cast<uint8_t>(BufferFlags::overflow), 0x0, 0x0, 0x0};
+    constexpr uint8_t bmcFlagsOffset =
+        offsetof(struct CircularBufferHeader, bmcFlags);
+    EXPECT_CALL(*dataInterfaceMockPtr,
+                write(bmcFlagsOffset, ElementsAreArray(expectedFlagWrite)))
+        .WillOnce(Return(sizeof(little_uint32_t)));
+
+    PollResult result = bufferImpl->poll();
+    EXPECT_FALSE(result.idle());
+    EXPECT_TRUE(result.ueLogPending);
+    EXPECT_TRUE(result.overflowAcknowledged);
+    EXPECT_EQ(result.queueBytesPending, 0x20U);
+
+    // The UE log is read from the cached header, without another header read
+    std::vector<uint8_t> ueData(testUeRegionSize, 0xAA);
+    EXPECT_CALL(*dataInterfaceMockPtr,
+                readInto(bufferHeaderSize, SizeIs(testUeRegionSize)))
+        .WillOnce(ReadIntoBytes(ueData));
+    EXPECT_THAT(bufferImpl->readPendingUeLog(), ElementsAreArray(ueData));
+}
+
+TEST_F(BufferTest, PollPtrsTooBigFail)
+{
+    struct CircularBufferHeader header = testInitializationHeader;
+    header.biosWritePtr = boost::endian::native_to_little<uint32_t>(0x1000);
+
+    uint8_t* headerPtr = reinterpret_cast<uint8_t*>(&header);
+    std::vector<uint8_t> headerBytes(headerPtr, headerPtr + bufferHeaderSize);
+    EXPECT_CALL(*dataInterfaceMockPtr, readInto(0, SizeIs(bufferHeaderSize)))
+        .WillOnce(ReadIntoBytes(headerBytes));
+    EXPECT_THROW(bufferImpl->poll(), std::runtime_error);
+}
+
 class BufferWraparoundReadTest : public BufferTest
 {
   protected:
@@ -555,8 +627,8 @@ TEST_F(BufferWraparoundReadTest, NoWrapAroundReadFails)
     // Fail the first read
     std::vector<std::uint8_t> shortTestBytesRead(testLength - 1);
     EXPECT_CALL(*dataInterfaceMockPtr,
-                read(testOffset + expectedqueueOffset, testLength))
-        .WillOnce(Return(shortTestBytesRead));
+                readInto(testOffset + expectedqueueOffset, SizeIs(testLength)))
+        .WillOnce(ReadIntoBytes(shortTestBytesRead));
 
     EXPECT_THROW(
         try {
@@ -579,8 +651,8 @@ TEST_F(BufferWraparoundReadTest, NoWrapAroundReadPass)
     // Successfully read all the requested length without a wrap around
     std::vector<std::uint8_t> testBytesRead(testLength);
     EXPECT_CALL(*dataInterfaceMockPtr,
-                read(testOffset + expectedqueueOffset, testLength))
-        .WillOnce(Return(testBytesRead));
+                readInto(testOffset + expectedqueueOffset, SizeIs(testLength)))
+        .WillOnce(ReadIntoBytes(testBytesRead));
 
     // Call to updateReadPtr is triggered
     const std::vector<uint8_t> expectedReadPtr{
@@ -607,14 +679,16 @@ TEST_F(BufferWraparoundReadTest, WrapAroundReadFails)
 
     // Read until the end of the queue
     std::vector<std::uint8_t> testBytesReadShort(testLength - testBytesLeft);
-    EXPECT_CALL(*dataInterfaceMockPtr, read(testOffset + expectedqueueOffset,
-                                            testLength - testBytesLeft))
-        .WillOnce(Return(testBytesReadShort));
+    EXPECT_CALL(*dataInterfaceMockPtr,
+                readInto(testOffset + expectedqueueOffset,
+                         SizeIs(testLength - testBytesLeft)))
+        .WillOnce(ReadIntoBytes(testBytesReadShort));
 
     // Read 1 byte short after wraparound
     std::vector<std::uint8_t> testBytesLeftReadShort(testBytesLeft - 1);
-    EXPECT_CALL(*dataInterfaceMockPtr, read(expectedqueueOffset, testBytesLeft))
-        .WillOnce(Return(testBytesLeftReadShort));
+    EXPECT_CALL(*dataInterfaceMockPtr,
+                readInto(expectedqueueOffset, SizeIs(testBytesLeft)))
+        .WillOnce(ReadIntoBytes(testBytesLeftReadShort));
 
     EXPECT_THROW(
         try {
@@ -639,13 +713,15 @@ TEST_F(BufferWraparoundReadTest, WrapAroundReadPasses)
     // Read to the end of the queue
     std::vector<std::uint8_t> testBytesReadFirst{16, 15, 14, 13, 12, 11, 10,
                                                  9,  8,  7,  6,  5,  4};
-    EXPECT_CALL(*dataInterfaceMockPtr, read(testOffset + expectedqueueOffset,
-                                            testLength - testBytesLeft))
-        .WillOnce(Return(testBytesReadFirst));
+    EXPECT_CALL(*dataInterfaceMockPtr,
+                readInto(testOffset + expectedqueueOffset,
+                         SizeIs(testLength - testBytesLeft)))
+        .WillOnce(ReadIntoBytes(testBytesReadFirst));
 
     std::vector<std::uint8_t> testBytesReadSecond{3, 2, 1};
-    EXPECT_CALL(*dataInterfaceMockPtr, read(expectedqueueOffset, testBytesLeft))
-        .WillOnce(Return(testBytesReadSecond));
+    EXPECT_CALL(*dataInterfaceMockPtr,
+                readInto(expectedqueueOffset, SizeIs(testBytesLeft)))
+        .WillOnce(ReadIntoBytes(testBytesReadSecond));
 
     // Call to updateReadPtr is triggered
     const std::vector<uint8_t> expectedReadPtr{
@@ -675,8 +751,8 @@ TEST_F(BufferWraparoundReadTest, WrapAroundCornerCasePass)
     // Read to the very end of the queue
     std::vector<std::uint8_t> testBytes{4, 3, 2, 1};
     EXPECT_CALL(*dataInterfaceMockPtr,
-                read(testOffset + expectedqueueOffset, testLength))
-        .WillOnce(Return(testBytes));
+                readInto(testOffset + expectedqueueOffset, SizeIs(testLength)))
+        .WillOnce(ReadIntoBytes(testBytes));
 
     // Call to updateReadPtr is triggered, since we read to the very end of the
     // buffer, update the readPtr up around to 0
@@ -715,19 +791,19 @@ class BufferEntryTest : public BufferWraparoundReadTest
         // This will wrap, split the read mocks in 2
         if (expetedBytesOutput.size() > queueSizeToQueueEnd)
         {
-            EXPECT_CALL(*dataInterfaceMockPtr, read(_, _))
-                .WillOnce(Return(std::vector<std::uint8_t>(
+            EXPECT_CALL(*dataInterfaceMockPtr, readInto(_, _))
+                .WillOnce(ReadIntoBytes(std::vector<std::uint8_t>(
                     expetedBytesOutput.begin(),
                     expetedBytesOutput.begin() + queueSizeToQueueEnd)));
-            EXPECT_CALL(*dataInterfaceMockPtr, read(_, _))
-                .WillOnce(Return(std::vector<std::uint8_t>(
+            EXPECT_CALL(*dataInterfaceMockPtr, readInto(_, _))
+                .WillOnce(ReadIntoBytes(std::vector<std::uint8_t>(
                     expetedBytesOutput.begin() + queueSizeToQueueEnd,
                     expetedBytesOutput.end())));
         }
         else
         {
-            EXPECT_CALL(*dataInterfaceMockPtr, read(_, _))
-                .WillOnce(Return(std::vector<std::uint8_t>(
+            EXPECT_CALL(*dataInterfaceMockPtr, readInto(_, _))
+                .WillOnce(ReadIntoBytes(std::vector<std::uint8_t>(
                     expetedBytesOutput.begin(), expetedBytesOutput.end())));
         }
 
@@ -835,6 +911,15 @@ class BufferReadErrorLogsTest : public BufferEntryTest
   protected:
     BufferReadErrorLogsTest() = default;
 
+    // Bytes of a single queue entry, the entry header followed by the entry
+    std::vector<uint8_t> entryBytes()
+    {
+        std::vector<uint8_t> bytes(testEntryHeaderPtr,
+                                   testEntryHeaderPtr + entryHeaderSize);
+        bytes.resize(entryAndHeaderSize);
+        return bytes;
+    }
+
     uint8_t* testEntryHeaderPtr = reinterpret_cast<uint8_t*>(&testEntryHeader);
     size_t entryAndHeaderSize = entryHeaderSize + testEntrySize;
 };
@@ -847,8 +932,8 @@ TEST_F(BufferReadErrorLogsTest, PtrsTooBigFail)
         boost::endian::native_to_little((testMaxOffset + 1));
     initializeFuncMock();
 
-    EXPECT_CALL(*dataInterfaceMockPtr, read(0, bufferHeaderSize))
-        .WillOnce(Return(std::vector<uint8_t>(
+    EXPECT_CALL(*dataInterfaceMockPtr, readInto(0, SizeIs(bufferHeaderSize)))
+        .WillOnce(ReadIntoBytes(std::vector<uint8_t>(
             testInitializationHeaderPtr,
             testInitializationHeaderPtr + bufferHeaderSize)));
     EXPECT_THROW(
@@ -861,33 +946,39 @@ TEST_F(BufferReadErrorLogsTest, PtrsTooBigFail)
             throw;
         },
         std::runtime_error);
+}
 
-    // Reset the biosWritePtr and set the bmcReadPtr too big
-    testInitializationHeader.biosWritePtr = 0;
-    initializeFuncMock();
+TEST_F(BufferReadErrorLogsTest, ReadPtrTooBigSkipsToWritePtr)
+{
+    InSequence s;
+    testInitializationHeader.biosWritePtr =
+        boost::endian::native_to_little(entryAndHeaderSize);
     testInitializationHeader.bmcReadPtr =
         boost::endian::native_to_little((testMaxOffset + 1));
     initializeFuncMock();
 
-    EXPECT_CALL(*dataInterfaceMockPtr, read(0, bufferHeaderSize))
-        .WillOnce(Return(std::vector<uint8_t>(
+    EXPECT_CALL(*dataInterfaceMockPtr, readInto(0, SizeIs(bufferHeaderSize)))
+        .WillOnce(ReadIntoBytes(std::vector<uint8_t>(
             testInitializationHeaderPtr,
             testInitializationHeaderPtr + bufferHeaderSize)));
-    EXPECT_THROW(
-        try {
-            bufferImpl->readErrorLogs();
-        } catch (const std::runtime_error& e) {
-            EXPECT_STREQ(e.what(), "[readErrorLogs] currentReadPtr was '385' "
-                                   "which was bigger than maxOffset '384'");
-            throw;
-        },
-        std::runtime_error);
+    // Nothing is read from the queue, the read pointer is realigned with the
+    // write pointer instead
+    const std::vector<uint8_t> expectedReadPtr{
+        static_cast<uint8_t>(entryAndHeaderSize), 0x0, 0x0};
+    EXPECT_CALL(*dataInterfaceMockPtr, write(expectedBmcReadPtrOffset,
+                                             ElementsAreArray(expectedReadPtr)))
+        .WillOnce(Return(expectedWriteSize));
+
+    std::vector<EntryPair> entryPairs;
+    EXPECT_NO_THROW(entryPairs = bufferImpl->readErrorLogs());
+    EXPECT_TRUE(entryPairs.empty());
+    EXPECT_EQ(bufferImpl->getRecoveryStats().writePtrFallbacks, 1U);
 }
 
 TEST_F(BufferReadErrorLogsTest, IdenticalPtrsPass)
 {
-    EXPECT_CALL(*dataInterfaceMockPtr, read(0, bufferHeaderSize))
-        .WillOnce(Return(std::vector<uint8_t>(
+    EXPECT_CALL(*dataInterfaceMockPtr, readInto(0, SizeIs(bufferHeaderSize)))
+        .WillOnce(ReadIntoBytes(std::vector<uint8_t>(
             testInitializationHeaderPtr,
             testInitializationHeaderPtr + bufferHeaderSize)));
     EXPECT_NO_THROW(bufferImpl->readErrorLogs());
@@ -900,15 +991,20 @@ TEST_F(BufferReadErrorLogsTest, NoWraparoundPass)
     testInitializationHeader.biosWritePtr =
         boost::endian::native_to_little((entryAndHeaderSize));
     initializeFuncMock();
-    EXPECT_CALL(*dataInterfaceMockPtr, read(0, bufferHeaderSize))
-        .WillOnce(Return(std::vector<uint8_t>(
+    EXPECT_CALL(*dataInterfaceMockPtr, readInto(0, SizeIs(bufferHeaderSize)))
+        .WillOnce(ReadIntoBytes(std::vector<uint8_t>(
             testInitializationHeaderPtr,
             testInitializationHeaderPtr + bufferHeaderSize)));
-    std::vector<uint8_t> testEntryHeaderVector(
-        testEntryHeaderPtr, testEntryHeaderPtr + entryHeaderSize);
-    std::vector<uint8_t> testEntryVector(testEntrySize);
-    wraparoundReadMock(/*relativeOffset=*/0, testEntryHeaderVector);
-    wraparoundReadMock(/*relativeOffset=*/0 + entryHeaderSize, testEntryVector);
+    // The whole pending range is read at once
+    EXPECT_CALL(*dataInterfaceMockPtr,
+                readInto(expectedqueueOffset, SizeIs(entryAndHeaderSize)))
+        .WillOnce(ReadIntoBytes(entryBytes()));
+    // And the read pointer is updated once
+    const std::vector<uint8_t> expectedReadPtr{
+        static_cast<uint8_t>(entryAndHeaderSize), 0x0, 0x0};
+    EXPECT_CALL(*dataInterfaceMockPtr, write(expectedBmcReadPtrOffset,
+                                             ElementsAreArray(expectedReadPtr)))
+        .WillOnce(Return(expectedWriteSize));
 
     std::vector<EntryPair> entryPairs;
     EXPECT_NO_THROW(entryPairs = bufferImpl->readErrorLogs());
@@ -916,7 +1012,51 @@ TEST_F(BufferReadErrorLogsTest, NoWraparoundPass)
     // Check that we only read one entryPair and that the content is correct
     EXPECT_EQ(entryPairs.size(), 1U);
     EXPECT_EQ(entryPairs[0].first, testEntryHeader);
-    EXPECT_THAT(entryPairs[0].second, ElementsAreArray(testEntryVector));
+    EXPECT_THAT(entryPairs[0].second,
+                ElementsAreArray(std::vector<uint8_t>(testEntrySize)));
+    EXPECT_EQ(boost::endian::little_to_native(
+                  bufferImpl->getCachedBufferHeader().bmcReadPtr),
+              entryAndHeaderSize);
+}
+
+TEST_F(BufferReadErrorLogsTest, PollThenReadPendingPass)
+{
+    InSequence s;
+    testInitializationHeader.biosWritePtr =
+        boost::endian::native_to_little((entryAndHeaderSize));
+    initializeFuncMock();
+    // The buffer header is only read once, by poll
+    EXPECT_CALL(*dataInterfaceMockPtr, readInto(0, SizeIs(bufferHeaderSize)))
+        .WillOnce(ReadIntoBytes(std::vector<uint8_t>(
+            testInitializationHeaderPtr,
+            testInitializationHeaderPtr + bufferHeaderSize)));
+
+    PollResult result;
+    EXPECT_NO_THROW(result = bufferImpl->poll());
+    EXPECT_EQ(result.queueBytesPending, entryAndHeaderSize);
+
+    EXPECT_CALL(*dataInterfaceMockPtr,
+                readInto(expectedqueueOffset, SizeIs(entryAndHeaderSize)))
+        .WillOnce(ReadIntoBytes(entryBytes()));
+
+    std::vector<EntryPair> entryPairs;
+    EXPECT_NO_THROW(entryPairs = bufferImpl->readPendingErrorLogs());
+    EXPECT_EQ(entryPairs.size(), 1U);
+    EXPECT_EQ(entryPairs[0].first, testEntryHeader);
+
+    // The read pointer is only written once the entry was consumed and the
+    // batch is committed
+    EXPECT_NO_THROW(bufferImpl->markEntryConsumed());
+    const std::vector<uint8_t> expectedReadPtr{
+        static_cast<uint8_t>(entryAndHeaderSize), 0x0, 0x0};
+    EXPECT_CALL(*dataInterfaceMockPtr, write(expectedBmcReadPtrOffset,
+                                             ElementsAreArray(expectedReadPtr)))
+        .WillOnce(Return(expectedWriteSize));
+    EXPECT_NO_THROW(bufferImpl->commitReadPtr());
+
+    // Nothing left to consume or commit
+    EXPECT_THROW(bufferImpl->markEntryConsumed(), std::runtime_error);
+    EXPECT_NO_THROW(bufferImpl->commitReadPtr());
 }
 
 TEST_F(BufferReadErrorLogsTest, WraparoundMultiplEntryPass)
@@ -929,29 +1069,30 @@ TEST_F(BufferReadErrorLogsTest, WraparoundMultiplEntryPass)
     // Set the biosWritePtr to 1 entryHeader + entry size from the "beginning"
     testInitializationHeader.biosWritePtr = entryAndHeaderSize;
     initializeFuncMock();
-    EXPECT_CALL(*dataInterfaceMockPtr, read(0, bufferHeaderSize))
-        .WillOnce(Return(std::vector<uint8_t>(
+    EXPECT_CALL(*dataInterfaceMockPtr, readInto(0, SizeIs(bufferHeaderSize)))
+        .WillOnce(ReadIntoBytes(std::vector<uint8_t>(
             testInitializationHeaderPtr,
             testInitializationHeaderPtr + bufferHeaderSize)));
 
-    std::vector<uint8_t> testEntryHeaderVector(
-        testEntryHeaderPtr, testEntryHeaderPtr + entryHeaderSize);
-    std::vector<uint8_t> testEntryVector(testEntrySize);
-    wraparoundReadMock(/*relativeOffset=*/entryAndHeaderSizeAwayFromEnd,
-                       testEntryHeaderVector);
-    wraparoundReadMock(/*relativeOffset=*/entryAndHeaderSizeAwayFromEnd +
-                           entryHeaderSize,
-                       testEntryVector);
-    wraparoundReadMock(/*relativeOffset=*/0 + entryAndHeaderSize,
-                       testEntryHeaderVector);
-    wraparoundReadMock(/*relativeOffset=*/0 + entryAndHeaderSize +
-                           entryHeaderSize,
-                       testEntryVector);
+    // One read up to the end of the queue and one from the start of the queue
+    EXPECT_CALL(*dataInterfaceMockPtr,
+                readInto(expectedqueueOffset + entryAndHeaderSizeAwayFromEnd,
+                         SizeIs(entryAndHeaderSize)))
+        .WillOnce(ReadIntoBytes(entryBytes()));
+    EXPECT_CALL(*dataInterfaceMockPtr,
+                readInto(expectedqueueOffset, SizeIs(entryAndHeaderSize)))
+        .WillOnce(ReadIntoBytes(entryBytes()));
+    const std::vector<uint8_t> expectedReadPtr{
+        static_cast<uint8_t>(entryAndHeaderSize), 0x0, 0x0};
+    EXPECT_CALL(*dataInterfaceMockPtr, write(expectedBmcReadPtrOffset,
+                                             ElementsAreArray(expectedReadPtr)))
+        .WillOnce(Return(expectedWriteSize));
 
     std::vector<EntryPair> entryPairs;
     EXPECT_NO_THROW(entryPairs = bufferImpl->readErrorLogs());
 
-    // Check that we only read one entryPair and that the content is correct
+    // Check that we read both entryPairs and that the content is correct
+    std::vector<uint8_t> testEntryVector(testEntrySize);
     EXPECT_EQ(entryPairs.size(), 2);
     EXPECT_EQ(entryPairs[0].first, testEntryHeader);
     EXPECT_EQ(entryPairs[1].first, testEntryHeader);
@@ -959,7 +1100,74 @@ TEST_F(BufferReadErrorLogsTest, WraparoundMultiplEntryPass)
     EXPECT_THAT(entryPairs[1].second, ElementsAreArray(testEntryVector));
 }
 
-TEST_F(BufferReadErrorLogsTest, WraparoundMismatchingPtrsFail)
+TEST_F(BufferReadErrorLogsTest, EntrySplitAcrossWraparoundPass)
+{
+    InSequence s;
+    // Start the entry 1 byte before the end of the queue, so that both the
+    // entry header and the entry are split by the wraparound
+    uint32_t readPtr = testMaxOffset - 1;
+    testInitializationHeader.bmcReadPtr =
+        boost::endian::native_to_little(readPtr);
+    testInitializationHeader.biosWritePtr = entryAndHeaderSize - 1;
+    initializeFuncMock();
+    EXPECT_CALL(*dataInterfaceMockPtr, readInto(0, SizeIs(bufferHeaderSize)))
+        .WillOnce(ReadIntoBytes(std::vector<uint8_t>(
+            testInitializationHeaderPtr,
+            testInitializationHeaderPtr + bufferHeaderSize)));
+
+    std::vector<uint8_t> bytes = entryBytes();
+    EXPECT_CALL(*dataInterfaceMockPtr,
+                readInto(expectedqueueOffset + readPtr, SizeIs(1)))
+        .WillOnce(ReadIntoBytes(std::vector<uint8_t>(bytes.begin(),
+                                                     bytes.begin() + 1)));
+    EXPECT_CALL(*dataInterfaceMockPtr,
+                readInto(expectedqueueOffset, SizeIs(entryAndHeaderSize - 1)))
+        .WillOnce(ReadIntoBytes(
+            std::vector<uint8_t>(bytes.begin() + 1, bytes.end())));
+    EXPECT_CALL(*dataInterfaceMockPtr, write(expectedBmcReadPtrOffset, _))
+        .WillOnce(Return(expectedWriteSize));
+
+    std::vector<EntryPair> entryPairs;
+    EXPECT_NO_THROW(entryPairs = bufferImpl->readErrorLogs());
+    EXPECT_EQ(entryPairs.size(), 1U);
+    EXPECT_EQ(entryPairs[0].first, testEntryHeader);
+}
+
+TEST_F(BufferReadErrorLogsTest, ChecksumFailSkipsToWritePtr)
+{
+    InSequence s;
+    testInitializationHeader.biosWritePtr =
+        boost::endian::native_to_little((entryAndHeaderSize));
+    initializeFuncMock();
+    EXPECT_CALL(*dataInterfaceMockPtr, readInto(0, SizeIs(bufferHeaderSize)))
+        .WillOnce(ReadIntoBytes(std::vector<uint8_t>(
+            testInitializationHeaderPtr,
+            testInitializationHeaderPtr + bufferHeaderSize)));
+
+    std::vector<uint8_t> bytes = entryBytes();
+    bytes.back() = 0x3;
+    EXPECT_CALL(*dataInterfaceMockPtr,
+                readInto(expectedqueueOffset, SizeIs(entryAndHeaderSize)))
+        .WillOnce(ReadIntoBytes(bytes));
+    // There is no valid entry after the corrupt one, so the read pointer
+    // skips to the write pointer
+    const std::vector<uint8_t> expectedReadPtr{
+        static_cast<uint8_t>(entryAndHeaderSize), 0x0, 0x0};
+    EXPECT_CALL(*dataInterfaceMockPtr, write(expectedBmcReadPtrOffset,
+                                             ElementsAreArray(expectedReadPtr)))
+        .WillOnce(Return(expectedWriteSize));
+
+    std::vector<EntryPair> entryPairs;
+    EXPECT_NO_THROW(entryPairs = bufferImpl->readErrorLogs());
+    EXPECT_TRUE(entryPairs.empty());
+
+    RecoveryStats stats = bufferImpl->getRecoveryStats();
+    EXPECT_EQ(stats.resyncs, 1U);
+    EXPECT_EQ(stats.bytesSkipped, entryAndHeaderSize);
+    EXPECT_EQ(stats.writePtrFallbacks, 1U);
+}
+
+TEST_F(BufferReadErrorLogsTest, WraparoundMismatchingPtrsSkipsToWritePtr)
 {
     InSequence s;
     testInitializationHeader.bmcReadPtr = boost::endian::native_to_little(0);
@@ -967,28 +1175,135 @@ TEST_F(BufferReadErrorLogsTest, WraparoundMismatchingPtrsFail)
     testInitializationHeader.biosWritePtr =
         boost::endian::native_to_little(entryAndHeaderSize - 1);
     initializeFuncMock();
-    EXPECT_CALL(*dataInterfaceMockPtr, read(0, bufferHeaderSize))
-        .WillOnce(Return(std::vector<uint8_t>(
+    EXPECT_CALL(*dataInterfaceMockPtr, readInto(0, SizeIs(bufferHeaderSize)))
+        .WillOnce(ReadIntoBytes(std::vector<uint8_t>(
             testInitializationHeaderPtr,
             testInitializationHeaderPtr + bufferHeaderSize)));
 
-    std::vector<uint8_t> testEntryHeaderVector(
-        testEntryHeaderPtr, testEntryHeaderPtr + entryHeaderSize);
-    std::vector<uint8_t> testEntryVector(testEntrySize);
-    wraparoundReadMock(/*relativeOffset=*/0, testEntryHeaderVector);
-    wraparoundReadMock(/*relativeOffset=*/0 + entryHeaderSize, testEntryVector);
+    EXPECT_CALL(*dataInterfaceMockPtr,
+                readInto(expectedqueueOffset, SizeIs(entryAndHeaderSize - 1)))
+        .WillOnce(ReadIntoBytes(entryBytes()));
+    const std::vector<uint8_t> expectedReadPtr{
+        static_cast<uint8_t>(entryAndHeaderSize - 1), 0x0, 0x0};
+    EXPECT_CALL(*dataInterfaceMockPtr, write(expectedBmcReadPtrOffset,
+                                             ElementsAreArray(expectedReadPtr)))
+        .WillOnce(Return(expectedWriteSize));
 
-    EXPECT_THROW(
-        try {
-            bufferImpl->readErrorLogs();
-        } catch (const std::runtime_error& e) {
-            EXPECT_STREQ(
-                e.what(),
-                "[readErrorLogs] biosWritePtr '37' and bmcReaddPtr '38' "
-                "are not identical after reading through all the logs");
-            throw;
-        },
-        std::runtime_error);
+    std::vector<EntryPair> entryPairs;
+    EXPECT_NO_THROW(entryPairs = bufferImpl->readErrorLogs());
+    EXPECT_TRUE(entryPairs.empty());
+    EXPECT_EQ(bufferImpl->getRecoveryStats().bytesSkipped,
+              entryAndHeaderSize - 1);
+}
+
+class BufferCommitPolicyTest : public BufferReadErrorLogsTest
+{
+  protected:
+    // Replace bufferImpl with one using the provided policy, and queue up
+    // numEntries entries starting at the beginning of the queue
+    void readEntries(ReadPtrCommitPolicy policy, size_t numEntries)
+    {
+        auto mock = std::make_unique<DataInterfaceMock>();
+        dataInterfaceMockPtr = mock.get();
+        bufferImpl = std::make_unique<BufferImpl>(std::move(mock), policy);
+
+        InSequence s;
+        testInitializationHeader.biosWritePtr =
+            boost::endian::native_to_little(entryAndHeaderSize * numEntries);
+        initializeFuncMock();
+        EXPECT_CALL(*dataInterfaceMockPtr,
+                    readInto(0, SizeIs(bufferHeaderSize)))
+            .WillOnce(ReadIntoBytes(std::vector<uint8_t>(
+                testInitializationHeaderPtr,
+                testInitializationHeaderPtr + bufferHeaderSize)));
+        std::vector<uint8_t> bytes;
+        for (size_t i = 0; i < numEntries; ++i)
+        {
+            std::vector<uint8_t> entry = entryBytes();
+            bytes.insert(bytes.end(), entry.begin(), entry.end());
+        }
+        EXPECT_CALL(*dataInterfaceMockPtr,
+                    readInto(expectedqueueOffset, SizeIs(bytes.size())))
+            .WillOnce(ReadIntoBytes(bytes));
+
+        EXPECT_NO_THROW(bufferImpl->poll());
+        EXPECT_EQ(bufferImpl->readPendingErrorLogs().size(), numEntries);
+    }
+
+    void expectReadPtrWrite(size_t readPtr)
+    {
+        const std::vector<uint8_t> expectedReadPtr{
+            static_cast<uint8_t>(readPtr), 0x0, 0x0};
+        EXPECT_CALL(*dataInterfaceMockPtr,
+                    write(expectedBmcReadPtrOffset,
+                          ElementsAreArray(expectedReadPtr)))
+            .WillOnce(Return(expectedWriteSize));
+    }
+};
+
+TEST_F(BufferCommitPolicyTest, ZeroThresholdFail)
+{
+    for (ReadPtrCommitMode mode : {ReadPtrCommitMode::everyNEntries,
+                                   ReadPtrCommitMode::everyNBytes})
+    {
+        EXPECT_THROW(BufferImpl(std::make_unique<DataInterfaceMock>(),
+                                {.mode = mode, .threshold = 0}),
+                     std::invalid_argument);
+    }
+    EXPECT_NO_THROW(BufferImpl(std::make_unique<DataInterfaceMock>(),
+                               {.mode = ReadPtrCommitMode::perBatch}));
+}
+
+TEST_F(BufferCommitPolicyTest, PerEntry)
+{
+    readEntries({.mode = ReadPtrCommitMode::perEntry}, 3);
+    InSequence s;
+    for (size_t i = 1; i <= 3; ++i)
+    {
+        expectReadPtrWrite(entryAndHeaderSize * i);
+        bufferImpl->markEntryConsumed();
+    }
+    // Everything was already committed
+    bufferImpl->commitReadPtr();
+}
+
+TEST_F(BufferCommitPolicyTest, EveryNEntries)
+{
+    readEntries({.mode = ReadPtrCommitMode::everyNEntries, .threshold = 2}, 3);
+    InSequence s;
+    bufferImpl->markEntryConsumed();
+    expectReadPtrWrite(entryAndHeaderSize * 2);
+    bufferImpl->markEntryConsumed();
+    bufferImpl->markEntryConsumed();
+    // The end of the batch commits the remaining entry
+    expectReadPtrWrite(entryAndHeaderSize * 3);
+    bufferImpl->commitReadPtr();
+}
+
+TEST_F(BufferCommitPolicyTest, EveryNBytes)
+{
+    readEntries({.mode = ReadPtrCommitMode::everyNBytes,
+                 .threshold = static_cast<uint32_t>(entryAndHeaderSize + 1)},
+                3);
+    InSequence s;
+    bufferImpl->markEntryConsumed();
+    expectReadPtrWrite(entryAndHeaderSize * 2);
+    bufferImpl->markEntryConsumed();
+    bufferImpl->markEntryConsumed();
+    expectReadPtrWrite(entryAndHeaderSize * 3);
+    bufferImpl->commitReadPtr();
+}
+
+TEST_F(BufferCommitPolicyTest, PerBatch)
+{
+    readEntries({.mode = ReadPtrCommitMode::perBatch}, 3);
+    InSequence s;
+    bufferImpl->markEntryConsumed();
+    bufferImpl->markEntryConsumed();
+    // Only the consumed entries are committed, the last one will be read
+    // again on the next batch
+    expectReadPtrWrite(entryAndHeaderSize * 2);
+    bufferImpl->commitReadPtr();
 }
 
 } // namespace
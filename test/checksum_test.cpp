@@ -0,0 +1,194 @@
+#include "checksum/checksum.hpp"
+#include "checksum/crc32.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace
+{
+
+using ::testing::ElementsAreArray;
+
+class ChecksumTest : public ::testing::TestWithParam<ChecksumKernel>
+{
+  protected:
+    ChecksumTest() : bytes(testSize)
+    {
+        // Not a repeating pattern, so that every byte position matters
+        uint32_t state = 0x12345678;
+        for (uint8_t& byte : bytes)
+        {
+            state = state * 1103515245 + 12345;
+            byte = static_cast<uint8_t>(state >> 16);
+        }
+    }
+
+    void SetUp() override
+    {
+        if (!isChecksumKernelSupported(GetParam()))
+        {
+            GTEST_SKIP() << "Kernel not supported on this CPU";
+        }
+    }
+
+    static uint8_t referenceChecksum(std::span<const uint8_t> span)
+    {
+        return std::accumulate(span.begin(), span.end(), 0,
+                               std::bit_xor<void>());
+    }
+
+    // Cover the vector bodies of every kernel with any misalignment and tail
+    static constexpr size_t testSize = 300;
+    static constexpr size_t maxMisalignment = 32;
+
+    std::vector<uint8_t> bytes;
+};
+
+TEST_P(ChecksumTest, XorChecksumAllLengthsAndAlignments)
+{
+    for (size_t offset = 0; offset < maxMisalignment; ++offset)
+    {
+        for (size_t length = 0; offset + length <= testSize; ++length)
+        {
+            std::span<const uint8_t> span =
+                std::span(bytes).subspan(offset, length);
+            ASSERT_EQ(xorChecksum(GetParam(), span), referenceChecksum(span))
+                << "offset " << offset << " length " << length;
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    AllKernels, ChecksumTest,
+    ::testing::Values(ChecksumKernel::portable, ChecksumKernel::sse2,
+                      ChecksumKernel::avx2, ChecksumKernel::neon));
+
+TEST(ChecksumKernelTest, BestKernelIsSupported)
+{
+    EXPECT_TRUE(isChecksumKernelSupported(ChecksumKernel::portable));
+    EXPECT_TRUE(isChecksumKernelSupported(bestChecksumKernel()));
+}
+
+class Crc32Test : public ::testing::TestWithParam<Crc32Kernel>
+{
+  protected:
+    Crc32Test() : bytes(testSize)
+    {
+        uint32_t state = 0x87654321;
+        for (uint8_t& byte : bytes)
+        {
+            state = state * 1103515245 + 12345;
+            byte = static_cast<uint8_t>(state >> 16);
+        }
+    }
+
+    void SetUp() override
+    {
+        if (!isCrc32KernelSupported(GetParam()))
+        {
+            GTEST_SKIP() << "Kernel not supported on this CPU";
+        }
+    }
+
+    // One bit at a time, straight from the definition
+    static uint32_t referenceCrc(uint32_t crc, std::span<const uint8_t> span)
+    {
+        for (uint8_t byte : span)
+        {
+            crc ^= byte;
+            for (int k = 0; k < 8; ++k)
+            {
+                crc = (crc & 1) ? (crc >> 1) ^ 0xedb88320 : crc >> 1;
+            }
+        }
+        return crc;
+    }
+
+    // Several folding blocks of 64 bytes, plus any tail
+    static constexpr size_t testSize = 600;
+    static constexpr size_t maxMisalignment = 16;
+
+    std::vector<uint8_t> bytes;
+};
+
+TEST_P(Crc32Test, KnownValue)
+{
+    // Check value from the CRC-32 (IEEE 802.3) catalogue
+    constexpr std::string_view check = "123456789";
+    std::span<const uint8_t> bytes(
+        reinterpret_cast<const uint8_t*>(check.data()), check.size());
+    uint32_t crc = crc32Update(GetParam(), crc32Init, bytes);
+    EXPECT_EQ(crc32Final(crc), 0xCBF43926);
+}
+
+TEST_P(Crc32Test, AllLengthsAndAlignments)
+{
+    for (size_t offset = 0; offset < maxMisalignment; ++offset)
+    {
+        for (size_t length = 0; offset + length <= testSize; ++length)
+        {
+            std::span<const uint8_t> span =
+                std::span(bytes).subspan(offset, length);
+            ASSERT_EQ(crc32Update(GetParam(), crc32Init, span),
+                      referenceCrc(crc32Init, span))
+                << "offset " << offset << " length " << length;
+        }
+    }
+}
+
+TEST_P(Crc32Test, RunningValueAcrossChunks)
+{
+    // Dictionaries arrive in chunks, the running value must carry over
+    const uint32_t expected = referenceCrc(crc32Init, bytes);
+    for (size_t chunkSize : {1, 7, 16, 63, 64, 65, 200})
+    {
+        uint32_t crc = crc32Init;
+        for (size_t offset = 0; offset < bytes.size(); offset += chunkSize)
+        {
+            crc = crc32Update(
+                GetParam(), crc,
+                std::span(bytes).subspan(
+                    offset, std::min(chunkSize, bytes.size() - offset)));
+        }
+        EXPECT_EQ(crc, expected) << "chunk size " << chunkSize;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(AllKernels, Crc32Test,
+                         ::testing::Values(Crc32Kernel::slicingBy8,
+                                           Crc32Kernel::armv8,
+                                           Crc32Kernel::pclmul));
+
+TEST(Crc32KernelTest, BestKernelIsSupported)
+{
+    EXPECT_TRUE(isCrc32KernelSupported(Crc32Kernel::slicingBy8));
+    EXPECT_TRUE(isCrc32KernelSupported(bestCrc32Kernel()));
+}
+
+TEST(Crc32KernelTest, AppendAdvancesCrc)
+{
+    // Bigger than the chunks the CRC is computed in
+    std::vector<uint8_t> src(10000);
+    std::iota(src.begin(), src.end(), 0);
+    std::vector<uint8_t> dest = {0xaa, 0xbb};
+
+    uint32_t crc = crc32Append(crc32Init, src, dest);
+    EXPECT_EQ(crc, crc32Update(crc32Init, src));
+    ASSERT_EQ(dest.size(), src.size() + 2);
+    EXPECT_EQ(dest[0], 0xaa);
+    EXPECT_EQ(dest[1], 0xbb);
+    EXPECT_THAT(std::span(dest).subspan(2), ElementsAreArray(src));
+}
+
+} // namespace
+} // namespace bios_bmc_smm_error_logger
@@ -0,0 +1,85 @@
+#include "doorbell.hpp"
+
+#include <poll.h>
+#include <unistd.h>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace
+{
+
+bool isReadable(int fd)
+{
+    struct pollfd pfd = {.fd = fd, .events = POLLIN, .revents = 0};
+    return ::poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLIN);
+}
+
+TEST(EventFdDoorbellTest, RingAndAcknowledge)
+{
+    EventFdDoorbell doorbell;
+    EXPECT_FALSE(isReadable(doorbell.getFd()));
+    EXPECT_EQ(doorbell.acknowledge(), 0U);
+
+    doorbell.ring();
+    EXPECT_TRUE(isReadable(doorbell.getFd()));
+    EXPECT_EQ(doorbell.acknowledge(), 1U);
+    EXPECT_FALSE(isReadable(doorbell.getFd()));
+}
+
+TEST(EventFdDoorbellTest, RingsAreCoalesced)
+{
+    EventFdDoorbell doorbell;
+    doorbell.ring();
+    doorbell.ring();
+    doorbell.ring();
+    EXPECT_EQ(doorbell.acknowledge(), 3U);
+    EXPECT_FALSE(isReadable(doorbell.getFd()));
+}
+
+TEST(EventFdDoorbellTest, AsioWakesBeforeSafetyNet)
+{
+    EventFdDoorbell doorbell;
+    boost::asio::io_context io;
+    boost::asio::posix::stream_descriptor descriptor(io,
+                                                     ::dup(doorbell.getFd()));
+    boost::asio::steady_timer safetyNet(io, std::chrono::seconds(10));
+
+    bool rang = false;
+    descriptor.async_wait(boost::asio::posix::stream_descriptor::wait_read,
+                          [&](const boost::system::error_code& error) {
+                              ASSERT_FALSE(error);
+                              rang = doorbell.acknowledge() > 0;
+                              safetyNet.cancel();
+                          });
+    safetyNet.async_wait([](const boost::system::error_code&) {});
+
+    std::thread bios([&doorbell]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        doorbell.ring();
+    });
+    const auto start = std::chrono::steady_clock::now();
+    io.run();
+    bios.join();
+
+    EXPECT_TRUE(rang);
+    EXPECT_LT(std::chrono::steady_clock::now() - start,
+              std::chrono::seconds(5));
+}
+
+TEST(UioDoorbellTest, MissingDeviceFail)
+{
+    EXPECT_THROW(UioDoorbell("/dev/uio-does-not-exist"), std::runtime_error);
+}
+
+} // namespace
+} // namespace bios_bmc_smm_error_logger
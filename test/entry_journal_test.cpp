@@ -0,0 +1,258 @@
+#include "entry_journal.hpp"
+
+#include <unistd.h>
+
+#include <boost/endian/conversion.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace
+{
+
+using ::testing::ElementsAreArray;
+using ::testing::IsEmpty;
+
+class EntryJournalTest : public ::testing::Test
+{
+  protected:
+    EntryJournalTest() :
+        path(std::filesystem::temp_directory_path() /
+             ("entry_journal_test." + std::to_string(::getpid())))
+    {
+        std::filesystem::remove(path);
+    }
+
+    ~EntryJournalTest() override
+    {
+        std::filesystem::remove(path);
+    }
+
+    static struct QueueEntryHeader entryHeader(uint16_t sequenceId,
+                                               uint16_t entrySize,
+                                               uint8_t rdeCommandType)
+    {
+        struct QueueEntryHeader header = {};
+        header.sequenceId = boost::endian::native_to_little(sequenceId);
+        header.entrySize = boost::endian::native_to_little(entrySize);
+        header.checksum = 0x5a;
+        header.rdeCommandType = rdeCommandType;
+        return header;
+    }
+
+    struct ReadRecord
+    {
+        JournalRecordKind kind;
+        uint16_t sequenceId;
+        uint8_t rdeCommandType;
+        std::vector<uint8_t> payload;
+    };
+
+    std::vector<ReadRecord> readAll(const EntryJournalReader& reader)
+    {
+        std::vector<ReadRecord> records;
+        reader.forEach([&records](const JournalRecord& record) {
+            records.push_back(
+                {record.kind,
+                 boost::endian::little_to_native(record.entryHeader.sequenceId),
+                 record.entryHeader.rdeCommandType,
+                 std::vector<uint8_t>(record.payload.begin(),
+                                      record.payload.end())});
+        });
+        return records;
+    }
+
+    const std::filesystem::path path;
+    const std::vector<uint8_t> entry0 = {1, 2, 3, 4};
+    const std::vector<uint8_t> entry1 = {5, 6};
+    const std::vector<uint8_t> ueLog = {0xaa, 0xbb, 0xcc};
+};
+
+TEST_F(EntryJournalTest, RoundTrip)
+{
+    {
+        EntryJournalWriter writer(path);
+        writer.appendEntry(entryHeader(0, entry0.size(), 1), entry0);
+        writer.appendUeLog(ueLog);
+        writer.appendEntry(entryHeader(1, entry1.size(), 2), entry1);
+        writer.appendEntry(entryHeader(2, 0, 3), {});
+        EXPECT_EQ(writer.getNumRecords(), 4U);
+    }
+
+    EntryJournalReader reader(path);
+    EXPECT_FALSE(reader.isTruncated());
+    EXPECT_EQ(reader.size(), sizeof(JournalFileHeader) +
+                                 4 * sizeof(JournalRecordHeader) +
+                                 entry0.size() + entry1.size() + ueLog.size());
+    std::vector<ReadRecord> records = readAll(reader);
+    ASSERT_EQ(records.size(), 4U);
+    EXPECT_EQ(records[0].kind, JournalRecordKind::queueEntry);
+    EXPECT_EQ(records[0].sequenceId, 0);
+    EXPECT_EQ(records[0].rdeCommandType, 1);
+    EXPECT_THAT(records[0].payload, ElementsAreArray(entry0));
+    EXPECT_EQ(records[1].kind, JournalRecordKind::ueLog);
+    EXPECT_EQ(records[1].rdeCommandType, 0);
+    EXPECT_THAT(records[1].payload, ElementsAreArray(ueLog));
+    EXPECT_EQ(records[2].sequenceId, 1);
+    EXPECT_THAT(records[2].payload, ElementsAreArray(entry1));
+    EXPECT_EQ(records[3].rdeCommandType, 3);
+    EXPECT_THAT(records[3].payload, IsEmpty());
+}
+
+TEST_F(EntryJournalTest, TimestampsAreKept)
+{
+    const auto before = std::chrono::system_clock::now();
+    {
+        EntryJournalWriter writer(path);
+        writer.appendUeLog(ueLog);
+    }
+    const auto after = std::chrono::system_clock::now();
+
+    EntryJournalReader reader(path);
+    reader.forEach([&](const JournalRecord& record) {
+        EXPECT_GE(record.timestamp, before);
+        EXPECT_LE(record.timestamp, after);
+    });
+}
+
+TEST_F(EntryJournalTest, AppendsToExistingJournal)
+{
+    {
+        EntryJournalWriter writer(path);
+        writer.appendEntry(entryHeader(0, entry0.size(), 1), entry0);
+    }
+    {
+        EntryJournalWriter writer(path);
+        writer.appendEntry(entryHeader(1, entry1.size(), 1), entry1);
+        EXPECT_EQ(writer.getNumRecords(), 1U);
+    }
+
+    EntryJournalReader reader(path);
+    std::vector<ReadRecord> records = readAll(reader);
+    ASSERT_EQ(records.size(), 2U);
+    EXPECT_THAT(records[0].payload, ElementsAreArray(entry0));
+    EXPECT_THAT(records[1].payload, ElementsAreArray(entry1));
+}
+
+TEST_F(EntryJournalTest, BuffersUntilFlush)
+{
+    EntryJournalWriter writer(path);
+    writer.appendEntry(entryHeader(0, entry0.size(), 1), entry0);
+    // Nothing but the file header is written yet
+    EXPECT_EQ(std::filesystem::file_size(path), sizeof(JournalFileHeader));
+
+    writer.flush();
+    EXPECT_EQ(std::filesystem::file_size(path),
+              sizeof(JournalFileHeader) + sizeof(JournalRecordHeader) +
+                  entry0.size());
+}
+
+TEST_F(EntryJournalTest, WritesOutFullBuffer)
+{
+    const size_t recordSize = sizeof(JournalRecordHeader) + entry0.size();
+    EntryJournalWriter writer(path, 2 * recordSize);
+    writer.appendEntry(entryHeader(0, entry0.size(), 1), entry0);
+    writer.appendEntry(entryHeader(1, entry0.size(), 1), entry0);
+    EXPECT_EQ(std::filesystem::file_size(path), sizeof(JournalFileHeader));
+
+    // The third record does not fit, the first two are written out
+    writer.appendEntry(entryHeader(2, entry0.size(), 1), entry0);
+    EXPECT_EQ(std::filesystem::file_size(path),
+              sizeof(JournalFileHeader) + 2 * recordSize);
+}
+
+TEST_F(EntryJournalTest, TruncatedRecordIsSkipped)
+{
+    {
+        EntryJournalWriter writer(path);
+        writer.appendEntry(entryHeader(0, entry0.size(), 1), entry0);
+        writer.appendEntry(entryHeader(1, entry1.size(), 1), entry1);
+    }
+    // Cut the last record short, as a crash mid write would
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+
+    EntryJournalReader reader(path);
+    EXPECT_TRUE(reader.isTruncated());
+    std::vector<ReadRecord> records = readAll(reader);
+    ASSERT_EQ(records.size(), 1U);
+    EXPECT_THAT(records[0].payload, ElementsAreArray(entry0));
+}
+
+TEST_F(EntryJournalTest, AppendsAfterTruncatedRecord)
+{
+    {
+        EntryJournalWriter writer(path);
+        writer.appendEntry(entryHeader(0, entry0.size(), 1), entry0);
+        writer.appendEntry(entryHeader(1, entry1.size(), 1), entry1);
+    }
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+
+    // Restarted after the crash, the torn record is dropped and the new ones
+    // follow the last complete one
+    {
+        EntryJournalWriter writer(path);
+        writer.appendEntry(entryHeader(2, entry0.size(), 1), entry0);
+        writer.appendUeLog(ueLog);
+    }
+
+    EntryJournalReader reader(path);
+    EXPECT_FALSE(reader.isTruncated());
+    std::vector<ReadRecord> records = readAll(reader);
+    ASSERT_EQ(records.size(), 3U);
+    EXPECT_EQ(records[0].sequenceId, 0);
+    EXPECT_EQ(records[1].sequenceId, 2);
+    EXPECT_THAT(records[1].payload, ElementsAreArray(entry0));
+    EXPECT_EQ(records[2].kind, JournalRecordKind::ueLog);
+    EXPECT_THAT(records[2].payload, ElementsAreArray(ueLog));
+}
+
+TEST_F(EntryJournalTest, EmptyJournal)
+{
+    {
+        EntryJournalWriter writer(path);
+    }
+    EntryJournalReader reader(path);
+    EXPECT_FALSE(reader.isTruncated());
+    EXPECT_THAT(readAll(reader), IsEmpty());
+}
+
+TEST_F(EntryJournalTest, NotAJournalFail)
+{
+    {
+        std::ofstream file(path);
+        file << "this is not an entry journal";
+    }
+    EXPECT_THROW(EntryJournalWriter writer(path), std::runtime_error);
+    EXPECT_THROW(EntryJournalReader reader(path), std::runtime_error);
+}
+
+TEST_F(EntryJournalTest, TooSmallFail)
+{
+    {
+        std::ofstream file(path);
+        file << "BBSM";
+    }
+    EXPECT_THROW(EntryJournalReader reader(path), std::runtime_error);
+}
+
+TEST_F(EntryJournalTest, OpenFail)
+{
+    EXPECT_THROW(EntryJournalWriter writer("/does-not-exist/journal"),
+                 std::runtime_error);
+    EXPECT_THROW(EntryJournalReader reader("/does-not-exist/journal"),
+                 std::runtime_error);
+}
+
+} // namespace
+} // namespace bios_bmc_smm_error_logger
@@ -0,0 +1,281 @@
+#include "entry_pipeline.hpp"
+#include "fake_bios_test.hpp"
+#include "spsc_ring.hpp"
+
+#include <boost/endian/conversion.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace
+{
+
+using ::testing::ElementsAre;
+using ::testing::Le;
+using ::testing::Lt;
+
+TEST(SpscRingTest, ZeroCapacityFail)
+{
+    EXPECT_THROW(SpscRing<int>(0), std::invalid_argument);
+}
+
+TEST(SpscRingTest, FullAndEmpty)
+{
+    SpscRing<int> ring(2);
+    EXPECT_EQ(ring.consumerSlot(), nullptr);
+    *ring.producerSlot() = 1;
+    ring.publish();
+    *ring.producerSlot() = 2;
+    ring.publish();
+    EXPECT_EQ(ring.producerSlot(), nullptr);
+
+    EXPECT_EQ(*ring.consumerSlot(), 1);
+    ring.release();
+    *ring.producerSlot() = 3;
+    ring.publish();
+    EXPECT_EQ(*ring.consumerSlot(), 2);
+    ring.release();
+    EXPECT_EQ(*ring.consumerSlot(), 3);
+    ring.release();
+    EXPECT_EQ(ring.consumerSlot(), nullptr);
+    EXPECT_EQ(ring.published(), 3U);
+    EXPECT_EQ(ring.released(), 3U);
+}
+
+TEST(SpscRingTest, ProducerConsumerThreads)
+{
+    constexpr uint64_t numItems = 100000;
+    SpscRing<uint64_t> ring(16);
+    std::thread consumer([&ring]() {
+        for (uint64_t expected = 0; expected < numItems; ++expected)
+        {
+            uint64_t* slot;
+            while ((slot = ring.consumerSlot()) == nullptr)
+            {
+                std::this_thread::yield();
+            }
+            ASSERT_EQ(*slot, expected);
+            ring.release();
+        }
+    });
+    for (uint64_t i = 0; i < numItems; ++i)
+    {
+        uint64_t* slot;
+        while ((slot = ring.producerSlot()) == nullptr)
+        {
+            std::this_thread::yield();
+        }
+        *slot = i;
+        ring.publish();
+    }
+    consumer.join();
+    EXPECT_EQ(ring.released(), numItems);
+}
+
+class EntryPipelineTest : public FakeBiosTest
+{
+  protected:
+    // Decode stage that records the sequence IDs it was given
+    EntryPipeline::DecodeFunction recordSequenceIds()
+    {
+        return [this](const QueueEntryHeader& entryHeader,
+                      std::span<const uint8_t>) {
+            std::lock_guard lock(mutex);
+            sequenceIds.push_back(
+                boost::endian::little_to_native(entryHeader.sequenceId));
+        };
+    }
+
+    size_t drain(EntryPipeline& pipeline)
+    {
+        bufferImpl->poll();
+        return pipeline.drain(*bufferImpl);
+    }
+
+    std::mutex mutex;
+    std::vector<uint16_t> sequenceIds;
+};
+
+TEST_F(EntryPipelineTest, EntriesReachDecodeStage)
+{
+    EntryPipeline pipeline(recordSequenceIds(), 8);
+    writeEntry(1, testEntrySize);
+    writeEntry(2, testEntrySize);
+    EXPECT_EQ(drain(pipeline), 2U);
+    // Space is given back to BIOS as soon as the entries are queued
+    EXPECT_EQ(bmcReadPtr(), biosWritePtr());
+    pipeline.waitIdle();
+
+    writeEntry(3, testEntrySize);
+    EXPECT_EQ(drain(pipeline), 1U);
+    pipeline.waitIdle();
+    EXPECT_THAT(sequenceIds, ElementsAre(1, 2, 3));
+
+    PipelineStats stats = pipeline.getStats();
+    EXPECT_EQ(stats.entriesQueued, 3U);
+    EXPECT_EQ(stats.entriesDecoded, 3U);
+    EXPECT_EQ(stats.queueFullStalls, 0U);
+    EXPECT_THAT(stats.maxQueueDepth, Le(2U));
+}
+
+TEST_F(EntryPipelineTest, EntryBytesAreCopied)
+{
+    std::vector<std::vector<uint8_t>> entries;
+    EntryPipeline pipeline(
+        [&entries](const QueueEntryHeader&, std::span<const uint8_t> entry) {
+            entries.emplace_back(entry.begin(), entry.end());
+        },
+        8);
+    writeEntry(1, testEntrySize);
+    drain(pipeline);
+    // BIOS reusing the space doesn't affect the queued copy
+    for (size_t i = 0; i < entryHeaderSize + testEntrySize; ++i)
+    {
+        queueByte(i) = 0;
+    }
+    pipeline.waitIdle();
+
+    ASSERT_EQ(entries.size(), 1U);
+    ASSERT_EQ(entries[0].size(), testEntrySize);
+    for (size_t i = 0; i < testEntrySize; ++i)
+    {
+        EXPECT_EQ(entries[0][i], static_cast<uint8_t>(1 + i));
+    }
+}
+
+TEST_F(EntryPipelineTest, DrainLatencyIndependentOfStorage)
+{
+    // Storage that takes a long time for every entry
+    constexpr auto storageDelay = std::chrono::milliseconds(50);
+    constexpr uint16_t numEntries = 6;
+    EntryPipeline pipeline(
+        [&](const QueueEntryHeader& entryHeader,
+            std::span<const uint8_t> entry) {
+            std::this_thread::sleep_for(storageDelay);
+            recordSequenceIds()(entryHeader, entry);
+        },
+        numEntries);
+    for (uint16_t i = 0; i < numEntries; ++i)
+    {
+        writeEntry(i, testEntrySize);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(drain(pipeline), numEntries);
+    const auto drainTime = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(bmcReadPtr(), biosWritePtr());
+    // Decoding inline would have taken numEntries * storageDelay, draining
+    // takes less than a single store
+    EXPECT_THAT(drainTime, Lt(storageDelay));
+
+    pipeline.waitIdle();
+    EXPECT_EQ(sequenceIds.size(), numEntries);
+}
+
+TEST_F(EntryPipelineTest, FullQueueLeavesEntriesInBuffer)
+{
+    std::promise<void> unblock;
+    std::shared_future<void> unblocked = unblock.get_future().share();
+    EntryPipeline pipeline(
+        [&](const QueueEntryHeader& entryHeader,
+            std::span<const uint8_t> entry) {
+            unblocked.wait();
+            recordSequenceIds()(entryHeader, entry);
+        },
+        2);
+    writeEntry(1, testEntrySize);
+    writeEntry(2, testEntrySize);
+    const uint32_t thirdEntryOffset = writeEntry(3, testEntrySize);
+    writeEntry(4, testEntrySize);
+
+    // The decode stage is stuck on entry 1, which still holds its slot
+    EXPECT_EQ(drain(pipeline), 2U);
+    EXPECT_EQ(bmcReadPtr(), thirdEntryOffset);
+    EXPECT_EQ(pipeline.getStats().queueFullStalls, 1U);
+
+    unblock.set_value();
+    pipeline.waitIdle();
+    EXPECT_EQ(drain(pipeline), 2U);
+    EXPECT_EQ(bmcReadPtr(), biosWritePtr());
+    pipeline.waitIdle();
+    EXPECT_THAT(sequenceIds, ElementsAre(1, 2, 3, 4));
+    EXPECT_EQ(pipeline.getStats().queueFullStalls, 1U);
+}
+
+TEST_F(EntryPipelineTest, BatchDoneAfterLastQueuedEntry)
+{
+    std::promise<void> unblock;
+    std::shared_future<void> unblocked = unblock.get_future().share();
+    // Number of entries decoded each time a batch was done
+    std::vector<size_t> batches;
+    EntryPipeline pipeline(
+        [&](const QueueEntryHeader& entryHeader,
+            std::span<const uint8_t> entry) {
+            unblocked.wait();
+            recordSequenceIds()(entryHeader, entry);
+        },
+        8, [&]() {
+            std::lock_guard lock(mutex);
+            batches.push_back(sequenceIds.size());
+        });
+
+    // The decode stage is stuck on entry 1 until all 3 are queued
+    writeEntry(1, testEntrySize);
+    writeEntry(2, testEntrySize);
+    writeEntry(3, testEntrySize);
+    EXPECT_EQ(drain(pipeline), 3U);
+    unblock.set_value();
+    pipeline.waitIdle();
+    EXPECT_THAT(batches, ElementsAre(3));
+
+    writeEntry(4, testEntrySize);
+    EXPECT_EQ(drain(pipeline), 1U);
+    pipeline.waitIdle();
+    EXPECT_THAT(batches, ElementsAre(3, 4));
+}
+
+TEST_F(EntryPipelineTest, DecodeErrorIsCounted)
+{
+    EntryPipeline pipeline(
+        [&](const QueueEntryHeader& entryHeader,
+            std::span<const uint8_t> entry) {
+            if (boost::endian::little_to_native(entryHeader.sequenceId) == 1)
+            {
+                throw std::runtime_error("storage failure");
+            }
+            recordSequenceIds()(entryHeader, entry);
+        },
+        8);
+    writeEntry(1, testEntrySize);
+    writeEntry(2, testEntrySize);
+    drain(pipeline);
+    pipeline.waitIdle();
+
+    EXPECT_THAT(sequenceIds, ElementsAre(2));
+    EXPECT_EQ(pipeline.getStats().decodeErrors, 1U);
+}
+
+TEST_F(EntryPipelineTest, DestructorFinishesQueuedEntries)
+{
+    {
+        EntryPipeline pipeline(recordSequenceIds(), 8);
+        writeEntry(1, testEntrySize);
+        writeEntry(2, testEntrySize);
+        drain(pipeline);
+    }
+    EXPECT_THAT(sequenceIds, ElementsAre(1, 2));
+}
+
+} // namespace
+} // namespace bios_bmc_smm_error_logger
@@ -1,8 +1,20 @@
+#include "nlohmann/json.hpp"
 #include "rde/external_storer_file.hpp"
 
+#include <unistd.h>
+
 #include <boost/asio/io_context.hpp>
 
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <future>
+#include <sstream>
+#include <string>
 #include <string_view>
+#include <vector>
 
 #include <gmock/gmock-matchers.h>
 #include <gmock/gmock.h>
@@ -15,6 +27,7 @@ namespace rde
 
 using ::testing::_;
 using ::testing::DoAll;
+using ::testing::HasSubstr;
 using ::testing::InSequence;
 using ::testing::Return;
 using ::testing::SaveArg;
@@ -27,11 +40,33 @@ class MockFileWriter : public FileHandlerInterface
     MOCK_METHOD(bool, createFolder, (const std::string& path),
                 (const, override));
     MOCK_METHOD(bool, createFile,
-                (const std::string& path, const nlohmann::json& jsonPdr),
+                (const std::string& path,
+                 std::span<const std::string_view> jsonParts),
                 (const, override));
     MOCK_METHOD(bool, removeAll, (const std::string& path), (const, override));
 };
 
+// The JSON the parts handed to createFile make up
+nlohmann::json joinJsonParts(std::span<const std::string_view> jsonParts)
+{
+    std::string json;
+    for (std::string_view part : jsonParts)
+    {
+        json += part;
+    }
+    return nlohmann::json::parse(json);
+}
+
+MATCHER_P(JsonPartsEq, expected, "")
+{
+    return joinJsonParts(arg) == expected;
+}
+
+ACTION_P(SaveJsonParts, jsonPdr)
+{
+    *jsonPdr = joinJsonParts(arg1);
+}
+
 class ExternalStorerFileWriterTest : public ::testing::Test
 {
   protected:
@@ -50,6 +85,14 @@ class ExternalStorerFileWriterTest : public ::testing::Test
         std::filesystem::remove_all(baseDir);
     }
 
+    std::string readIndexFile(const std::filesystem::path& folder)
+    {
+        std::ifstream file(baseDir / folder / "index.json");
+        std::stringstream content;
+        content << file.rdbuf();
+        return content.str();
+    }
+
     std::filesystem::path baseDir;
     std::unique_ptr<ExternalStorerFileWriter> fileWriter;
 };
@@ -68,14 +111,105 @@ TEST_F(ExternalStorerFileWriterTest, CreateFolderTraversal)
 
 TEST_F(ExternalStorerFileWriterTest, CreateValidFile)
 {
-    nlohmann::json testJson = {{"key", "value"}};
+    const std::array<std::string_view, 1> testJson = {R"({"key":"value"})"};
     EXPECT_TRUE(fileWriter->createFile("valid_file", testJson));
     EXPECT_TRUE(std::filesystem::exists(baseDir / "valid_file" / "index.json"));
 }
 
+TEST_F(ExternalStorerFileWriterTest, CreateFileWritesParts)
+{
+    const std::array<std::string_view, 3> jsonParts = {
+        R"({"key":)", R"("value")", "}"};
+    EXPECT_TRUE(fileWriter->createFile("parts_file", jsonParts));
+    EXPECT_EQ(readIndexFile("parts_file"), R"({"key":"value"})");
+}
+
+TEST_F(ExternalStorerFileWriterTest, CreateFileWritesManyParts)
+{
+    // More parts than are written at once
+    std::vector<std::string> numbers;
+    std::vector<std::string_view> jsonParts = {"["};
+    std::string expected = "[";
+    for (int i = 0; i < 200; ++i)
+    {
+        numbers.push_back(std::to_string(i));
+    }
+    for (const std::string& number : numbers)
+    {
+        if (jsonParts.size() > 1)
+        {
+            jsonParts.push_back(",");
+            expected += ",";
+        }
+        jsonParts.push_back(number);
+        jsonParts.push_back("");
+        expected += number;
+    }
+    jsonParts.push_back("]");
+    expected += "]";
+    EXPECT_TRUE(fileWriter->createFile("many_parts", jsonParts));
+    EXPECT_EQ(readIndexFile("many_parts"), expected);
+}
+
+TEST_F(ExternalStorerFileWriterTest, CreateFileOverwrites)
+{
+    const std::array<std::string_view, 1> longJson = {R"({"key":"long"})"};
+    const std::array<std::string_view, 1> shortJson = {"{}"};
+    EXPECT_TRUE(fileWriter->createFile("/a/b", longJson));
+    EXPECT_TRUE(fileWriter->createFile("/a/b", shortJson));
+    EXPECT_EQ(readIndexFile("a/b"), "{}");
+}
+
+TEST_F(ExternalStorerFileWriterTest, CreateFileNormalizesPath)
+{
+    const std::array<std::string_view, 1> testJson = {"{}"};
+    EXPECT_TRUE(fileWriter->createFile("/a/../b/./c/", testJson));
+    EXPECT_TRUE(std::filesystem::exists(baseDir / "b" / "c" / "index.json"));
+    EXPECT_FALSE(std::filesystem::exists(baseDir / "a"));
+}
+
+TEST_F(ExternalStorerFileWriterTest, CreateFileAfterExternalRemoval)
+{
+    // The writer keeps the directories open, they can still be removed by
+    // someone else
+    const std::array<std::string_view, 1> testJson = {"{}"};
+    EXPECT_TRUE(fileWriter->createFile("/service/Entries/1", testJson));
+    std::filesystem::remove_all(baseDir / "service");
+    EXPECT_TRUE(fileWriter->createFile("/service/Entries/2", testJson));
+    EXPECT_TRUE(std::filesystem::exists(
+        baseDir / "service" / "Entries" / "2" / "index.json"));
+}
+
+TEST_F(ExternalStorerFileWriterTest, RemoveEntryKeepsOthers)
+{
+    const std::array<std::string_view, 1> testJson = {"{}"};
+    EXPECT_TRUE(fileWriter->createFile("/service/Entries/1", testJson));
+    EXPECT_TRUE(fileWriter->createFile("/service/Entries/2", testJson));
+    EXPECT_TRUE(fileWriter->removeAll("/service/Entries/1"));
+    EXPECT_FALSE(std::filesystem::exists(baseDir / "service/Entries/1"));
+    EXPECT_TRUE(std::filesystem::exists(baseDir / "service/Entries/2"));
+    // Removing what is not there is not a failure
+    EXPECT_TRUE(fileWriter->removeAll("/service/Entries/1"));
+
+    EXPECT_TRUE(fileWriter->removeAll("/service"));
+    EXPECT_FALSE(std::filesystem::exists(baseDir / "service"));
+    EXPECT_TRUE(fileWriter->createFile("/service/Entries/3", testJson));
+    EXPECT_TRUE(std::filesystem::exists(
+        baseDir / "service" / "Entries" / "3" / "index.json"));
+}
+
+TEST_F(ExternalStorerFileWriterTest, CreatesBaseDir)
+{
+    const std::array<std::string_view, 1> testJson = {"{}"};
+    ExternalStorerFileWriter writer((baseDir / "not" / "yet").string());
+    EXPECT_TRUE(writer.createFile("/entry", testJson));
+    EXPECT_TRUE(std::filesystem::exists(baseDir / "not" / "yet" / "entry" /
+                                        "index.json"));
+}
+
 TEST_F(ExternalStorerFileWriterTest, CreateFileTraversal)
 {
-    nlohmann::json testJson = {{"key", "value"}};
+    const std::array<std::string_view, 1> testJson = {R"({"key":"value"})"};
     EXPECT_FALSE(fileWriter->createFile("../invalid_file", testJson));
     EXPECT_FALSE(
         std::filesystem::exists(baseDir / "../invalid_file" / "index.json"));
@@ -83,7 +217,7 @@ TEST_F(ExternalStorerFileWriterTest, CreateFileTraversal)
 
 TEST_F(ExternalStorerFileWriterTest, RemoveValidFile)
 {
-    nlohmann::json testJson = {{"key", "value"}};
+    const std::array<std::string_view, 1> testJson = {R"({"key":"value"})"};
     fileWriter->createFile("file_to_remove", testJson);
     EXPECT_TRUE(fileWriter->removeAll("file_to_remove"));
     EXPECT_FALSE(std::filesystem::exists(baseDir / "file_to_remove"));
@@ -106,7 +240,7 @@ TEST_F(ExternalStorerFileWriterTest, CreateFolderLeadingSlash)
 
 TEST_F(ExternalStorerFileWriterTest, CreateFileLeadingSlash)
 {
-    nlohmann::json testJson = {{"key", "value"}};
+    const std::array<std::string_view, 1> testJson = {R"({"key":"value"})"};
     EXPECT_TRUE(fileWriter->createFile("/valid_file_leading_slash", testJson));
     EXPECT_TRUE(std::filesystem::exists(
         baseDir / "valid_file_leading_slash" / "index.json"));
@@ -117,7 +251,7 @@ TEST_F(ExternalStorerFileWriterTest, CreateFileLeadingSlash)
 
 TEST_F(ExternalStorerFileWriterTest, RemoveFileLeadingSlash)
 {
-    nlohmann::json testJson = {{"key", "value"}};
+    const std::array<std::string_view, 1> testJson = {R"({"key":"value"})"};
     fileWriter->createFile("/file_to_remove_leading_slash", testJson);
     EXPECT_TRUE(fileWriter->removeAll("/file_to_remove_leading_slash"));
     EXPECT_FALSE(
@@ -133,7 +267,7 @@ TEST_F(ExternalStorerFileWriterTest, MoreCreateFolderTraversal)
 
 TEST_F(ExternalStorerFileWriterTest, MoreCreateFileTraversal)
 {
-    nlohmann::json testJson = {{"key", "value"}};
+    const std::array<std::string_view, 1> testJson = {R"({"key":"value"})"};
     EXPECT_FALSE(fileWriter->createFile("test1/../../test2", testJson));
     EXPECT_FALSE(fileWriter->createFile("/../test3", testJson));
     EXPECT_FALSE(fileWriter->createFile("../app/test4", testJson));
@@ -226,9 +360,11 @@ TEST_F(ExternalStorerFileTest, LogServiceTest)
         "/redfish/v1/Systems/system/LogServices/6F7-C1A7C/Entries";
     nlohmann::json exEntriesJson = "{}"_json;
     nlohmann::json exServiceJson = nlohmann::json::parse(jsonStr);
-    EXPECT_CALL(*mockFileWriterPtr, createFile(exServiceFolder, exServiceJson))
+    EXPECT_CALL(*mockFileWriterPtr, createFile(exServiceFolder,
+                                               JsonPartsEq(exServiceJson)))
         .WillOnce(Return(true));
-    EXPECT_CALL(*mockFileWriterPtr, createFile(exEntriesFolder, exEntriesJson))
+    EXPECT_CALL(*mockFileWriterPtr, createFile(exEntriesFolder,
+                                               JsonPartsEq(exEntriesJson)))
         .WillOnce(Return(true));
     EXPECT_THAT(exStorer->publishJson(jsonStr), true);
 }
@@ -260,9 +396,11 @@ TEST_F(ExternalStorerFileTest, LogEntryTest)
         "/redfish/v1/Systems/system/LogServices/6F7-C1A7C/Entries";
     nlohmann::json exEntriesJson = "{}"_json;
     nlohmann::json exServiceJson = nlohmann::json::parse(jsonLogSerivce);
-    EXPECT_CALL(*mockFileWriterPtr, createFile(exServiceFolder, exServiceJson))
+    EXPECT_CALL(*mockFileWriterPtr, createFile(exServiceFolder,
+                                               JsonPartsEq(exServiceJson)))
         .WillOnce(Return(true));
-    EXPECT_CALL(*mockFileWriterPtr, createFile(exEntriesFolder, exEntriesJson))
+    EXPECT_CALL(*mockFileWriterPtr, createFile(exEntriesFolder,
+                                               JsonPartsEq(exEntriesJson)))
         .WillOnce(Return(true));
     EXPECT_THAT(exStorer->publishJson(jsonLogSerivce), true);
 
@@ -276,7 +414,7 @@ TEST_F(ExternalStorerFileTest, LogEntryTest)
     nlohmann::json logEntryOut;
     std::string logPath1;
     EXPECT_CALL(*mockFileWriterPtr, createFile(_, _))
-        .WillOnce(DoAll(SaveArg<0>(&logPath1), SaveArg<1>(&logEntryOut),
+        .WillOnce(DoAll(SaveArg<0>(&logPath1), SaveJsonParts(&logEntryOut),
                         Return(true)));
     EXPECT_THAT(exStorer->publishJson(jsonLogEntry), true);
     EXPECT_FALSE(logPath1.empty());
@@ -286,7 +424,7 @@ TEST_F(ExternalStorerFileTest, LogEntryTest)
     // Now send a LogEntry#2, which will be the first to be deleted
     std::string logPath2;
     EXPECT_CALL(*mockFileWriterPtr, createFile(_, _))
-        .WillOnce(DoAll(SaveArg<0>(&logPath2), SaveArg<1>(&logEntryOut),
+        .WillOnce(DoAll(SaveArg<0>(&logPath2), SaveJsonParts(&logEntryOut),
                         Return(true)));
     EXPECT_THAT(exStorer->publishJson(jsonLogEntry), true);
     EXPECT_FALSE(logPath2.empty());
@@ -296,7 +434,7 @@ TEST_F(ExternalStorerFileTest, LogEntryTest)
     // Now send a LogEntry#3
     std::string logPath3;
     EXPECT_CALL(*mockFileWriterPtr, createFile(_, _))
-        .WillOnce(DoAll(SaveArg<0>(&logPath3), SaveArg<1>(&logEntryOut),
+        .WillOnce(DoAll(SaveArg<0>(&logPath3), SaveJsonParts(&logEntryOut),
                         Return(true)));
     EXPECT_THAT(exStorer->publishJson(jsonLogEntry), true);
     EXPECT_FALSE(logPath3.empty());
@@ -307,7 +445,7 @@ TEST_F(ExternalStorerFileTest, LogEntryTest)
     std::string logPath4;
     EXPECT_CALL(*mockFileWriterPtr, removeAll(logPath2)).WillOnce(Return(true));
     EXPECT_CALL(*mockFileWriterPtr, createFile(_, _))
-        .WillOnce(DoAll(SaveArg<0>(&logPath4), SaveArg<1>(&logEntryOut),
+        .WillOnce(DoAll(SaveArg<0>(&logPath4), SaveJsonParts(&logEntryOut),
                         Return(true)));
     EXPECT_THAT(exStorer->publishJson(jsonLogEntry), true);
     EXPECT_FALSE(logPath4.empty());
@@ -318,7 +456,7 @@ TEST_F(ExternalStorerFileTest, LogEntryTest)
     std::string logPath5;
     EXPECT_CALL(*mockFileWriterPtr, removeAll(logPath3)).WillOnce(Return(true));
     EXPECT_CALL(*mockFileWriterPtr, createFile(_, _))
-        .WillOnce(DoAll(SaveArg<0>(&logPath5), SaveArg<1>(&logEntryOut),
+        .WillOnce(DoAll(SaveArg<0>(&logPath5), SaveJsonParts(&logEntryOut),
                         Return(true)));
     EXPECT_THAT(exStorer->publishJson(jsonLogEntry), true);
     EXPECT_FALSE(logPath5.empty());
@@ -326,6 +464,304 @@ TEST_F(ExternalStorerFileTest, LogEntryTest)
     EXPECT_EQ(logEntryOut["@odata.id"], nullptr);
 }
 
+TEST(ExternalStorerNoBusTest, LogEntryWrittenWithoutConnection)
+{
+    const std::string jsonLogService = R"({
+        "@odata.id": "/redfish/v1/Systems/system/LogServices/6F7-C1A7C",
+        "@odata.type": "#LogService.v1_1_0.LogService","Id":"6F7-C1A7C"})";
+    const std::string jsonLogEntry =
+        R"({"@odata.type": "#LogEntry.v1_13_0.LogEntry"})";
+    auto mockFileWriter = std::make_unique<MockFileWriter>("/some/path");
+    EXPECT_CALL(*mockFileWriter, createFile(_, _))
+        .Times(3)
+        .WillRepeatedly(Return(true));
+    ExternalStorerFileInterface exStorer(nullptr, "/some/path",
+                                         std::move(mockFileWriter));
+    EXPECT_TRUE(exStorer.publishJson(jsonLogService));
+    EXPECT_TRUE(exStorer.publishJson(jsonLogEntry));
+}
+
+TEST(ExternalStorerRetentionTest, LogEntriesEvictedAfterRestart)
+{
+    boost::asio::io_context io;
+    auto conn = std::make_shared<sdbusplus::asio::connection>(io);
+    const std::filesystem::path indexPath =
+        std::filesystem::temp_directory_path() /
+        ("external_storer_retention_test." + std::to_string(::getpid()));
+    std::filesystem::remove(indexPath);
+    const std::string jsonLogService = R"({
+        "@odata.id": "/redfish/v1/Systems/system/LogServices/6F7-C1A7C",
+        "@odata.type": "#LogService.v1_1_0.LogService","Id":"6F7-C1A7C"})";
+    const std::string jsonLogEntry =
+        R"({"@odata.type": "#LogEntry.v1_13_0.LogEntry"})";
+
+    // 1 saved and 2 non saved entries
+    std::vector<std::string> logPaths(3);
+    {
+        auto mockFileWriter = std::make_unique<MockFileWriter>("/some/path");
+        EXPECT_CALL(*mockFileWriter, createFile(_, _))
+            .WillOnce(Return(true))
+            .WillOnce(Return(true))
+            .WillOnce(DoAll(SaveArg<0>(&logPaths[0]), Return(true)))
+            .WillOnce(DoAll(SaveArg<0>(&logPaths[1]), Return(true)))
+            .WillOnce(DoAll(SaveArg<0>(&logPaths[2]), Return(true)));
+        ExternalStorerFileInterface exStorer(
+            conn, "/some/path", std::move(mockFileWriter), 1, 2,
+            std::chrono::milliseconds(0), 0, indexPath.string());
+        EXPECT_TRUE(exStorer.publishJson(jsonLogService));
+        for (int i = 0; i < 3; ++i)
+        {
+            EXPECT_TRUE(exStorer.publishJson(jsonLogEntry));
+        }
+    }
+
+    // After a restart the oldest non saved entry is still the first to go
+    auto mockFileWriter = std::make_unique<MockFileWriter>("/some/path");
+    EXPECT_CALL(*mockFileWriter, createFile(_, _))
+        .WillRepeatedly(Return(true));
+    EXPECT_CALL(*mockFileWriter, removeAll(logPaths[1]))
+        .WillOnce(Return(true));
+    ExternalStorerFileInterface exStorer(
+        conn, "/some/path", std::move(mockFileWriter), 1, 2,
+        std::chrono::milliseconds(0), 0, indexPath.string());
+    EXPECT_TRUE(exStorer.publishJson(jsonLogService));
+    EXPECT_TRUE(exStorer.publishJson(jsonLogEntry));
+    std::filesystem::remove(indexPath);
+}
+
+TEST(ExternalStorerRetentionTest, LogEntriesRemovedAfterRestart)
+{
+    boost::asio::io_context io;
+    auto conn = std::make_shared<sdbusplus::asio::connection>(io);
+    const std::filesystem::path indexPath =
+        std::filesystem::temp_directory_path() /
+        ("external_storer_removal_test." + std::to_string(::getpid()));
+    std::filesystem::remove(indexPath);
+    const std::string jsonLogService = R"({
+        "@odata.id": "/redfish/v1/Systems/system/LogServices/6F7-C1A7C",
+        "@odata.type": "#LogService.v1_1_0.LogService","Id":"6F7-C1A7C"})";
+    const std::string jsonLogEntry =
+        R"({"@odata.type": "#LogEntry.v1_13_0.LogEntry"})";
+    auto makeStorer = [&](std::unique_ptr<MockFileWriter> mockFileWriter) {
+        return std::make_unique<ExternalStorerFileInterface>(
+            conn, "/some/path", std::move(mockFileWriter), 0, 1,
+            std::chrono::milliseconds(0), 0, indexPath.string());
+    };
+
+    // The daemon goes down before the evicted entry is deleted
+    std::string logPath;
+    {
+        auto mockFileWriter = std::make_unique<MockFileWriter>("/some/path");
+        EXPECT_CALL(*mockFileWriter, createFile(_, _))
+            .WillOnce(Return(true))
+            .WillOnce(Return(true))
+            .WillOnce(DoAll(SaveArg<0>(&logPath), Return(true)))
+            .WillOnce(Return(true));
+        EXPECT_CALL(*mockFileWriter, removeAll(_)).WillOnce(Return(false));
+        auto exStorer = makeStorer(std::move(mockFileWriter));
+        EXPECT_TRUE(exStorer->publishJson(jsonLogService));
+        EXPECT_TRUE(exStorer->publishJson(jsonLogEntry));
+        EXPECT_FALSE(exStorer->publishJson(jsonLogEntry));
+    }
+
+    // It is deleted once the daemon is back, and only then
+    auto mockFileWriter = std::make_unique<MockFileWriter>("/some/path");
+    EXPECT_CALL(*mockFileWriter, removeAll(logPath)).WillOnce(Return(true));
+    makeStorer(std::move(mockFileWriter));
+    mockFileWriter = std::make_unique<MockFileWriter>("/some/path");
+    EXPECT_CALL(*mockFileWriter, removeAll(_)).Times(0);
+    makeStorer(std::move(mockFileWriter));
+    std::filesystem::remove(indexPath);
+}
+
+TEST(ExternalStorerRetentionTest, LogEntriesEvictedForBytes)
+{
+    boost::asio::io_context io;
+    auto conn = std::make_shared<sdbusplus::asio::connection>(io);
+    const std::string jsonLogService = R"({
+        "@odata.id": "/redfish/v1/Systems/system/LogServices/6F7-C1A7C",
+        "@odata.type": "#LogService.v1_1_0.LogService","Id":"6F7-C1A7C"})";
+    const std::string jsonLogEntry =
+        R"({"@odata.type": "#LogEntry.v1_13_0.LogEntry"})";
+
+    // Each entry takes up a page of tmpfs, two of them fit
+    const uint64_t maxBytes = 2 * ::sysconf(_SC_PAGESIZE);
+    std::string oldestLogPath;
+    auto mockFileWriter = std::make_unique<MockFileWriter>("/some/path");
+    MockFileWriter* mockFileWriterPtr = mockFileWriter.get();
+    ExternalStorerFileInterface exStorer(
+        conn, "/some/path", std::move(mockFileWriter), 0, 100,
+        std::chrono::milliseconds(0), maxBytes);
+    EXPECT_CALL(*mockFileWriterPtr, createFile(_, _))
+        .WillOnce(Return(true))
+        .WillOnce(Return(true))
+        .WillOnce(DoAll(SaveArg<0>(&oldestLogPath), Return(true)))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*mockFileWriterPtr, removeAll(_)).Times(0);
+    EXPECT_TRUE(exStorer.publishJson(jsonLogService));
+    EXPECT_TRUE(exStorer.publishJson(jsonLogEntry));
+    EXPECT_TRUE(exStorer.publishJson(jsonLogEntry));
+    ::testing::Mock::VerifyAndClearExpectations(mockFileWriterPtr);
+
+    EXPECT_CALL(*mockFileWriterPtr, removeAll(oldestLogPath))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*mockFileWriterPtr, createFile(_, _)).WillOnce(Return(true));
+    EXPECT_TRUE(exStorer.publishJson(jsonLogEntry));
+}
+
+TEST(ExternalStorerRetentionTest, LogEntriesReapedInBackground)
+{
+    boost::asio::io_context io;
+    auto conn = std::make_shared<sdbusplus::asio::connection>(io);
+    const std::string jsonLogService = R"({
+        "@odata.id": "/redfish/v1/Systems/system/LogServices/6F7-C1A7C",
+        "@odata.type": "#LogService.v1_1_0.LogService","Id":"6F7-C1A7C"})";
+    const std::string jsonLogEntry =
+        R"({"@odata.type": "#LogEntry.v1_13_0.LogEntry"})";
+
+    // Only the newest entry is kept, and one old entry can wait
+    std::vector<std::string> logPaths(3);
+    auto mockFileWriter = std::make_unique<MockFileWriter>("/some/path");
+    MockFileWriter* mockFileWriterPtr = mockFileWriter.get();
+    EXPECT_CALL(*mockFileWriterPtr, createFile(_, _))
+        .WillOnce(Return(true))
+        .WillOnce(Return(true))
+        .WillOnce(DoAll(SaveArg<0>(&logPaths[0]), Return(true)))
+        .WillOnce(DoAll(SaveArg<0>(&logPaths[1]), Return(true)))
+        .WillOnce(DoAll(SaveArg<0>(&logPaths[2]), Return(true)))
+        .WillOnce(Return(true));
+    auto exStorer = std::make_unique<ExternalStorerFileInterface>(
+        conn, "/some/path", std::move(mockFileWriter), 0, 1,
+        std::chrono::milliseconds(0), 0, "", 1);
+    EXPECT_TRUE(exStorer->publishJson(jsonLogService));
+    EXPECT_TRUE(exStorer->publishJson(jsonLogEntry));
+
+    // The reaper gets stuck deleting the first entry, the next entries are
+    // still written
+    std::promise<void> reaping;
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    bool removedInline = false;
+    EXPECT_CALL(*mockFileWriterPtr, removeAll(logPaths[0]))
+        .WillOnce([&](const std::string&) {
+            reaping.set_value();
+            released.wait();
+            return true;
+        });
+    EXPECT_TRUE(exStorer->publishJson(jsonLogEntry));
+    ASSERT_EQ(reaping.get_future().wait_for(std::chrono::seconds(10)),
+              std::future_status::ready);
+
+    // The second entry waits in the backlog
+    EXPECT_CALL(*mockFileWriterPtr, removeAll(logPaths[1]))
+        .WillOnce(Return(true));
+    EXPECT_TRUE(exStorer->publishJson(jsonLogEntry));
+
+    // The backlog is full, the third entry is deleted before writing
+    EXPECT_CALL(*mockFileWriterPtr, removeAll(logPaths[2]))
+        .WillOnce([&](const std::string&) {
+            removedInline = true;
+            return true;
+        });
+    EXPECT_TRUE(exStorer->publishJson(jsonLogEntry));
+    EXPECT_TRUE(removedInline);
+
+    // The backlog is deleted before the storer is gone
+    release.set_value();
+    exStorer.reset();
+}
+
+TEST(ExternalStorerBatchTest, LogEntriesWrittenOnCommit)
+{
+    boost::asio::io_context io;
+    auto conn = std::make_shared<sdbusplus::asio::connection>(io);
+    const std::string jsonLogService = R"({
+        "@odata.id": "/redfish/v1/Systems/system/LogServices/6F7-C1A7C",
+        "@odata.type": "#LogService.v1_1_0.LogService","Id":"6F7-C1A7C"})";
+    const std::string jsonLogEntry =
+        R"({"@odata.type": "#LogEntry.v1_13_0.LogEntry", "Severity": "OK"})";
+
+    // 2 non saved entries
+    auto mockFileWriter = std::make_unique<MockFileWriter>("/some/path");
+    MockFileWriter* mockFileWriterPtr = mockFileWriter.get();
+    ExternalStorerFileInterface exStorer(conn, "/some/path",
+                                         std::move(mockFileWriter), 0, 2);
+    EXPECT_CALL(*mockFileWriterPtr, createFile(_, _))
+        .Times(2)
+        .WillRepeatedly(Return(true));
+    EXPECT_TRUE(exStorer.publishJson(jsonLogService));
+    ::testing::Mock::VerifyAndClearExpectations(mockFileWriterPtr);
+
+    exStorer.beginBatch();
+    for (int i = 0; i < 3; ++i)
+    {
+        EXPECT_TRUE(exStorer.publishJson(jsonLogEntry));
+    }
+    ::testing::Mock::VerifyAndClearExpectations(mockFileWriterPtr);
+
+    // The first entry is already too old to keep, it is never written
+    std::vector<nlohmann::json> written(2);
+    EXPECT_CALL(*mockFileWriterPtr, removeAll(_)).Times(0);
+    EXPECT_CALL(*mockFileWriterPtr, createFile(_, _))
+        .WillOnce(DoAll(SaveJsonParts(&written[0]), Return(true)))
+        .WillOnce(DoAll(SaveJsonParts(&written[1]), Return(true)));
+    EXPECT_TRUE(exStorer.commitBatch());
+    for (const nlohmann::json& entry : written)
+    {
+        EXPECT_EQ(entry["Severity"], "OK");
+        EXPECT_NE(entry["Id"], nullptr);
+    }
+    EXPECT_NE(written[0]["Id"], written[1]["Id"]);
+
+    // Outside of a batch entries are written right away
+    EXPECT_CALL(*mockFileWriterPtr, removeAll(_)).WillOnce(Return(true));
+    EXPECT_CALL(*mockFileWriterPtr, createFile(_, _)).WillOnce(Return(true));
+    EXPECT_TRUE(exStorer.publishJson(jsonLogEntry));
+}
+
+TEST(ExternalStorerBatchTest, LogServiceCommitsStagedEntries)
+{
+    boost::asio::io_context io;
+    auto conn = std::make_shared<sdbusplus::asio::connection>(io);
+    const std::string jsonLogService1 = R"({
+        "@odata.id": "/redfish/v1/Systems/system/LogServices/1",
+        "@odata.type": "#LogService.v1_1_0.LogService","Id":"1"})";
+    const std::string jsonLogService2 = R"({
+        "@odata.id": "/redfish/v1/Systems/system/LogServices/2",
+        "@odata.type": "#LogService.v1_1_0.LogService","Id":"2"})";
+    const std::string jsonLogEntry =
+        R"({"@odata.type": "#LogEntry.v1_13_0.LogEntry"})";
+
+    auto mockFileWriter = std::make_unique<MockFileWriter>("/some/path");
+    MockFileWriter* mockFileWriterPtr = mockFileWriter.get();
+    ExternalStorerFileInterface exStorer(conn, "/some/path",
+                                         std::move(mockFileWriter));
+    {
+        InSequence s;
+        EXPECT_CALL(*mockFileWriterPtr,
+                    createFile(HasSubstr("LogServices/1"), _))
+            .Times(2)
+            .WillRepeatedly(Return(true));
+        // The entry staged under LogService 1 is written before switching
+        EXPECT_CALL(*mockFileWriterPtr,
+                    createFile(HasSubstr("LogServices/1/Entries/"), _))
+            .WillOnce(Return(true));
+        EXPECT_CALL(*mockFileWriterPtr,
+                    createFile(HasSubstr("LogServices/2"), _))
+            .Times(2)
+            .WillRepeatedly(Return(true));
+        EXPECT_CALL(*mockFileWriterPtr,
+                    createFile(HasSubstr("LogServices/2/Entries/"), _))
+            .WillOnce(Return(true));
+    }
+    EXPECT_TRUE(exStorer.publishJson(jsonLogService1));
+    exStorer.beginBatch();
+    EXPECT_TRUE(exStorer.publishJson(jsonLogEntry));
+    EXPECT_TRUE(exStorer.publishJson(jsonLogService2));
+    EXPECT_TRUE(exStorer.publishJson(jsonLogEntry));
+    EXPECT_TRUE(exStorer.commitBatch());
+}
+
 TEST_F(ExternalStorerFileTest, OtherSchemaNoOdataIdTest)
 {
     // Try a another PDRs without @odata.id.
@@ -351,9 +787,225 @@ TEST_F(ExternalStorerFileTest, OtherSchemaTypeTest)
     std::string exFolder =
         "/redfish/v1/Systems/system/Memory/dimm0/MemoryMetrics";
     nlohmann::json exJson = nlohmann::json::parse(jsonStr);
-    EXPECT_CALL(*mockFileWriterPtr, createFile(exFolder, exJson))
+    EXPECT_CALL(*mockFileWriterPtr, createFile(exFolder, JsonPartsEq(exJson)))
+        .WillOnce(Return(true));
+    EXPECT_THAT(exStorer->publishJson(jsonStr), true);
+}
+
+TEST_F(ExternalStorerFileTest, OdataTypeNotStringTest)
+{
+    std::string jsonStr = R"(
+      {
+        "@odata.id": "/redfish/v1/Systems/system/Memory/dimm0/MemoryMetrics",
+        "@odata.type": 5
+      }
+    )";
+    EXPECT_THAT(exStorer->publishJson(jsonStr), false);
+}
+
+TEST_F(ExternalStorerFileTest, OtherSchemaEscapedOdataIdTest)
+{
+    // The path is used with its escapes resolved, the content is written as is
+    std::string jsonStr = R"(
+      {
+        "@odata.id": "\/redfish\/v1\/Systems\/system\/Memory",
+        "@odata.type": "#MemoryCollection.MemoryCollection"
+      }
+    )";
+    EXPECT_CALL(*mockFileWriterPtr,
+                createFile("/redfish/v1/Systems/system/Memory",
+                           JsonPartsEq(nlohmann::json::parse(jsonStr))))
+        .WillOnce(Return(true));
+    EXPECT_THAT(exStorer->publishJson(jsonStr), true);
+}
+
+TEST_F(ExternalStorerFileTest, LogEntryKeepsOtherFieldsTest)
+{
+    std::string jsonLogSerivce = R"(
+      {
+        "@odata.id": "/redfish/v1/Systems/system/LogServices/6F7-C1A7C",
+        "@odata.type": "#LogService.v1_1_0.LogService","Id":"6F7-C1A7C"
+      }
+    )";
+    EXPECT_CALL(*mockFileWriterPtr, createFile(_, _))
+        .Times(2)
+        .WillRepeatedly(Return(true));
+    EXPECT_THAT(exStorer->publishJson(jsonLogSerivce), true);
+
+    std::string jsonLogEntry = R"(
+      {
+        "@odata.id": "/some/odata/id",
+        "Id": "0",
+        "@odata.type": "#LogEntry.v1_13_0.LogEntry",
+        "Severity": "Critical",
+        "Oem": {"@odata.id": "/kept", "Id": 7, "List": [1, 2.5e3, null]}
+      }
+    )";
+    nlohmann::json logEntryOut;
+    std::string logPath;
+    EXPECT_CALL(*mockFileWriterPtr, createFile(_, _))
+        .WillOnce(DoAll(SaveArg<0>(&logPath), SaveJsonParts(&logEntryOut),
+                        Return(true)));
+    EXPECT_THAT(exStorer->publishJson(jsonLogEntry), true);
+
+    nlohmann::json expected = nlohmann::json::parse(jsonLogEntry);
+    expected.erase("@odata.id");
+    expected["Id"] = logPath.substr(logPath.rfind('/') + 1);
+    EXPECT_EQ(logEntryOut, expected);
+}
+
+TEST_F(ExternalStorerFileTest, OtherSchemaSkipsIdenticalTest)
+{
+    std::string jsonStr = R"({"@odata.id": "/counter",)"
+                          R"("@odata.type": "#Counter.Counter","Count": 1})";
+    std::string updatedJsonStr =
+        R"({"@odata.id": "/counter",)"
+        R"("@odata.type": "#Counter.Counter","Count": 2})";
+    InSequence s;
+    EXPECT_CALL(*mockFileWriterPtr, createFile("/counter", _))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*mockFileWriterPtr,
+                createFile("/counter", JsonPartsEq(nlohmann::json::parse(
+                                           updatedJsonStr))))
         .WillOnce(Return(true));
     EXPECT_THAT(exStorer->publishJson(jsonStr), true);
+    // Same content as on disk, not written again
+    EXPECT_THAT(exStorer->publishJson(jsonStr), true);
+    EXPECT_THAT(exStorer->publishJson(updatedJsonStr), true);
+}
+
+class ExternalStorerCounterCacheTest : public ::testing::Test
+{
+  public:
+    ExternalStorerCounterCacheTest() :
+        conn(std::make_shared<sdbusplus::asio::connection>(io))
+    {}
+
+  protected:
+    // Counters are only written when flushed by the test, unless an interval
+    // is given
+    void createStorer(std::chrono::milliseconds counterFlushInterval =
+                          std::chrono::hours(1))
+    {
+        auto mockFileWriter = std::make_unique<MockFileWriter>(rootPath);
+        mockFileWriterPtr = mockFileWriter.get();
+        exStorer = std::make_unique<ExternalStorerFileInterface>(
+            conn, rootPath, std::move(mockFileWriter), 1, 2,
+            counterFlushInterval);
+    }
+
+    static std::string counterJson(int count,
+                                   std::string_view path = "/counter")
+    {
+        return std::format(R"({{"@odata.id": "{}",)"
+                           R"("@odata.type": "#Counter.Counter",)"
+                           R"("Count": {}}})",
+                           path, count);
+    }
+
+    boost::asio::io_context io;
+    std::shared_ptr<sdbusplus::asio::connection> conn;
+    std::unique_ptr<ExternalStorerFileInterface> exStorer;
+    MockFileWriter* mockFileWriterPtr;
+    const std::string rootPath = "/some/path";
+};
+
+TEST_F(ExternalStorerCounterCacheTest, KeepsLatestUpdate)
+{
+    createStorer();
+    EXPECT_CALL(*mockFileWriterPtr, createFile(_, _)).Times(0);
+    for (int count = 0; count < 10; ++count)
+    {
+        EXPECT_THAT(exStorer->publishJson(counterJson(count)), true);
+    }
+    ::testing::Mock::VerifyAndClearExpectations(mockFileWriterPtr);
+
+    EXPECT_CALL(*mockFileWriterPtr,
+                createFile("/counter", JsonPartsEq(nlohmann::json::parse(
+                                           counterJson(9)))))
+        .WillOnce(Return(true));
+    exStorer->flushCounters();
+    // Nothing left to write
+    exStorer->flushCounters();
+}
+
+TEST_F(ExternalStorerCounterCacheTest, SkipsContentOnDisk)
+{
+    createStorer();
+    EXPECT_CALL(*mockFileWriterPtr, createFile("/counter", _))
+        .WillOnce(Return(true));
+    EXPECT_THAT(exStorer->publishJson(counterJson(1)), true);
+    exStorer->flushCounters();
+
+    // Updated and put back before the flush, or the same update again
+    EXPECT_THAT(exStorer->publishJson(counterJson(2)), true);
+    EXPECT_THAT(exStorer->publishJson(counterJson(1)), true);
+    exStorer->flushCounters();
+    EXPECT_THAT(exStorer->publishJson(counterJson(1)), true);
+    exStorer->flushCounters();
+}
+
+TEST_F(ExternalStorerCounterCacheTest, FailedWriteIsRetriedOnUpdate)
+{
+    createStorer();
+    InSequence s;
+    EXPECT_CALL(*mockFileWriterPtr, createFile("/counter", _))
+        .WillOnce(Return(false));
+    EXPECT_CALL(*mockFileWriterPtr, createFile("/counter", _))
+        .WillOnce(Return(true));
+    EXPECT_THAT(exStorer->publishJson(counterJson(1)), true);
+    exStorer->flushCounters();
+    // Nothing made it to disk, so the same content is still written
+    EXPECT_THAT(exStorer->publishJson(counterJson(1)), true);
+    exStorer->flushCounters();
+}
+
+TEST_F(ExternalStorerCounterCacheTest, CacheIsBounded)
+{
+    createStorer();
+    // The cache is full of counters waiting to be written, one more is
+    // written right away
+    EXPECT_CALL(*mockFileWriterPtr, createFile("/counters/256", _))
+        .WillOnce(Return(true));
+    for (int i = 0; i <= 256; ++i)
+    {
+        EXPECT_THAT(exStorer->publishJson(
+                        counterJson(1, std::format("/counters/{}", i))),
+                    true);
+    }
+    ::testing::Mock::VerifyAndClearExpectations(mockFileWriterPtr);
+
+    EXPECT_CALL(*mockFileWriterPtr, createFile(_, _))
+        .Times(256)
+        .WillRepeatedly(Return(true));
+    exStorer->flushCounters();
+    ::testing::Mock::VerifyAndClearExpectations(mockFileWriterPtr);
+
+    // Once written, a counter is forgotten to make room for a new one
+    EXPECT_THAT(exStorer->publishJson(counterJson(1, "/counters/257")), true);
+    EXPECT_CALL(*mockFileWriterPtr, createFile("/counters/257", _))
+        .WillOnce(Return(true));
+    exStorer->flushCounters();
+}
+
+TEST_F(ExternalStorerCounterCacheTest, FlushesOnDestruction)
+{
+    createStorer();
+    EXPECT_CALL(*mockFileWriterPtr, createFile("/counter", _))
+        .WillOnce(Return(true));
+    EXPECT_THAT(exStorer->publishJson(counterJson(1)), true);
+    exStorer.reset();
+}
+
+TEST_F(ExternalStorerCounterCacheTest, FlushesOnInterval)
+{
+    createStorer(std::chrono::milliseconds(10));
+    std::promise<void> written;
+    EXPECT_CALL(*mockFileWriterPtr, createFile("/counter", _))
+        .WillOnce(DoAll([&written]() { written.set_value(); }, Return(true)));
+    EXPECT_THAT(exStorer->publishJson(counterJson(1)), true);
+    EXPECT_EQ(written.get_future().wait_for(std::chrono::seconds(10)),
+              std::future_status::ready);
 }
 
 } // namespace rde
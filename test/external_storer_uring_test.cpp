@@ -0,0 +1,195 @@
+#include "rde/external_storer_uring.hpp"
+
+#include <unistd.h>
+
+#include <boost/asio/io_context.hpp>
+
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace rde
+{
+namespace
+{
+
+class ExternalStorerUringWriterTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        baseDir = std::filesystem::temp_directory_path() /
+                  ("uring_test_dir." + std::to_string(::getpid()));
+        std::filesystem::remove_all(baseDir);
+        try
+        {
+            fileWriter = std::make_unique<ExternalStorerUringWriter>(
+                io, baseDir.string());
+        }
+        catch (const std::runtime_error& e)
+        {
+            GTEST_SKIP() << e.what();
+        }
+    }
+
+    void TearDown() override
+    {
+        fileWriter.reset();
+        std::filesystem::remove_all(baseDir);
+    }
+
+    /** @brief Flush and run the io_context until the writer is done */
+    void flushAndWait()
+    {
+        bool done = false;
+        fileWriter->flush([&done]() { done = true; });
+        while (!done)
+        {
+            io.run_one();
+        }
+    }
+
+    std::string readIndexFile(const std::filesystem::path& folder)
+    {
+        std::ifstream file(baseDir / folder / "index.json");
+        std::stringstream content;
+        content << file.rdbuf();
+        return content.str();
+    }
+
+    boost::asio::io_context io;
+    std::filesystem::path baseDir;
+    std::unique_ptr<ExternalStorerUringWriter> fileWriter;
+};
+
+TEST_F(ExternalStorerUringWriterTest, CreateFileWritesParts)
+{
+    const std::array<std::string_view, 3> jsonParts = {
+        R"({"key":)", R"("value")", "}"};
+    EXPECT_TRUE(fileWriter->createFile("/LogServices/a/Entries/1", jsonParts));
+    flushAndWait();
+    EXPECT_EQ(readIndexFile("LogServices/a/Entries/1"), R"({"key":"value"})");
+}
+
+TEST_F(ExternalStorerUringWriterTest, CreateFileTraversalFail)
+{
+    const std::array<std::string_view, 1> json = {"{}"};
+    EXPECT_FALSE(fileWriter->createFile("../invalid_file", json));
+    EXPECT_FALSE(fileWriter->removeAll("../invalid_file"));
+}
+
+TEST_F(ExternalStorerUringWriterTest, CallsForAPathAreInOrder)
+{
+    for (int i = 0; i < 5; ++i)
+    {
+        const std::string json = std::to_string(i);
+        const std::array<std::string_view, 1> parts = {json};
+        EXPECT_TRUE(fileWriter->createFile("counter", parts));
+    }
+    flushAndWait();
+    EXPECT_EQ(readIndexFile("counter"), "4");
+
+    // Removed before it is created again
+    const std::array<std::string_view, 1> json = {"{}"};
+    EXPECT_TRUE(fileWriter->removeAll("counter"));
+    EXPECT_TRUE(fileWriter->createFile("counter", json));
+    EXPECT_TRUE(fileWriter->removeAll("entry"));
+    flushAndWait();
+    EXPECT_EQ(readIndexFile("counter"), "{}");
+}
+
+TEST_F(ExternalStorerUringWriterTest, ManyFilesAtOnce)
+{
+    // More files than there are fixed file slots
+    std::vector<std::string> jsons;
+    for (int i = 0; i < 100; ++i)
+    {
+        jsons.push_back(std::format(R"({{"Id":"{}"}})", i));
+        const std::array<std::string_view, 1> parts = {jsons.back()};
+        EXPECT_TRUE(fileWriter->createFile(
+            std::format("Entries/{}", i), parts));
+    }
+    flushAndWait();
+    for (int i = 0; i < 100; ++i)
+    {
+        EXPECT_EQ(readIndexFile(std::format("Entries/{}", i)), jsons[i]);
+    }
+}
+
+TEST_F(ExternalStorerUringWriterTest, RemoveAll)
+{
+    const std::array<std::string_view, 1> json = {"{}"};
+    EXPECT_TRUE(fileWriter->createFile("Entries/1", json));
+    EXPECT_TRUE(fileWriter->createFile("Entries/2", json));
+    EXPECT_TRUE(fileWriter->createFile("Entries/2/nested", json));
+    flushAndWait();
+
+    EXPECT_TRUE(fileWriter->removeAll("Entries/1"));
+    // Holds more than an index.json
+    EXPECT_TRUE(fileWriter->removeAll("Entries/2"));
+    // Nothing to remove
+    EXPECT_TRUE(fileWriter->removeAll("Entries/3"));
+    flushAndWait();
+    EXPECT_FALSE(std::filesystem::exists(baseDir / "Entries" / "1"));
+    EXPECT_FALSE(std::filesystem::exists(baseDir / "Entries" / "2"));
+    EXPECT_TRUE(std::filesystem::is_directory(baseDir / "Entries"));
+}
+
+TEST_F(ExternalStorerUringWriterTest, RemoveAllOfBaseDir)
+{
+    const std::array<std::string_view, 1> json = {"{}"};
+    EXPECT_TRUE(fileWriter->createFile("Entries/1", json));
+    flushAndWait();
+
+    // Only the worker takes part, the flush callback still runs on the
+    // io_context
+    EXPECT_TRUE(fileWriter->removeAll(""));
+    flushAndWait();
+    EXPECT_FALSE(std::filesystem::exists(baseDir / "Entries"));
+}
+
+TEST_F(ExternalStorerUringWriterTest, CreateFileAfterExternalRemoval)
+{
+    const std::array<std::string_view, 1> json = {"{}"};
+    EXPECT_TRUE(fileWriter->createFile("LogServices/a/Entries/1", json));
+    flushAndWait();
+
+    std::filesystem::remove_all(baseDir / "LogServices");
+    EXPECT_TRUE(fileWriter->createFile("LogServices/a/Entries/2", json));
+    flushAndWait();
+    EXPECT_EQ(readIndexFile("LogServices/a/Entries/2"), "{}");
+}
+
+TEST_F(ExternalStorerUringWriterTest, DestructorWaitsForWrites)
+{
+    const std::array<std::string_view, 1> json = {"{}"};
+    EXPECT_TRUE(fileWriter->createFile("Entries/1", json));
+    fileWriter->flush();
+    EXPECT_TRUE(fileWriter->createFile("Entries/2", json));
+    // Never submitted or reaped on the io_context
+    fileWriter.reset();
+    EXPECT_EQ(readIndexFile("Entries/1"), "{}");
+    EXPECT_EQ(readIndexFile("Entries/2"), "{}");
+}
+
+TEST_F(ExternalStorerUringWriterTest, DestructorWaitsForWorker)
+{
+    const std::array<std::string_view, 1> json = {"{}"};
+    // The parents are created by the worker before the chain is queued
+    EXPECT_TRUE(fileWriter->createFile("LogServices/a/Entries/1", json));
+    fileWriter.reset();
+    EXPECT_EQ(readIndexFile("LogServices/a/Entries/1"), "{}");
+}
+
+} // namespace
+} // namespace rde
+} // namespace bios_bmc_smm_error_logger
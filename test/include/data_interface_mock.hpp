@@ -1,6 +1,7 @@
 #pragma once
 #include "data_interface.hpp"
 
+#include <algorithm>
 #include <cstdint>
 #include <span>
 #include <vector>
@@ -15,10 +16,23 @@ class DataInterfaceMock : public DataInterface
   public:
     MOCK_METHOD(std::vector<uint8_t>, read,
                 (const uint32_t offset, const uint32_t length), (override));
+    MOCK_METHOD(uint32_t, readInto,
+                (const uint32_t offset, std::span<uint8_t> bytes), (override));
     MOCK_METHOD(uint32_t, write,
                 (const uint32_t offset, const std::span<const uint8_t> bytes),
                 (override));
     MOCK_METHOD(uint32_t, getMemoryRegionSize, (), (override));
 };
 
+/**
+ * Action for DataInterfaceMock::readInto, copies up to the requested number of
+ * bytes from `bytes` into the destination and returns the number copied.
+ */
+ACTION_P(ReadIntoBytes, bytes)
+{
+    const size_t length = std::min<size_t>(bytes.size(), arg1.size());
+    std::copy_n(bytes.begin(), length, arg1.begin());
+    return static_cast<uint32_t>(length);
+}
+
 } // namespace bios_bmc_smm_error_logger
@@ -0,0 +1,140 @@
+#pragma once
+#include "buffer.hpp"
+#include "fake_data_interface.hpp"
+
+#include <boost/endian/arithmetic.hpp>
+#include <boost/endian/conversion.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace bios_bmc_smm_error_logger
+{
+
+/**
+ * Test fixture where the test plays BIOS, writing entries into a
+ * FakeDataInterface that is drained by a real BufferImpl
+ */
+class FakeBiosTest : public ::testing::Test
+{
+  protected:
+    FakeBiosTest()
+    {
+        auto fakeDataInterfacePtr =
+            std::make_unique<FakeDataInterface>(testRegionSize);
+        fakeDataInterface = fakeDataInterfacePtr.get();
+        bufferImpl =
+            std::make_unique<BufferImpl>(std::move(fakeDataInterfacePtr));
+        bufferImpl->initialize(testBmcInterfaceVersion, testQueueSize,
+                               testUeRegionSize, testMagicNumber);
+    }
+
+    // Append an entry to the queue the way BIOS would
+    // @return offset of the entry relative to the queue
+    uint32_t writeEntry(uint16_t sequenceId, size_t entrySize)
+    {
+        struct QueueEntryHeader entryHeader{};
+        entryHeader.sequenceId = boost::endian::native_to_little(sequenceId);
+        entryHeader.entrySize =
+            boost::endian::native_to_little(static_cast<uint16_t>(entrySize));
+        entryHeader.rdeCommandType = 0x1;
+
+        const uint8_t* entryHeaderPtr =
+            reinterpret_cast<const uint8_t*>(&entryHeader);
+        std::vector<uint8_t> bytes(entryHeaderPtr,
+                                   entryHeaderPtr + entryHeaderSize);
+        for (size_t i = 0; i < entrySize; ++i)
+        {
+            bytes.push_back(static_cast<uint8_t>(sequenceId + i));
+        }
+        bytes[offsetof(struct QueueEntryHeader, checksum)] = std::accumulate(
+            bytes.begin(), bytes.end(), 0, std::bit_xor<void>());
+
+        const uint32_t entryOffset = biosWritePtr();
+        for (size_t i = 0; i < bytes.size(); ++i)
+        {
+            queueByte(entryOffset + i) = bytes[i];
+        }
+        setBiosWritePtr((entryOffset + bytes.size()) % testMaxOffset);
+        return entryOffset;
+    }
+
+    // Toggle the BIOS side overflow flag, as BIOS does when the queue is full
+    void signalOverflow()
+    {
+        header().biosFlags =
+            boost::endian::little_to_native(header().biosFlags) ^
+            static_cast<uint32_t>(BufferFlags::overflow);
+    }
+
+    uint8_t& queueByte(uint32_t relativeOffset)
+    {
+        return fakeDataInterface
+            ->memory[testQueueOffset + relativeOffset % testMaxOffset];
+    }
+
+    struct CircularBufferHeader& header()
+    {
+        return *reinterpret_cast<struct CircularBufferHeader*>(
+            fakeDataInterface->memory.data());
+    }
+
+    uint32_t biosWritePtr()
+    {
+        return boost::endian::little_to_native(header().biosWritePtr);
+    }
+
+    void setBiosWritePtr(uint32_t writePtr)
+    {
+        header().biosWritePtr = boost::endian::native_to_little(writePtr);
+    }
+
+    uint32_t bmcReadPtr()
+    {
+        return boost::endian::little_to_native(header().bmcReadPtr);
+    }
+
+    // Drain the queue the way the read loop does
+    // @return the sequence IDs of the entries drained
+    std::vector<uint16_t> drain()
+    {
+        std::vector<uint16_t> sequenceIds;
+        if (bufferImpl->poll().queueBytesPending == 0)
+        {
+            return sequenceIds;
+        }
+        for (const auto& [entryHeader, entry] :
+             bufferImpl->readPendingErrorLogs())
+        {
+            sequenceIds.push_back(
+                boost::endian::little_to_native(entryHeader.sequenceId));
+            bufferImpl->markEntryConsumed();
+        }
+        bufferImpl->commitReadPtr();
+        return sequenceIds;
+    }
+
+    static constexpr size_t testRegionSize = 0x200;
+    static constexpr uint32_t testBmcInterfaceVersion = 123;
+    static constexpr uint16_t testQueueSize = 0x200;
+    static constexpr uint16_t testUeRegionSize = 0x50;
+    static constexpr std::array<uint32_t, 4> testMagicNumber = {
+        0x12345678, 0x22345678, 0x32345678, 0x42345678};
+    static constexpr size_t testQueueOffset =
+        sizeof(struct CircularBufferHeader) + testUeRegionSize;
+    static constexpr size_t testMaxOffset = testQueueSize - testQueueOffset;
+    static constexpr size_t entryHeaderSize = sizeof(struct QueueEntryHeader);
+    static constexpr size_t testEntrySize = 0x20;
+
+    FakeDataInterface* fakeDataInterface;
+    std::unique_ptr<BufferImpl> bufferImpl;
+};
+
+} // namespace bios_bmc_smm_error_logger
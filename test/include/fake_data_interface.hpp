@@ -0,0 +1,64 @@
+#pragma once
+#include "data_interface.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace bios_bmc_smm_error_logger
+{
+
+/**
+ * DataInterface backed by plain memory. Unlike DataInterfaceMock, the tests
+ * get to play the BIOS side of the buffer by editing `memory` directly.
+ */
+class FakeDataInterface : public DataInterface
+{
+  public:
+    explicit FakeDataInterface(uint32_t regionSize) : memory(regionSize, 0) {}
+
+    std::vector<uint8_t> read(const uint32_t offset,
+                              const uint32_t length) override
+    {
+        std::vector<uint8_t> bytes(length);
+        bytes.resize(readInto(offset, bytes));
+        return bytes;
+    }
+
+    uint32_t readInto(const uint32_t offset, std::span<uint8_t> bytes) override
+    {
+        if (offset > memory.size())
+        {
+            return 0;
+        }
+        const size_t length = std::min(bytes.size(), memory.size() - offset);
+        std::copy_n(memory.begin() + offset, length, bytes.begin());
+        return length;
+    }
+
+    uint32_t write(const uint32_t offset,
+                   const std::span<const uint8_t> bytes) override
+    {
+        if (offset > memory.size())
+        {
+            return 0;
+        }
+        const size_t length = std::min(bytes.size(), memory.size() - offset);
+        std::copy_n(bytes.begin(), length, memory.begin() + offset);
+        ++numWrites;
+        bytesWritten += length;
+        return length;
+    }
+
+    uint32_t getMemoryRegionSize() override
+    {
+        return memory.size();
+    }
+
+    std::vector<uint8_t> memory;
+    size_t numWrites = 0;
+    size_t bytesWritten = 0;
+};
+
+} // namespace bios_bmc_smm_error_logger
@@ -0,0 +1,132 @@
+#include "rde/json_scanner.hpp"
+
+#include <string>
+#include <string_view>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace rde
+{
+namespace
+{
+
+using ::testing::Optional;
+
+TEST(JsonObjectScannerTest, TopLevelMembers)
+{
+    JsonObjectScanner scanner;
+    constexpr std::string_view json = R"( {"@odata.id" : "/a/b", "Id":"0",
+        "Nested": {"Id": "inner", "List": [{"Id": 1}, "x"]}, "Number": -1.5e+3,
+        "Flags": [true, false, null]} )";
+    ASSERT_TRUE(scanner.scan(json));
+
+    const auto& members = scanner.getMembers();
+    ASSERT_EQ(members.size(), 5U);
+    EXPECT_EQ(members[0].key, "@odata.id");
+    EXPECT_EQ(members[0].value, R"("/a/b")");
+    EXPECT_EQ(members[0].text, R"("@odata.id" : "/a/b")");
+    EXPECT_EQ(members[1].key, "Id");
+    EXPECT_EQ(members[2].key, "Nested");
+    EXPECT_EQ(members[2].value,
+              R"({"Id": "inner", "List": [{"Id": 1}, "x"]})");
+    EXPECT_EQ(members[3].value, "-1.5e+3");
+    EXPECT_EQ(members[4].value, "[true, false, null]");
+
+    // Only top level members are found
+    EXPECT_EQ(scanner.find("List"), nullptr);
+    EXPECT_THAT(JsonObjectScanner::getString(scanner.find("Id")),
+                Optional(std::string("0")));
+}
+
+TEST(JsonObjectScannerTest, EmptyObject)
+{
+    JsonObjectScanner scanner;
+    ASSERT_TRUE(scanner.scan("{}"));
+    EXPECT_TRUE(scanner.getMembers().empty());
+    EXPECT_EQ(scanner.find("Id"), nullptr);
+}
+
+TEST(JsonObjectScannerTest, MembersAreReplacedOnScan)
+{
+    JsonObjectScanner scanner;
+    ASSERT_TRUE(scanner.scan(R"({"a": 1, "b": 2})"));
+    ASSERT_TRUE(scanner.scan(R"({"c": 3})"));
+    ASSERT_EQ(scanner.getMembers().size(), 1U);
+    EXPECT_EQ(scanner.getMembers()[0].key, "c");
+}
+
+TEST(JsonObjectScannerTest, RepeatedKeyLastWins)
+{
+    JsonObjectScanner scanner;
+    ASSERT_TRUE(scanner.scan(R"({"Id": "first", "Id": "second"})"));
+    EXPECT_THAT(JsonObjectScanner::getString(scanner.find("Id")),
+                Optional(std::string("second")));
+}
+
+TEST(JsonObjectScannerTest, GetStringResolvesEscapes)
+{
+    JsonObjectScanner scanner;
+    ASSERT_TRUE(scanner.scan(
+        R"({"a": "\/x\\y\"z\n\t", "b": "\u00e9\u20ac\ud83d\ude00"})"));
+    EXPECT_THAT(JsonObjectScanner::getString(scanner.find("a")),
+                Optional(std::string("/x\\y\"z\n\t")));
+    EXPECT_THAT(JsonObjectScanner::getString(scanner.find("b")),
+                Optional(std::string("\u00e9\u20ac\U0001F600")));
+}
+
+TEST(JsonObjectScannerTest, GetStringNotAString)
+{
+    JsonObjectScanner scanner;
+    ASSERT_TRUE(scanner.scan(R"({"a": 5, "b": {"c": "d"}, "e": null})"));
+    EXPECT_EQ(JsonObjectScanner::getString(scanner.find("a")), std::nullopt);
+    EXPECT_EQ(JsonObjectScanner::getString(scanner.find("b")), std::nullopt);
+    EXPECT_EQ(JsonObjectScanner::getString(scanner.find("e")), std::nullopt);
+    EXPECT_EQ(JsonObjectScanner::getString(nullptr), std::nullopt);
+}
+
+TEST(JsonObjectScannerTest, MalformedFail)
+{
+    JsonObjectScanner scanner;
+    for (std::string_view json : {
+             "",
+             "Invalid JSON",
+             "[1, 2]",
+             R"("string")",
+             "{",
+             R"({"a": 1)",
+             R"({"a" 1})",
+             R"({"a": 1,})",
+             R"({"a": 1 "b": 2})",
+             R"({a: 1})",
+             R"({"a": [1, 2})",
+             R"({"a": tru})",
+             R"({"a": 01})",
+             R"({"a": 1.})",
+             R"({"a": -})",
+             R"({"a": "\x"})",
+             R"({"a": "\u12"})",
+             "{\"a\": \"line\nbreak\"}",
+             R"({"a": 1} trailing)",
+             R"({"a": 1}{"b": 2})",
+         })
+    {
+        EXPECT_FALSE(scanner.scan(json)) << json;
+    }
+}
+
+TEST(JsonObjectScannerTest, DeepNestingFail)
+{
+    JsonObjectScanner scanner;
+    std::string json = R"({"a": )";
+    json.append(1000, '[');
+    json.append(1000, ']');
+    json += "}";
+    EXPECT_FALSE(scanner.scan(json));
+}
+
+} // namespace
+} // namespace rde
+} // namespace bios_bmc_smm_error_logger
@@ -0,0 +1,280 @@
+#include "rde/log_entry_index.hpp"
+
+#include <unistd.h>
+
+#include <boost/uuid/uuid_generators.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace rde
+{
+namespace
+{
+
+using ::testing::IsEmpty;
+using ::testing::Optional;
+
+class LogEntryRetentionIndexTest : public ::testing::Test
+{
+  protected:
+    LogEntryRetentionIndexTest() :
+        path(std::filesystem::temp_directory_path() /
+             ("log_entry_index_test." + std::to_string(::getpid())))
+    {
+        std::filesystem::remove(path);
+    }
+
+    ~LogEntryRetentionIndexTest() override
+    {
+        std::filesystem::remove(path);
+    }
+
+    /** @brief Add an entry after making room for it, as the storer does */
+    boost::uuids::uuid
+        addEntry(LogEntryRetentionIndex& index, const std::string& logServiceId,
+                 uint32_t size,
+                 std::vector<RetainedLogEntry>* evicted = nullptr)
+    {
+        while (std::optional<RetainedLogEntry> oldest =
+                   index.getNextEviction(logServiceId, size))
+        {
+            index.evict(*oldest);
+            if (evicted != nullptr)
+            {
+                evicted->push_back(*oldest);
+            }
+        }
+        const boost::uuids::uuid id = randomGen();
+        index.add(id, logServiceId, size);
+        return id;
+    }
+
+    static std::vector<boost::uuids::uuid>
+        getIds(const std::vector<RetainedLogEntry>& entries)
+    {
+        std::vector<boost::uuids::uuid> ids;
+        for (const RetainedLogEntry& entry : entries)
+        {
+            ids.push_back(entry.id);
+        }
+        return ids;
+    }
+
+    const std::filesystem::path path;
+    boost::uuids::random_generator randomGen;
+};
+
+TEST_F(LogEntryRetentionIndexTest, KeepsSavedAndNewest)
+{
+    LogEntryRetentionIndex index("", 2, 3, 0);
+    std::vector<boost::uuids::uuid> ids;
+    for (int i = 0; i < 5; ++i)
+    {
+        ids.push_back(addEntry(index, "service", 100));
+    }
+    EXPECT_EQ(index.getNextEviction("service", 100)->id, ids[2]);
+
+    std::vector<RetainedLogEntry> evicted;
+    ids.push_back(addEntry(index, "service", 100, &evicted));
+    ASSERT_EQ(evicted.size(), 1U);
+    EXPECT_EQ(evicted[0].id, ids[2]);
+    EXPECT_EQ(evicted[0].logServiceId, "service");
+    EXPECT_FALSE(evicted[0].saved);
+
+    std::vector<RetainedLogEntry> entries = index.getEntries();
+    EXPECT_EQ(getIds(entries), (std::vector<boost::uuids::uuid>{
+                                   ids[0], ids[1], ids[3], ids[4], ids[5]}));
+    EXPECT_TRUE(entries[0].saved);
+    EXPECT_TRUE(entries[1].saved);
+    EXPECT_FALSE(entries[2].saved);
+    EXPECT_EQ(index.getNumEntries(), 5U);
+    EXPECT_EQ(index.getTotalSize(), 500U);
+}
+
+TEST_F(LogEntryRetentionIndexTest, EvictsToStayWithinBytes)
+{
+    LogEntryRetentionIndex index("", 1, 10, 1000);
+    const boost::uuids::uuid saved = addEntry(index, "service", 400);
+    const boost::uuids::uuid first = addEntry(index, "service", 300);
+    const boost::uuids::uuid second = addEntry(index, "service", 200);
+
+    // 1000 bytes are in use, two entries have to go for a 500 byte one
+    std::vector<RetainedLogEntry> evicted;
+    const boost::uuids::uuid third = addEntry(index, "service", 500, &evicted);
+    EXPECT_EQ(getIds(evicted),
+              (std::vector<boost::uuids::uuid>{first, second}));
+    EXPECT_EQ(getIds(index.getEntries()),
+              (std::vector<boost::uuids::uuid>{saved, third}));
+    EXPECT_EQ(index.getTotalSize(), 900U);
+}
+
+TEST_F(LogEntryRetentionIndexTest, SavedEntriesAreNotEvictedForBytes)
+{
+    LogEntryRetentionIndex index("", 2, 10, 100);
+    addEntry(index, "service", 100);
+    // Over the limit, but there is nothing that can be evicted
+    EXPECT_EQ(index.getNextEviction("service", 100), std::nullopt);
+    addEntry(index, "service", 100);
+    EXPECT_EQ(index.getTotalSize(), 200U);
+}
+
+TEST_F(LogEntryRetentionIndexTest, EvictsForLogServiceSlot)
+{
+    LogEntryRetentionIndex index("", 0, 100, 0);
+    std::vector<boost::uuids::uuid> ids;
+    for (size_t i = 0; i < LogEntryRetentionIndex::maxLogServices; ++i)
+    {
+        ids.push_back(addEntry(index, "service" + std::to_string(i), 100));
+    }
+    // Known LogServices need no slot
+    EXPECT_EQ(index.getNextEviction("service0", 100), std::nullopt);
+
+    std::vector<RetainedLogEntry> evicted;
+    addEntry(index, "new", 100, &evicted);
+    ASSERT_EQ(evicted.size(), 1U);
+    EXPECT_EQ(evicted[0].id, ids[0]);
+    EXPECT_EQ(evicted[0].logServiceId, "service0");
+    EXPECT_EQ(index.getEntries().back().logServiceId, "new");
+    EXPECT_EQ(index.getEntries().front().logServiceId, "service1");
+}
+
+TEST_F(LogEntryRetentionIndexTest, LogServiceSlotKeepsSavedEntries)
+{
+    LogEntryRetentionIndex index("", 1, 100, 0);
+    const boost::uuids::uuid saved = addEntry(index, "service0", 100);
+    std::vector<boost::uuids::uuid> ids;
+    for (size_t i = 1; i < LogEntryRetentionIndex::maxLogServices; ++i)
+    {
+        ids.push_back(addEntry(index, "service" + std::to_string(i), 100));
+        if (i != 3)
+        {
+            addEntry(index, "service" + std::to_string(i), 100);
+        }
+    }
+
+    // Not the oldest entry, the LogService with the fewest entries goes
+    std::vector<RetainedLogEntry> evicted;
+    addEntry(index, "new", 100, &evicted);
+    ASSERT_EQ(evicted.size(), 1U);
+    EXPECT_EQ(evicted[0].id, ids[2]);
+    EXPECT_EQ(evicted[0].logServiceId, "service3");
+    EXPECT_EQ(index.getEntries().front().id, saved);
+    EXPECT_EQ(index.getEntries()[1].logServiceId, "service1");
+    EXPECT_EQ(index.getEntries().back().logServiceId, "new");
+    EXPECT_EQ(index.getNumEntries(), 30U);
+}
+
+TEST_F(LogEntryRetentionIndexTest, RejectsLogServiceWithoutSlot)
+{
+    LogEntryRetentionIndex index("", LogEntryRetentionIndex::maxLogServices,
+                                 100, 0);
+    for (size_t i = 0; i < LogEntryRetentionIndex::maxLogServices; ++i)
+    {
+        addEntry(index, "service" + std::to_string(i), 100);
+    }
+    EXPECT_TRUE(index.hasRoomForLogService("service0"));
+    EXPECT_FALSE(index.hasRoomForLogService("new"));
+    EXPECT_EQ(index.getNextEviction("new", 100), std::nullopt);
+    EXPECT_THROW(index.evict(index.getEntries().front()), std::logic_error);
+}
+
+TEST_F(LogEntryRetentionIndexTest, PersistsAcrossRestart)
+{
+    std::vector<boost::uuids::uuid> ids;
+    {
+        LogEntryRetentionIndex index(path.string(), 1, 3, 0);
+        // Wrap around the ring
+        for (int i = 0; i < 6; ++i)
+        {
+            ids.push_back(addEntry(index, "service", 100 + i));
+        }
+    }
+
+    LogEntryRetentionIndex index(path.string(), 1, 3, 0);
+    std::vector<RetainedLogEntry> entries = index.getEntries();
+    EXPECT_EQ(getIds(entries), (std::vector<boost::uuids::uuid>{
+                                   ids[0], ids[3], ids[4], ids[5]}));
+    EXPECT_EQ(entries[3].logServiceId, "service");
+    EXPECT_EQ(entries[3].size, 105U);
+    EXPECT_EQ(index.getTotalSize(), 100U + 103 + 104 + 105);
+    EXPECT_THAT(index.getNextEviction("service", 100),
+                Optional(::testing::Field(&RetainedLogEntry::id, ids[3])));
+}
+
+TEST_F(LogEntryRetentionIndexTest, PendingRemovalsSurviveRestart)
+{
+    std::vector<RetainedLogEntry> evicted;
+    {
+        LogEntryRetentionIndex index(path.string(), 0, 2, 0, 2);
+        for (int i = 0; i < 5; ++i)
+        {
+            addEntry(index, "service", 100, &evicted);
+        }
+        ASSERT_EQ(evicted.size(), 3U);
+        // Only the newest two are kept track of
+        index.markRemoved(evicted[2].id);
+    }
+
+    LogEntryRetentionIndex index(path.string(), 0, 2, 0, 2);
+    std::vector<RetainedLogEntry> pending = index.getPendingRemovals();
+    ASSERT_EQ(pending.size(), 1U);
+    EXPECT_EQ(pending[0].id, evicted[1].id);
+    EXPECT_EQ(pending[0].logServiceId, "service");
+    EXPECT_EQ(pending[0].size, 100U);
+    index.markRemoved(evicted[1].id);
+    EXPECT_THAT(index.getPendingRemovals(), IsEmpty());
+}
+
+TEST_F(LogEntryRetentionIndexTest, ResetsOnOtherLimits)
+{
+    {
+        LogEntryRetentionIndex index(path.string(), 1, 3, 0);
+        addEntry(index, "service", 100);
+    }
+    LogEntryRetentionIndex index(path.string(), 1, 4, 0);
+    EXPECT_THAT(index.getEntries(), IsEmpty());
+    EXPECT_EQ(index.getTotalSize(), 0U);
+}
+
+TEST_F(LogEntryRetentionIndexTest, ResetsNotAnIndex)
+{
+    {
+        std::ofstream file(path);
+        file << "this is not a retention index";
+    }
+    LogEntryRetentionIndex index(path.string(), 1, 3, 0);
+    EXPECT_THAT(index.getEntries(), IsEmpty());
+    addEntry(index, "service", 100);
+    EXPECT_EQ(index.getNumEntries(), 1U);
+}
+
+TEST_F(LogEntryRetentionIndexTest, OpenFail)
+{
+    EXPECT_THROW(LogEntryRetentionIndex index("/proc/no-index", 1, 3, 0),
+                 std::runtime_error);
+}
+
+TEST_F(LogEntryRetentionIndexTest, LogServiceIdTooLongFail)
+{
+    LogEntryRetentionIndex index("", 1, 3, 0);
+    EXPECT_THROW(
+        index.add(randomGen(),
+                  std::string(LogEntryRetentionIndex::maxLogServiceIdSize + 1,
+                              'a'),
+                  100),
+        std::invalid_argument);
+}
+
+} // namespace
+} // namespace rde
+} // namespace bios_bmc_smm_error_logger
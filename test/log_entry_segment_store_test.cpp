@@ -0,0 +1,261 @@
+#include "rde/external_storer_file.hpp"
+#include "rde/external_storer_segment.hpp"
+#include "rde/log_entry_segment_store.hpp"
+
+#include <unistd.h>
+
+#include <array>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace rde
+{
+namespace
+{
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::Optional;
+
+constexpr std::string_view entriesPath =
+    "/redfish/v1/Systems/system/LogServices/a/Entries";
+
+class LogEntrySegmentStoreTest : public ::testing::Test
+{
+  protected:
+    LogEntrySegmentStoreTest() :
+        dir(std::filesystem::temp_directory_path() /
+            ("segment_store_test." + std::to_string(::getpid())))
+    {
+        std::filesystem::remove_all(dir);
+    }
+
+    ~LogEntrySegmentStoreTest() override
+    {
+        std::filesystem::remove_all(dir);
+    }
+
+    static std::string entryPath(int i)
+    {
+        return std::format("{}/{}", entriesPath, i);
+    }
+
+    static bool append(LogEntrySegmentStore& store, const std::string& path,
+                       std::string_view json)
+    {
+        return store.append(path, std::span(&json, 1));
+    }
+
+    const std::filesystem::path dir;
+};
+
+TEST_F(LogEntrySegmentStoreTest, AppendAndRead)
+{
+    LogEntrySegmentStore store(dir.string(), 4096);
+    const std::array<std::string_view, 3> jsonParts = {
+        R"({"key":)", R"("value")", "}"};
+    EXPECT_TRUE(store.append(entryPath(0), jsonParts));
+    EXPECT_TRUE(append(store, entryPath(1), "{}"));
+
+    EXPECT_THAT(store.read(entryPath(0)),
+                Optional(std::string(R"({"key":"value"})")));
+    // Same path, spelled differently
+    EXPECT_THAT(store.read(entryPath(1) + "/"), Optional(std::string("{}")));
+    EXPECT_EQ(store.read(entryPath(2)), std::nullopt);
+    EXPECT_THAT(store.list(std::string(entriesPath)), ElementsAre("0", "1"));
+    EXPECT_EQ(store.getNumEntries(), 2U);
+}
+
+TEST_F(LogEntrySegmentStoreTest, AppendReplaces)
+{
+    LogEntrySegmentStore store(dir.string(), 4096);
+    EXPECT_TRUE(append(store, entryPath(0), "old"));
+    EXPECT_TRUE(append(store, entryPath(0), "new"));
+    EXPECT_THAT(store.read(entryPath(0)), Optional(std::string("new")));
+    EXPECT_EQ(store.getNumEntries(), 1U);
+}
+
+TEST_F(LogEntrySegmentStoreTest, RemoveTakesEntriesUnderPath)
+{
+    LogEntrySegmentStore store(dir.string(), 4096);
+    EXPECT_TRUE(append(store, entryPath(0), "{}"));
+    EXPECT_TRUE(append(store, entryPath(1), "{}"));
+    EXPECT_TRUE(append(store, "/redfish/v1/Systems/system/LogServices/ab", ""));
+
+    EXPECT_TRUE(store.remove(entryPath(0)));
+    EXPECT_THAT(store.list(std::string(entriesPath)), ElementsAre("1"));
+    // Not under LogServices/a, even though it sorts in between
+    EXPECT_TRUE(store.remove("/redfish/v1/Systems/system/LogServices/a"));
+    EXPECT_THAT(store.list(std::string(entriesPath)), IsEmpty());
+    EXPECT_EQ(store.getNumEntries(), 1U);
+    EXPECT_TRUE(store.remove(entryPath(5)));
+}
+
+TEST_F(LogEntrySegmentStoreTest, DeadSegmentsAreDeleted)
+{
+    LogEntrySegmentStore store(dir.string(), 512);
+    const std::string json(200, 'x');
+    for (int i = 0; i < 10; ++i)
+    {
+        EXPECT_TRUE(append(store, entryPath(i), json));
+    }
+    EXPECT_GT(store.getNumSegments(), 3U);
+
+    for (int i = 0; i < 9; ++i)
+    {
+        EXPECT_TRUE(store.remove(entryPath(i)));
+    }
+    EXPECT_EQ(store.getNumSegments(), 1U);
+    EXPECT_THAT(store.read(entryPath(9)), Optional(json));
+
+    // The current segment starts over once it is empty
+    EXPECT_TRUE(store.remove(entryPath(9)));
+    EXPECT_EQ(std::filesystem::file_size(dir / "9.seg"), 0U);
+}
+
+TEST_F(LogEntrySegmentStoreTest, MostlyDeadSegmentIsCompacted)
+{
+    LogEntrySegmentStore store(dir.string(), 1024);
+    const std::string json(100, 'x');
+    EXPECT_TRUE(append(store, entryPath(0), "saved"));
+    for (int i = 1; i < 20; ++i)
+    {
+        EXPECT_TRUE(append(store, entryPath(i), json));
+    }
+    EXPECT_TRUE(std::filesystem::exists(dir / "0.seg"));
+
+    // Entry 0 keeps the first segment from being deleted
+    for (int i = 1; i < 8; ++i)
+    {
+        EXPECT_TRUE(store.remove(entryPath(i)));
+    }
+    EXPECT_FALSE(std::filesystem::exists(dir / "0.seg"));
+    EXPECT_THAT(store.read(entryPath(0)), Optional(std::string("saved")));
+    EXPECT_EQ(store.getNumEntries(), 13U);
+}
+
+TEST_F(LogEntrySegmentStoreTest, CompactsSegmentsLoadedBack)
+{
+    const std::string json(100, 'x');
+    {
+        LogEntrySegmentStore store(dir.string(), 1024);
+        EXPECT_TRUE(append(store, entryPath(0), "saved"));
+        for (int i = 1; i < 20; ++i)
+        {
+            EXPECT_TRUE(append(store, entryPath(i), json));
+        }
+    }
+
+    LogEntrySegmentStore store(dir.string(), 1024);
+    for (int i = 1; i < 8; ++i)
+    {
+        EXPECT_TRUE(store.remove(entryPath(i)));
+    }
+    EXPECT_FALSE(std::filesystem::exists(dir / "0.seg"));
+    EXPECT_THAT(store.read(entryPath(0)), Optional(std::string("saved")));
+
+    // Entry 0 is tracked in the segment it was moved to
+    EXPECT_TRUE(append(store, entryPath(0), "replaced"));
+    EXPECT_TRUE(store.remove(entryPath(0)));
+    EXPECT_EQ(store.read(entryPath(0)), std::nullopt);
+    EXPECT_EQ(store.getNumEntries(), 12U);
+}
+
+TEST_F(LogEntrySegmentStoreTest, LoadsBackAfterRestart)
+{
+    {
+        LogEntrySegmentStore store(dir.string(), 512);
+        const std::string json(200, 'x');
+        for (int i = 0; i < 6; ++i)
+        {
+            EXPECT_TRUE(append(store, entryPath(i), json));
+        }
+        EXPECT_TRUE(store.remove(entryPath(1)));
+        EXPECT_TRUE(append(store, entryPath(2), "replaced"));
+    }
+
+    LogEntrySegmentStore store(dir.string(), 512);
+    EXPECT_THAT(store.list(std::string(entriesPath)),
+                ElementsAre("0", "2", "3", "4", "5"));
+    EXPECT_THAT(store.read(entryPath(2)), Optional(std::string("replaced")));
+    // Appends go on after what was loaded
+    EXPECT_TRUE(append(store, entryPath(6), "{}"));
+    EXPECT_THAT(store.read(entryPath(6)), Optional(std::string("{}")));
+}
+
+TEST_F(LogEntrySegmentStoreTest, TornRecordIsDropped)
+{
+    {
+        LogEntrySegmentStore store(dir.string(), 4096);
+        EXPECT_TRUE(append(store, entryPath(0), "first"));
+        EXPECT_TRUE(append(store, entryPath(1), "second"));
+    }
+    std::filesystem::resize_file(
+        dir / "0.seg", std::filesystem::file_size(dir / "0.seg") - 2);
+
+    LogEntrySegmentStore store(dir.string(), 4096);
+    EXPECT_THAT(store.list(std::string(entriesPath)), ElementsAre("0"));
+    EXPECT_TRUE(append(store, entryPath(2), "third"));
+    EXPECT_THAT(store.read(entryPath(2)), Optional(std::string("third")));
+}
+
+TEST_F(LogEntrySegmentStoreTest, OpenFail)
+{
+    EXPECT_THROW(LogEntrySegmentStore store("/proc/no-segments", 4096),
+                 std::runtime_error);
+}
+
+TEST_F(LogEntrySegmentStoreTest, WriterKeepsLogEntriesInStore)
+{
+    const std::filesystem::path baseDir = dir / "bmcweb";
+    ExternalStorerSegmentWriter writer(
+        std::make_unique<LogEntrySegmentStore>((dir / "segments").string(),
+                                               4096),
+        std::make_unique<ExternalStorerFileWriter>(baseDir.string()));
+    const std::array<std::string_view, 1> json = {"{}"};
+    EXPECT_TRUE(writer.createFile(std::string(entriesPath), json));
+    EXPECT_TRUE(writer.createFile(entryPath(0), json));
+
+    // Only the Entries/index.json is a file
+    EXPECT_TRUE(std::filesystem::exists(
+        baseDir / std::string(entriesPath).substr(1) / "index.json"));
+    EXPECT_FALSE(std::filesystem::exists(
+        baseDir / entryPath(0).substr(1) / "index.json"));
+    EXPECT_THAT(writer.getStore().read(entryPath(0)),
+                Optional(std::string("{}")));
+    EXPECT_FALSE(writer.hasIndexFile(entryPath(0)));
+    EXPECT_TRUE(writer.hasIndexFile(std::string(entriesPath)));
+    EXPECT_EQ(writer.getStoredSize(entryPath(0), 2),
+              LogEntrySegmentStore::recordOverhead + entryPath(0).size() + 2);
+
+    // Exported in the directory layout
+    const std::filesystem::path exportDir = dir / "export";
+    ExternalStorerFileWriter exporter(exportDir.string());
+    EXPECT_TRUE(writer.getStore().exportTo(exporter));
+    std::ifstream file(exportDir / entryPath(0).substr(1) / "index.json");
+    std::stringstream content;
+    content << file.rdbuf();
+    EXPECT_EQ(content.str(), "{}");
+
+    EXPECT_TRUE(writer.removeAll("/redfish/v1/Systems/system/LogServices/a"));
+    EXPECT_EQ(writer.getStore().getNumEntries(), 0U);
+    EXPECT_FALSE(std::filesystem::exists(
+        baseDir / std::string(entriesPath).substr(1)));
+}
+
+} // namespace
+} // namespace rde
+} // namespace bios_bmc_smm_error_logger
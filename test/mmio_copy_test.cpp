@@ -0,0 +1,87 @@
+#include "mmio_copy.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace
+{
+
+using ::testing::ElementsAreArray;
+
+class MmioCopyTest : public ::testing::Test
+{
+  protected:
+    MmioCopyTest() : region(testRegionSize), expected(testRegionSize)
+    {
+        std::iota(region.begin(), region.end(), 0);
+    }
+
+    static constexpr size_t testRegionSize = 64;
+    // Cover every head/tail combination for both 32-bit and 64-bit words
+    static constexpr size_t maxMisalignment = 8;
+    static constexpr size_t maxLength = 40;
+
+    std::vector<uint8_t> region;
+    std::vector<uint8_t> expected;
+};
+
+TEST_F(MmioCopyTest, CopyFromMmioAllAlignments)
+{
+    for (size_t srcOffset = 0; srcOffset < maxMisalignment; ++srcOffset)
+    {
+        for (size_t destOffset = 0; destOffset < maxMisalignment; ++destOffset)
+        {
+            for (size_t length = 0; length <= maxLength; ++length)
+            {
+                std::vector<uint8_t> dest(maxMisalignment + maxLength, 0xff);
+                copyFromMmio(region.data() + srcOffset,
+                             std::span(dest).subspan(destOffset, length));
+
+                std::vector<uint8_t> expectedDest(dest.size(), 0xff);
+                std::copy_n(region.begin() + srcOffset, length,
+                            expectedDest.begin() + destOffset);
+                EXPECT_THAT(dest, ElementsAreArray(expectedDest))
+                    << "srcOffset " << srcOffset << " destOffset "
+                    << destOffset << " length " << length;
+            }
+        }
+    }
+}
+
+TEST_F(MmioCopyTest, CopyToMmioAllAlignments)
+{
+    std::vector<uint8_t> src(maxMisalignment + maxLength);
+    std::iota(src.begin(), src.end(), 0x80);
+
+    for (size_t srcOffset = 0; srcOffset < maxMisalignment; ++srcOffset)
+    {
+        for (size_t destOffset = 0; destOffset < maxMisalignment; ++destOffset)
+        {
+            for (size_t length = 0; length <= maxLength; ++length)
+            {
+                std::fill(region.begin(), region.end(), 0);
+                copyToMmio(region.data() + destOffset,
+                           std::span<const uint8_t>(src).subspan(srcOffset,
+                                                                 length));
+
+                std::fill(expected.begin(), expected.end(), 0);
+                std::copy_n(src.begin() + srcOffset, length,
+                            expected.begin() + destOffset);
+                EXPECT_THAT(region, ElementsAreArray(expected))
+                    << "srcOffset " << srcOffset << " destOffset "
+                    << destOffset << " length " << length;
+            }
+        }
+    }
+}
+
+} // namespace
+} // namespace bios_bmc_smm_error_logger
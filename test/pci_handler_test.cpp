@@ -104,6 +104,27 @@ TEST_F(PciHandlerTest, ReadPasses)
                 ElementsAreArray(expectedVector));
 }
 
+TEST_F(PciHandlerTest, ReadIntoPasses)
+{
+    // Normal read from 0
+    std::vector<uint8_t> result(2);
+    std::vector<uint8_t> expectedVector{0, 11};
+    EXPECT_EQ(pciDataHandler->readInto(0, result), 2);
+    EXPECT_THAT(result, ElementsAreArray(expectedVector));
+
+    // Read over buffer boundary (which will read until the end)
+    result.assign(testRegionSize - 4 + 1, 0xff);
+    expectedVector = {44, 55, 66, 77, 0xff};
+    EXPECT_EQ(pciDataHandler->readInto(4, result), testRegionSize - 4);
+    EXPECT_THAT(result, ElementsAreArray(expectedVector));
+
+    // Zero size and offset too big
+    std::vector<uint8_t> emptyVector;
+    EXPECT_EQ(pciDataHandler->readInto(0, emptyVector), 0);
+    result.resize(1);
+    EXPECT_EQ(pciDataHandler->readInto(testRegionSize + 1, result), 0);
+}
+
 TEST_F(PciHandlerTest, WritePasses)
 {
     std::vector<std::byte> expectedMapped{
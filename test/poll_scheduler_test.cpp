@@ -0,0 +1,156 @@
+#include "poll_scheduler.hpp"
+
+#include <chrono>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace
+{
+
+using std::chrono::milliseconds;
+
+class PollSchedulerTest : public ::testing::Test
+{
+  protected:
+    PollSchedulerTest() : scheduler(testConfig, start) {}
+
+    static constexpr PollSchedulerConfig testConfig = {
+        .minInterval = milliseconds(10), .maxInterval = milliseconds(80)};
+    static constexpr PollActivity idle = {
+        .queueBytesPending = 0, .queueCapacity = 384, .drainStalled = false};
+    static constexpr PollActivity busy = {
+        .queueBytesPending = 100, .queueCapacity = 384, .drainStalled = false};
+
+    const PollScheduler::Clock::time_point start =
+        PollScheduler::Clock::time_point(std::chrono::seconds(100));
+    PollScheduler scheduler;
+};
+
+TEST_F(PollSchedulerTest, InvalidConfigFail)
+{
+    EXPECT_THROW(PollScheduler({.minInterval = milliseconds(0),
+                                .maxInterval = milliseconds(10)},
+                               start),
+                 std::invalid_argument);
+    EXPECT_THROW(PollScheduler({.minInterval = milliseconds(20),
+                                .maxInterval = milliseconds(10)},
+                               start),
+                 std::invalid_argument);
+}
+
+TEST_F(PollSchedulerTest, IdleBacksOffExponentially)
+{
+    EXPECT_EQ(scheduler.next(start, idle), start + milliseconds(10));
+    EXPECT_EQ(scheduler.next(start + milliseconds(10), idle),
+              start + milliseconds(30));
+    EXPECT_FALSE(scheduler.burstEnded());
+    // From here on the max interval is used
+    EXPECT_EQ(scheduler.next(start + milliseconds(30), idle),
+              start + milliseconds(70));
+    EXPECT_TRUE(scheduler.burstEnded());
+    EXPECT_EQ(scheduler.next(start + milliseconds(70), idle),
+              start + milliseconds(150));
+    EXPECT_FALSE(scheduler.burstEnded());
+    EXPECT_EQ(scheduler.next(start + milliseconds(150), idle),
+              start + milliseconds(230));
+    EXPECT_EQ(scheduler.getInterval(), milliseconds(80));
+}
+
+TEST_F(PollSchedulerTest, ProcessingTimeDoesNotDrift)
+{
+    // Settle at the max interval first
+    PollScheduler::Clock::time_point deadline = start;
+    for (int i = 0; i < 4; ++i)
+    {
+        deadline = scheduler.next(deadline, idle);
+    }
+
+    // Every poll finishes 3ms after its deadline, the deadlines stay on the
+    // same 80ms grid
+    for (int i = 0; i < 10; ++i)
+    {
+        PollScheduler::Clock::time_point next =
+            scheduler.next(deadline + milliseconds(3), idle);
+        EXPECT_EQ(next, deadline + milliseconds(80));
+        deadline = next;
+    }
+}
+
+TEST_F(PollSchedulerTest, EarlyWakeSchedulesFromNow)
+{
+    EXPECT_EQ(scheduler.next(start, idle), start + milliseconds(10));
+    EXPECT_EQ(scheduler.next(start + milliseconds(10), idle),
+              start + milliseconds(30));
+    // Woken 15ms ahead of the deadline, the next poll is an interval from
+    // the wakeup rather than from the deadline that wasn't reached
+    EXPECT_EQ(scheduler.next(start + milliseconds(15), idle),
+              start + milliseconds(55));
+    // The same holds while waiting on a stalled drain
+    EXPECT_EQ(scheduler.next(start + milliseconds(20),
+                             {.queueBytesPending = 100,
+                              .queueCapacity = 384,
+                              .drainStalled = true}),
+              start + milliseconds(30));
+}
+
+TEST_F(PollSchedulerTest, PendingDataPollsBackToBack)
+{
+    scheduler.next(start, idle);
+    scheduler.next(start + milliseconds(10), idle);
+    scheduler.next(start + milliseconds(30), idle);
+
+    const PollScheduler::Clock::time_point now = start + milliseconds(71);
+    EXPECT_EQ(scheduler.next(now, busy), now);
+    EXPECT_EQ(scheduler.next(now + milliseconds(1), busy),
+              now + milliseconds(1));
+    // Back to the short interval once the queue is empty
+    EXPECT_EQ(scheduler.next(now + milliseconds(2), idle),
+              now + milliseconds(11));
+    EXPECT_EQ(scheduler.getInterval(), milliseconds(20));
+}
+
+TEST_F(PollSchedulerTest, StalledDrainDoesNotSpin)
+{
+    PollActivity stalled = busy;
+    stalled.drainStalled = true;
+    EXPECT_EQ(scheduler.next(start, busy), start);
+    EXPECT_EQ(scheduler.next(start + milliseconds(1), stalled),
+              start + milliseconds(10));
+    EXPECT_EQ(scheduler.next(start + milliseconds(10), stalled),
+              start + milliseconds(20));
+    EXPECT_EQ(scheduler.getInterval(), milliseconds(10));
+}
+
+TEST_F(PollSchedulerTest, LatePollDoesNotCatchUp)
+{
+    scheduler.next(start, idle);
+    // Way past the deadline, poll once now instead of once per missed tick
+    const PollScheduler::Clock::time_point late = start + milliseconds(500);
+    EXPECT_EQ(scheduler.next(late, idle), late);
+    EXPECT_EQ(scheduler.next(late, idle), late + milliseconds(40));
+}
+
+TEST_F(PollSchedulerTest, Stats)
+{
+    PollScheduler::Clock::time_point now = start;
+    for (int i = 0; i < 50; ++i)
+    {
+        scheduler.next(now, i == 10 ? busy : idle);
+        now += milliseconds(20);
+    }
+    // 50 polls 20ms apart, the window closes on the poll a second in
+    PollSchedulerStats stats = scheduler.getStats();
+    EXPECT_EQ(stats.wakeups, 50U);
+    EXPECT_DOUBLE_EQ(stats.wakeupsPerSecond, 0.0);
+    scheduler.next(now, idle);
+    stats = scheduler.getStats();
+    EXPECT_DOUBLE_EQ(stats.wakeupsPerSecond, 51.0);
+    EXPECT_EQ(stats.maxQueueFill, 100U);
+    EXPECT_EQ(stats.queueCapacity, 384U);
+}
+
+} // namespace
+} // namespace bios_bmc_smm_error_logger
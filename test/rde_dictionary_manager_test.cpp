@@ -1,9 +1,12 @@
+#include "checksum/crc32.hpp"
 #include "rde/rde_dictionary_manager.hpp"
 
+#include <algorithm>
 #include <cstring>
 #include <memory>
 #include <optional>
 #include <span>
+#include <vector>
 
 #include <gmock/gmock-matchers.h>
 #include <gmock/gmock.h>
@@ -174,5 +177,26 @@ TEST_F(RdeDictionaryManagerTest, DictionaryInvalidateTest)
     EXPECT_THAT(dm.getDictionaryCount(), 0);
 }
 
+TEST_F(RdeDictionaryManagerTest, DictionaryCrcAdvancedWhileCopied)
+{
+    uint32_t crc = crc32Init;
+    dm.startDictionaryEntry(resourceId, std::span(dummyDictionary1), &crc);
+    EXPECT_TRUE(
+        dm.addDictionaryData(resourceId, std::span(dummyDictionary2), &crc));
+    // Nothing copied, nothing added to the CRC
+    EXPECT_FALSE(dm.addDictionaryData(resourceId + 1,
+                                      std::span(dummyDictionary2), &crc));
+    dm.markDataComplete(resourceId);
+
+    std::vector<uint8_t> expected(dummyDictionary1.begin(),
+                                  dummyDictionary1.end());
+    expected.insert(expected.end(), dummyDictionary2.begin(),
+                    dummyDictionary2.end());
+    EXPECT_EQ(crc, crc32Update(crc32Init, expected));
+    auto dataOrErr = dm.getDictionary(resourceId);
+    ASSERT_TRUE(dataOrErr);
+    EXPECT_TRUE(std::ranges::equal(*dataOrErr, expected));
+}
+
 } // namespace rde
 } // namespace bios_bmc_smm_error_logger
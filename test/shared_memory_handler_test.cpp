@@ -0,0 +1,85 @@
+#include "shared_memory_handler.hpp"
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace bios_bmc_smm_error_logger
+{
+namespace
+{
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+
+constexpr size_t testRegionSize = 0x1000;
+
+TEST(SharedMemoryDataHandlerTest, MemfdStartsZeroed)
+{
+    auto handler = SharedMemoryDataHandler::createMemfd(testRegionSize);
+    EXPECT_EQ(handler->getMemoryRegionSize(), testRegionSize);
+    EXPECT_EQ(handler->getDoorbell(), nullptr);
+    EXPECT_THAT(handler->read(0, 4), ElementsAre(0, 0, 0, 0));
+}
+
+TEST(SharedMemoryDataHandlerTest, SharedMappingSeesWrites)
+{
+    auto bmcSide = SharedMemoryDataHandler::createMemfd(testRegionSize);
+    auto biosSide = bmcSide->share();
+
+    const std::vector<uint8_t> bytes = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+    EXPECT_EQ(biosSide->write(0x103, bytes), bytes.size());
+    EXPECT_THAT(bmcSide->read(0x103, bytes.size()), ElementsAreArray(bytes));
+
+    // Reads and writes past the end are cut short, same as over PCI
+    EXPECT_EQ(bmcSide->write(testRegionSize - 2, bytes), 2U);
+    EXPECT_THAT(biosSide->read(testRegionSize - 2, bytes.size()),
+                ElementsAre(1, 2));
+}
+
+TEST(SharedMemoryDataHandlerTest, FileIsSharedAndKept)
+{
+    const std::filesystem::path path =
+        std::filesystem::temp_directory_path() /
+        ("shared_memory_handler_test." + std::to_string(::getpid()));
+    const std::vector<uint8_t> bytes = {0xde, 0xad, 0xbe, 0xef};
+    {
+        auto bmcSide = SharedMemoryDataHandler::openFile(path, testRegionSize);
+        auto biosSide = SharedMemoryDataHandler::openFile(path, testRegionSize);
+        biosSide->write(0x10, bytes);
+        EXPECT_THAT(bmcSide->read(0x10, bytes.size()),
+                    ElementsAreArray(bytes));
+    }
+    EXPECT_EQ(std::filesystem::file_size(path), testRegionSize);
+    {
+        auto handler = SharedMemoryDataHandler::openFile(path, testRegionSize);
+        EXPECT_THAT(handler->read(0x10, bytes.size()),
+                    ElementsAreArray(bytes));
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(SharedMemoryDataHandlerTest, OpenFileFail)
+{
+    EXPECT_THROW(SharedMemoryDataHandler::openFile(
+                     "/does-not-exist/buffer", testRegionSize),
+                 std::runtime_error);
+}
+
+TEST(SharedMemoryDataHandlerTest, KeepsDoorbell)
+{
+    auto doorbell = std::make_unique<EventFdDoorbell>();
+    Doorbell* doorbellPtr = doorbell.get();
+    auto handler = SharedMemoryDataHandler::createMemfd(testRegionSize,
+                                                        std::move(doorbell));
+    EXPECT_EQ(handler->getDoorbell(), doorbellPtr);
+    EXPECT_EQ(handler->share()->getDoorbell(), nullptr);
+}
+
+} // namespace
+} // namespace bios_bmc_smm_error_logger